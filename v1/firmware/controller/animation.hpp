@@ -0,0 +1,143 @@
+/**********************************************************************/
+/**
+ * @brief  Animation Clock and Playback
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+
+#include <cstdbool>
+#include <cstdint>
+
+#include "mono_image.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Animations run by time, not by rendered frames. AnimClock is ticked once
+// per rendered frame with the micros() time stamp, and players advance by
+// its delta. A player not advanced (e.g. the render mode is not shown)
+// pauses, and a long stall is clamped to ANIM_CLOCK_MAX_DELTA_US.
+
+// Duration of n frames at fps, e.g. the old "every 3 frames at 70 fps".
+#define ANIM_FRAMES_US(n, fps)      ((uint32_t)(n) * 1000000UL / (fps))
+#define ANIM_CLOCK_MAX_DELTA_US     (100000UL)
+
+typedef enum anim_mode_ {
+    ANIM_MODE_LOOP = 0,
+    ANIM_MODE_ONCE,             // Stops at the last frame
+} anim_mode_t;
+
+// One event per frame advance.
+typedef enum anim_event_ {
+    ANIM_EVENT_FRAME = 0,       // Next frame
+    ANIM_EVENT_LOOP,            // Wrapped to the first frame
+    ANIM_EVENT_END,             // Once, reached the end (stays at the last frame)
+} anim_event_t;
+
+typedef struct anim_ {
+    const mono_images_t * frames_;
+    uint32_t frameUs_;          // Frame duration
+    const uint16_t * frameMs_;  // Per frame duration in ms, count_ entries (nullptr : frameUs_)
+    anim_mode_t mode_;
+} anim_t;
+
+typedef void (*anim_hook_t)(void * context, anim_event_t event);
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class AnimClock
+{
+public:
+    void tick(uint32_t nowUs) {
+        if (started_) {
+            uint32_t d = nowUs - nowUs_;
+            deltaUs_ = (d > ANIM_CLOCK_MAX_DELTA_US)? ANIM_CLOCK_MAX_DELTA_US : d;
+        } else {
+            deltaUs_ = 0;
+            started_ = true;
+        }
+        nowUs_ = nowUs;
+    }
+    uint32_t now(void) const { return nowUs_; }
+    uint32_t delta(void) const { return deltaUs_; }
+
+private:
+    uint32_t nowUs_ = 0;
+    uint32_t deltaUs_ = 0;
+    bool started_ = false;
+};
+
+class AnimPlayer
+{
+public:
+    // play() from the hook keeps the time left over, so a chain of
+    // animations does not drift.
+    void play(const anim_t * anim, int frame = 0) {
+        anim_ = anim;
+        frame_ = (frame < anim->frames_->count_)? frame : 0;
+        ended_ = false;
+        if (!inHook_) accUs_ = 0;
+    }
+    void setHook(anim_hook_t hook, void * context) {
+        hook_ = hook;
+        context_ = context;
+    }
+
+    // Returns the number of frames advanced.
+    int advance(uint32_t deltaUs) {
+        if (anim_ == nullptr || ended_) return 0;
+        int n = 0;
+        accUs_ += deltaUs;
+        while (!ended_) {
+            uint32_t d = frameUs(frame_);
+            if (d == 0 || accUs_ < d) break;
+            accUs_ -= d;
+            anim_event_t event = ANIM_EVENT_FRAME;
+            if (frame_ + 1 < anim_->frames_->count_) {
+                frame_++;
+            } else if (anim_->mode_ == ANIM_MODE_LOOP) {
+                frame_ = 0;
+                event = ANIM_EVENT_LOOP;
+            } else {
+                ended_ = true;
+                accUs_ = 0;
+                event = ANIM_EVENT_END;
+            }
+            n++;
+            if (hook_) {
+                inHook_ = true;
+                hook_(context_, event);
+                inHook_ = false;
+            }
+        }
+        return n;
+    }
+
+public:
+    const anim_t * anim(void) const { return anim_; }
+    const mono_image_t * image(void) const { return &anim_->frames_->images_[frame_]; }
+    int  frame(void) const { return frame_; }
+    bool ended(void) const { return ended_; }
+    uint32_t frameUs(int frame) const {
+        return (anim_->frameMs_)? ((uint32_t)anim_->frameMs_[frame] * 1000UL) : anim_->frameUs_;
+    }
+
+private:
+    const anim_t * anim_ = nullptr;
+    int frame_ = 0;
+    bool ended_ = false;
+    bool inHook_ = false;
+    uint32_t accUs_ = 0;
+    anim_hook_t hook_ = nullptr;
+    void * context_ = nullptr;
+};
@@ -9,14 +9,18 @@
  *----------------------------------------------------------------------
  */
 #include <cstdint>
+#include <cstring>
 #include <cmath>
-#include <functional>
 
 #include "motor.hpp"
 
 #include "image_data.hpp"
-#include "snow.hpp"
-//#include "character.hpp"
+#include "particles.hpp"
+#include "life.hpp"
+#include "character.hpp"
+#include "timeline.hpp"
+#include "intro_scene.hpp"
+#include "text_render.hpp"
 
 #include "app.hpp"
 
@@ -27,9 +31,33 @@
 
 static PseudoRand rnd_;
 
-#define GRAINS      (100)
-static Snow snow;
-static Snow::Grain grains[GRAINS];
+// Particle storage is 6 bytes each. On the host pbench measures 15 ~ 19 ns a
+// particle (update + plot, 1.1 ~ 1.4x the old Snow). On the RP2040 the PBENCH
+// command times it against the frame interval, the scenes keep 100 until then.
+#define SNOW_PARTICLES      (100)
+static Particles snow;
+static uint16_t snowX_[SNOW_PARTICLES];
+static int16_t  snowY_[SNOW_PARTICLES];
+static int16_t  snowVY_[SNOW_PARTICLES];
+
+#ifdef IMAGE_DATA_HAS_VIDEO_BADAPPLE
+#define VIDEO_PLANE_SIZE    ((256 / 8) * CV_HEIGHT)   // Max 256 x 128 video
+static uint8_t videoPlane_[VIDEO_PLANE_SIZE];
+#endif
+
+static Timeline intro_;
+static intro_scene_t introScene_;
+
+// Ticker band of the whole circumference, the text is rendered to it from
+// the glyph cache and drawn as a plane.
+#define TICKER_SPAN_SIZE    ((CV_V_WIDTH + 7) / 8 * 28)     // font_ticker height
+static uint8_t tickerSpan_[TICKER_SPAN_SIZE];
+static GlyphCache tickerCache_;
+
+// The ticker as a scroll layer, the text and the band lines once. (the text
+// shorter than the circumference, App::scrollLayer)
+#define TICKER_LAYER_SIZE   ((CV_V_WIDTH + 7) / 8 * (28 + 8))
+static uint8_t tickerLayer_[TICKER_LAYER_SIZE];
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions
@@ -42,8 +70,8 @@ App::App()
 
     rnd_.setSeed(rand(), rand(), rand(), rand());
 
-    snow.setRandCallback(getRand);
-    snow.setSnowGrains(grains, GRAINS);
+    snow.setSeed(rnd_.rand());
+    snow.setBuffers(snowX_, snowY_, snowVY_, SNOW_PARTICLES);
 }
 
 App::~App()
@@ -65,9 +93,10 @@ App::init(void)
 void
 App::loop(
     uint32_t timeUs,
-    float angle
+    uint16_t angle
 ) {
     angle_ = angle;
+    timeUs_ = timeUs;
 
     if (autoRenderModeChangeTimer_.check()) {
         if (autoRenderModeChange_) {
@@ -78,18 +107,61 @@ App::loop(
 }
 
 void
-App::render(uint8_t * buffer)
+App::render(uint8_t * buffer, sprite_list_t * sprites)
+{
+    setupRender(buffer, sprites);
+
+    animClock_.tick(timeUs_);
+
+    grayRendered_ = false;
+    render();
+    fillPlanes();
+}
+
+// USB streaming mode, the cylinder rendered on the host. Only the rotation
+// is applied here, by the angle at this frame.
+void
+App::renderStream(uint8_t * buffer, sprite_list_t * sprites, const mono_plane_t * plane)
+{
+    setupRender(buffer, sprites);
+
+    drawer_.drawPlane(-angle2xpos(angle_), 0, plane);
+    grayRendered_ = false;
+    fillPlanes();
+}
+
+void
+App::setupRender(uint8_t * buffer, sprite_list_t * sprites)
+{
+    renderBuffer_ = buffer;
+    setupPlane(0);
+
+    // Setup Drawer
+    drawer_.setSpriteList(sprites, &sprites_);
+}
+
+// The screens on the bit plane. (the sprite list is kept)
+void
+App::setupPlane(int plane)
 {
     // Setup render buffer
+    uint8_t * buffer = renderBuffer_ + (plane * CV_FRAME_BYTES);
     for (int i = 0; i < CV_DISPLAYS; i++) {
       MonoScreen * monoscreen = screen_.getMonoScreen(i);
       monoscreen->setBuffer( buffer + (i * CV_ONE_FRAME_BYTES) );
     }
 
-    // Setup Drawer
     drawer_.init(&screen_);
+}
 
-    render();
+// A monochrome frame is lit on all the planes, the full intensity.
+void
+App::fillPlanes(void)
+{
+    if (grayRendered_) return;
+    for (int plane = 1; plane < grayPlanes_; plane++) {
+        memcpy(renderBuffer_ + (plane * CV_FRAME_BYTES), renderBuffer_, CV_FRAME_BYTES);
+    }
 }
 
 void
@@ -106,11 +178,86 @@ App::setMode(int mode)
 }
 
 void
-App::setAngle(float angle)
+App::setAngle(uint16_t angle)
 {
     angle_ = angle;
 }
 
+// Reseed the random sources, the same seed gives the same frames. (see
+// v1/tools/golden)
+void
+App::setSeed(uint32_t seed)
+{
+    rnd_.setSeed(123456789UL ^ seed, 362436069UL, 521288629UL, 88675123UL);
+
+    snow.setSeed(rnd_.rand());
+}
+
+// The buffers of render() are planes * CV_FRAME_BYTES.
+void
+App::setGrayPlanes(int planes)
+{
+    grayPlanes_ = (planes < 1)? 1 : (planes > CV_GRAY_PLANES_MAX)? CV_GRAY_PLANES_MAX : planes;
+}
+
+void
+App::setTickerText(const char * text)
+{
+    strncpy(tickerText_, text, APP_TICKER_TEXT_MAX);
+    tickerText_[APP_TICKER_TEXT_MAX] = '\0';
+    tickerGeneration_++;
+}
+
+void
+App::setTickerSpeed(int pixelsPerSec)
+{
+    tickerSpeed_ = pixelsPerSec;
+}
+
+// The last frame rendered as a layer moved by the row, the bridges show it
+// by the start line. Only the ticker with the text in one turn, the band of
+// the whole circumference is the same plane turned by the scroll and the
+// angle. (a longer text has the seam of the band at the angle, in frames)
+bool
+App::scrollLayer(scroll_layer_t * layer)
+{
+    if (rendermode_ != 10 || grayPlanes_ != 1) return false;
+
+    static const Font font(&font_ticker);
+    const int y = (CV_HEIGHT - font.height()) / 2;
+    const int height = font.height() + 8;
+    const mono_surface_t surface = { CV_V_WIDTH, height, tickerLayer_ };
+    if ((CV_V_WIDTH % 8) != 0 || (CV_V_WIDTH / 8) * height > TICKER_LAYER_SIZE) return false;
+    if (tickerPeriod(font.textWidth(tickerText_, TEXT_LAYOUT_PROPORTIONAL)) != CV_V_WIDTH) return false;
+
+    if (tickerLayerGeneration_ != tickerGeneration_) {
+        memset(tickerLayer_, 0, sizeof(tickerLayer_));
+        mono_fill(&surface, 0, 0, CV_V_WIDTH, 1, MONO_ROP_OR);
+        mono_fill(&surface, 0, height - 1, CV_V_WIDTH, 1, MONO_ROP_OR);
+        text_render_span(&surface, 0, 4, &font, tickerText_, TEXT_LAYOUT_PROPORTIONAL, &tickerCache_);
+        tickerLayerGeneration_ = tickerGeneration_;
+    }
+
+    // The text x t is at the cylinder x (t - xpos - scroll), the plane
+    // column (V_WIDTH - 1 - t). (see render_mode_10)
+    int scroll = (int)(tickerScroll_ / 1000000);
+    int xpos = angle2xpos(angle_);
+    layer->plane_ = { surface.width_, surface.height_, surface.buffer_ };
+    layer->y_ = y - 4;
+    layer->row_ = CvScreenGeometry::wrap(CV_MARGIN - xpos - scroll);
+    layer->generation_ = tickerGeneration_;
+    return true;
+}
+
+// The text and a gap, whole pages, the circumference at least.
+int
+App::tickerPeriod(int width)
+{
+    int period = width + (CV_V_WIDTH / 4);
+    if (period < CV_V_WIDTH) period = CV_V_WIDTH;
+    return (period + 7) & ~7;
+}
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions
  *----------------------------------------------------------------------
@@ -129,6 +276,9 @@ App::render(void)
     case 5: render_mode_5(); break;
     case 6: render_mode_6(); break;
     case 7: render_mode_7(); break;
+    case 8: render_mode_8(); break;
+    case 9: render_mode_9(); break;
+    case 10: render_mode_10(); break;
     default: break;
     }
 }
@@ -151,48 +301,59 @@ App::render_mode_0(void)
 #endif
     //drawer_.clearFrame();
 
-    static const mono_images_t * frames = &image_badapple_frames;
-    static int frameno = 0;
-
     int xpos = angle2xpos(angle_);
-    MonoImage image(&frames->images_[frameno]);
-    drawer_.drawImageOffset(-xpos, CV_HEIGHT / 2, &image);
 
-    frameno++;
-    if (frameno >= frames->count_) frameno = 0;
+#ifdef IMAGE_DATA_HAS_VIDEO_BADAPPLE
+    static MonoVideo video;
+    static bool inited = false;
+    static uint32_t startUs = 0;
+    if (!inited) {
+        inited = video.init(&video_badapple, videoPlane_, sizeof(videoPlane_));
+        startUs = timeUs_;
+    }
+
+    // Decoded from flash into one plane, follow the time even if frames are dropped.
+    video.seek(video.frameAt(timeUs_ - startUs));
+    drawer_.drawPlane(-xpos, CV_HEIGHT / 2, video.plane(), true);
+#else
+    drawer_.clearFrame();
+
+    MonoImage image(&image_title_cylinview_frames.images_[0]);
+    drawer_.drawSpriteCentered(CV_WIDTH / 2 - xpos, CV_HEIGHT / 2, &image);
+#endif
 }
 
-#if 0
 void
 App::render_mode_1(void)
 {
     drawer_.clearFrame();
 
-    auto render_mode_1_draw = [&](int cx, int cy, float * deg)
+    auto render_mode_1_draw = [&](int cx, int cy, int * deg)
     {
-        const float div = 1.0;
+        const int   div = 1;
         const int   limit = (1 * CV_V_WIDTH);
         
         int x;
-        float y;
+        fixed_t y;
         int nodiff;
         int counter;
-        float ydiff = tan((2 * M_PI) * (*deg / 360.0));
+        fixed_t ydiff = fixed_tan(fixed_angle_from_deg(*deg), fixed_from_int(CV_HEIGHT));
 
         x = cx;
-        y = cy;
+        y = fixed_from_int(cy);
         nodiff = 0;
         counter = 0;
         
         while (1) {
-            drawer_.drawDot(x + 0, (int)y + 0, 1);
-            drawer_.drawDot(x + 0, (int)y + 1, 1);
-            drawer_.drawDot(x + 0, (int)y - 1, 1);
-            drawer_.drawDot(x + 1, (int)y + 0, 1);
-            drawer_.drawDot(x - 1, (int)y + 0, 1);
+            int iy = fixed_trunc(y);
+            drawer_.drawDot(x + 0, iy + 0, 1);
+            drawer_.drawDot(x + 0, iy + 1, 1);
+            drawer_.drawDot(x + 0, iy - 1, 1);
+            drawer_.drawDot(x + 1, iy + 0, 1);
+            drawer_.drawDot(x - 1, iy + 0, 1);
             x = x + 1;
             y = y + ydiff;
-            int iy = (int)y;
+            iy = fixed_trunc(y);
             if (iy >= 128 || iy < 0) break;
             if (iy == cy) nodiff++;
             if (nodiff >= (CV_V_WIDTH / 2)) break;
@@ -201,17 +362,18 @@ App::render_mode_1(void)
         }
 
         x = cx;
-        y = cy;
+        y = fixed_from_int(cy);
         nodiff = 0;
         counter = 0;
 
         while (1) {
-            drawer_.drawDot(x, (int)y + 1, 1);
-            drawer_.drawDot(x, (int)y + 0, 1);
-            drawer_.drawDot(x, (int)y - 1, 1);
+            int iy = fixed_trunc(y);
+            drawer_.drawDot(x, iy + 1, 1);
+            drawer_.drawDot(x, iy + 0, 1);
+            drawer_.drawDot(x, iy - 1, 1);
             x = x - 1;
             y = y - ydiff;
-            int iy = (int)y;
+            iy = fixed_trunc(y);
             if (iy >= 128 || iy < 0) break;
             if (iy == cy) nodiff++;
             if (nodiff >= (CV_V_WIDTH / 2)) break;
@@ -220,13 +382,13 @@ App::render_mode_1(void)
         }
         
         *deg += div;
-        if (*deg >= 360.0) *deg = *deg - 360.0;
+        if (*deg >= 360) *deg = *deg - 360;
     };
 
-    static float degree0 = 45.0 * 0;
-    static float degree1 = 45.0 * 1;
-    static float degree2 = 45.0 * 2;
-    static float degree3 = 45.0 * 3;
+    static int degree0 = 45 * 0;
+    static int degree1 = 45 * 1;
+    static int degree2 = 45 * 2;
+    static int degree3 = 45 * 3;
     render_mode_1_draw((32 / 2), 128 / 2, &degree0);
     render_mode_1_draw((32 / 2), 128 / 2, &degree1);
     render_mode_1_draw((32 / 2), 128 / 2, &degree2);
@@ -258,10 +420,7 @@ App::render_mode_3(void)
 
     int xpos = angle2xpos(angle_);
     snow.loop();
-    for (int i = 0; i < GRAINS; i++) {
-        Snow::Grain * g = &grains[i];
-        drawer_.drawDot(g->x_ - xpos, g->y_);
-    }
+    snow.draw(&drawer_, xpos);
 }
 
 void
@@ -269,15 +428,14 @@ App::render_mode_4(void)
 {
     drawer_.clearFrame();
 
-    static const mono_images_t * frames = &image_anim_test_frames;
-    static int frameno = 0;
+    static const anim_t anim = { &image_anim_test_frames, ANIM_FRAMES_US(1, 70), nullptr, ANIM_MODE_LOOP };
+    static AnimPlayer player;
+    if (player.anim() == nullptr) player.play(&anim);
+    player.advance(animClock_.delta());
 
     int xpos = angle2xpos(angle_);
-    MonoImage image(&frames->images_[frameno]);
+    MonoImage image(player.image());
     drawer_.drawImageOffset(-xpos, 64, &image);
-
-    frameno++;
-    if (frameno >= frames->count_) frameno = 0;
 }
 
 void
@@ -287,337 +445,42 @@ App::render_mode_5(void)
 
     int xpos = angle2xpos(angle_);
     snow.loop();
-    for (int i = 0; i < GRAINS; i++) {
-        Snow::Grain * g = &grains[i];
-        drawer_.drawDot(g->x_ - xpos, g->y_);
-    }
-
-    //static const mono_images_t * frames = &image_anim_test_frames;
-    static const mono_images_t * frames = &image_sky1_frames;
-    //static const mono_images_t * frames = &image_sky2_frames;
-    static int frameno = 0;
-    static int framexpos = 0;
-
-    MonoImage image(&frames->images_[frameno]);
-    drawer_.drawImageBlendOffset(framexpos - xpos, 64, &image);
-
-    framexpos++;
-    if (framexpos >= CV_V_WIDTH) framexpos = 0;
-
-    frameno++;
-    if (frameno >= frames->count_) frameno = 0;
+    snow.draw(&drawer_, xpos);
+
+    //static const anim_t anim = { &image_anim_test_frames, ANIM_FRAMES_US(1, 70), nullptr, ANIM_MODE_LOOP };
+    static const anim_t anim = { &image_sky1_frames, ANIM_FRAMES_US(1, 70), nullptr, ANIM_MODE_LOOP };
+    //static const anim_t anim = { &image_sky2_frames, ANIM_FRAMES_US(1, 70), nullptr, ANIM_MODE_LOOP };
+    static AnimPlayer player;
+    if (player.anim() == nullptr) player.play(&anim);
+    player.advance(animClock_.delta());
+
+    // Scrolls a pixel per 70 fps frame.
+    const uint32_t pixelUs = ANIM_FRAMES_US(1, 70);
+    static uint32_t scrollUs = 0;
+    scrollUs = (scrollUs + animClock_.delta()) % (CV_V_WIDTH * pixelUs);
+    int framexpos = (int)(scrollUs / pixelUs);
+
+    MonoImage image(player.image());
+    drawer_.drawSpriteOffset(framexpos - xpos, 64, &image);
 }
 
 void
 App::render_mode_6(void)
 {
-    const int fps = 70;
-    const int motspeed = 80;
-
-    static int m6State = 0;
-    static int m6Counter0 = 0;
-    static int m6Counter1 = 0;
-    static int m6Counter2 = 0;
-    static int m6Counter3 = 0;
-    static bool m6Inited = false;
-
-    static auto m6Init = [&](const std::function<void(void)> & func) {
-        if (!m6Inited) {
-            m6Counter0 = 0;
-            m6Counter1 = 0;
-            m6Counter2 = 0;
-            m6Counter3 = 0;
-            m6Inited = true;
-            func();
-        }
-    };
-
-    static auto m6Timer = [&](const std::function<void(void)> & func, int timeout) {
-        m6Counter0++;
-        if (m6Counter0 >= timeout) {
-            m6Counter0 = 0;
-            func();
-        }
-    };
-
-    static auto m6GotoNextState = [&](int nextstate = -1) {
-        if (nextstate >= 0) {
-            m6State = nextstate;
-        } else {
-            m6State++;
-        }
-        m6Inited = false;
-    };
-
-    int xpos = angle2xpos(angle_);
-    switch (m6State)
-    {
-    case 0: // Show display numbers
-    {
-        m6Init([&](){
-            motor_set_brake(true);
-        });
-
-        drawer_.clearFrame();
-    
-        for (int i = 0; i <= m6Counter1; i++) {
-            MonoImage image(&image_dispnum_frames.images_[i]);
-            drawer_.drawImageBlendCentered((i * CV_DISTANCE)  + CV_WIDTH / 2, CV_HEIGHT / 2, &image);
-        }
-
-        m6Timer([&](){
-            m6Counter1++;
-            if (m6Counter1 >= CV_DISPLAYS) {
-                m6GotoNextState();
-            }
-        }, fps / 8);
-    } break;
-    case 1: // Start rotating while zero position
-    {
-        m6Init([&](){
-            motor_set_power(-motspeed);
-        });
-
-        if (xpos <= 10) {
-            m6GotoNextState();
-        }
-    } break;
-    case 2: // Interval
-    {
-        m6Init([&](){
-            m6Counter1 = CV_DISPLAYS - 1;
-        });
-
-        drawer_.clearFrame();
-
-        for (int i = 0; i <= m6Counter1; i++) {
-            MonoImage image(&image_dispnum_frames.images_[i]);
-            drawer_.drawImageBlendCentered((i * CV_DISTANCE) + CV_WIDTH / 2 - xpos, CV_HEIGHT / 2, &image);
-        }
-
-        m6Timer([&](){
-            m6GotoNextState();
-        }, fps * 5);
-    } break;
-    case 3: // Show center line
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame();
-        
-        drawer_.drawHLine(CV_WIDTH / 2 - xpos, CV_WIDTH / 2 + m6Counter1 - xpos, CV_HEIGHT / 2);
-        drawer_.drawHLine(CV_WIDTH / 2 - xpos, CV_WIDTH / 2 - m6Counter1 - xpos, CV_HEIGHT / 2);
-
-        m6Counter1 += ((int)(fps / 10.0));
-        if (m6Counter1 >= (CV_V_WIDTH / 2)) {
-            m6GotoNextState();
-        }
-    } break;
-    case 4: // Show white screen gradually
-    {
-        m6Init([&](){
-            m6Counter1 = 1;
-        });
-
-        drawer_.clearFrame();
-
-        for (int i = 0; i < m6Counter1; i++) {
-            drawer_.drawHLine(0 - xpos, CV_V_WIDTH - 1 - xpos, CV_HEIGHT / 2 + i);
-            drawer_.drawHLine(0 - xpos, CV_V_WIDTH - 1 - xpos, CV_HEIGHT / 2 - i);
-        }
-
-        m6Counter1 += ((int)(fps / 20.0));
-        if (m6Counter1 >= (CV_HEIGHT / 2)) {
-            m6GotoNextState();
-        }
-    } break;
-    case 5: // Interval
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame(DISP_COLOR_WHITE);
-
-        m6Timer([&](){
-            m6GotoNextState();
-        }, fps);
-    } break;
-    case 6: // Show CylinView logo
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame(DISP_COLOR_WHITE);
-
-        MonoImage image(&image_title_cylinview_frames.images_[0]);
-        drawer_.drawImageBlendCentered(CV_WIDTH / 2 - xpos, CV_HEIGHT / 2, &image);
-
-        m6Timer([&](){
-            m6GotoNextState();
-        }, fps * 5);
-    } break;
-    case 7: // Hide logo gradually, and stop if zero position
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame();
-
-        for (int i = 0; i < ((CV_HEIGHT / 2) - m6Counter1); i++) {
-            drawer_.drawHLine(0, CV_V_WIDTH - 1, CV_HEIGHT / 2 + i);
-            drawer_.drawHLine(0, CV_V_WIDTH - 1, CV_HEIGHT / 2 - i);
-        }
-
-        // not enough cpu power
-        //MonoImage image(&image_title_cylinview_frames.images_[0]);
-        //drawer_.drawImageBlendCentered(CV_WIDTH / 2 - xpos, CV_HEIGHT / 2, &image);
-
-        m6Counter1 += ((int)(fps / 20.0));
-        if (m6Counter1 >= (CV_HEIGHT / 2)) {
-            m6GotoNextState();
-        }
-    } break;
-    case 8: // Wait zero position and stop
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame();
-
-        if (xpos <= 10) {
-            motor_set_brake(true);
-            m6GotoNextState();
-        }
-    } break;
-    case 9: // Interval
-    {
-        m6Init([&](){
-            motor_set_brake(true);
-        });
-        m6Timer([&](){
-            m6GotoNextState();
-        }, fps * 1);
-    } break;
-    case 10: // Show snow
-    {
-        m6Init([&](){});
-        
-        drawer_.clearFrame();
-
-        snow.loop();
-        for (int i = 0; i < GRAINS; i++) {
-            Snow::Grain * g = &grains[i];
-            drawer_.drawDot(g->x_ - xpos, g->y_);
-        }
-    
-        m6Timer([&](){
-            m6GotoNextState();
-        }, fps * 2.5);
-    } break;
-    case 11: // Show snow, and show ground gradually
-    {
-        m6Init([&](){});
-        
-        drawer_.clearFrame();
-
-        snow.loop();
-        for (int i = 0; i < GRAINS; i++) {
-            Snow::Grain * g = &grains[i];
-            drawer_.drawDot(g->x_ - xpos, g->y_);
-        }
-        
-        drawer_.drawRectFill(
-            0             , CV_HEIGHT - m6Counter1,
-            CV_V_WIDTH - 1, CV_HEIGHT - 1
-        );
-    
-        m6Timer([&](){
-            m6Counter1++;
-            if (m6Counter1 >= 8) {
-                m6GotoNextState();
-            }
-        }, fps * 0.6);
-    } break;
-    case 12: // Character entry
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame();
-
-        snow.loop();
-        for (int i = 0; i < GRAINS; i++) {
-            Snow::Grain * g = &grains[i];
-            drawer_.drawDot(g->x_ - xpos, g->y_);
-        }
-        
-        drawer_.drawRectFill(
-            0             , CV_HEIGHT - 8,
-            CV_V_WIDTH - 1, CV_HEIGHT - 1
-        );
-
-        static const mono_images_t * animations[] = {
-            &image_entry_frames
-        };
-        const mono_images_t * frames = animations[m6Counter2];
-        MonoImage image(&frames->images_[m6Counter1]);
-        drawer_.drawImageBlendOffset(CV_WIDTH / 2, CV_HEIGHT / 2, &image);
-    
-        m6Counter3++;
-        if (m6Counter3 > 2) {
-          m6Counter3 = 0;
-          m6Counter1++;
-          if (m6Counter1 >= frames->count_) {
-              m6Counter1 = 0;
-              m6Counter2++;
-              if (m6Counter2 >= (sizeof(animations) / sizeof(mono_images_t*))) {
-                  m6GotoNextState();
-              }
-          }
-        }
-    } break;
-    case 13: // Interval
-    {
-        m6Init([&](){});
-
-        drawer_.clearFrame();
+    // Table driven, see intro_scene.cpp
+    if (!intro_.running()) {
+        introScene_.drawer_ = &drawer_;
+        introScene_.snow_ = &snow;
+        introScene_.finished_ = false;
+        intro_.start(intro_scene_steps, intro_scene_step_count, &introScene_, timeUs_);
+    }
 
-        snow.loop();
-        for (int i = 0; i < GRAINS; i++) {
-            Snow::Grain * g = &grains[i];
-            drawer_.drawDot(g->x_ - xpos, g->y_);
-        }
+    introScene_.xpos_ = angle2xpos(angle_);
+    intro_.update(timeUs_);
 
-        drawer_.drawRectFill(
-            0             , CV_HEIGHT - 8,
-            CV_V_WIDTH - 1, CV_HEIGHT - 1
-        );
-    
-        const mono_images_t * frames = &image_idle2_frames;
-        MonoImage image(&frames->images_[m6Counter1]);
-        drawer_.drawImageBlendOffset(CV_WIDTH / 2, CV_HEIGHT / 2, &image);
-    
-        m6Counter3++;
-        if (m6Counter3 > 2) {
-          m6Counter3 = 0;
-          m6Counter1++;
-          if (m6Counter1 >= frames->count_) {
-              m6Counter1 = 0;
-              m6Counter2++;
-              if (m6Counter2 >= 1) {
-                  m6GotoNextState();
-              }
-          }
-        }
-    } break;
-    case 14:
-    {
-        #if 0
-        m6GotoNextState();
-        #else
-        motor_set_power(-motspeed);
+    if (introScene_.finished_) {
+        intro_.stop();
         rendermode_ = 7;
-        #endif
-    } break;
-    default: 
-    {
-        m6State = 0; 
-    } break;
     }
 }
 
@@ -639,28 +502,111 @@ App::render_mode_7(void)
     drawer_.clearFrame();
 
     snow.loop();
-    for (int i = 0; i < GRAINS; i++) {
-        Snow::Grain * g = &grains[i];
-        drawer_.drawDot(g->x_ - xpos, g->y_);
-    }
+    snow.draw(&drawer_, xpos);
 
     drawer_.drawRectFill(
         0             , CV_HEIGHT - 8,
         CV_V_WIDTH - 1, CV_HEIGHT - 1
     );
 
+    character_.update(animClock_.delta());
     MonoImage image(character_.getImage());
-    drawer_.drawImageBlendOffset(CV_WIDTH / 2 - xpos + character_.getXpos(), CV_HEIGHT / 2, &image);
+    drawer_.drawSpriteOffset(CV_WIDTH / 2 - xpos + character_.getXpos(), CV_HEIGHT / 2, &image);
 }
-#endif
 
-void App::render_mode_1(void) {};
-void App::render_mode_2(void) {};
-void App::render_mode_3(void) {};
-void App::render_mode_4(void) {};
-void App::render_mode_5(void) {};
-void App::render_mode_6(void) {};
-void App::render_mode_7(void) {};
+void
+App::render_mode_8(void)
+{
+    // Life on the whole cylinder, reseeded when it settles.
+    static LifeGrid life;
+    static bool inited = false;
+    static int lastPopulation = 0;
+    static int stableCount = 0;
+    if (!inited) {
+        inited = true;
+        life.init(LIFE_PACK_COLUMNS);
+        life.randomize(rnd_.rand());
+    }
+
+    int xpos = angle2xpos(angle_);
+
+    life.step();
+    life.render(&screen_, xpos);
+
+    int population = life.population();
+    stableCount = (population == lastPopulation)? (stableCount + 1) : 0;
+    lastPopulation = population;
+    if (stableCount > 30 || life.generation() > 3000) {
+        stableCount = 0;
+        life.randomize(rnd_.rand());
+    }
+}
+
+void
+App::render_mode_9(void)
+{
+    // Grayscale, a sky getting brighter to the bottom and a sun of rings
+    // going round, the snow in white. Each plane has the bit of the levels.
+    // (monochrome : the lower half)
+    const int levels = 1 << grayPlanes_;
+    const int radius = 24;
+
+    int xpos = angle2xpos(angle_);
+    int sunx = (int)((timeUs_ / 50000) % CV_V_WIDTH) - xpos;
+    int suny = CV_HEIGHT / 3;
+
+    snow.loop();
+    for (int plane = 0; plane < grayPlanes_; plane++) {
+        setupPlane(plane);
+        drawer_.clearFrame();
+
+        for (int y = 0; y < CV_HEIGHT; y++) {
+            int level = (y * levels) / CV_HEIGHT;
+            if (level & (1 << plane)) drawer_.drawHLine(0, CV_V_WIDTH - 1, y);
+        }
+
+        // The inner rings over the outer ones, the center at the top level.
+        for (int level = 1; level < levels; level++) {
+            int r = radius - ((level - 1) * radius) / levels;
+            color_t c = (level & (1 << plane))? DISP_COLOR_WHITE : DISP_COLOR_BLACK;
+            drawer_.drawCircleFill(sunx, suny, r, c);
+        }
+
+        snow.draw(&drawer_, xpos);
+    }
+    grayRendered_ = true;
+}
+
+void
+App::render_mode_10(void)
+{
+    // Ticker, the text scrolls round the cylinder and repeats, a gap after
+    // it. The text is rendered on 8 column steps of the scroll, the glyphs
+    // keep their bit phase and are hits of the glyph cache, the rest of the
+    // scroll is the x of the band.
+    static const Font font(&font_ticker);
+    const int y = (CV_HEIGHT - font.height()) / 2;
+    const mono_surface_t span = { CV_V_WIDTH, font.height(), tickerSpan_ };
+
+    int period = tickerPeriod(font.textWidth(tickerText_, TEXT_LAYOUT_PROPORTIONAL));
+    const int64_t scale = 1000000;
+    tickerScroll_ = (tickerScroll_ + ((int64_t)animClock_.delta() * tickerSpeed_)) % (period * scale);
+    if (tickerScroll_ < 0) tickerScroll_ += (period * scale);
+    int scroll = (int)(tickerScroll_ / scale);
+
+    memset(tickerSpan_, 0, sizeof(tickerSpan_));
+    for (int x = -(scroll & ~7); x < CV_V_WIDTH; x += period) {
+        text_render_span(&span, x, 0, &font, tickerText_, TEXT_LAYOUT_PROPORTIONAL, &tickerCache_);
+    }
+
+    int xpos = angle2xpos(angle_);
+
+    drawer_.clearFrame();
+    drawer_.drawHLine(0, CV_V_WIDTH - 1, y - 4);
+    drawer_.drawHLine(0, CV_V_WIDTH - 1, y + font.height() + 3);
+    mono_plane_t plane = { span.width_, span.height_, span.buffer_ };
+    drawer_.drawPlane(-xpos - (scroll & 7), y, &plane);
+}
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions - Utils
@@ -674,7 +620,7 @@ App::getRand(void)
 }
 
 int
-App::angle2xpos(float angle)
+App::angle2xpos(uint32_t angle)
 {
-    return (angle / (2 * M_PI)) * CV_V_WIDTH;
+    return (int)((angle * CV_V_WIDTH) >> ENCODER_COUNT_BITS);
 }
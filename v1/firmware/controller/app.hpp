@@ -13,18 +13,27 @@
 #include <cstdint>
 
 #include "interval_timer.hpp"
+#include "encoder.hpp"
+#include "fixed_math.hpp"
 #include "pseudo_rand.hpp"
+#include "animation.hpp"
 
 #include "screen_config.hpp"
 #include "mono_screen.hpp"
 #include "cyclic_mono_screen.hpp"
 #include "cyclic_mono_drawer.hpp"
+#include "sprite_format.hpp"
+#include "sprite_registry.hpp"
+#include "font.hpp"
+#include "scroll_layer.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
+#define APP_TICKER_TEXT_MAX     (128)   // Characters of the ticker text
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Class definitions
  *----------------------------------------------------------------------
@@ -40,14 +49,24 @@ public:
     void init(void);
     void loop(
         uint32_t timeUs,
-        float angle
+        uint16_t angle
     );
-    void render(uint8_t * buffer);
+    void render(uint8_t * buffer, sprite_list_t * sprites = nullptr);
+    void renderStream(uint8_t * buffer, sprite_list_t * sprites, const mono_plane_t * plane);
     void setAutoModeChange(bool enable, int intervalMs);
     void setMode(int mode);
-    void setAngle(float angle);
+    void setAngle(uint16_t angle);
+    void setSeed(uint32_t seed);
+    void setGrayPlanes(int planes);
+    int grayPlanes(void) const { return grayPlanes_; }
+    void setTickerText(const char * text);
+    void setTickerSpeed(int pixelsPerSec);
+    bool scrollLayer(scroll_layer_t * layer);
 
 public:
+    void setupRender(uint8_t * buffer, sprite_list_t * sprites);
+    void setupPlane(int plane);
+    void fillPlanes(void);
     void render(void);
     void render_mode_0(void);
     void render_mode_1(void);
@@ -57,14 +76,19 @@ public:
     void render_mode_5(void);
     void render_mode_6(void);
     void render_mode_7(void);
+    void render_mode_8(void);
+    void render_mode_9(void);
+    void render_mode_10(void);
 
 public:
     static uint32_t getRand(void);
-    static int angle2xpos(float angle_);
+    static int angle2xpos(uint32_t angle);
+    static int tickerPeriod(int width);
 
 public:
     CyclicMonoScreen screen_;
     CyclicMonoDrawer drawer_;
+    SpriteRegistry sprites_;
     
     int rendermode_;    
     int maxRenderMode_ = 5;
@@ -72,5 +96,19 @@ public:
     bool autoRenderModeChange_ = true;
     IntervalTimer autoRenderModeChangeTimer_;
 
-    float angle_;
+    uint16_t angle_;    // Encoder count, ENCODER_COUNTS per revolution
+    uint32_t timeUs_ = 0;
+    AnimClock animClock_;   // Ticked per rendered frame, by timeUs_
+
+    // Grayscale, the frame is the bit planes in a row. (LSB first)
+    int grayPlanes_ = 1;
+    bool grayRendered_ = false; // The mode drew the planes, or the plane 0 is copied
+    uint8_t * renderBuffer_ = nullptr;
+
+    // Ticker, scrolls on the cylinder by its own clock. (render mode 10)
+    char tickerText_[APP_TICKER_TEXT_MAX + 1] = "CylinView - persistence of vision cylinder display";
+    int tickerSpeed_ = 60;      // Pixels per second to -x, negative : to +x
+    int64_t tickerScroll_ = 0;  // Pixels x 1000000
+    uint32_t tickerGeneration_ = 1;         // Changed with the text
+    uint32_t tickerLayerGeneration_ = 0;    // Of the text on the layer
 };
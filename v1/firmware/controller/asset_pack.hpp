@@ -0,0 +1,113 @@
+/**********************************************************************/
+/**
+ * @brief  Asset Pack (Panel Native, Deduplicated Sprites)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstring>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Asset pack is made by the host asset compiler (v1/tools/assetc).
+//
+// Frame data is panel native (see mono_plane_t). A frame is split into
+// strips of 8 columns, each strip is (height_) bytes, one byte per row,
+// and identical strips are shared in the pack. Column c of a frame holds
+// the image pixel at x = (width_ - 1 - c), because the screen x axis is
+// mirrored against the cylinder x axis.
+//
+// Alpha is a run list per row, in the column coordinate :
+//   [runs] ([start] [length - 1]) * runs
+// Frames without transparent pixels in the trimmed box have no alpha.
+
+#define ASSET_PACK_NO_ALPHA     (0xFFFFFFFFUL)
+
+typedef struct asset_frame_ {
+    uint16_t width_;            // Trimmed bounding box
+    uint16_t height_;
+    uint16_t full_width_;       // Size before trimming
+    uint16_t full_height_;
+    int16_t  trim_x_;           // Trimmed box position in the full image
+    int16_t  trim_y_;
+    int16_t  draw_offset_x_;    // Includes trim_x_ / trim_y_
+    int16_t  draw_offset_y_;
+    uint32_t strips_;           // Offset of strip_index_, ((width_ + 7) / 8) entries
+    uint32_t alpha_;            // Offset of alpha_data_, or ASSET_PACK_NO_ALPHA
+} asset_frame_t;
+
+typedef struct asset_anim_ {
+    const char * name_;
+    uint16_t count_;
+    uint32_t frames_;           // Offset of frame_list_
+} asset_anim_t;
+
+typedef struct asset_pack_ {
+    int anim_count_;
+    const asset_anim_t  * anims_;
+    const uint16_t      * frame_list_;
+    const asset_frame_t * frames_;
+    const uint16_t      * strip_index_;
+    const uint32_t      * strip_offsets_;
+    const uint8_t       * strip_data_;
+    const uint8_t       * alpha_data_;
+} asset_pack_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class AssetImage
+{
+public:
+    explicit AssetImage(const asset_pack_t * pack, int anim, int frameno) {
+        const asset_anim_t * a = &pack->anims_[anim];
+        pack_  = pack;
+        frame_ = &pack->frames_[pack->frame_list_[a->frames_ + frameno]];
+    }
+    virtual ~AssetImage() {}
+
+public:
+    static int find(const asset_pack_t * pack, const char * name) {
+        for (int i = 0; i < pack->anim_count_; i++) {
+            if (strcmp(pack->anims_[i].name_, name) == 0) return i;
+        }
+        return -1;
+    }
+    static int count(const asset_pack_t * pack, int anim) { return pack->anims_[anim].count_; }
+
+public:
+    int width(void) { return frame_->width_; }
+    int height(void) { return frame_->height_; }
+    int fullWidth(void) { return frame_->full_width_; }
+    int fullHeight(void) { return frame_->full_height_; }
+    int trimX(void) { return frame_->trim_x_; }
+    int trimY(void) { return frame_->trim_y_; }
+    int drawOffsetX(void) { return frame_->draw_offset_x_; }
+    int drawOffsetY(void) { return frame_->draw_offset_y_; }
+    bool hasAlpha(void) { return frame_->alpha_ != ASSET_PACK_NO_ALPHA; }
+
+public:
+    const uint8_t * strip(int index) {
+        return pack_->strip_data_ + pack_->strip_offsets_[pack_->strip_index_[frame_->strips_ + index]];
+    }
+    const uint8_t * alphaRuns(void) { return pack_->alpha_data_ + frame_->alpha_; }
+    uint8_t getDot(int x, int y) {
+        int c = width() - 1 - x;
+        return (strip(c >> 3)[y] >> (c & 7)) & 0x01;
+    }
+
+public:
+    const asset_pack_t  * pack_;
+    const asset_frame_t * frame_;
+};
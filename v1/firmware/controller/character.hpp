@@ -16,6 +16,7 @@
 
 #include "screen_config.hpp"
 #include "image_data.hpp"
+#include "animation.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -37,6 +38,9 @@
  *----------------------------------------------------------------------
  */
 
+#define CHARACTER_FRAME_US      ANIM_FRAMES_US(3, 70)
+#define CHARACTER_AUTO_MAX_US   (4000000UL)     // Next random state within this
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Class definitions
  *----------------------------------------------------------------------
@@ -53,15 +57,12 @@ public:
     int state_;
     int nextState_;
     
-    const mono_images_t * curFrames_;
-    int curFrameIndex_;
+    AnimPlayer player_;
     int move_;
     int xpos_;
-    
-    int skip_;
 
     bool auto_;
-    int autoTime_;
+    int32_t autoUs_;
 
 public:
 
@@ -69,12 +70,11 @@ public:
     {
         state_ = 0;
         nextState_ = 0;
-        curFrameIndex_ = 0;
         move_ = 0;
         xpos_ = 0;
-        skip_ = 0;
         auto_ = false;
-        autoTime_ = 0;
+        autoUs_ = 0;
+        player_.setHook(onFrame, this);
 
         setNextState(-1, true);
     }
@@ -87,7 +87,7 @@ public:
     void setAuto(bool enable = true)
     {
         auto_ = enable;
-        autoTime_ = rnd_() % (70 * 4);
+        autoUs_ = (int32_t)(rnd_() % CHARACTER_AUTO_MAX_US);
     }
 
 public:
@@ -95,7 +95,6 @@ public:
     {
         if (nextState_ != -1 && immediate) {
             setCurState(nextState_);
-            curFrameIndex_ = 0;
             nextState_ = -1;
         } else if (state != -1) {
             nextState_ = state;
@@ -107,13 +106,20 @@ public:
     {
         state_ = state;
 
+        static const anim_t anims[] = {
+            { &image_idle2_frames, CHARACTER_FRAME_US, nullptr, ANIM_MODE_LOOP },
+            { &image_run1_frames,  CHARACTER_FRAME_US, nullptr, ANIM_MODE_LOOP },
+            { &image_jump1_frames, CHARACTER_FRAME_US, nullptr, ANIM_MODE_LOOP },
+        };
+
         switch (state_)
         {
-        case 0:  curFrames_ = &image_idle2_frames; move_ = 0; break;
-        case 1:  curFrames_ = &image_run1_frames;  move_ = 2; break;
-        case 2:  curFrames_ = &image_jump1_frames; move_ = 2; break;
-        default: curFrames_ = &image_idle2_frames; state_ = 0; break;
+        case 0:  move_ = 0; break;
+        case 1:  move_ = 2; break;
+        case 2:  move_ = 2; break;
+        default: move_ = 0; state_ = 0; break;
         }
+        player_.play(&anims[state_]);
     }
 
 public:
@@ -122,32 +128,33 @@ public:
         return xpos_;
     }
 
-    const mono_image_t * getImage(void)
+    // Advance by the animation clock delta, once per rendered frame.
+    void update(uint32_t deltaUs)
     {
-        const mono_image_t * image = &curFrames_->images_[curFrameIndex_];
-
         if (auto_) {
-            autoTime_--;
-            if (autoTime_ <= 0) {
+            autoUs_ -= (int32_t)deltaUs;
+            if (autoUs_ <= 0) {
                 setNextState((int)(rnd_() % 3));
                 setAuto();
             }
         }
 
-        // @todo frame countup calculation from fps.
-        skip_++;
-        if (skip_ > 2) {
-            skip_ = 0;
+        player_.advance(deltaUs);
+    }
 
-            xpos_ += move_;
+    const mono_image_t * getImage(void)
+    {
+        return player_.image();
+    }
 
-            curFrameIndex_++;
-            if (curFrameIndex_ >= curFrames_->count_) {
-                curFrameIndex_ = 0;
-                setNextState(-1, true);
-            }
+private:
+    // Moves per animation frame, and changes the state at the end of a cycle.
+    static void onFrame(void * context, anim_event_t event)
+    {
+        Character * self = (Character *)context;
+        self->xpos_ += self->move_;
+        if (event == ANIM_EVENT_LOOP) {
+            self->setNextState(-1, true);
         }
-
-        return image;
     }
 };
@@ -45,7 +45,7 @@ CircularBuffer::setBuffer(uint8_t * buffer, size_t size, int num)
         printf("WARN: Invalid supported buffer num.\n");
         num = CIRCULAR_BUFFER_MAX_NUM;
     }
-    if ((size_ % num_) != 0) {
+    if ((size % num) != 0) {
         printf("WARN: The num is not an integer multiple of the buffer size\n");
     }
 
@@ -91,6 +91,18 @@ CircularBuffer::getReadBufferPtr(void)
     return rdBufPtr_;
 }
 
+int
+CircularBuffer::getWriteIndex(void)
+{
+    return wr_;
+}
+
+int
+CircularBuffer::getReadIndex(void)
+{
+    return rd_;
+}
+
 void
 CircularBuffer::nextWriteBuffer(void)
 {
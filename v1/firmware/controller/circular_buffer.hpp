@@ -38,6 +38,8 @@ public:
     bool        getReadReady(void);
     uint8_t *   getWriteBufferPtr(void);
     uint8_t *   getReadBufferPtr(void);
+    int         getWriteIndex(void);
+    int         getReadIndex(void);
     void        nextWriteBuffer(void);
     void        nextReadBuffer(void);
 
@@ -0,0 +1,262 @@
+/**********************************************************************/
+/**
+ * @brief  Command Parser (Text Line and Binary Frame)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "cmd_parser.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Returned for missing params, callers may write to it.
+static char cmdparser_empty_[1] = { '\0' };
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+CmdParser::CmdParser()
+{
+    reset();
+}
+
+CmdParser::~CmdParser()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+CmdParser::reset(void)
+{
+    state_ = STATE_TEXT;
+    lineLen_ = 0;
+    argc_ = 0;
+    inToken_ = false;
+    ready_ = false;
+    binSize_ = 0;
+    line_[0] = '\0';
+}
+
+cmdparser_result_t
+CmdParser::push(uint8_t c)
+{
+    if (ready_) {
+        // The previous command is consumed.
+        ready_ = false;
+        lineLen_ = 0;
+        argc_ = 0;
+        inToken_ = false;
+        binSize_ = 0;
+    }
+
+    switch (state_) {
+    case STATE_TEXT:
+        return pushText(c);
+    case STATE_SKIP_LINE:
+        if (c == '\n') state_ = STATE_TEXT;
+        return CMDPARSER_NONE;
+    default:
+        return pushBinary(c);
+    }
+}
+
+char *
+CmdParser::arg(int index)
+{
+    if (index < 0 || index >= argc_) return cmdparser_empty_;
+    return argv_[index];
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Text
+ *----------------------------------------------------------------------
+ */
+
+cmdparser_result_t
+CmdParser::pushText(uint8_t c)
+{
+    if (c == CMDPARSER_SYNC1 && lineLen_ == 0) {
+        // Binary frame at the line start.
+        state_ = STATE_SYNC2;
+        crc_ = crc16(c, 0xFFFF);
+        return CMDPARSER_NONE;
+    }
+
+    if (c == '\n') {
+        line_[lineLen_] = '\0';
+        if (argc_ == 0) {
+            // Empty line
+            lineLen_ = 0;
+            inToken_ = false;
+            return CMDPARSER_NONE;
+        }
+        ready_ = true;
+        return CMDPARSER_TEXT;
+    }
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\0') {
+        // Terminate the token in place, and collapse the spaces.
+        if (inToken_) {
+            line_[lineLen_++] = '\0';
+            inToken_ = false;
+        }
+        return CMDPARSER_NONE;
+    }
+
+    // Text is printable ASCII, e.g. a broken frame is not run as a command.
+    if (c < 0x20 || c >= 0x7F) {
+        return skip();
+    }
+
+    // Keep a room for the terminator.
+    if (lineLen_ >= CMDPARSER_MAX_LINE_LEN - 1) {
+        return skip();
+    }
+    if (!inToken_) {
+        inToken_ = true;
+        if (argc_ < CMDPARSER_MAX_ARGS) {
+            argv_[argc_++] = &line_[lineLen_];
+        }
+    }
+    line_[lineLen_++] = (char)c;
+    return CMDPARSER_NONE;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Binary
+ *----------------------------------------------------------------------
+ */
+
+cmdparser_result_t
+CmdParser::pushBinary(uint8_t c)
+{
+    switch (state_) {
+    case STATE_SYNC2:
+        if (c != CMDPARSER_SYNC2) return skip();
+        state_ = STATE_CMD;
+        break;
+    case STATE_CMD:
+        binCmd_ = c;
+        state_ = STATE_LEN_L;
+        break;
+    case STATE_LEN_L:
+        binLen_ = c;
+        state_ = STATE_LEN_H;
+        break;
+    case STATE_LEN_H:
+        binLen_ |= (uint16_t)c << 8;
+        state_ = STATE_NLEN_L;
+        break;
+    case STATE_NLEN_L:
+        if (c != (uint8_t)~binLen_) return skip();
+        state_ = STATE_NLEN_H;
+        break;
+    case STATE_NLEN_H:
+        if (c != (uint8_t)~(binLen_ >> 8)) return skip();
+        if (binLen_ > CMDPARSER_MAX_PAYLOAD) return skip();
+        binSize_ = 0;
+        state_ = (binLen_ > 0)? STATE_PAYLOAD : STATE_CRC_L;
+        break;
+    case STATE_PAYLOAD:
+        payload_[binSize_++] = c;
+        if (binSize_ >= binLen_) state_ = STATE_CRC_L;
+        break;
+    case STATE_CRC_L:
+        rxCrc_ = c;
+        state_ = STATE_CRC_H;
+        return CMDPARSER_NONE;
+    case STATE_CRC_H:
+        rxCrc_ |= (uint16_t)c << 8;
+        if (rxCrc_ != crc_) return drop();
+        state_ = STATE_TEXT;
+        ready_ = true;
+        return CMDPARSER_BINARY;
+    default:
+        return skip();
+    }
+    crc_ = crc16(c, crc_);
+    return CMDPARSER_NONE;
+}
+
+// Drop, and skip until the next '\n'. The frame length is unknown, and the
+// rest must not run as a text command.
+cmdparser_result_t
+CmdParser::skip(void)
+{
+    drop();
+    state_ = STATE_SKIP_LINE;
+    return CMDPARSER_ERROR;
+}
+
+// Drop, the next byte is a line start.
+cmdparser_result_t
+CmdParser::drop(void)
+{
+    errors_++;
+    state_ = STATE_TEXT;
+    lineLen_ = 0;
+    argc_ = 0;
+    inToken_ = false;
+    binSize_ = 0;
+    return CMDPARSER_ERROR;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Utils
+ *----------------------------------------------------------------------
+ */
+
+// CRC16-CCITT (0x1021) of a byte, without the table.
+uint16_t
+CmdParser::crc16(uint8_t c, uint16_t crc)
+{
+    uint8_t x = (uint8_t)((crc >> 8) ^ c);
+    x ^= x >> 4;
+    return (uint16_t)((crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x);
+}
+
+uint16_t
+CmdParser::crc16(const uint8_t * data, size_t size, uint16_t crc)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc = crc16(data[i], crc);
+    }
+    return crc;
+}
+
+size_t
+CmdParser::makeFrame(uint8_t * buffer, size_t bufferSize, uint8_t cmd, const uint8_t * data, size_t size)
+{
+    size_t total = CMDPARSER_HEADER_SIZE + size + CMDPARSER_CRC_SIZE;
+    if (size > CMDPARSER_MAX_PAYLOAD || bufferSize < total) return 0;
+
+    uint8_t lenL = (uint8_t)(size >> 0);
+    uint8_t lenH = (uint8_t)(size >> 8);
+    buffer[0] = CMDPARSER_SYNC1;
+    buffer[1] = CMDPARSER_SYNC2;
+    buffer[2] = cmd;
+    buffer[3] = lenL;
+    buffer[4] = lenH;
+    buffer[5] = (uint8_t)~lenL;
+    buffer[6] = (uint8_t)~lenH;
+    if (size > 0) memcpy(buffer + CMDPARSER_HEADER_SIZE, data, size);
+
+    uint16_t crc = crc16(buffer, CMDPARSER_HEADER_SIZE + size);
+    buffer[CMDPARSER_HEADER_SIZE + size + 0] = (uint8_t)(crc >> 0);
+    buffer[CMDPARSER_HEADER_SIZE + size + 1] = (uint8_t)(crc >> 8);
+    return total;
+}
@@ -0,0 +1,123 @@
+/**********************************************************************/
+/**
+ * @brief  Command Parser (Text Line and Binary Frame)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Bytes are pushed one by one, nothing is rescanned or copied.
+//
+// Text : "CMD PARAM0 PARAM1 ...\n", split on ' ', '\t' and '\r' while the
+//        bytes arrive. The tokens are terminated in place in the line buffer.
+//        Tokens over CMDPARSER_MAX_ARGS are dropped. A line over
+//        CMDPARSER_MAX_LINE_LEN, or with a byte not printable ASCII, is an
+//        error and skipped until '\n'.
+//
+// Binary : same framing to the SPI bridge command, starts at a line start.
+//        SYNC1 SYNC2 CMD LEN_L LEN_H ~LEN_L ~LEN_H PAYLOAD[LEN] CRC_L CRC_H
+//        CRC16-CCITT (0x1021, init 0xFFFF) from SYNC1 to the end of PAYLOAD.
+//        A broken header skips until '\n' (send "\n" to resync), a CRC error
+//        drops only the frame.
+
+#define CMDPARSER_MAX_LINE_LEN      (256)
+#define CMDPARSER_MAX_ARGS          (1 + 16)    // Command + params
+#define CMDPARSER_MAX_PAYLOAD       (256)
+
+#define CMDPARSER_SYNC1             (0xAA)
+#define CMDPARSER_SYNC2             (0x55)
+#define CMDPARSER_HEADER_SIZE       (7)
+#define CMDPARSER_CRC_SIZE          (2)
+
+typedef enum cmdparser_result_ {
+    CMDPARSER_NONE = 0,     // Need more bytes
+    CMDPARSER_TEXT,         // A text command is ready
+    CMDPARSER_BINARY,       // A binary command is ready
+    CMDPARSER_ERROR,        // A line or a frame is dropped
+} cmdparser_result_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class CmdParser
+{
+public:
+    explicit CmdParser();
+    virtual ~CmdParser();
+
+public:
+    void reset(void);
+    cmdparser_result_t push(uint8_t c);
+
+public:
+    // Text command, valid until the next push().
+    int argc(void) const { return argc_; }
+    char * arg(int index);
+
+    // Binary command, valid until the next push().
+    uint8_t binaryCmd(void) const { return binCmd_; }
+    const uint8_t * payload(void) const { return payload_; }
+    int payloadSize(void) const { return binSize_; }
+
+    uint32_t errors(void) const { return errors_; }
+
+public:
+    static uint16_t crc16(uint8_t c, uint16_t crc);
+    static uint16_t crc16(const uint8_t * data, size_t size, uint16_t crc = 0xFFFF);
+    // Make a binary frame to buffer, returns the size (0 : too small).
+    static size_t makeFrame(uint8_t * buffer, size_t bufferSize, uint8_t cmd, const uint8_t * data, size_t size);
+
+private:
+    cmdparser_result_t pushText(uint8_t c);
+    cmdparser_result_t pushBinary(uint8_t c);
+    cmdparser_result_t skip(void);
+    cmdparser_result_t drop(void);
+
+private:
+    typedef enum state_ {
+        STATE_TEXT = 0,
+        STATE_SKIP_LINE,
+        STATE_SYNC2,
+        STATE_CMD,
+        STATE_LEN_L,
+        STATE_LEN_H,
+        STATE_NLEN_L,
+        STATE_NLEN_H,
+        STATE_PAYLOAD,
+        STATE_CRC_L,
+        STATE_CRC_H,
+    } state_t;
+
+    state_t state_ = STATE_TEXT;
+    uint32_t errors_ = 0;
+
+    // Text
+    char line_[CMDPARSER_MAX_LINE_LEN + 1];
+    char * argv_[CMDPARSER_MAX_ARGS];
+    int lineLen_ = 0;
+    int argc_ = 0;
+    bool inToken_ = false;
+    bool ready_ = false;    // The previous push() returned a command
+
+    // Binary
+    uint8_t payload_[CMDPARSER_MAX_PAYLOAD];
+    uint8_t binCmd_ = 0;
+    uint16_t binLen_ = 0;
+    int binSize_ = 0;
+    uint16_t crc_ = 0xFFFF;
+    uint16_t rxCrc_ = 0;
+};
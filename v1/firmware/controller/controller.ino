@@ -24,6 +24,12 @@
 #include "mono_screen.hpp"
 #include "cyclic_mono_screen.hpp"
 #include "cyclic_mono_drawer.hpp"
+#include "sprite_format.hpp"
+#include "frame_stream.hpp"
+#include "scroll_layer.hpp"
+#include "trace_recorder.hpp"
+#include "span_trace.hpp"
+#include "particles.hpp"
 #include "app.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -70,6 +76,7 @@
 
 #define ENABLE_SETUP_SERIAL_HOST_WAIT   (0)
 #define SETUP_SERIAL_HOST_WAIT_MS       (3000) // startup wait after serial begin for host pc connection
+#define ENABLE_TRACE_AT_BOOT            (0)    // record the trace from the boot, seed 0 (see trace_recorder.hpp)
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -78,6 +85,7 @@
 
 #define CIRCULAR_BUFFER_NUM             (2)
 #define ENCODER_USE_SPI                 (1)
+#define STREAM_IDLE_TIMEOUT_MS          (3000)  // leave the streaming mode without data
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -100,19 +108,52 @@ static const int pin_spi0_rx_        = 16;
 static const int pin_spi0_cs_        = 17;
 static const int pin_spi0_sck_       = 18;
 static const int pin_spi0_tx_        = 19;
+static const int pin_spi0_cs2_       = 20; // 3rd bridge, shares SPI0
+static const int pin_spi1_cs2_       = 21; // 4th bridge, shares SPI1
 
 static const int pin_enc_pwm_        = 28;
 
 static const int pin_buildin_led_   = PIN_LED; // 25
 
+static const sib_bus_t spi_buses_[SIB_BUSES] = {
+  { pin_spi0_rx_, pin_spi0_sck_, pin_spi0_tx_ },
+  { pin_spi1_rx_, pin_spi1_sck_, pin_spi1_tx_ },
+};
+
+// Bridge boards in the panel order, CV_BRIDGES of them are used.
+static const sib_endpoint_t spi_endpoints_[SIB_ENDPOINTS_MAX] = {
+  { 0, pin_spi0_cs_ },
+  { 1, pin_spi1_cs_ },
+  { 0, pin_spi0_cs2_ },
+  { 1, pin_spi1_cs2_ },
+};
+static_assert(CV_BRIDGES <= SIB_ENDPOINTS_MAX, "Bridge boards");
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
 static float getAngle(void);
+static uint16_t getAngleCount(void);
 static uint16_t getRawAngle(void);
 static void commandParser(SerialCmd & cmd);
+static void binaryCommandParser(SerialCmd & cmd);
+static void streamStart(void);
+static void streamStop(void);
+static void streamReceive(void);
+static void streamRender(void);
+static void sendStreamStats(void);
+static void setGray(int planes, int steps);
+static void traceStart(SerialCmd & cmd, bool once);
+static void traceCommand(SerialCmd & cmd);
+static void traceDump(void);
+static void spansStart(bool on);
+static void spansDump(void);
+static void core1Pause(void);
+static void core1Resume(void);
+static uint8_t * spareBuffer(size_t * size);
+static void particleBench(int count, int frames);
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -125,21 +166,40 @@ static bool core1SetupDone_ = false;
 static SerialCmd cmd_(&Serial);
 static IntervalTimer debugTimer_;
 
-static uint8_t rawbuffer_[CV_FRAME_BYTES * CIRCULAR_BUFFER_NUM];
+static uint8_t rawbuffer_[CV_FRAME_BYTES * CV_GRAY_PLANES_MAX * CIRCULAR_BUFFER_NUM];
 static CircularBuffer buffer_;
+static sprite_list_t spriteLists_[CIRCULAR_BUFFER_NUM];
 static SpiI2cBridge spi2i2cbridge_;
+static SpanTrace spans_;                // Render on core0, the SPI on core1, and the bridges (SPANS)
+
+// The frame of the slot as a scroll layer, sent by the start line while it
+// moves a little a frame. (App::scrollLayer, SpiI2cBridge::scrollFits)
+static scroll_layer_t scrollLayers_[CIRCULAR_BUFFER_NUM];
+static bool scrollLayerValid_[CIRCULAR_BUFFER_NUM];
+static bool scrollLayerEnabled_ = true;
 
 static App app_;
-static float angle_ = 0;
+static uint16_t angleCount_ = 0;
 static uint16_t angleOffset_ = 12900;
 
 static IntervalTimer encMonTimer_;
 static bool encoderMonitor_ = false;
 
 static int fps_ = 0;
+static int fpsLast_ = 0;
 static bool fpsMonitor_ = false;
 
-static bool enableSpiRender_ = true;
+static volatile bool enableSpiRender_ = true;
+
+// core1 paused between the frames by core0 (core1Pause()), a request and
+// its echo : the echo is only written by core1 after it saw the request.
+static volatile bool core1Pause_ = false;
+static volatile uint32_t core1PauseSeq_ = 0;
+static volatile uint32_t core1PauseAck_ = 0;
+
+static FrameStream stream_;     // Its plane and body in the spare planes (streamStart())
+static bool streaming_ = false;
+static uint32_t streamRxMs_ = 0;
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions - Core 0
@@ -168,19 +228,10 @@ void setup()
   encMonTimer_.setIntervalMs(100);
   
   // Init Buffers
-  buffer_.setBuffer(rawbuffer_, sizeof(rawbuffer_), CIRCULAR_BUFFER_NUM);
+  buffer_.setBuffer(rawbuffer_, CV_FRAME_BYTES * CIRCULAR_BUFFER_NUM, CIRCULAR_BUFFER_NUM);
 
   // Init SPI for SPI2I2C Bridge
-  spi2i2cbridge_.init(
-    pin_spi0_rx_,
-    pin_spi0_cs_,
-    pin_spi0_sck_,
-    pin_spi0_tx_,
-    pin_spi1_rx_,
-    pin_spi1_cs_,
-    pin_spi1_sck_,
-    pin_spi1_tx_
-  );
+  spi2i2cbridge_.init(spi_buses_, spi_endpoints_, CV_BRIDGES);
 
   // Init Encoder
   encoder_set_angle_offset(angleOffset_);
@@ -200,14 +251,32 @@ void setup()
 
   // Init App
   app_.init();
+  spi2i2cbridge_.setSpriteRegistry(&app_.sprites_);
+  spi2i2cbridge_.setSpanTrace(&spans_);
 
   // wait i2c-spi-bridge
-  while (!spi2i2cbridge_.sendPing(0)) {;}
-  while (!spi2i2cbridge_.sendPing(1)) {;}
+  for (int id = 0; id < spi2i2cbridge_.endpoints(); id++) {
+    while (!spi2i2cbridge_.sendPing(id)) {;}
+  }
+
+  // setup i2c-spi-bridge, the boards are mounted in turn.
+  for (int id = 0; id < spi2i2cbridge_.endpoints(); id++) {
+    spi2i2cbridge_.sendSetIDDirection(id, (id & 1) == 0);
+  }
+
+  // SPI clock per link, the highest one without errors.
+  for (int id = 0; id < spi2i2cbridge_.endpoints(); id++) {
+    uint32_t hz = spi2i2cbridge_.trainLink(id);
+    Serial.printf("SPI link %d : %u Hz\n", id, (unsigned)hz);
+  }
+
+  // Frames are presented on all the bridges at once.
+  spi2i2cbridge_.setPresent(true);
 
-  // setup i2c-spi-bridge
-  spi2i2cbridge_.sendSetIDDirection(0, true);
-  spi2i2cbridge_.sendSetIDDirection(1, false);
+  #if ENABLE_TRACE_AT_BOOT
+  app_.setSeed(0);
+  trace_start(micros(), 0, app_.rendermode_, app_.grayPlanes(), true, true);
+  #endif
 
   //
   // Setup done
@@ -220,26 +289,50 @@ void setup()
 void loop()
 {
   //
-  // Serial Commands
+  // Serial Commands, or the frame stream
   //
 
-  if (cmd_.loop() != 0) {
-    commandParser(cmd_);
+  if (streaming_) {
+    streamReceive();
+  } else {
+    switch (cmd_.loop()) {
+    case SERIALCMD_TEXT:
+      traceCommand(cmd_);
+      commandParser(cmd_);
+      break;
+    case SERIALCMD_BINARY:
+      trace_binary(cmd_.getBinaryCmd(), cmd_.getPayload(), cmd_.getPayloadSize());
+      binaryCommandParser(cmd_);
+      break;
+    default: break;
+    }
   }
 
   //
   // Main processes
   //
 
-  angle_ = getAngle();
-  
-  app_.loop(micros(), angle_);
+  uint32_t nowUs = micros();
+  angleCount_ = getAngleCount();
+  trace_loop(nowUs, angleCount_);
 
-  if (buffer_.getWriteReady()) {
+  app_.loop(nowUs, angleCount_);
+
+  if (streaming_) {
+    streamRender();
+  } else if (buffer_.getWriteReady()) {
     // Current buffer is now writable.
 
     // Render    
-    app_.render(buffer_.getWriteBufferPtr());
+    int slot = buffer_.getWriteIndex();
+    spans_.begin(SPAN_RENDER, app_.rendermode_);
+    app_.render(buffer_.getWriteBufferPtr(), &spriteLists_[slot]);
+    spans_.end(SPAN_RENDER);
+    scrollLayerValid_[slot] = scrollLayerEnabled_ && app_.scrollLayer(&scrollLayers_[slot]);
+    if (trace_recording()) {
+      uint32_t hash = (trace_hashing())? trace_hash(buffer_.getWriteBufferPtr(), CV_FRAME_BYTES * app_.grayPlanes(), &spriteLists_[buffer_.getWriteIndex()]) : 0;
+      trace_frame(micros(), app_.rendermode_, 0, hash);
+    }
 
     // Set next write buffer
     buffer_.nextWriteBuffer();
@@ -258,12 +351,16 @@ void loop()
     if (fpsMonitor_) {
       Serial.printf("%d\n", fps_);
     }
+    fpsLast_ = fps_;
     fps_ = 0;
+    if (streaming_) {
+      sendStreamStats();
+    }
   }
 
   if (encMonTimer_.check()) {
     if (encoderMonitor_) {
-      Serial.printf("%f\n", angle_);
+      Serial.printf("%f\n", angleCount_ * ((2.0 * M_PI) / ENCODER_COUNTS));
     }
   }
 }
@@ -297,17 +394,57 @@ void loop1(void)
   // Main processes
   //
 
+  if (core1Pause_) {
+    // No frame on the way, the sequence read after the request.
+    core1PauseAck_ = core1PauseSeq_;
+    return;
+  }
+
   if (enableSpiRender_ && buffer_.getReadReady()) {
     // transfer data available, start spi transfers
 
-    // Send frame data to spi-i2c-bridge
-    spi2i2cbridge_.sendFrameDataParallel(buffer_.getReadBufferPtr(), CV_FRAME_BYTES);
+    int slot = buffer_.getReadIndex();
+    const sprite_list_t * sprites = &spriteLists_[slot];
+    const scroll_layer_t * layer = (scrollLayerValid_[slot] && sprites->count_ == 0)? &scrollLayers_[slot] : nullptr;
+    if (spi2i2cbridge_.scrollFits(layer)) {
+      // The layer moved by the start line, only the pages ahead are sent.
+      spi2i2cbridge_.sendScrollFrame(layer);
+    } else {
+      // Send frame data to spi-i2c-bridge, the bit planes in a row.
+      size_t size = CV_FRAME_BYTES * spi2i2cbridge_.grayPlanes();
+      spi2i2cbridge_.sendFrameDataParallel(buffer_.getReadBufferPtr(), size, sprites);
+    }
     
     // transfer completed, set next read buffers
     buffer_.nextReadBuffer();
   }
 }
 
+// From core0, returns when core1 is between the frames and stays there
+// until core1Resume(). A new sequence each time, an old echo does not pass.
+static void core1Pause(void)
+{
+  uint32_t seq = core1PauseSeq_ + 1;
+  core1PauseSeq_ = seq;
+  core1Pause_ = true;
+  while (core1PauseAck_ != seq) {}
+}
+
+static void core1Resume(void)
+{
+  core1Pause_ = false;
+}
+
+// The bit planes of rawbuffer_ the slots do not use, behind them. Free for
+// core0 between the frames. (96 KB monochrome, none with 4 planes) The frame
+// stream and PBENCH have them, one at a time.
+static uint8_t * spareBuffer(size_t * size)
+{
+  size_t used = CV_FRAME_BYTES * app_.grayPlanes() * CIRCULAR_BUFFER_NUM;
+  *size = sizeof(rawbuffer_) - used;
+  return rawbuffer_ + used;
+}
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions
  *----------------------------------------------------------------------
@@ -322,6 +459,15 @@ static float getAngle(void)
   #endif
 }
 
+static uint16_t getAngleCount(void)
+{
+  #if ENCODER_USE_SPI
+  return encoder_get_count_spi();
+  #else
+  return encoder_get_count_pwm();
+  #endif
+}
+
 static uint16_t getRawAngle(void)
 {
   #if ENCODER_USE_SPI
@@ -403,10 +549,74 @@ static void commandParser(SerialCmd & cmd)
   {
     encoderMonitor_ = GETPARAM(0, Int);
   }
+  ISCMD("STREAM")
+  {
+    if (GETPARAM(0, Int)) streamStart();
+  }
   ISCMD("ENA_SPI_XFER")
   {
     enableSpiRender_ = GETPARAM(0, Int);
   }
+  ISCMD("GRAY")
+  {
+    int planes = GETPARAM(0, Int);
+    int steps = GETPARAM(1, Int);
+    setGray(planes, steps);
+  }
+  ISCMD("TEXT")
+  {
+    // Ticker text, the params joined with a space.
+    char text[APP_TICKER_TEXT_MAX + 1] = "";
+    for (int i = 0; i < SERIALCMD_MAX_PARAMS_NUM && cmd.getParam(i)[0] != '\0'; i++) {
+      if (i > 0) strncat(text, " ", APP_TICKER_TEXT_MAX - strlen(text));
+      strncat(text, cmd.getParam(i), APP_TICKER_TEXT_MAX - strlen(text));
+    }
+    app_.setTickerText(text);
+    Serial.printf("text = %s\n", text);
+  }
+  ISCMD("SCROLL")
+  {
+    // Scroll layer on / off, and the stats.
+    if (cmd.getParam(0)[0] != '\0') scrollLayerEnabled_ = GETPARAM(0, Int);
+    const sib_scroll_stats_t * stats = spi2i2cbridge_.scrollStats();
+    Serial.printf("scroll = %d : frames %u, pages %u, reloads %u, misses %u\n",
+      (int)scrollLayerEnabled_, (unsigned)stats->frames_, (unsigned)stats->pages_,
+      (unsigned)stats->reloads_, (unsigned)stats->misses_);
+  }
+  ISCMD("TICKER")
+  {
+    int speed = GETPARAM(0, Int);
+    app_.setTickerSpeed(speed);
+    Serial.printf("ticker speed = %d px/s\n", speed);
+  }
+  ISCMD("TRACE")
+  {
+    // TRACE START|ONCE [seed] [hash], TRACE STOP, TRACE DUMP, TRACE
+    CMDSTART
+    ISCMD2("START") { traceStart(cmd, false); }
+    ISCMD2("ONCE")  { traceStart(cmd, true); }
+    ISCMD2("STOP")  { trace_stop(); }
+    ISCMD2("DUMP")  { traceDump(); }
+    else {
+      trace_stats_t stats;
+      trace_get_stats(&stats);
+      Serial.printf("trace : %s, %u records, %u overwritten, %u frames\n", (stats.recording_)? "recording" : "stopped",
+        (unsigned)stats.records_, (unsigned)stats.overwritten_, (unsigned)stats.frames_);
+    }
+  }
+  ISCMD("SPANS")
+  {
+    // SPANS START|STOP|DUMP, SPANS
+    CMDSTART
+    ISCMD2("START") { spansStart(true); }
+    ISCMD2("STOP")  { spansStart(false); }
+    ISCMD2("DUMP")  { spansDump(); }
+    else {
+      Serial.printf("spans : %s, core0 %u events (%u overwritten), core1 %u events (%u overwritten)\n",
+        (spans_.recording())? "recording" : "stopped", (unsigned)spans_.count(0), (unsigned)spans_.overwritten(0),
+        (unsigned)spans_.count(1), (unsigned)spans_.overwritten(1));
+    }
+  }
   ISCMD("MOVETO")
   {
     float target = GETPARAM(0, Float);
@@ -430,6 +640,13 @@ static void commandParser(SerialCmd & cmd)
     motor_set_brake(true);
     Serial.printf("done\n");
   }
+  ISCMD("PBENCH")
+  {
+    // PBENCH [count] [frames], the particle engine timed on this core.
+    int count = GETPARAM(0, Int);
+    int frames = GETPARAM(1, Int);
+    particleBench(count, frames);
+  }
   ISCMD("SPI_TEST1")
   {
     uint8_t id = GETPARAM(0, Int);
@@ -461,6 +678,43 @@ static void commandParser(SerialCmd & cmd)
     bool result = spi2i2cbridge_.sendPing(id);
     Serial.printf("finish ping %d\n", result);
   }
+  ISCMD("SPI_TRAIN")
+  {
+    // The link and the bus are changed, core1 waits.
+    uint8_t id = GETPARAM(0, Int);
+    core1Pause();
+    uint32_t hz = spi2i2cbridge_.trainLink(id);
+    core1Resume();
+    Serial.printf("SPI link %d : %u Hz\n", id, (unsigned)hz);
+  }
+  ISCMD("SPI_LINK")
+  {
+    uint8_t id = GETPARAM(0, Int);
+    const SpiLinkRate * link = spi2i2cbridge_.link(id);
+    const spi_link_stats_t * stats = link->stats();
+    Serial.printf("SPI link %d : %u Hz (trained %u Hz), frames %u, errors %u, retries %u, fallbacks %u, test rounds %u / %u failed\n",
+      id, (unsigned)link->clock(), (unsigned)link->trainedClock(), (unsigned)stats->frames_, (unsigned)stats->errors_,
+      (unsigned)stats->retries_, (unsigned)stats->fallbacks_, (unsigned)stats->testRounds_, (unsigned)stats->testErrors_);
+  }
+  ISCMD("SPI_PRESENT")
+  {
+    for (int id = 0; id < spi2i2cbridge_.endpoints(); id++) {
+      const sib_present_stats_t * stats = spi2i2cbridge_.presentStats(id);
+      Serial.printf("SPI present %d : presents %u, missed %u, sent +%u us, latency %u us (max %u us)\n",
+        id, (unsigned)stats->presents_, (unsigned)stats->missed_, (unsigned)stats->sentUs_,
+        (unsigned)stats->latencyUs_, (unsigned)stats->maxLatencyUs_);
+    }
+    Serial.printf("SPI present skew : %u us (max %u us)\n",
+      (unsigned)spi2i2cbridge_.presentSkewUs(), (unsigned)spi2i2cbridge_.presentSkewMaxUs());
+  }
+  ISCMD("SPI_PRESENT_MODE")
+  {
+    // Broadcast over the SPI and the present counters reset, core1 waits.
+    uint8_t on = GETPARAM(0, Int);
+    core1Pause();
+    spi2i2cbridge_.setPresent(on);
+    core1Resume();
+  }
   ISCMD("SPI_DIR")
   {
     uint8_t id = GETPARAM(0, Int);
@@ -490,3 +744,345 @@ static void commandParser(SerialCmd & cmd)
     ISCMD2("EXAMPLE2") { Serial.printf("CMD : Sub Example Command 2\n"); }
   }
 }
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Binary Command
+ *----------------------------------------------------------------------
+ */
+
+// Framing is in cmd_parser.hpp. A reply has the command | BIN_RSP_FLAG, and
+// is dropped if the host does not read. (the render loop never waits)
+static const int BIN_CMD_PING           = 0x01;   // any -> echo
+static const int BIN_CMD_SET_MODE       = 0x02;   // u8 mode
+static const int BIN_CMD_MOTOR_POWER    = 0x03;   // s16 power
+static const int BIN_CMD_MOTOR_BRAKE    = 0x04;   // u8 brake
+static const int BIN_CMD_ANGLE_OFFSET   = 0x05;   // u16 offset
+static const int BIN_CMD_GET_STATUS     = 0x10;   // -> u16 fps, u16 angle, u8 mode, u32 errors
+static const int BIN_CMD_STREAM         = 0x20;   // u8 on, stats every second -> u32 frames, u32 dropped, u32 errors, u32 bytes, u16 seq, u16 fps
+static const int BIN_RSP_FLAG           = 0x80;
+
+static void binaryCommandParser(SerialCmd & cmd)
+{
+  const uint8_t * p = cmd.getPayload();
+  int size = cmd.getPayloadSize();
+  uint8_t id = cmd.getBinaryCmd();
+
+  switch (id)
+  {
+  case BIN_CMD_PING:
+    cmd.sendBinary(id | BIN_RSP_FLAG, p, size);
+    break;
+  case BIN_CMD_SET_MODE:
+    if (size >= 1) app_.setMode(p[0]);
+    break;
+  case BIN_CMD_MOTOR_POWER:
+    if (size >= 2) motor_set_power((int16_t)(p[0] | (p[1] << 8)));
+    break;
+  case BIN_CMD_MOTOR_BRAKE:
+    if (size >= 1) motor_set_brake(p[0] != 0);
+    break;
+  case BIN_CMD_ANGLE_OFFSET:
+    if (size >= 2) {
+      angleOffset_ = (uint16_t)(p[0] | (p[1] << 8));
+      encoder_set_angle_offset(angleOffset_);
+    }
+    break;
+  case BIN_CMD_GET_STATUS:
+  {
+    uint32_t errors = cmd.getErrors();
+    uint8_t status[9] = {
+      (uint8_t)(fpsLast_ >> 0), (uint8_t)(fpsLast_ >> 8),
+      (uint8_t)(angleCount_ >> 0), (uint8_t)(angleCount_ >> 8),
+      (uint8_t)app_.rendermode_,
+      (uint8_t)(errors >> 0), (uint8_t)(errors >> 8), (uint8_t)(errors >> 16), (uint8_t)(errors >> 24),
+    };
+    cmd.sendBinary(id | BIN_RSP_FLAG, status, sizeof(status));
+  } break;
+  case BIN_CMD_STREAM:
+    if (size >= 1 && p[0] != 0) streamStart();
+    break;
+  default:
+    break;
+  }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Trace
+ *----------------------------------------------------------------------
+ */
+
+// The App is reseeded, the replay starts from the same random state.
+// (the render modes keep their state from before the trace)
+static void traceStart(SerialCmd & cmd, bool once)
+{
+  uint32_t seed = (cmd.getParam(1)[0] != '\0')? (uint32_t)GETPARAM(1, Int) : micros();
+  bool hash = GETPARAM(2, Int) != 0;
+  app_.setSeed(seed);
+  trace_start(micros(), seed, app_.rendermode_, app_.grayPlanes(), hash, once);
+  Serial.printf("trace : seed %u%s%s\n", (unsigned)seed, (hash)? ", hashed" : "", (once)? ", once" : "");
+}
+
+// The command line as received, not the trace commands.
+static void traceCommand(SerialCmd & cmd)
+{
+  if (!trace_recording() || strcmp(cmd.getCmd(), "TRACE") == 0) return;
+  char line[TRACE_TEXT_MAX + 1];
+  strncpy(line, cmd.getCmd(), TRACE_TEXT_MAX);
+  line[TRACE_TEXT_MAX] = '\0';
+  for (int i = 0; i < SERIALCMD_MAX_PARAMS_NUM && cmd.getParam(i)[0] != '\0'; i++) {
+    strncat(line, " ", TRACE_TEXT_MAX - strlen(line));
+    strncat(line, cmd.getParam(i), TRACE_TEXT_MAX - strlen(line));
+  }
+  trace_command(line);
+}
+
+// Text lines for v1/tools/tracereplay, the recording is stopped.
+static void traceDump(void)
+{
+  trace_stop();
+  trace_stats_t stats;
+  trace_get_stats(&stats);
+  Serial.printf("@TRACE %d %u %u\n", TRACE_VERSION, (unsigned)stats.records_, (unsigned)stats.overwritten_);
+  trace_record_t record;
+  char line[TRACE_LINE_SIZE];
+  for (uint32_t i = 0; trace_get(i, &record); i++) {
+    trace_format(&record, line, sizeof(line));
+    Serial.printf("%s\n", line);
+  }
+  Serial.printf("@TRACE END\n");
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Span Trace
+ *----------------------------------------------------------------------
+ */
+
+// The bridges are started and synced over the SPI, core1 waits.
+static void spansStart(bool on)
+{
+  core1Pause();
+
+  spi2i2cbridge_.startSpans(on);
+  Serial.printf("spans : %s\n", (on)? "start" : "stop");
+
+  core1Resume();
+}
+
+// Text lines for v1/tools/spantrace, the source 0 is the controller and
+// 1 + id the bridges. The recording is stopped.
+static void spansDump(void)
+{
+  core1Pause();
+
+  if (spans_.recording()) spi2i2cbridge_.startSpans(false);
+  int sources = 1 + spi2i2cbridge_.endpoints();
+  char line[SPAN_LINE_SIZE];
+  Serial.printf("@SPANS %d %d\n", SPAN_VERSION, sources);
+  for (int core = 0; core < SPAN_CORES; core++) {
+    Serial.printf("@SPANS RING 0 %d %u %u\n", core, (unsigned)spans_.count(core), (unsigned)spans_.overwritten(core));
+    span_event_t event;
+    for (uint32_t i = 0; spans_.get(core, i, &event); i++) {
+      SpanTrace::format(0, &event, line, sizeof(line));
+      Serial.printf("%s\n", line);
+    }
+  }
+  for (int id = 0; id < spi2i2cbridge_.endpoints(); id++) {
+    for (int core = 0; core < SPAN_CORES; core++) {
+      span_event_t events[SIB_SPAN_BLOCK_EVENTS];
+      sib_span_ring_t ring = { 0, 0 };
+      uint32_t index = 0;
+      int n = spi2i2cbridge_.readSpans(id, core, index, events, &ring);
+      Serial.printf("@SPANS RING %d %d %u %u\n", 1 + id, core, (unsigned)ring.events_, (unsigned)ring.overwritten_);
+      while (n > 0) {
+        for (int i = 0; i < n; i++) {
+          SpanTrace::format(1 + id, &events[i], line, sizeof(line));
+          Serial.printf("%s\n", line);
+        }
+        index += n;
+        n = spi2i2cbridge_.readSpans(id, core, index, events, &ring);
+      }
+    }
+  }
+  Serial.printf("@SPANS END\n");
+
+  core1Resume();
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - USB Frame Stream
+ *----------------------------------------------------------------------
+ */
+
+// All serial bytes are frames (frame_stream.hpp) until STREAM_FORMAT_END, or
+// no data for STREAM_IDLE_TIMEOUT_MS. Commands are not parsed meanwhile.
+static void streamStart(void)
+{
+  // The panel frames are one plane, the cylinder plane and the body go to
+  // the spare planes. (no command meanwhile, PBENCH uses them too)
+  if (spi2i2cbridge_.grayPlanes() > 1) setGray(1, 0);
+  size_t spare = 0;
+  uint8_t * buffer = spareBuffer(&spare);
+  if (spare < 2 * STREAM_PLANE_SIZE) return;
+  stream_.init(buffer, buffer + STREAM_PLANE_SIZE, STREAM_PLANE_SIZE);
+  streaming_ = true;
+  streamRxMs_ = millis();
+}
+
+static void streamStop(void)
+{
+  sendStreamStats();
+  streaming_ = false;
+}
+
+static void streamReceive(void)
+{
+  int available = Serial.available();
+  while (available > 0) {
+    // A panel frame is read straight to the write slot, taken at its header.
+    stream_.setPanelTarget(buffer_.getWriteReady()? buffer_.getWriteBufferPtr() : nullptr);
+
+    size_t room = 0;
+    uint8_t * dst = stream_.rxPtr(&room);
+    size_t size = Serial.readBytes(dst, MIN((size_t)available, room));
+    if (size == 0) break;
+    available -= size;
+    streamRxMs_ = millis();
+
+    switch (stream_.rxDone(size)) {
+    case STREAM_EVENT_PANELS:
+    {
+      // No sprites on a streamed frame.
+      sprite_list_t * sprites = &spriteLists_[buffer_.getWriteIndex()];
+      sprites->flags_ = 0;
+      sprites->count_ = 0;
+      scrollLayerValid_[buffer_.getWriteIndex()] = false;
+      trace_frame(micros(), app_.rendermode_, TRACE_FLAG_STREAM, 0);
+      buffer_.nextWriteBuffer();
+      fps_++;
+    } break;
+    case STREAM_EVENT_END:
+      streamStop();
+      return;
+    default:
+      break;
+    }
+  }
+
+  if (millis() - streamRxMs_ > STREAM_IDLE_TIMEOUT_MS) {
+    streamStop();
+  }
+}
+
+// The cylinder plane is drawn at the live angle to every free slot, so the
+// rotation follows the encoder and not the host frame rate.
+static void streamRender(void)
+{
+  if (!stream_.hasPlane() || stream_.writingPanels() || !buffer_.getWriteReady()) return;
+
+  app_.renderStream(buffer_.getWriteBufferPtr(), &spriteLists_[buffer_.getWriteIndex()], stream_.plane());
+  scrollLayerValid_[buffer_.getWriteIndex()] = false;
+  trace_frame(micros(), app_.rendermode_, TRACE_FLAG_STREAM, 0);
+  buffer_.nextWriteBuffer();
+  fps_++;
+}
+
+// Grayscale of planes bit planes (1 : monochrome), the steps lower ones by
+// the contrast. The bridges and the slots are set up with core1 stopped
+// between the frames, the frames on the way are dropped.
+static void setGray(int planes, int steps)
+{
+  core1Pause();
+
+  planes = CONSTRAIN(planes, 1, CV_GRAY_PLANES_MAX);
+  bool ok = spi2i2cbridge_.setGray(planes, steps);
+  buffer_.setBuffer(rawbuffer_, CV_FRAME_BYTES * planes * CIRCULAR_BUFFER_NUM, CIRCULAR_BUFFER_NUM);
+  app_.setGrayPlanes(planes);
+  Serial.printf("gray : %d planes, %d steps%s\n", planes, steps, (ok)? "" : " (bridge not ready)");
+
+  core1Resume();
+}
+
+static void sendStreamStats(void)
+{
+  const stream_stats_t * st = stream_.stats();
+  uint8_t stats[20];
+  const uint32_t values[4] = { st->frames_, st->dropped_, st->errors_, st->bytes_ };
+  for (int i = 0; i < 4; i++) {
+    stats[i * 4 + 0] = (uint8_t)(values[i] >> 0);
+    stats[i * 4 + 1] = (uint8_t)(values[i] >> 8);
+    stats[i * 4 + 2] = (uint8_t)(values[i] >> 16);
+    stats[i * 4 + 3] = (uint8_t)(values[i] >> 24);
+  }
+  stats[16] = (uint8_t)(st->seq_ >> 0);
+  stats[17] = (uint8_t)(st->seq_ >> 8);
+  stats[18] = (uint8_t)(fpsLast_ >> 0);
+  stats[19] = (uint8_t)(fpsLast_ >> 8);
+  cmd_.sendBinary(BIN_CMD_STREAM | BIN_RSP_FLAG, stats, sizeof(stats));
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Particle Benchmark
+ *----------------------------------------------------------------------
+ */
+
+// Update + plot time of Particles on the RP2040 (pbench on the host), for
+// count particles or 100 ~ 10k, against the frame interval at the last
+// frame rate. A frame and the particles are in the spare planes, the slots
+// are not touched. (GRAY 1 for 10k)
+static void particleBench(int count, int frames)
+{
+  static const int counts[] = { 100, 1000, 2000, 5000, 10000 };
+  size_t spare = 0;
+  uint8_t * buffer = spareBuffer(&spare);
+  int capacity = (spare > CV_FRAME_BYTES)? (int)((spare - CV_FRAME_BYTES) / 6) : 0;
+  if (frames <= 0) frames = 100;
+
+  CyclicMonoScreen screen;
+  CyclicMonoDrawer drawer;
+  for (int i = 0; i < CV_DISPLAYS; i++) {
+    screen.getMonoScreen(i)->setBuffer(buffer + (i * CV_ONE_FRAME_BYTES));
+  }
+  drawer.init(&screen);
+
+  uint32_t frameUs = (fpsLast_ > 0)? (1000000UL / fpsLast_) : 0;
+  Serial.printf("pbench : %d particles max, %d frames, frame interval %u us (%d fps)\n",
+    capacity, frames, (unsigned)frameUs, fpsLast_);
+
+  int fits = 0;
+  for (int i = 0; i < (int)(sizeof(counts) / sizeof(counts[0])); i++) {
+    int n = (count > 0)? count : counts[i];
+    if (n > capacity) {
+      Serial.printf("particles %5d : over the spare planes\n", n);
+      break;
+    }
+    uint16_t * x = (uint16_t *)(buffer + CV_FRAME_BYTES);
+    int16_t * y = (int16_t *)(x + n);
+    int16_t * vy = y + n;
+    Particles particles;
+    particles.setBuffers(x, y, vy, n);
+    particles.setFallSpeed(1 << PARTICLE_Y_SHIFT, 1 << PARTICLE_Y_SHIFT);
+    // Falling, not on the ground at the start.
+    for (int f = 0; f < CV_HEIGHT; f++) particles.loop();
+
+    uint32_t updateUs = 0, plotUs = 0;
+    for (int f = 0; f < frames; f++) {
+      uint32_t t0 = micros();
+      particles.loop();
+      uint32_t t1 = micros();
+      particles.draw(&drawer, f);
+      uint32_t t2 = micros();
+      updateUs += t1 - t0;
+      plotUs += t2 - t1;
+    }
+    updateUs /= frames;
+    plotUs /= frames;
+    uint32_t totalUs = updateUs + plotUs;
+    bool inFrame = (frameUs > 0 && totalUs <= frameUs);
+    if (inFrame) fits = n;
+    Serial.printf("particles %5d : update %u us, plot %u us, %u us a frame (%u ns a particle)%s\n",
+      n, (unsigned)updateUs, (unsigned)plotUs, (unsigned)totalUs, (unsigned)((totalUs * 1000ULL) / n),
+      (frameUs == 0)? "" : (inFrame)? ", in the frame" : ", over the frame");
+    if (count > 0) break;
+  }
+  Serial.printf("pbench : %d particles in the frame interval\n", fits);
+}
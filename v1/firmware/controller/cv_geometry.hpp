@@ -0,0 +1,146 @@
+/**********************************************************************/
+/**
+ * @brief  Cylinder Geometry (Compile Time, shared with spi-i2c-bridge)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Visible (not margin) cylinder x range, continuous on one panel.
+// The panel column is decreasing along the cylinder x. (mirrored)
+typedef struct cv_visible_span_ {
+    int16_t x1_;            // Cylinder x (0 ~ V_WIDTH - 1), inclusive
+    int16_t x2_;
+    int16_t panel_;
+    int16_t column_;        // Panel column of x1_
+} cv_visible_span_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+// Panels around the cylinder, and the SSD1306 panel buffer layout. The
+// screens, the drawer and the bridge driver are templates on it, so the
+// strides are constants (a shift for a power of 2 height) and the margin
+// tables are in the flash, built by the compiler.
+//
+//   Height   : panel columns, the cylinder height (SSD1306 SEG, <= 128)
+//   Width    : panel rows, along the cylinder (SSD1306 COM, 8 ~ 64)
+//   Margin   : pixels between the panels
+//   Displays : panels around the cylinder
+//   Channels : panels per bridge (I2C channels)
+//
+// Panel buffer : page (row >> 3) by page, Height bytes a page, bit (row & 7).
+template <int Height, int Width, int Margin, int Displays, int Channels = 8>
+struct CvGeometry
+{
+    static_assert(Height > 0 && Height <= 128, "SSD1306 has 128 columns");
+    static_assert(Width >= 8 && Width <= 64 && (Width % 8) == 0, "SSD1306 has 8 pages of 8 rows");
+    static_assert(Margin >= 0, "");
+    static_assert(Displays > 0 && Channels > 0 && (Displays % Channels) == 0, "Displays are split to the bridges");
+
+    static constexpr int HEIGHT = Height;
+    static constexpr int WIDTH = Width;
+    static constexpr int MARGIN = Margin;
+    static constexpr int DISPLAYS = Displays;
+    static constexpr int CHANNELS = Channels;
+
+    static constexpr int PIXELS = HEIGHT * WIDTH;
+    static constexpr int ONE_FRAME_BYTES = PIXELS / 8;
+    static constexpr int FRAME_BYTES = ONE_FRAME_BYTES * DISPLAYS;
+    static constexpr int DISTANCE = WIDTH + MARGIN;
+    static constexpr int V_WIDTH = DISTANCE * DISPLAYS;
+    static constexpr int V_PIXELS = V_WIDTH * HEIGHT;
+    static constexpr int PAGES = WIDTH / 8;
+    static constexpr int BRIDGES = DISPLAYS / CHANNELS;
+    static constexpr int BRIDGE_BYTES = ONE_FRAME_BYTES * CHANNELS;
+    static constexpr int VISIBLE_SPANS_MAX = DISPLAYS + 1;
+
+    // SSD1306 setup of the panel size. The 128 x 32 panel has the
+    // sequential COM pins, the others the alternative. A narrow panel is
+    // in the middle of the 128 columns.
+    static constexpr uint8_t SSD1306_MULTIPLEX = (uint8_t)(WIDTH - 1);
+    static constexpr uint8_t SSD1306_COMPINS = (HEIGHT == 128 && WIDTH == 32)? 0x02 : 0x12;
+    static constexpr uint8_t SSD1306_COLUMN_OFFSET = (uint8_t)((128 - HEIGHT) / 2);
+
+    // The GDDRAM has 8 pages, a panel of 4 pages or less has a second
+    // frame in the pages after it, shown by the start line. (grayscale)
+    static constexpr bool SSD1306_BACK_FRAME = (PAGES * 2 <= 8);
+
+    // A scrolled layer is shown by the start line over the 8 pages, the
+    // panel rows from any line span PAGES + 1 pages, one more is loaded
+    // ahead. (the scroll layer of the bridge)
+    static constexpr int SSD1306_GDDRAM_PAGES = 8;
+    static constexpr bool SSD1306_SCROLL = (PAGES + 2 <= SSD1306_GDDRAM_PAGES);
+
+    // Byte of the panel buffer at (column, row).
+    static constexpr int offset(int column, int row) { return ((row >> 3) * HEIGHT) + column; }
+
+    // Cylinder x to screen x (0 ~ V_WIDTH - 1). The panel i shows screen x
+    // [i * DISTANCE, i * DISTANCE + WIDTH), mirrored to the cylinder x.
+    static constexpr int screenX(int x) {
+        x = (-x - (MARGIN + 1)) % V_WIDTH;
+        return (x < 0)? x + V_WIDTH : x;
+    }
+
+    // Cylinder x (0 ~ V_WIDTH - 1) to (panel * WIDTH + column), -1 on margin.
+    struct columns_t { int16_t v_[V_WIDTH]; };
+    static constexpr columns_t makeColumns(void) {
+        columns_t t = {};
+        for (int x = 0; x < V_WIDTH; x++) {
+            int sx = screenX(x);
+            int panel = (sx / DISTANCE) % DISPLAYS;
+            int column = sx % DISTANCE;
+            t.v_[x] = (int16_t)((column >= WIDTH)? -1 : (panel * WIDTH) + column);
+        }
+        return t;
+    }
+    static constexpr columns_t COLUMNS = makeColumns();
+
+    // Visible spans in the cylinder x order.
+    struct spans_t { cv_visible_span_t s_[VISIBLE_SPANS_MAX]; int count_; };
+    static constexpr spans_t makeSpans(void) {
+        spans_t t = {};
+        for (int x = 0; x < V_WIDTH; x++) {
+            int v = COLUMNS.v_[x];
+            if (v < 0) continue;
+            cv_visible_span_t * last = (t.count_ > 0)? &t.s_[t.count_ - 1] : nullptr;
+            if (last != nullptr && last->x2_ == (x - 1) && last->panel_ == (v / WIDTH)) {
+                last->x2_ = (int16_t)x;
+            } else if (t.count_ < VISIBLE_SPANS_MAX) {
+                cv_visible_span_t * span = &t.s_[t.count_++];
+                span->x1_ = (int16_t)x;
+                span->x2_ = (int16_t)x;
+                span->panel_ = (int16_t)(v / WIDTH);
+                span->column_ = (int16_t)(v % WIDTH);
+            }
+        }
+        return t;
+    }
+    static constexpr spans_t SPANS = makeSpans();
+
+    // Wrap a cylinder x, usually in (-V_WIDTH, 2 * V_WIDTH) with no modulo.
+    static constexpr int wrap(int x) {
+        if (x < 0) x += V_WIDTH;
+        else if (x >= V_WIDTH) x -= V_WIDTH;
+        if ((unsigned)x >= (unsigned)V_WIDTH) {
+            x %= V_WIDTH;
+            if (x < 0) x += V_WIDTH;
+        }
+        return x;
+    }
+};
+
+// The cylinder of this build. (128 x 32 panels, 16 on 2 bridges)
+typedef CvGeometry<128, 32, 39, 16, 8> CvDefaultGeometry;
@@ -55,11 +55,13 @@
  *----------------------------------------------------------------------
  */
 
-CyclicMonoDrawer::CyclicMonoDrawer()
+template <typename G>
+CyclicMonoDrawerT<G>::CyclicMonoDrawerT()
 {
 }
 
-CyclicMonoDrawer::~CyclicMonoDrawer()
+template <typename G>
+CyclicMonoDrawerT<G>::~CyclicMonoDrawerT()
 {
 }
 
@@ -68,9 +70,10 @@ CyclicMonoDrawer::~CyclicMonoDrawer()
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-CyclicMonoDrawer::init(
-    CyclicMonoScreen * screen
+CyclicMonoDrawerT<G>::init(
+    CyclicMonoScreenT<G> * screen
 ) {
     screen_ = screen;
 
@@ -84,33 +87,60 @@ CyclicMonoDrawer::init(
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-CyclicMonoDrawer::clearFrame(color_t c)
+CyclicMonoDrawerT<G>::clearFrame(color_t c)
 {
     screen_->clear(c);
 }
 
+template <typename G>
 color_t
-CyclicMonoDrawer::getDot(int x, int y) const
+CyclicMonoDrawerT<G>::getDot(int x, int y) const
 {
     return screen_->getDot(x, y);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::setDot(int x, int y, color_t c)
+CyclicMonoDrawerT<G>::setDot(int x, int y, color_t c)
 {
     screen_->setDot(x, y, c);
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawDot(int x, int y, color_t c)
+CyclicMonoDrawerT<G>::drawDot(int x, int y, color_t c)
 {
-    setDot(x, y, c);
-    return 0;
+    if (y < 0 || height_ <= y) return -1;
+    return setPanelDot(panelColumn(x), y, c);
+}
+
+// Bulk dots, e.g. particles. Same to drawDot(x[i] + xoffset, y[i]) for all.
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawDots(const int16_t * x, const int16_t * y, int count, int xoffset, color_t c)
+{
+    uint8_t * buffers[G::DISPLAYS];
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        buffers[i] = screen_->screens_[i].getBuffer();
+    }
+    for (int i = 0; i < count; i++) {
+        int y1 = y[i];
+        if ((unsigned)y1 >= (unsigned)height_) continue;
+        int x1 = x[i] + xoffset;
+        int v = G::COLUMNS.v_[G::wrap(x1)];
+        if (v < 0) continue;
+        int column = (unsigned)v % G::WIDTH;
+        uint8_t * p = buffers[(unsigned)v / G::WIDTH] + G::offset(y1, column);
+        if (c == DISP_COLOR_WHITE) *p |=  (uint8_t)(0x01 << (column & 7));
+        else                       *p &= ~(uint8_t)(0x01 << (column & 7));
+    }
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawHLine(int x1, int x2, int y, color_t c)
+CyclicMonoDrawerT<G>::drawHLine(int x1, int x2, int y, color_t c)
 {
     if (y < 0 || height_ <= y) return -1;
     /*DisableForCyclic*///if ((x1 < 0 && x2 < 0) || (width_ <= x1 && width_ <= x2)) return -1;
@@ -120,34 +150,34 @@ CyclicMonoDrawer::drawHLine(int x1, int x2, int y, color_t c)
     /*DisableForCyclic*///if (x1 < 0) x1 = 0;
     /*DisableForCyclic*///if (x2 >= width_) x2 = width_ - 1;
 
-    int l = x2 - x1 + 1;
-    for (int i = 0; i < l; i++) {
-        drawDot(x1 + i, y, c);
-    }
+    fillPanels(x1, x2, y, y, (c == DISP_COLOR_WHITE)? MONO_ROP_OR : MONO_ROP_ANDNOT);
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawVLine(int x, int y1, int y2, color_t c)
+CyclicMonoDrawerT<G>::drawVLine(int x, int y1, int y2, color_t c)
 {
     /*DisableForCyclic*///if (x < 0 || width_ <= x) return -1;
     if ((y1 < 0 && y2 < 0) || (height_ <= y1 && height_ <= y2)) return -1;
+    if (!isVisible(x)) return -1;
 
     if (y1 > y2) std::swap(y1, y2);
 
     if (y1 < 0) y1 = 0;
     if (y2 >= height_) y2 = height_ - 1;
 
-    int l = y2 - y1 + 1;
-    for (int i = 0; i < l; i++) {
-        drawDot(x , y1 + i, c);
-    }
+    fillPanels(x, x, y1, y2, (c == DISP_COLOR_WHITE)? MONO_ROP_OR : MONO_ROP_ANDNOT);
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawLine(int x1, int y1, int x2, int y2, color_t c)
+CyclicMonoDrawerT<G>::drawLine(int x1, int y1, int x2, int y2, color_t c)
 {
+    if ((y1 < 0 && y2 < 0) || (height_ <= y1 && height_ <= y2)) return -1;
+    if (!isVisible(x1, x2)) return -1;
+
     int xinc1 = 0, xinc2 = 0;
     int yinc1 = 0, yinc2 = 0;
     if (x2 >= x1)   { xinc1 =  1;   xinc2 =  1;}
@@ -192,14 +222,16 @@ CyclicMonoDrawer::drawLine(int x1, int y1, int x2, int y2, color_t c)
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawRect(int x1, int y1, int x2, int y2, color_t c, bool fill)
+CyclicMonoDrawerT<G>::drawRect(int x1, int y1, int x2, int y2, color_t c, bool fill)
 {
     return (fill)? drawRectFill(x1,y1,x2,y2,c) : drawRectNoFill(x1,y1,x2,y2,c);
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawRectNoFill(int x1, int y1, int x2, int y2, color_t c)
+CyclicMonoDrawerT<G>::drawRectNoFill(int x1, int y1, int x2, int y2, color_t c)
 {
     /*DisableForCyclic*///if ((x1 < 0 && x2 < 0) || (width_ <= x1 && width_ <= x2)) return -1;
     /*DisableForCyclic*///if ((y1 < 0 && y2 < 0) || (height_ <= y1 && height_ <= y2)) return -1;
@@ -210,28 +242,30 @@ CyclicMonoDrawer::drawRectNoFill(int x1, int y1, int x2, int y2, color_t c)
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawRectFill(int x1, int y1, int x2, int y2, color_t c)
+CyclicMonoDrawerT<G>::drawRectFill(int x1, int y1, int x2, int y2, color_t c)
 {
     /*DisableForCyclic*///if ((x1 < 0 && x2 < 0) || (width_ <= x1 && width_ <= x2)) return -1;
     /*DisableForCyclic*///if ((y1 < 0 && y2 < 0) || (height_ <= y1 && height_ <= y2)) return -1;
 
     if (y1 > y2) std::swap(y1, y2);
+    if (x1 > x2) std::swap(x1, x2);
 
-    for (int i = y1; i <= y2; i++) drawHLine(x1, x2, i, c);
+    fillPanels(x1, x2, y1, y2, (c == DISP_COLOR_WHITE)? MONO_ROP_OR : MONO_ROP_ANDNOT);
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawTriangleFillScanLine(
-        double& l_x, double& l_a, double& r_x, double& r_a,
+CyclicMonoDrawerT<G>::drawTriangleFillScanLine(
+        fixed_t& l_x, fixed_t& l_a, fixed_t& r_x, fixed_t& r_a,
         int& sy, int ey, color_t c )
 {
     int width_m1 = width_ - 1;
     for ( ; sy < ey ; ++sy ) {
-        int sx = (int)(l_x + 0.5);
-        int ex = (int)(r_x + 0.5);
-        sx = (l_x < 0)? 0 : sx;
+        int sx = (l_x < 0)? 0 : fixed_round(l_x);
+        int ex = fixed_round_trunc(r_x);
         if ( ex > width_m1 ) ex = width_m1;
         drawHLine(sx, ex, sy, c);
         l_x += l_a; r_x += r_a;
@@ -239,8 +273,9 @@ CyclicMonoDrawer::drawTriangleFillScanLine(
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawTriangleFill(int x1, int y1, int x2, int y2, int x3, int y3, color_t c)
+CyclicMonoDrawerT<G>::drawTriangleFill(int x1, int y1, int x2, int y2, int x3, int y3, color_t c)
 {
     if ( y1 > y2 ) { std::swap(x1, x2); std::swap(y1, y2); }
     if ( y1 > y3 ) { std::swap(x1, x3); std::swap(y1, y3); }
@@ -254,10 +289,10 @@ CyclicMonoDrawer::drawTriangleFill(int x1, int y1, int x2, int y2, int x3, int y
     /*DisableForCyclic*///if ( x1 < 0 && x2 < 0 && x3 < 0 ) return -1;
     /*DisableForCyclic*///if ( x1 >= width_ && x2 >= width_ && x3 >= width_ ) return -1;
 
-    double top_mid_x = top_x;
-    double top_btm_x = top_x;
+    fixed_t top_mid_x = fixed_from_int(top_x);
+    fixed_t top_btm_x = fixed_from_int(top_x);
 
-    if ( top_y == mid_y ) top_mid_x = mid_x;
+    if ( top_y == mid_y ) top_mid_x = fixed_from_int(mid_x);
 
     int sy = top_y;
     int my = mid_y;
@@ -267,29 +302,29 @@ CyclicMonoDrawer::drawTriangleFill(int x1, int y1, int x2, int y2, int x3, int y
         sy = 0;
         if ( mid_y >= 0 ) {
             if ( top_y != mid_y )
-                top_mid_x = (double)( mid_x - top_x ) * (double)mid_y / (double)( top_y - mid_y ) + (double)mid_x;
+                top_mid_x = fixed_ratio(( mid_x - top_x ) * mid_y, ( top_y - mid_y )) + fixed_from_int(mid_x);
         } else {
             if ( mid_y != btm_y )
-                top_mid_x = (double)( btm_x - mid_x ) * (double)btm_y / (double)( mid_y - btm_y ) + (double)btm_x;
+                top_mid_x = fixed_ratio(( btm_x - mid_x ) * btm_y, ( mid_y - btm_y )) + fixed_from_int(btm_x);
         }
         if ( top_y != btm_y )
-            top_btm_x = (double)( btm_x - top_x ) * (double)btm_y / (double)( top_y - btm_y ) + (double)btm_x;
+            top_btm_x = fixed_ratio(( btm_x - top_x ) * btm_y, ( top_y - btm_y )) + fixed_from_int(btm_x);
     }
 
     if ( btm_y >= height_ ) ey = height_ - 1;
 
-    double top_mid_a = ( mid_y != top_y ) ?
-      (double)( mid_x - top_x ) / (double)( mid_y - top_y ) : 0;
-    double mid_btm_a = ( mid_y != btm_y ) ?
-      (double)( mid_x - btm_x ) / (double)( mid_y - btm_y ) : 0;
-    double top_btm_a = ( top_y != btm_y ) ?
-      (double)( top_x - btm_x ) / (double)( top_y - btm_y ) : 0;
+    fixed_t top_mid_a = ( mid_y != top_y ) ?
+      fixed_ratio( mid_x - top_x, mid_y - top_y ) : 0;
+    fixed_t mid_btm_a = ( mid_y != btm_y ) ?
+      fixed_ratio( mid_x - btm_x, mid_y - btm_y ) : 0;
+    fixed_t top_btm_a = ( top_y != btm_y ) ?
+      fixed_ratio( top_x - btm_x, top_y - btm_y ) : 0;
 
     int splitLine_x = ( top_y != btm_y ) ?
       ( top_x - btm_x ) * ( mid_y - top_y ) / ( top_y - btm_y ) + top_x :
       btm_x;
 
-    double l_x, l_a, r_x, r_a;
+    fixed_t l_x, l_a, r_x, r_a;
     if ( mid_x < splitLine_x) {
         l_x = top_mid_x;
         l_a = top_mid_a;
@@ -313,8 +348,9 @@ CyclicMonoDrawer::drawTriangleFill(int x1, int y1, int x2, int y2, int x3, int y
     return 0;
 }
 
+template <typename G>
 int
-CyclicMonoDrawer::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, color_t c)
+CyclicMonoDrawerT<G>::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, color_t c)
 {
     drawLine(x1, y1, x2, y2, c);
     drawLine(x1, y1, x3, y3, c);
@@ -322,9 +358,13 @@ CyclicMonoDrawer::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, c
     return 0;
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawCircle(int x0, int y0, int radius, color_t c)
+CyclicMonoDrawerT<G>::drawCircle(int x0, int y0, int radius, color_t c)
 {
+    if ((y0 + radius) < 0 || height_ <= (y0 - radius)) return;
+    if (!isVisible(x0 - radius, x0 + radius)) return;
+
     int x = radius-1;
     int y = 0;
     int dx = 1;
@@ -332,14 +372,19 @@ CyclicMonoDrawer::drawCircle(int x0, int y0, int radius, color_t c)
     int err = dx - (radius << 1);
 
     while (x >= y) {
-        drawDot(x0 + x, y0 + y, c);
-        drawDot(x0 + y, y0 + x, c);
-        drawDot(x0 - y, y0 + x, c);
-        drawDot(x0 - x, y0 + y, c);
-        drawDot(x0 - x, y0 - y, c);
-        drawDot(x0 - y, y0 - x, c);
-        drawDot(x0 + y, y0 - x, c);
-        drawDot(x0 + x, y0 - y, c);
+        // 4 columns per step, each has 2 dots.
+        int px = panelColumn(x0 + x);
+        int py = panelColumn(x0 + y);
+        int ny = panelColumn(x0 - y);
+        int nx = panelColumn(x0 - x);
+        setPanelDot(px, y0 + y, c);
+        setPanelDot(py, y0 + x, c);
+        setPanelDot(ny, y0 + x, c);
+        setPanelDot(nx, y0 + y, c);
+        setPanelDot(nx, y0 - y, c);
+        setPanelDot(ny, y0 - x, c);
+        setPanelDot(py, y0 - x, c);
+        setPanelDot(px, y0 - y, c);
 
         if (err <= 0) {
             y++;
@@ -354,9 +399,13 @@ CyclicMonoDrawer::drawCircle(int x0, int y0, int radius, color_t c)
     }
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawCircleFill(int x0, int y0, int radius, color_t c)
+CyclicMonoDrawerT<G>::drawCircleFill(int x0, int y0, int radius, color_t c)
 {
+    if ((y0 + radius) < 0 || height_ <= (y0 - radius)) return;
+    if (!isVisible(x0 - radius, x0 + radius)) return;
+
     int x = radius-1;
     int y = 0;
     int dx = 1;
@@ -387,8 +436,9 @@ CyclicMonoDrawer::drawCircleFill(int x0, int y0, int radius, color_t c)
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImage(int x, int y, MonoImage * image, bool blend, bool centered, bool offset)
+CyclicMonoDrawerT<G>::drawImage(int x, int y, MonoImage * image, bool blend, bool centered, bool offset)
 {
     if (centered) {
         x -= (image->width() / 2);
@@ -398,63 +448,301 @@ CyclicMonoDrawer::drawImage(int x, int y, MonoImage * image, bool blend, bool ce
         x += image->drawOffsetX();
         y += image->drawOffsetY();
     }
-    if (blend && image->hasAlpha()) {
-        for (int y2 = 0; y2 < image->height(); y2++) {
-            for (int x2 = 0; x2 < image->width(); x2++) {
-                if (image->getDotAlpha(x2, y2) != 0) {
-                    color_t c = (color_t)image->getDot(x2, y2);
-                    drawDot(x + x2, y + y2, c);
-                }
+    int w = image->width();
+    int h = image->height();
+    if (w <= 0) return;
+    int y1 = MAX(0, -y);
+    int y2 = MIN(h, height_ - y);
+    bool alpha = blend && image->hasAlpha();
+
+    // Visible columns only, directly to the panel.
+    forEachVisible(x, x + w - 1, [&](int lo, int hi, int panel, int column) {
+        MonoScreenT<G> * screen = &screen_->screens_[panel];
+        for (int x2 = lo; x2 <= hi; x2++, column--) {
+            for (int y3 = y1; y3 < y2; y3++) {
+                if (alpha && image->getDotAlpha(x2 - x, y3) == 0) continue;
+                screen->setDot(column, y + y3, (color_t)image->getDot(x2 - x, y3));
             }
         }
-    } else {
-      for (int y2 = 0; y2 < image->height(); y2++) {
-          for (int x2 = 0; x2 < image->width(); x2++) {
-              color_t c = (color_t)image->getDot(x2, y2);
-              drawDot(x + x2, y + y2, c);
-          }
-      }
-    }
+    });
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageCentered(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageCentered(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, false, true, false);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageBlend(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageBlend(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, true, false, false);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageBlendCentered(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageBlendCentered(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, true, true, false);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageOffset(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageOffset(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, false, false, true);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageOffsetCentered(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageOffsetCentered(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, false, true, true);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageBlendOffset(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageBlendOffset(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, true, false, true);
 }
 
+template <typename G>
 void
-CyclicMonoDrawer::drawImageBlendOffsetCentered(int x, int y, MonoImage * image)
+CyclicMonoDrawerT<G>::drawImageBlendOffsetCentered(int x, int y, MonoImage * image)
 {
     drawImage(x, y, image, true, true, true);
 }
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawPlane(int x, int y, const mono_plane_t * plane, bool centered)
+{
+    int w = plane->width_;
+    int h = plane->height_;
+    if (centered) {
+        x -= (w / 2);
+        y -= (h / 2);
+    }
+    blitPanels(x, y, plane);
+}
+
+// The image column i is at cylinder x (x + i), dithered on the visible
+// spans. The threshold tile is on the panel columns, it stays still while
+// the image moves.
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawGray(int x, int y, const gray_image_t * image, mono_dither_t method, int level, bool centered)
+{
+    if (image->width_ <= 0) return;
+    if (centered) {
+        x -= (image->width_ / 2);
+        y -= (image->height_ / 2);
+    }
+    forEachVisible(x, x + image->width_ - 1, [&](int lo, int hi, int panel, int column) {
+        mono_surface_t surface = { G::WIDTH, G::HEIGHT, screen_->screens_[panel].getBuffer() };
+        mono_dither(&surface, column - (hi - lo), y, image, lo - x, 0, hi - lo + 1, image->height_, method, level);
+    });
+}
+
+// Glyphs ORed at cylinder x from x, the text is drawn over the background.
+// Returns the cylinder x at the end of the text.
+template <typename G>
+int
+CyclicMonoDrawerT<G>::drawText(int x, int y, const Font * font, const char * text, text_layout_t layout, bool centered)
+{
+    if (centered) {
+        x -= (font->textWidth(text, layout) / 2);
+        y -= (font->height() / 2);
+    }
+    for (const char * p = text; *p != '\0'; p++) {
+        const font_glyph_t * g = font->glyph((uint8_t)*p);
+        if (g->width_ > 0) {
+            mono_plane_t plane;
+            font->plane(g, &plane);
+            blitPanels(x + font->left(g, layout), y, &plane, MONO_ROP_OR);
+        }
+        x += font->advance(g, layout);
+    }
+    return x;
+}
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawAsset(int x, int y, AssetImage * image, bool centered, bool offset)
+{
+    if (centered) {
+        x -= (image->fullWidth() / 2);
+        y -= (image->fullHeight() / 2);
+    }
+    x += (offset)? image->drawOffsetX() : image->trimX();
+    y += (offset)? image->drawOffsetY() : image->trimY();
+
+    int w = image->width();
+    int h = image->height();
+    if (image->hasAlpha()) {
+        // Opaque runs only.
+        const uint8_t * runs = image->alphaRuns();
+        for (int y2 = 0; y2 < h; y2++) {
+            int n = *runs++;
+            for (int i = 0; i < n; i++) {
+                int c0 = runs[0];
+                int c1 = c0 + runs[1] + 1;
+                runs += 2;
+                for (int c = c0; c < c1; c++) {
+                    color_t v = (color_t)((image->strip(c >> 3)[y2] >> (c & 7)) & 0x01);
+                    drawDot(x + w - 1 - c, y + y2, v);
+                }
+            }
+        }
+    } else {
+        // Each strip is a plane of (up to) 8 columns, strip s holds the columns from 8s.
+        for (int s = 0; (s * 8) < w; s++) {
+            int pw = w - (s * 8);
+            if (pw > 8) pw = 8;
+            mono_plane_t plane = { pw, h, image->strip(s) };
+            blitPanels(x + w - (s * 8) - pw, y, &plane);
+        }
+    }
+}
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawAssetCentered(int x, int y, AssetImage * image)
+{
+    drawAsset(x, y, image, true, false);
+}
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawAssetOffset(int x, int y, AssetImage * image)
+{
+    drawAsset(x, y, image, false, true);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Panel Blit
+ *----------------------------------------------------------------------
+ */
+
+template <typename G>
+bool
+CyclicMonoDrawerT<G>::isVisible(int x) const
+{
+    return panelColumn(x) >= 0;
+}
+
+template <typename G>
+bool
+CyclicMonoDrawerT<G>::isVisible(int x1, int x2)
+{
+    bool visible = false;
+    forEachVisible(x1, x2, [&](int, int, int, int) { visible = true; });
+    return visible;
+}
+
+// Plane column c is at screen x (s0 + c), s0 = screenX(x + width - 1).
+// The panel i shows screen x [i * DISTANCE, i * DISTANCE + WIDTH),
+// so the plane column d = (i * DISTANCE - s0) mod V_WIDTH is at the
+// panel column 0, and the plane may also start inside the panel when it
+// wraps around the cylinder. Margins are never touched.
+template <typename G>
+void
+CyclicMonoDrawerT<G>::blitPanels(int x, int y, const mono_plane_t * plane, mono_rop_t rop)
+{
+    int s0 = screen_->screenX(x + plane->width_ - 1);
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        mono_surface_t surface = { G::WIDTH, G::HEIGHT, screen_->screens_[i].getBuffer() };
+        int d = ((i * G::DISTANCE) - s0 + G::V_WIDTH) % G::V_WIDTH;
+        if (d < plane->width_) {
+            mono_blit(&surface, 0, y, plane, d, 0, G::WIDTH, plane->height_, rop);
+        }
+        if ((d + G::WIDTH) > G::V_WIDTH) {
+            mono_blit(&surface, G::V_WIDTH - d, y, plane, 0, 0, G::WIDTH, plane->height_, rop);
+        }
+    }
+}
+
+// Solid source to cylinder x [x1, x2], on the visible spans.
+template <typename G>
+void
+CyclicMonoDrawerT<G>::fillPanels(int x1, int x2, int y1, int y2, mono_rop_t rop)
+{
+    forEachVisible(x1, x2, [&](int lo, int hi, int panel, int column) {
+        mono_surface_t surface = { G::WIDTH, G::HEIGHT, screen_->screens_[panel].getBuffer() };
+        mono_fill(&surface, column - (hi - lo), y1, hi - lo + 1, y2 - y1 + 1, rop);
+    });
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Bridge Sprites
+ *----------------------------------------------------------------------
+ */
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::setSpriteList(sprite_list_t * list, SpriteRegistry * registry)
+{
+    spriteList_ = list;
+    spriteRegistry_ = registry;
+    if (spriteList_ != nullptr) {
+        spriteList_->flags_ = 0;
+        spriteList_->count_ = 0;
+    }
+}
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawSprite(int x, int y, MonoImage * image, bool centered, bool offset)
+{
+    int handle = -1;
+    if (spriteList_ != nullptr && spriteRegistry_ != nullptr && spriteList_->count_ < SPRITE_MAX_INSTANCES) {
+        handle = spriteRegistry_->getHandle(image->image_);
+    }
+    if (handle < 0) {
+        // Bridge sprites are not available, rasterize here.
+        drawImage(x, y, image, true, centered, offset);
+        return;
+    }
+
+    if (centered) {
+        x -= (image->width() / 2);
+        y -= (image->height() / 2);
+    }
+    if (offset) {
+        x += image->drawOffsetX();
+        y += image->drawOffsetY();
+    }
+    if (y >= height_ || (y + image->height()) <= 0) return;
+
+    // The row bit 0 is the right end pixel of the image. (screen x is mirrored)
+    sprite_instance_t * instance = &spriteList_->instances_[spriteList_->count_];
+    instance->handle_ = (uint16_t)handle;
+    instance->x_ = (int16_t)screen_->screenX(x + image->width() - 1);
+    instance->y_ = (int16_t)y;
+    spriteList_->count_++;
+}
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawSpriteCentered(int x, int y, MonoImage * image)
+{
+    drawSprite(x, y, image, true, false);
+}
+
+template <typename G>
+void
+CyclicMonoDrawerT<G>::drawSpriteOffset(int x, int y, MonoImage * image)
+{
+    drawSprite(x, y, image, false, true);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Instantiation
+ *----------------------------------------------------------------------
+ */
+
+// The geometry of this build. The host tools include this file for the others.
+template class CyclicMonoDrawerT<CvScreenGeometry>;
@@ -14,8 +14,15 @@
 #include <functional>
 
 #include "screen_config.hpp"
+#include "fixed_math.hpp"
 #include "cyclic_mono_screen.hpp"
 #include "mono_image.hpp"
+#include "mono_blit.hpp"
+#include "mono_dither.hpp"
+#include "font.hpp"
+#include "asset_pack.hpp"
+#include "sprite_format.hpp"
+#include "sprite_registry.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -42,14 +49,17 @@
  *----------------------------------------------------------------------
  */
 
-class CyclicMonoDrawer
+// Drawer of the geometry G. (cv_geometry.hpp) The visible spans and the
+// margin table are the constants of G.
+template <typename G>
+class CyclicMonoDrawerT
 {
 public:
-    explicit CyclicMonoDrawer();
-    virtual ~CyclicMonoDrawer();
+    explicit CyclicMonoDrawerT();
+    virtual ~CyclicMonoDrawerT();
 
 public:
-    void init(CyclicMonoScreen * screen);
+    void init(CyclicMonoScreenT<G> * screen);
 
 public:
     int         width(void) { return width_; }
@@ -60,13 +70,14 @@ public:
     color_t     getDot(int x, int y) const;
     void        setDot(int x, int y, color_t c = DISP_COLOR_WHITE);
     int         drawDot(int x, int y, color_t c = DISP_COLOR_WHITE);
+    void        drawDots(const int16_t * x, const int16_t * y, int count, int xoffset = 0, color_t c = DISP_COLOR_WHITE);
     int         drawHLine(int x1, int x2, int y, color_t c = DISP_COLOR_WHITE);
     int         drawVLine(int x, int y1, int y2, color_t c = DISP_COLOR_WHITE);
     int         drawLine(int x1, int y1, int x2, int y2, color_t c = DISP_COLOR_WHITE);
     int         drawRect(int x1, int y1, int x2, int y2, color_t c = DISP_COLOR_WHITE, bool fill = false);
     int         drawRectNoFill(int x1, int y1, int x2, int y2, color_t c = DISP_COLOR_WHITE);
     int         drawRectFill(int x1, int y1, int x2, int y2, color_t c = DISP_COLOR_WHITE);
-    int         drawTriangleFillScanLine(double& l_x, double& l_a, double& r_x, double& r_a, int& sy, int ey, color_t c = DISP_COLOR_WHITE);
+    int         drawTriangleFillScanLine(fixed_t& l_x, fixed_t& l_a, fixed_t& r_x, fixed_t& r_a, int& sy, int ey, color_t c = DISP_COLOR_WHITE);
     int         drawTriangleFill(int x1, int y1, int x2, int y2, int x3, int y3, color_t c = DISP_COLOR_WHITE);
     int         drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, color_t c = DISP_COLOR_WHITE);
     void        drawCircle(int x0, int y0, int radius, color_t c = DISP_COLOR_WHITE);
@@ -81,12 +92,70 @@ public:
     void        drawImageOffsetCentered(int x, int y, MonoImage * image);
     void        drawImageBlendOffset(int x, int y, MonoImage * image);
     void        drawImageBlendOffsetCentered(int x, int y, MonoImage * image);
+    void        drawPlane(int x, int y, const mono_plane_t * plane, bool centered = false);
+    void        drawGray(int x, int y, const gray_image_t * image, mono_dither_t method = MONO_DITHER_BAYER, int level = MONO_DITHER_LEVEL_MAX, bool centered = false);
+    int         drawText(int x, int y, const Font * font, const char * text, text_layout_t layout = TEXT_LAYOUT_PROPORTIONAL, bool centered = false);
+    void        drawAsset(int x, int y, AssetImage * image, bool centered = false, bool offset = false);
+    void        drawAssetCentered(int x, int y, AssetImage * image);
+    void        drawAssetOffset(int x, int y, AssetImage * image);
+
+public:
+    void        setSpriteList(sprite_list_t * list, SpriteRegistry * registry);
+    void        drawSprite(int x, int y, MonoImage * image, bool centered = false, bool offset = false);
+    void        drawSpriteCentered(int x, int y, MonoImage * image);
+    void        drawSpriteOffset(int x, int y, MonoImage * image);
+
+public:
+    bool        isVisible(int x) const;
+    bool        isVisible(int x1, int x2);
+
+    // Call func(x1, x2, panel, column) for each visible part of cylinder x
+    // [x1, x2]. x1 / x2 are not wrapped, column is the panel column of x1.
+    template <typename F>
+    void        forEachVisible(int x1, int x2, F func) {
+        if (x1 > x2) { int t = x1; x1 = x2; x2 = t; }
+        if ((x2 - x1) >= G::V_WIDTH) x2 = x1 + G::V_WIDTH - 1;
+        int base = x1 % G::V_WIDTH;
+        if (base < 0) base += G::V_WIDTH;
+        for (base = x1 - base; base <= x2; base += G::V_WIDTH) {
+            for (int i = 0; i < G::SPANS.count_; i++) {
+                const cv_visible_span_t * span = &G::SPANS.s_[i];
+                int s1 = base + span->x1_;
+                if (s1 > x2) break;
+                int lo = (x1 > s1)? x1 : s1;
+                int hi = (x2 < base + span->x2_)? x2 : base + span->x2_;
+                if (lo > hi) continue;
+                func(lo, hi, (int)span->panel_, span->column_ - (lo - s1));
+            }
+        }
+    }
+
+private:
+    // Panel dot of cylinder x, (panel * WIDTH + column) or -1 on margin.
+    int         panelColumn(int x) const {
+        return G::COLUMNS.v_[G::wrap(x)];
+    }
+    int         setPanelDot(int v, int y, color_t c) {
+        if (v < 0 || y < 0 || height_ <= y) return -1;
+        screen_->screens_[v / G::WIDTH].setDot(v % G::WIDTH, y, c);
+        return 0;
+    }
+
+private:
+    void        blitPanels(int x, int y, const mono_plane_t * plane, mono_rop_t rop = MONO_ROP_COPY);
+    void        fillPanels(int x1, int x2, int y1, int y2, mono_rop_t rop);
 
 private:
     int width_;
     int height_;
     int pixels_;
 
+    sprite_list_t * spriteList_ = nullptr;
+    SpriteRegistry * spriteRegistry_ = nullptr;
+
 public:
-    CyclicMonoScreen * screen_;
+    CyclicMonoScreenT<G> * screen_;
 };
+
+typedef CyclicMonoDrawerT<CvScreenGeometry> CyclicMonoDrawer;
+extern template class CyclicMonoDrawerT<CvScreenGeometry>;
@@ -51,24 +51,75 @@
  *----------------------------------------------------------------------
  */
 
-class CyclicMonoScreen : public ScreenBase<bool>
+// The panels of the geometry G around the cylinder. (cv_geometry.hpp)
+template <typename G>
+class CyclicMonoScreenT : public ScreenBase<bool>
 {
 public:
-    explicit CyclicMonoScreen();
-    virtual ~CyclicMonoScreen();
+    explicit CyclicMonoScreenT() {}
+    virtual ~CyclicMonoScreenT() {}
 
 public:
-    int width(void) override { return CV_V_WIDTH; }
-    int height(void) override { return CV_HEIGHT; }
-    int pixels(void) override { return CV_V_PIXELS; }
+    int width(void) override { return G::V_WIDTH; }
+    int height(void) override { return G::HEIGHT; }
+    int pixels(void) override { return G::V_PIXELS; }
     bool getClearColor(void) override { return false; }
     void clear(bool c = 0) override;
     void setDot(int x, int y, bool c) override;
     bool getDot(int x, int y) override;
 
 public:
-    MonoScreen * getMonoScreen(int index);
+    MonoScreenT<G> * getMonoScreen(int index) { return &screens_[index]; }
+    // Convert cylinder x to screen x (0 ~ V_WIDTH - 1), same mapping to setDot().
+    int screenX(int x) { return G::screenX(x); }
 
 public:
-    MonoScreen screens_[CV_DISPLAYS];
+    MonoScreenT<G> screens_[G::DISPLAYS];
 };
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+template <typename G>
+void
+CyclicMonoScreenT<G>::clear(bool c)
+{
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        screens_[i].clear(c);
+    }
+}
+
+// The panel and the column of the cylinder x are from the table of the
+// geometry, no division by the panel distance.
+template <typename G>
+bool
+CyclicMonoScreenT<G>::getDot(int x, int y)
+{
+    if (y < 0 || G::HEIGHT <= y) return 0;
+
+    int v = G::COLUMNS.v_[G::wrap(x)];
+    if (v < 0) {
+        // margin area
+        return 0;
+    }
+    return screens_[v / G::WIDTH].getDot(v % G::WIDTH, y);
+}
+
+template <typename G>
+void
+CyclicMonoScreenT<G>::setDot(int x, int y, bool c)
+{
+    if (y < 0 || G::HEIGHT <= y) return;
+
+    int v = G::COLUMNS.v_[G::wrap(x)];
+    if (v < 0) {
+        // margin area
+        return;
+    }
+    screens_[v / G::WIDTH].setDot(v % G::WIDTH, y, c);
+}
+
+typedef CyclicMonoScreenT<CvScreenGeometry> CyclicMonoScreen;
+extern template class CyclicMonoScreenT<CvScreenGeometry>;
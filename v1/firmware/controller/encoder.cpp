@@ -111,6 +111,15 @@ float encoder_get_angle_pwm(void)
     return( (float) (len - pwm_min_us_) / (float)pwm_len_us_) * (2.0 * M_PI);
 }
 
+// Angle in ENCODER_COUNTS per revolution, without float.
+uint16_t encoder_get_count_pwm(void)
+{
+    uint32_t len = int_len_us_;
+    if (len > pwm_max_us_) len = pwm_max_us_;
+    if (len < pwm_min_us_) len = pwm_min_us_;
+    return (uint16_t)(((len - pwm_min_us_) << ENCODER_COUNT_BITS) / pwm_len_us_);
+}
+
 uint32_t encoder_get_raw_data_pwm(void)
 {
     // @TODO support angleOffset_
@@ -119,12 +128,18 @@ uint32_t encoder_get_raw_data_pwm(void)
 
 float encoder_get_angle_spi(void)
 {
-	return ((float)((readAngle() + angleOffset_) % 0x3FFF) / 0x4000) * (2.0 * M_PI);
+	return ((float)encoder_get_count_spi() / ENCODER_COUNTS) * (2.0 * M_PI);
+}
+
+// Angle in ENCODER_COUNTS per revolution, without float.
+uint16_t encoder_get_count_spi(void)
+{
+    return (readAngle() + angleOffset_) & (ENCODER_COUNTS - 1);
 }
 
 uint32_t encoder_get_raw_data_spi(void)
 {
-    return (readAngle() + angleOffset_) % 0x3FFF;
+    return encoder_get_count_spi();
 }
 
 void encoder_set_angle_offset(uint16_t offset)
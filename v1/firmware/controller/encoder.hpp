@@ -20,6 +20,9 @@
  *----------------------------------------------------------------------
  */
 
+#define ENCODER_COUNT_BITS  (14)    // AS5048A resolution
+#define ENCODER_COUNTS      (1 << ENCODER_COUNT_BITS)
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Class definitions
  *----------------------------------------------------------------------
@@ -29,6 +32,7 @@ void encoder_init_pwm(
     int pin_pwm
 );
 float encoder_get_angle_pwm(void);
+uint16_t encoder_get_count_pwm(void);
 uint32_t encoder_get_raw_data_pwm(void);
 
 void encoder_init_spi(
@@ -38,5 +42,6 @@ void encoder_init_spi(
     int pin_tx
 );
 float encoder_get_angle_spi(void);
+uint16_t encoder_get_count_spi(void);
 uint32_t encoder_get_raw_data_spi(void);
 void encoder_set_angle_offset(uint16_t offset);
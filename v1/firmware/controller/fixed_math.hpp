@@ -0,0 +1,123 @@
+/**********************************************************************/
+/**
+ * @brief  Fixed Point (16.16) Math
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// RP2040 has no FPU, use 16.16 fixed point instead of float / double.
+
+typedef int32_t fixed_t;
+
+#define FIXED_SHIFT         (16)
+#define FIXED_ONE           ((fixed_t)1 << FIXED_SHIFT)
+#define FIXED_HALF          ((fixed_t)1 << (FIXED_SHIFT - 1))
+
+// Binary angle, FIXED_ANGLE_FULL is 360 degree.
+#define FIXED_ANGLE_BITS    (16)
+#define FIXED_ANGLE_FULL    ((uint32_t)1 << FIXED_ANGLE_BITS)
+
+#define FIXED_SIN_TABLE_BITS    (8)     // Quarter wave table entries (+1)
+
+extern const fixed_t fixed_sin_table[(1 << FIXED_SIN_TABLE_BITS) + 1];
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static inline fixed_t fixed_from_int(int v)
+{
+    return (fixed_t)((uint32_t)v << FIXED_SHIFT);
+}
+
+// Same to (int)v, truncate toward zero
+static inline int fixed_trunc(fixed_t v)
+{
+    return (v >= 0)? (v >> FIXED_SHIFT) : -((-v) >> FIXED_SHIFT);
+}
+
+// Same to floor(v + 0.5)
+static inline int fixed_round(fixed_t v)
+{
+    return (v + FIXED_HALF) >> FIXED_SHIFT;
+}
+
+// Same to (int)(v + 0.5), truncate toward zero
+static inline int fixed_round_trunc(fixed_t v)
+{
+    return fixed_trunc(v + FIXED_HALF);
+}
+
+static inline fixed_t fixed_mul(fixed_t a, fixed_t b)
+{
+    return (fixed_t)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+static inline fixed_t fixed_div(fixed_t a, fixed_t b)
+{
+    return (fixed_t)(((int64_t)a << FIXED_SHIFT) / b);
+}
+
+// (a / b) as fixed point, for integer edge slopes.
+static inline fixed_t fixed_ratio(int a, int b)
+{
+    int64_t n = (int64_t)a << FIXED_SHIFT;
+    if (b < 0) { n = -n; b = -b; }
+    return (fixed_t)((n >= 0)? ((n + (b / 2)) / b) : -((-n + (b / 2)) / b));
+}
+
+static inline uint32_t fixed_angle_from_deg(int deg)
+{
+    return (uint32_t)(((int64_t)deg * FIXED_ANGLE_FULL) / 360) & (FIXED_ANGLE_FULL - 1);
+}
+
+// sin / cos of the binary angle, linear interpolation of the quarter wave table.
+static inline fixed_t fixed_sin(uint32_t angle)
+{
+    const int quarterBits = FIXED_ANGLE_BITS - 2;
+    const int fracBits = quarterBits - FIXED_SIN_TABLE_BITS;
+    const uint32_t quarter = (uint32_t)1 << quarterBits;
+
+    angle &= (FIXED_ANGLE_FULL - 1);
+    uint32_t q = angle >> quarterBits;
+    uint32_t pos = angle & (quarter - 1);
+    if (q & 1) pos = quarter - pos;
+
+    uint32_t i = pos >> fracBits;
+    uint32_t frac = pos & ((1 << fracBits) - 1);
+    fixed_t v = fixed_sin_table[i];
+    if (frac != 0) {
+        v += ((fixed_sin_table[i + 1] - v) * (fixed_t)frac) >> fracBits;
+    }
+    return (q & 2)? -v : v;
+}
+
+static inline fixed_t fixed_cos(uint32_t angle)
+{
+    return fixed_sin(angle + (FIXED_ANGLE_FULL / 4));
+}
+
+// tan, saturated to +-limit near +-90 degree.
+static inline fixed_t fixed_tan(uint32_t angle, fixed_t limit)
+{
+    fixed_t s = fixed_sin(angle);
+    fixed_t c = fixed_cos(angle);
+    int64_t absS = (s < 0)? -(int64_t)s : s;
+    int64_t absC = (c < 0)? -(int64_t)c : c;
+    if ((absS << FIXED_SHIFT) >= (int64_t)limit * absC) {
+        return ((s < 0) != (c < 0))? -limit : limit;
+    }
+    return fixed_div(s, c);
+}
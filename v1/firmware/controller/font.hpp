@@ -0,0 +1,110 @@
+/**********************************************************************/
+/**
+ * @brief  Bitmap Font (Panel Native Glyphs)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "mono_image.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Font is made by the host font compiler (v1/tools/fontc).
+//
+// A glyph is the ink box of the character, all glyphs are the font height.
+// Glyph data is panel native (see mono_plane_t) : strips of 8 columns,
+// height_ bytes each, one after another, so a glyph is a mono_plane_t as
+// is. Column c of a glyph holds the pixel at x = (width_ - 1 - c), the
+// columns past width_ in the last strip are 0.
+//
+// Layouts, no kerning :
+//   Monospace    : every character advances cell_, the glyph is at left_.
+//   Proportional : the glyph advances width_ + spacing_, a blank glyph
+//                  (e.g. the space) advances space_.
+
+typedef enum text_layout_ {
+    TEXT_LAYOUT_PROPORTIONAL = 0,
+    TEXT_LAYOUT_MONOSPACE,
+} text_layout_t;
+
+typedef struct font_glyph_ {
+    uint32_t offset_;           // Offset of the strips in data_
+    uint8_t  width_;            // Ink width, 0 : blank
+    uint8_t  left_;             // Ink left in the monospace cell
+} font_glyph_t;
+
+typedef struct font_ {
+    const char * name_;
+    uint8_t first_;             // Code of glyphs_[0]
+    uint8_t count_;
+    uint8_t height_;
+    uint8_t cell_;              // Monospace advance
+    uint8_t spacing_;           // Proportional gap between the glyphs
+    uint8_t space_;             // Proportional advance of a blank glyph
+    uint8_t widthMax_;          // Widest glyph
+    const font_glyph_t * glyphs_;
+    const uint8_t * data_;
+} font_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class Font
+{
+public:
+    explicit Font(const font_t * font) {
+        font_ = font;
+    }
+    virtual ~Font() {}
+
+public:
+    int height(void) const { return font_->height_; }
+    int cell(void) const { return font_->cell_; }
+    int widthMax(void) const { return font_->widthMax_; }
+
+public:
+    // The glyph of the code, a code out of the font is a blank.
+    const font_glyph_t * glyph(uint8_t code) const {
+        int index = (int)code - font_->first_;
+        if (index < 0 || index >= font_->count_) return &blank_;
+        return &font_->glyphs_[index];
+    }
+    // Ink x of the glyph from the pen position.
+    int left(const font_glyph_t * g, text_layout_t layout) const {
+        return (layout == TEXT_LAYOUT_MONOSPACE)? g->left_ : 0;
+    }
+    int advance(const font_glyph_t * g, text_layout_t layout) const {
+        if (layout == TEXT_LAYOUT_MONOSPACE) return font_->cell_;
+        return (g->width_ == 0)? font_->space_ : (g->width_ + font_->spacing_);
+    }
+    int textWidth(const char * text, text_layout_t layout) const {
+        int w = 0;
+        for (const char * p = text; *p != '\0'; p++) {
+            w += advance(glyph((uint8_t)*p), layout);
+        }
+        return w;
+    }
+    void plane(const font_glyph_t * g, mono_plane_t * plane) const {
+        plane->width_  = g->width_;
+        plane->height_ = font_->height_;
+        plane->buffer_ = font_->data_ + g->offset_;
+    }
+
+public:
+    const font_t * font_;
+
+private:
+    static constexpr font_glyph_t blank_ = { 0, 0, 0 };
+};
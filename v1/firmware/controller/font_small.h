@@ -0,0 +1,153 @@
+// name : font_small
+// 94 glyphs, height 7, cell 6, 1438 bytes
+
+const uint8_t font_small_data[] = {
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x01, 0x05, 0x05, 0x05, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x0a, 
+    0x1f, 0x0a, 0x1f, 0x0a, 0x0a, 0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04, 0x18, 0x19, 0x02, 0x04, 
+    0x08, 0x13, 0x03, 0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d, 0x03, 0x01, 0x02, 0x00, 0x00, 0x00, 
+    0x00, 0x01, 0x02, 0x04, 0x04, 0x04, 0x02, 0x01, 0x04, 0x02, 0x01, 0x01, 0x01, 0x02, 0x04, 0x00, 
+    0x0a, 0x04, 0x1f, 0x04, 0x0a, 0x00, 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 
+    0x00, 0x03, 0x01, 0x02, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+    0x03, 0x03, 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e, 
+    0x02, 0x06, 0x02, 0x02, 0x02, 0x02, 0x07, 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f, 0x1f, 0x02, 
+    0x04, 0x02, 0x01, 0x11, 0x0e, 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02, 0x1f, 0x10, 0x1e, 0x01, 
+    0x01, 0x11, 0x0e, 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e, 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 
+    0x08, 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e, 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c, 0x00, 
+    0x03, 0x03, 0x00, 0x03, 0x03, 0x00, 0x00, 0x03, 0x03, 0x00, 0x03, 0x01, 0x02, 0x01, 0x02, 0x04, 
+    0x08, 0x04, 0x02, 0x01, 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00, 0x08, 0x04, 0x02, 0x01, 0x02, 
+    0x04, 0x08, 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04, 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e, 
+    0x0e, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e, 0x0e, 0x11, 
+    0x10, 0x10, 0x10, 0x11, 0x0e, 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c, 0x1f, 0x10, 0x10, 0x1e, 
+    0x10, 0x10, 0x1f, 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10, 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 
+    0x0f, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11, 0x07, 0x02, 0x02, 0x02, 0x02, 0x02, 0x07, 0x07, 
+    0x02, 0x02, 0x02, 0x02, 0x12, 0x0c, 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x10, 0x10, 0x10, 
+    0x10, 0x10, 0x10, 0x1f, 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x19, 0x15, 0x13, 
+    0x11, 0x11, 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10, 
+    0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d, 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11, 0x0f, 0x10, 
+    0x10, 0x0e, 0x01, 0x01, 0x1e, 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x11, 0x11, 0x11, 0x11, 
+    0x11, 0x11, 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 
+    0x0a, 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x1f, 
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x1f, 0x07, 0x04, 0x04, 0x04, 0x04, 0x04, 0x07, 0x00, 0x10, 0x08, 
+    0x04, 0x02, 0x01, 0x00, 0x07, 0x01, 0x01, 0x01, 0x01, 0x01, 0x07, 0x04, 0x0a, 0x11, 0x00, 0x00, 
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x04, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 
+    0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f, 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e, 0x00, 0x00, 
+    0x0e, 0x10, 0x10, 0x11, 0x0e, 0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f, 0x00, 0x00, 0x0e, 0x11, 
+    0x1f, 0x10, 0x0e, 0x06, 0x09, 0x08, 0x1c, 0x08, 0x08, 0x08, 0x00, 0x0f, 0x11, 0x11, 0x0f, 0x01, 
+    0x0e, 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11, 0x02, 0x00, 0x06, 0x02, 0x02, 0x02, 0x07, 0x01, 
+    0x00, 0x03, 0x01, 0x01, 0x09, 0x06, 0x08, 0x08, 0x09, 0x0a, 0x0c, 0x0a, 0x09, 0x06, 0x02, 0x02, 
+    0x02, 0x02, 0x02, 0x07, 0x00, 0x00, 0x1a, 0x15, 0x15, 0x11, 0x11, 0x00, 0x00, 0x16, 0x19, 0x11, 
+    0x11, 0x11, 0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e, 0x00, 0x00, 0x1e, 0x11, 0x1e, 0x10, 0x10, 
+    0x00, 0x00, 0x0d, 0x13, 0x0f, 0x01, 0x01, 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00, 0x00, 
+    0x0e, 0x10, 0x0e, 0x01, 0x1e, 0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06, 0x00, 0x00, 0x11, 0x11, 
+    0x11, 0x13, 0x0d, 0x00, 0x00, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 
+    0x0a, 0x00, 0x00, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x00, 0x00, 0x11, 0x11, 0x0f, 0x01, 0x0e, 0x00, 
+    0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f, 0x01, 0x02, 0x02, 0x04, 0x02, 0x02, 0x01, 0x01, 0x01, 0x01, 
+    0x01, 0x01, 0x01, 0x01, 0x04, 0x02, 0x02, 0x01, 0x02, 0x02, 0x04, 0x00, 0x00, 0x08, 0x15, 0x02, 
+    0x00, 0x00, 
+};
+
+const font_glyph_t font_small_glyphs[] = {
+    { 0x00000000, 0, 0 },  // 0x20  
+    { 0x00000000, 1, 2 },  // 0x21 !
+    { 0x00000007, 3, 1 },  // 0x22 "
+    { 0x0000000e, 5, 0 },  // 0x23 #
+    { 0x00000015, 5, 0 },  // 0x24 $
+    { 0x0000001c, 5, 0 },  // 0x25 %
+    { 0x00000023, 5, 0 },  // 0x26 &
+    { 0x0000002a, 2, 1 },  // 0x27 '
+    { 0x00000031, 3, 1 },  // 0x28 (
+    { 0x00000038, 3, 1 },  // 0x29 )
+    { 0x0000003f, 5, 0 },  // 0x2a *
+    { 0x00000046, 5, 0 },  // 0x2b +
+    { 0x0000004d, 2, 1 },  // 0x2c ,
+    { 0x00000054, 5, 0 },  // 0x2d -
+    { 0x0000005b, 2, 1 },  // 0x2e .
+    { 0x00000062, 5, 0 },  // 0x2f /
+    { 0x00000069, 5, 0 },  // 0x30 0
+    { 0x00000070, 3, 1 },  // 0x31 1
+    { 0x00000077, 5, 0 },  // 0x32 2
+    { 0x0000007e, 5, 0 },  // 0x33 3
+    { 0x00000085, 5, 0 },  // 0x34 4
+    { 0x0000008c, 5, 0 },  // 0x35 5
+    { 0x00000093, 5, 0 },  // 0x36 6
+    { 0x0000009a, 5, 0 },  // 0x37 7
+    { 0x000000a1, 5, 0 },  // 0x38 8
+    { 0x000000a8, 5, 0 },  // 0x39 9
+    { 0x000000af, 2, 1 },  // 0x3a :
+    { 0x000000b6, 2, 1 },  // 0x3b ;
+    { 0x000000bd, 4, 0 },  // 0x3c <
+    { 0x000000c4, 5, 0 },  // 0x3d =
+    { 0x000000cb, 4, 1 },  // 0x3e >
+    { 0x000000d2, 5, 0 },  // 0x3f ?
+    { 0x000000d9, 5, 0 },  // 0x40 @
+    { 0x000000e0, 5, 0 },  // 0x41 A
+    { 0x000000e7, 5, 0 },  // 0x42 B
+    { 0x000000ee, 5, 0 },  // 0x43 C
+    { 0x000000f5, 5, 0 },  // 0x44 D
+    { 0x000000fc, 5, 0 },  // 0x45 E
+    { 0x00000103, 5, 0 },  // 0x46 F
+    { 0x0000010a, 5, 0 },  // 0x47 G
+    { 0x00000111, 5, 0 },  // 0x48 H
+    { 0x00000118, 3, 1 },  // 0x49 I
+    { 0x0000011f, 5, 0 },  // 0x4a J
+    { 0x00000126, 5, 0 },  // 0x4b K
+    { 0x0000012d, 5, 0 },  // 0x4c L
+    { 0x00000134, 5, 0 },  // 0x4d M
+    { 0x0000013b, 5, 0 },  // 0x4e N
+    { 0x00000142, 5, 0 },  // 0x4f O
+    { 0x00000149, 5, 0 },  // 0x50 P
+    { 0x00000150, 5, 0 },  // 0x51 Q
+    { 0x00000157, 5, 0 },  // 0x52 R
+    { 0x0000015e, 5, 0 },  // 0x53 S
+    { 0x00000165, 5, 0 },  // 0x54 T
+    { 0x0000016c, 5, 0 },  // 0x55 U
+    { 0x00000173, 5, 0 },  // 0x56 V
+    { 0x0000017a, 5, 0 },  // 0x57 W
+    { 0x00000181, 5, 0 },  // 0x58 X
+    { 0x00000188, 5, 0 },  // 0x59 Y
+    { 0x0000018f, 5, 0 },  // 0x5a Z
+    { 0x00000196, 3, 1 },  // 0x5b [
+    { 0x0000019d, 5, 0 },  // 0x5c
+    { 0x000001a4, 3, 1 },  // 0x5d ]
+    { 0x000001ab, 5, 0 },  // 0x5e ^
+    { 0x000001b2, 5, 0 },  // 0x5f _
+    { 0x000001b9, 3, 1 },  // 0x60 `
+    { 0x000001c0, 5, 0 },  // 0x61 a
+    { 0x000001c7, 5, 0 },  // 0x62 b
+    { 0x000001ce, 5, 0 },  // 0x63 c
+    { 0x000001d5, 5, 0 },  // 0x64 d
+    { 0x000001dc, 5, 0 },  // 0x65 e
+    { 0x000001e3, 5, 0 },  // 0x66 f
+    { 0x000001ea, 5, 0 },  // 0x67 g
+    { 0x000001f1, 5, 0 },  // 0x68 h
+    { 0x000001f8, 3, 1 },  // 0x69 i
+    { 0x000001ff, 4, 0 },  // 0x6a j
+    { 0x00000206, 4, 0 },  // 0x6b k
+    { 0x0000020d, 3, 1 },  // 0x6c l
+    { 0x00000214, 5, 0 },  // 0x6d m
+    { 0x0000021b, 5, 0 },  // 0x6e n
+    { 0x00000222, 5, 0 },  // 0x6f o
+    { 0x00000229, 5, 0 },  // 0x70 p
+    { 0x00000230, 5, 0 },  // 0x71 q
+    { 0x00000237, 5, 0 },  // 0x72 r
+    { 0x0000023e, 5, 0 },  // 0x73 s
+    { 0x00000245, 5, 0 },  // 0x74 t
+    { 0x0000024c, 5, 0 },  // 0x75 u
+    { 0x00000253, 5, 0 },  // 0x76 v
+    { 0x0000025a, 5, 0 },  // 0x77 w
+    { 0x00000261, 5, 0 },  // 0x78 x
+    { 0x00000268, 5, 0 },  // 0x79 y
+    { 0x0000026f, 5, 0 },  // 0x7a z
+    { 0x00000276, 3, 1 },  // 0x7b {
+    { 0x0000027d, 1, 2 },  // 0x7c |
+    { 0x00000284, 3, 1 },  // 0x7d }
+    { 0x0000028b, 5, 0 },  // 0x7e ~
+};
+
+const font_t font_small = {
+    "small",
+    0x20, 95,
+    7, 6, 1, 3, 5,
+    font_small_glyphs,
+    font_small_data
+};
@@ -0,0 +1,226 @@
+/**********************************************************************/
+/**
+ * @brief  Frame Stream Receiver (USB Streaming Mode)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "frame_stream.hpp"
+#include "mono_video.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+FrameStream::FrameStream()
+{
+    plane_.width_ = STREAM_PLANE_WIDTH;
+    plane_.height_ = STREAM_PLANE_HEIGHT;
+    plane_.buffer_ = nullptr;
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+FrameStream::~FrameStream()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+bool
+FrameStream::init(uint8_t * plane, uint8_t * body, size_t bodySize)
+{
+    if (plane == nullptr || body == nullptr || bodySize < STREAM_PLANE_SIZE) return false;
+    plane_.buffer_ = plane;
+    body_ = body;
+    bodySize_ = bodySize;
+    reset();
+    return true;
+}
+
+void
+FrameStream::reset(void)
+{
+    state_ = STATE_HEADER;
+    headerLen_ = 0;
+    dst_ = nullptr;
+    remain_ = 0;
+    hasPlane_ = false;
+    panelTarget_ = nullptr;
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+uint8_t *
+FrameStream::rxPtr(size_t * room)
+{
+    if (state_ == STATE_HEADER) {
+        *room = STREAM_HEADER_SIZE - headerLen_;
+        return &header_[headerLen_];
+    }
+    // Discarded bytes are read to the body buffer, and not used.
+    if (state_ == STATE_DISCARD) {
+        *room = (remain_ < bodySize_)? remain_ : bodySize_;
+        return body_;
+    }
+    *room = remain_;
+    return dst_;
+}
+
+stream_event_t
+FrameStream::rxDone(size_t size)
+{
+    if (size == 0) return STREAM_EVENT_NONE;
+    stats_.bytes_ += size;
+
+    if (state_ == STATE_HEADER) {
+        headerLen_ += size;
+        if (header_[0] != STREAM_MAGIC0 || (headerLen_ > 1 && header_[1] != STREAM_MAGIC1)) {
+            resync();
+            return STREAM_EVENT_NONE;
+        }
+        if (headerLen_ < STREAM_HEADER_SIZE) return STREAM_EVENT_NONE;
+        return startBody();
+    }
+
+    remain_ -= size;
+    if (state_ == STATE_BODY) dst_ += size;
+    if (remain_ > 0) return STREAM_EVENT_NONE;
+    return endBody();
+}
+
+void
+FrameStream::makeHeader(uint8_t * header, stream_format_t format, uint8_t flags, uint16_t seq, uint32_t size)
+{
+    header[0]  = STREAM_MAGIC0;
+    header[1]  = STREAM_MAGIC1;
+    header[2]  = (uint8_t)format;
+    header[3]  = flags;
+    header[4]  = (uint8_t)(seq >> 0);
+    header[5]  = (uint8_t)(seq >> 8);
+    header[6]  = (uint8_t)(size >> 0);
+    header[7]  = (uint8_t)(size >> 8);
+    header[8]  = (uint8_t)(size >> 16);
+    header[9]  = (uint8_t)(size >> 24);
+    header[10] = (uint8_t)~header[6];
+    header[11] = (uint8_t)~header[7];
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Private
+ *----------------------------------------------------------------------
+ */
+
+stream_event_t
+FrameStream::startBody(void)
+{
+    if (header_[10] != (uint8_t)~header_[6] || header_[11] != (uint8_t)~header_[7]) {
+        resync();
+        return STREAM_EVENT_NONE;
+    }
+    headerLen_ = 0;
+    format_ = header_[2];
+    flags_ = header_[3];
+    stats_.seq_ = (uint16_t)(header_[4] | (header_[5] << 8));
+    size_ = (size_t)header_[6] | ((size_t)header_[7] << 8) | ((size_t)header_[8] << 16) | ((size_t)header_[9] << 24);
+
+    bool valid = false;
+    switch (format_) {
+    case STREAM_FORMAT_PANELS:
+        valid = (size_ == CV_FRAME_BYTES);
+        // Straight to the write slot. (the body buffer is not used)
+        dst_ = panelTarget_;
+        hasPlane_ = false;
+        break;
+    case STREAM_FORMAT_CYLINDER:
+        valid = (size_ == STREAM_PLANE_SIZE);
+        dst_ = body_;
+        break;
+    case STREAM_FORMAT_DELTA:
+        valid = (size_ <= bodySize_);
+        dst_ = body_;
+        break;
+    case STREAM_FORMAT_END:
+        valid = (size_ == 0);
+        break;
+    default:
+        break;
+    }
+    if (!valid) {
+        // The size is checked, so a bad format is skipped by its size.
+        stats_.errors_++;
+        remain_ = size_;
+        state_ = (remain_ > 0)? STATE_DISCARD : STATE_HEADER;
+        return STREAM_EVENT_NONE;
+    }
+
+    remain_ = size_;
+    if (format_ == STREAM_FORMAT_END) {
+        state_ = STATE_HEADER;
+        return STREAM_EVENT_END;
+    }
+    if (format_ == STREAM_FORMAT_PANELS && dst_ == nullptr) {
+        // No free slot, the frame is dropped.
+        stats_.dropped_++;
+        state_ = STATE_DISCARD;
+        return STREAM_EVENT_NONE;
+    }
+    state_ = STATE_BODY;
+    if (remain_ == 0) return endBody();
+    return STREAM_EVENT_NONE;
+}
+
+stream_event_t
+FrameStream::endBody(void)
+{
+    bool body = (state_ == STATE_BODY);
+    state_ = STATE_HEADER;
+    dst_ = nullptr;
+    if (!body) return STREAM_EVENT_NONE;
+
+    uint8_t * plane = (uint8_t *)plane_.buffer_;
+    switch (format_) {
+    case STREAM_FORMAT_PANELS:
+        stats_.frames_++;
+        return STREAM_EVENT_PANELS;
+    case STREAM_FORMAT_CYLINDER:
+        memcpy(plane, body_, STREAM_PLANE_SIZE);
+        break;
+    case STREAM_FORMAT_DELTA:
+        if (flags_ & STREAM_FLAG_KEYFRAME) {
+            memset(plane, 0, STREAM_PLANE_SIZE);
+        } else if (!hasPlane_) {
+            // A delta without the keyframe.
+            stats_.errors_++;
+            return STREAM_EVENT_NONE;
+        }
+        mono_video_apply(plane, STREAM_PLANE_SIZE, body_, size_);
+        break;
+    default:
+        return STREAM_EVENT_NONE;
+    }
+    stats_.frames_++;
+    hasPlane_ = true;
+    return STREAM_EVENT_PLANE;
+}
+
+// Drop the header bytes until the next magic.
+void
+FrameStream::resync(void)
+{
+    stats_.errors_++;
+    do {
+        size_t i = 1;
+        while (i < headerLen_ && header_[i] != STREAM_MAGIC0) i++;
+        headerLen_ -= i;
+        memmove(header_, &header_[i], headerLen_);
+    } while (headerLen_ > 1 && header_[1] != STREAM_MAGIC1);
+    state_ = STATE_HEADER;
+}
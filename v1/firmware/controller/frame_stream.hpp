@@ -0,0 +1,137 @@
+/**********************************************************************/
+/**
+ * @brief  Frame Stream Receiver (USB Streaming Mode)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+#include "screen_config.hpp"
+#include "mono_image.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Frames rendered on the host, sent over the USB serial after the stream
+// is enabled (v1/tools/streamtx). Each frame is a header and a body :
+//   'C' 'V' FORMAT FLAGS SEQ_L SEQ_H SIZE[4] ~SIZE_L ~SIZE_H
+//
+//   STREAM_FORMAT_PANELS   : CV_FRAME_BYTES, the panel buffers as is. Read
+//                            directly to the circular buffer write slot, or
+//                            dropped if no slot is free. (no rotation)
+//   STREAM_FORMAT_CYLINDER : STREAM_PLANE_SIZE, the whole cylinder as a
+//                            mono_plane_t (CV_V_WIDTH x CV_HEIGHT). Drawn at
+//                            the live angle for every rendered frame.
+//   STREAM_FORMAT_DELTA    : mono_video token stream XOR to the cylinder
+//                            plane, cleared first if STREAM_FLAG_KEYFRAME.
+//   STREAM_FORMAT_END      : no body, leave the streaming mode.
+//
+// Bytes are written by the caller to rxPtr(), so a body is read with one
+// readBytes() per chunk and no intermediate copy. A broken header is
+// resynced to the next 'C'.
+
+#define STREAM_MAGIC0           ('C')
+#define STREAM_MAGIC1           ('V')
+#define STREAM_HEADER_SIZE      (12)
+
+#define STREAM_PLANE_WIDTH      (CV_V_WIDTH)
+#define STREAM_PLANE_HEIGHT     (CV_HEIGHT)
+#define STREAM_PLANE_SIZE       (((STREAM_PLANE_WIDTH + 7) / 8) * STREAM_PLANE_HEIGHT)
+
+#define STREAM_FLAG_KEYFRAME    (0x01)
+
+typedef enum stream_format_ {
+    STREAM_FORMAT_PANELS = 0,
+    STREAM_FORMAT_CYLINDER,
+    STREAM_FORMAT_DELTA,
+    STREAM_FORMAT_END = 0xFF,
+} stream_format_t;
+
+typedef enum stream_event_ {
+    STREAM_EVENT_NONE = 0,
+    STREAM_EVENT_PANELS,        // A frame is in the panel target
+    STREAM_EVENT_PLANE,         // The cylinder plane is updated
+    STREAM_EVENT_END,
+} stream_event_t;
+
+typedef struct stream_stats_ {
+    uint32_t frames_;           // Frames used
+    uint32_t dropped_;          // Panel frames without a free slot
+    uint32_t errors_;           // Broken headers, bad sizes
+    uint32_t bytes_;
+    uint16_t seq_;              // Last sequence number
+} stream_stats_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class FrameStream
+{
+public:
+    explicit FrameStream();
+    virtual ~FrameStream();
+
+public:
+    // plane : STREAM_PLANE_SIZE, body : STREAM_PLANE_SIZE or more. (owned by the caller)
+    bool init(uint8_t * plane, uint8_t * body, size_t bodySize);
+    void reset(void);
+
+    // Where a panel frame goes (the write slot), nullptr if none is free.
+    // Taken when a header arrives.
+    void setPanelTarget(uint8_t * target) { panelTarget_ = target; }
+
+    // The next bytes go to the returned pointer, up to room bytes.
+    uint8_t * rxPtr(size_t * room);
+    stream_event_t rxDone(size_t size);
+
+public:
+    // The cylinder plane has valid content.
+    bool hasPlane(void) const { return hasPlane_; }
+    // A panel frame is being written to the panel target.
+    bool writingPanels(void) const { return state_ == STATE_BODY && format_ == STREAM_FORMAT_PANELS; }
+    const mono_plane_t * plane(void) const { return &plane_; }
+    const stream_stats_t * stats(void) const { return &stats_; }
+
+public:
+    static void makeHeader(uint8_t * header, stream_format_t format, uint8_t flags, uint16_t seq, uint32_t size);
+
+private:
+    stream_event_t startBody(void);
+    stream_event_t endBody(void);
+    void resync(void);
+
+private:
+    typedef enum state_ {
+        STATE_HEADER = 0,
+        STATE_BODY,
+        STATE_DISCARD,
+    } state_t;
+
+    state_t state_ = STATE_HEADER;
+    uint8_t header_[STREAM_HEADER_SIZE];
+    size_t headerLen_ = 0;
+
+    uint8_t format_ = 0;
+    uint8_t flags_ = 0;
+    uint8_t * dst_ = nullptr;
+    size_t remain_ = 0;
+    size_t size_ = 0;
+
+    uint8_t * panelTarget_ = nullptr;
+    uint8_t * body_ = nullptr;
+    size_t bodySize_ = 0;
+    mono_plane_t plane_;
+    bool hasPlane_ = false;
+    stream_stats_t stats_;
+};
@@ -19,13 +19,22 @@
  *----------------------------------------------------------------------
  */
 
-//#include "image_anim_test.h"
-//#include "image_title_cylinview.h"
-//#include "image_dispnum.h"
-//#include "image_sky1.h"
-//#include "image_sky2.h"
-//#include "image_entry.h"
-//#include "image_idle2.h"
-//#include "image_run1.h"
-//#include "image_jump1.h"
-#include "image_badapple.h"
+#include "image_anim_test.h"
+#include "image_title_cylinview.h"
+#include "image_dispnum.h"
+#include "image_sky1.h"
+#include "image_sky2.h"
+#include "image_entry.h"
+#include "image_idle2.h"
+#include "image_run1.h"
+#include "image_jump1.h"
+#include "font_small.h"
+#include "font_ticker.h"
+
+#ifdef IMAGE_DATA_HAS_VIDEO_BADAPPLE
+#include "video_badapple.h"
+#endif
+
+#ifdef IMAGE_DATA_HAS_ASSET_PACK
+#include "asset_pack.h"
+#endif
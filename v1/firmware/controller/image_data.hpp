@@ -13,20 +13,37 @@
 #include <cstdbool>
 #include <cstdint>
 #include "mono_image.hpp"
+#include "mono_video.hpp"
+#include "asset_pack.hpp"
+#include "font.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
-//extern const mono_images_t image_anim_test_frames;
-//extern const mono_images_t image_dispnum_frames;
-//extern const mono_images_t image_title_cylinview_frames;
-//extern const mono_images_t image_sky1_frames;
-//extern const mono_images_t image_sky2_frames;
-//extern const mono_images_t image_entry_frames;
-//extern const mono_images_t image_idle2_frames;
-//extern const mono_images_t image_run1_frames;
-//extern const mono_images_t image_jump1_frames;
-extern const mono_images_t image_badapple_frames;
+extern const mono_images_t image_anim_test_frames;
+extern const mono_images_t image_dispnum_frames;
+extern const mono_images_t image_title_cylinview_frames;
+extern const mono_images_t image_sky1_frames;
+extern const mono_images_t image_sky2_frames;
+extern const mono_images_t image_entry_frames;
+extern const mono_images_t image_idle2_frames;
+extern const mono_images_t image_run1_frames;
+extern const mono_images_t image_jump1_frames;
 
+// Compiled by v1/tools/fontc (built-in 5x7, scale 1 / 4).
+extern const font_t font_small;
+extern const font_t font_ticker;
+
+// Encoded by v1/tools/mvenc, not included in the repository.
+#if __has_include("video_badapple.h")
+#define IMAGE_DATA_HAS_VIDEO_BADAPPLE
+extern const mono_video_t video_badapple;
+#endif
+
+// Compiled by v1/tools/assetc, not included in the repository.
+#if __has_include("asset_pack.h")
+#define IMAGE_DATA_HAS_ASSET_PACK
+extern const asset_pack_t asset_pack;
+#endif
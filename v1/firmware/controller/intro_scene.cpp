@@ -0,0 +1,234 @@
+/**********************************************************************/
+/**
+ * @brief  Intro Scene (Render Mode 6)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include "motor.hpp"
+#include "image_data.hpp"
+
+#include "intro_scene.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define INTRO_GROUND_HEIGHT     (8)
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Steps
+ *----------------------------------------------------------------------
+ */
+
+static inline intro_scene_t *
+scene(void * context)
+{
+    return (intro_scene_t *)context;
+}
+
+static void
+enter_brake(void * context)
+{
+    motor_set_brake(true);
+}
+
+static void
+enter_spin(void * context)
+{
+    motor_set_power(-INTRO_MOTOR_POWER);
+}
+
+static void
+enter_handover(void * context)
+{
+    motor_set_power(-INTRO_MOTOR_POWER);
+    scene(context)->finished_ = true;
+}
+
+static bool
+until_zero(void * context, const timeline_frame_t * frame)
+{
+    return scene(context)->xpos_ <= INTRO_ZERO_XPOS;
+}
+
+static void
+draw_clear(void * context, const timeline_frame_t * frame)
+{
+    scene(context)->drawer_->clearFrame();
+}
+
+static void
+draw_white(void * context, const timeline_frame_t * frame)
+{
+    scene(context)->drawer_->clearFrame(DISP_COLOR_WHITE);
+}
+
+// Display numbers, value_ is the last number shown.
+static void
+draw_numbers(void * context, const timeline_frame_t * frame)
+{
+    CyclicMonoDrawer * drawer = scene(context)->drawer_;
+    drawer->clearFrame();
+    for (int i = 0; i <= frame->value_ && i < CV_DISPLAYS; i++) {
+        MonoImage image(&image_dispnum_frames.images_[i]);
+        drawer->drawSpriteCentered((i * CV_DISTANCE) + CV_WIDTH / 2, CV_HEIGHT / 2, &image);
+    }
+}
+
+static void
+draw_numbers_scroll(void * context, const timeline_frame_t * frame)
+{
+    CyclicMonoDrawer * drawer = scene(context)->drawer_;
+    int xpos = scene(context)->xpos_;
+    drawer->clearFrame();
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        MonoImage image(&image_dispnum_frames.images_[i]);
+        drawer->drawSpriteCentered((i * CV_DISTANCE) + CV_WIDTH / 2 - xpos, CV_HEIGHT / 2, &image);
+    }
+}
+
+// Center line, value_ is the half length.
+static void
+draw_line(void * context, const timeline_frame_t * frame)
+{
+    CyclicMonoDrawer * drawer = scene(context)->drawer_;
+    int xpos = scene(context)->xpos_;
+    drawer->clearFrame();
+    drawer->drawHLine(CV_WIDTH / 2 - xpos, CV_WIDTH / 2 + frame->value_ - xpos, CV_HEIGHT / 2);
+    drawer->drawHLine(CV_WIDTH / 2 - xpos, CV_WIDTH / 2 - frame->value_ - xpos, CV_HEIGHT / 2);
+}
+
+// White band around the center, value_ is the half height.
+static void
+draw_band(intro_scene_t * s, int half)
+{
+    s->drawer_->clearFrame();
+    if (half <= 0) return;
+    s->drawer_->drawRectFill(
+        0             , CV_HEIGHT / 2 - (half - 1),
+        CV_V_WIDTH - 1, CV_HEIGHT / 2 + (half - 1)
+    );
+}
+
+static void
+draw_white_grow(void * context, const timeline_frame_t * frame)
+{
+    draw_band(scene(context), frame->value_);
+}
+
+static void
+draw_logo(void * context, const timeline_frame_t * frame)
+{
+    CyclicMonoDrawer * drawer = scene(context)->drawer_;
+    drawer->clearFrame(DISP_COLOR_WHITE);
+    MonoImage image(&image_title_cylinview_frames.images_[0]);
+    drawer->drawSpriteCentered(CV_WIDTH / 2 - scene(context)->xpos_, CV_HEIGHT / 2, &image);
+}
+
+static void
+draw_logo_hide(void * context, const timeline_frame_t * frame)
+{
+    draw_band(scene(context), (CV_HEIGHT / 2) - frame->value_);
+
+    // composited on the bridges
+    MonoImage image(&image_title_cylinview_frames.images_[0]);
+    scene(context)->drawer_->drawSpriteCentered(CV_WIDTH / 2 - scene(context)->xpos_, CV_HEIGHT / 2, &image);
+}
+
+static void
+draw_snow(intro_scene_t * s, int ground)
+{
+    s->drawer_->clearFrame();
+    s->snow_->loop();
+    s->snow_->draw(s->drawer_, s->xpos_);
+    if (ground > 0) {
+        s->drawer_->drawRectFill(
+            0             , CV_HEIGHT - ground,
+            CV_V_WIDTH - 1, CV_HEIGHT - 1
+        );
+    }
+}
+
+static void
+draw_snow_only(void * context, const timeline_frame_t * frame)
+{
+    draw_snow(scene(context), 0);
+}
+
+// Ground rises, value_ is the height.
+static void
+draw_snow_ground(void * context, const timeline_frame_t * frame)
+{
+    draw_snow(scene(context), frame->value_);
+}
+
+static int
+anim_frame(const timeline_frame_t * frame)
+{
+    return (int)(frame->elapsedUs_ / INTRO_ANIM_FRAME_US);
+}
+
+static void
+draw_anim(void * context, const timeline_frame_t * frame, const mono_images_t * frames)
+{
+    draw_snow(scene(context), INTRO_GROUND_HEIGHT);
+    int n = anim_frame(frame);
+    if (n >= frames->count_) n = frames->count_ - 1;
+    MonoImage image(&frames->images_[n]);
+    scene(context)->drawer_->drawSpriteOffset(CV_WIDTH / 2, CV_HEIGHT / 2, &image);
+}
+
+static void
+draw_entry(void * context, const timeline_frame_t * frame)
+{
+    draw_anim(context, frame, &image_entry_frames);
+}
+
+static bool
+until_entry(void * context, const timeline_frame_t * frame)
+{
+    return anim_frame(frame) >= image_entry_frames.count_;
+}
+
+static void
+draw_idle(void * context, const timeline_frame_t * frame)
+{
+    draw_anim(context, frame, &image_idle2_frames);
+}
+
+static bool
+until_idle(void * context, const timeline_frame_t * frame)
+{
+    return anim_frame(frame) >= image_idle2_frames.count_;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Table
+ *----------------------------------------------------------------------
+ */
+
+const timeline_step_t intro_scene_steps[] = {
+    // name            duration              enter           draw                 until        from  to                ease
+    { "numbers",       TIMELINE_US(1830),    enter_brake,    draw_numbers,        nullptr,     0,    CV_DISPLAYS,      TIMELINE_EASE_LINEAR },
+    { "spin up",       0,                    enter_spin,     nullptr,             until_zero,  0,    0,                TIMELINE_EASE_LINEAR },
+    { "numbers scroll",TIMELINE_US(5000),    nullptr,        draw_numbers_scroll, nullptr,     0,    0,                TIMELINE_EASE_LINEAR },
+    { "center line",   TIMELINE_US(1170),    nullptr,        draw_line,           nullptr,     0,    CV_V_WIDTH / 2,   TIMELINE_EASE_LINEAR },
+    { "white",         TIMELINE_US(300),     nullptr,        draw_white_grow,     nullptr,     1,    CV_HEIGHT / 2,    TIMELINE_EASE_LINEAR },
+    { "white hold",    TIMELINE_US(1000),    nullptr,        draw_white,          nullptr,     0,    0,                TIMELINE_EASE_LINEAR },
+    { "logo",          TIMELINE_US(5000),    nullptr,        draw_logo,           nullptr,     0,    0,                TIMELINE_EASE_LINEAR },
+    { "logo hide",     TIMELINE_US(300),     nullptr,        draw_logo_hide,      nullptr,     0,    CV_HEIGHT / 2,    TIMELINE_EASE_LINEAR },
+    { "spin down",     0,                    nullptr,        draw_clear,          until_zero,  0,    0,                TIMELINE_EASE_LINEAR },
+    { "brake",         TIMELINE_US(1000),    enter_brake,    nullptr,             nullptr,     0,    0,                TIMELINE_EASE_LINEAR },
+    { "snow",          TIMELINE_US(2500),    nullptr,        draw_snow_only,      nullptr,     0,    0,                TIMELINE_EASE_LINEAR },
+    { "ground",        TIMELINE_US(4800),    nullptr,        draw_snow_ground,    nullptr,     0,    INTRO_GROUND_HEIGHT, TIMELINE_EASE_LINEAR },
+    { "entry",         0,                    nullptr,        draw_entry,          until_entry, 0,    0,                TIMELINE_EASE_LINEAR },
+    { "idle",          0,                    nullptr,        draw_idle,           until_idle,  0,    0,                TIMELINE_EASE_LINEAR },
+    { "handover",      0,                    enter_handover, nullptr,             nullptr,     0,    0,                TIMELINE_EASE_LINEAR },
+};
+
+const int intro_scene_step_count = sizeof(intro_scene_steps) / sizeof(intro_scene_steps[0]);
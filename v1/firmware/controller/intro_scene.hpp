@@ -0,0 +1,40 @@
+/**********************************************************************/
+/**
+ * @brief  Intro Scene (Render Mode 6)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "cyclic_mono_drawer.hpp"
+#include "particles.hpp"
+#include "timeline.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Display numbers, spin up, logo, spin down, snow and the character entry.
+// The times are of the old frame counted sequence at 70 fps.
+
+#define INTRO_MOTOR_POWER       (80)
+#define INTRO_ZERO_XPOS         (10)            // Wait the rotation until xpos <= this
+#define INTRO_ANIM_FRAME_US     (3000000UL / 70) // 3 frames at 70 fps
+
+// Context of the steps, owned by the caller.
+typedef struct intro_scene_ {
+    CyclicMonoDrawer * drawer_;
+    Particles * snow_;
+    int xpos_;              // Set before Timeline::update()
+    bool finished_;         // Set by the last step, then hand over to the next mode
+} intro_scene_t;
+
+extern const timeline_step_t intro_scene_steps[];
+extern const int intro_scene_step_count;
@@ -0,0 +1,380 @@
+/**********************************************************************/
+/**
+ * @brief  Bit Parallel Cellular Automaton (Life) on the Cylinder
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+#include <cstdlib>
+
+#include "life.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define LIFE_ROW_LAST_MASK      ((LIFE_ROW_LAST_BITS >= 32)? 0xFFFFFFFFUL : ((1UL << (LIFE_ROW_LAST_BITS & 31)) - 1))
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Bit sliced count of 8 neighbours, (b3 b2 b1 b0) = 0 ~ 8.
+static inline void
+life_count(
+    uint32_t n0, uint32_t n1, uint32_t n2, uint32_t n3,
+    uint32_t n4, uint32_t n5, uint32_t n6, uint32_t n7,
+    uint32_t * b0, uint32_t * b1, uint32_t * b2, uint32_t * b3
+) {
+    // Full adders (3 : 2), and a half adder.
+    uint32_t sa = n0 ^ n1 ^ n2, ca = (n0 & n1) | (n2 & (n0 ^ n1));
+    uint32_t sb = n3 ^ n4 ^ n5, cb = (n3 & n4) | (n5 & (n3 ^ n4));
+    uint32_t sc = n6 ^ n7,      cc = n6 & n7;
+    // Weight 1
+    uint32_t d = (sa & sb) | (sc & (sa ^ sb));
+    *b0 = sa ^ sb ^ sc;
+    // Weight 2 : ca + cb + cc + d
+    uint32_t ts = ca ^ cb ^ cc, tc = (ca & cb) | (cc & (ca ^ cb));
+    uint32_t e = ts & d;
+    *b1 = ts ^ d;
+    // Weight 4 : tc + e
+    *b2 = tc ^ e;
+    *b3 = tc & e;
+}
+
+static inline uint32_t
+life_rule(
+    uint32_t alive,
+    uint32_t b0, uint32_t b1, uint32_t b2, uint32_t b3,
+    uint16_t birth, uint16_t survive
+) {
+    if (birth == LIFE_RULE_CONWAY_BIRTH && survive == LIFE_RULE_CONWAY_SURVIVE) {
+        // 3, or 2 and alive.
+        return b1 & ~b2 & ~b3 & (b0 | alive);
+    }
+    uint32_t next = 0;
+    uint16_t any = birth | survive;
+    for (int n = 0; n <= 8; n++) {
+        if (((any >> n) & 0x01) == 0) continue;
+        uint32_t eq = ((n & 1)? b0 : ~b0) & ((n & 2)? b1 : ~b1) & ((n & 4)? b2 : ~b2) & ((n & 8)? b3 : ~b3);
+        uint32_t take = (((birth >> n) & 0x01)? ~alive : 0) | (((survive >> n) & 0x01)? alive : 0);
+        next |= eq & take;
+    }
+    return next;
+}
+
+// Row neighbours, cell (x - 1) and (x + 1) at the bit x. Wraps at LIFE_WIDTH.
+static inline uint32_t
+life_row_west(const uint32_t * row, int k)
+{
+    uint32_t carry = (k > 0)? (row[k - 1] >> 31) : ((row[LIFE_ROW_WORDS - 1] >> (LIFE_ROW_LAST_BITS - 1)) & 0x01);
+    return (row[k] << 1) | carry;
+}
+
+static inline uint32_t
+life_row_east(const uint32_t * row, int k)
+{
+    uint32_t carry = (k < (LIFE_ROW_WORDS - 1))? (row[k + 1] << 31) : ((row[0] & 0x01) << (LIFE_ROW_LAST_BITS - 1));
+    return (row[k] >> 1) | carry;
+}
+
+// Column neighbours, cell (y - 1) and (y + 1) at the bit y. Dead out of the grid.
+static inline uint32_t
+life_column_north(const uint32_t * column, int k)
+{
+    uint32_t carry = (k > 0)? (column[k - 1] >> 31) : 0;
+    return (column[k] << 1) | carry;
+}
+
+static inline uint32_t
+life_column_south(const uint32_t * column, int k)
+{
+    uint32_t carry = (k < (LIFE_COLUMN_WORDS - 1))? (column[k + 1] << 31) : 0;
+    return (column[k] >> 1) | carry;
+}
+
+// 8 x 8 bit transpose, byte i bit j to byte j bit i.
+static inline uint64_t
+life_transpose8(uint64_t x)
+{
+    uint64_t t;
+    t = 0x0F0F0F0F00000000ULL & (x ^ (x << 28)); x ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (x ^ (x << 14)); x ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (x ^ (x <<  7)); x ^= t ^ (t >>  7);
+    return x;
+}
+
+static inline int
+life_wrap_x(int x)
+{
+    x %= LIFE_WIDTH;
+    return (x < 0)? (x + LIFE_WIDTH) : x;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+LifeGrid::LifeGrid()
+{
+    clear();
+}
+
+LifeGrid::~LifeGrid()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+LifeGrid::init(life_pack_t pack)
+{
+    pack_ = pack;
+    clear();
+}
+
+void
+LifeGrid::setRule(uint16_t birth, uint16_t survive)
+{
+    birth_ = birth & 0x1FF;
+    survive_ = survive & 0x1FF;
+}
+
+bool
+LifeGrid::setRule(const char * rule)
+{
+    uint16_t masks[2] = { 0, 0 };
+    int target = -1;
+    for (const char * p = rule; *p != '\0'; p++) {
+        if      (*p == 'B' || *p == 'b') target = 0;
+        else if (*p == 'S' || *p == 's') target = 1;
+        else if (*p == '/') continue;
+        else if (*p >= '0' && *p <= '8' && target >= 0) masks[target] |= (1 << (*p - '0'));
+        else return false;
+    }
+    if (target < 0) return false;
+    setRule(masks[0], masks[1]);
+    return true;
+}
+
+void
+LifeGrid::clear(void)
+{
+    memset(cells_, 0, sizeof(cells_));
+    generation_ = 0;
+}
+
+void
+LifeGrid::randomize(uint32_t seed)
+{
+    clear();
+    uint32_t s = (seed != 0)? seed : 2463534242UL;
+    for (int y = 0; y < LIFE_HEIGHT; y++) {
+        for (int x = 0; x < LIFE_WIDTH; x += 32) {
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            uint32_t r = s;
+            for (int i = 0; i < 32 && (x + i) < LIFE_WIDTH; i++) {
+                setCell(x + i, y, (r >> i) & 0x01);
+            }
+        }
+    }
+}
+
+bool
+LifeGrid::getCell(int x, int y) const
+{
+    if (y < 0 || LIFE_HEIGHT <= y) return false;
+    x = life_wrap_x(x);
+    if (pack_ == LIFE_PACK_ROWS) {
+        return (cells_[(y * LIFE_ROW_WORDS) + (x >> 5)] >> (x & 31)) & 0x01;
+    }
+    return (cells_[(x * LIFE_COLUMN_WORDS) + (y >> 5)] >> (y & 31)) & 0x01;
+}
+
+void
+LifeGrid::setCell(int x, int y, bool alive)
+{
+    if (y < 0 || LIFE_HEIGHT <= y) return;
+    x = life_wrap_x(x);
+    uint32_t * word;
+    uint32_t bit;
+    if (pack_ == LIFE_PACK_ROWS) {
+        word = &cells_[(y * LIFE_ROW_WORDS) + (x >> 5)];
+        bit = 1UL << (x & 31);
+    } else {
+        word = &cells_[(x * LIFE_COLUMN_WORDS) + (y >> 5)];
+        bit = 1UL << (y & 31);
+    }
+    if (alive) *word |= bit;
+    else       *word &= ~bit;
+}
+
+int
+LifeGrid::population(void) const
+{
+    int count = 0;
+    for (int i = 0; i < LIFE_WORDS; i++) {
+        count += __builtin_popcount(cells_[i]);
+    }
+    return count;
+}
+
+void
+LifeGrid::step(void)
+{
+    if (pack_ == LIFE_PACK_ROWS) stepRows();
+    else                         stepColumns();
+    generation_++;
+}
+
+// In place, with the copies of the old row (y - 1) and y.
+void
+LifeGrid::stepRows(void)
+{
+    static const uint32_t zero[LIFE_ROW_WORDS] = { 0 };
+    uint32_t save[2][LIFE_ROW_WORDS];
+    uint32_t * prev = save[0];
+    uint32_t * cur = save[1];
+    memset(prev, 0, sizeof(save[0]));
+
+    for (int y = 0; y < LIFE_HEIGHT; y++) {
+        uint32_t * row = &cells_[y * LIFE_ROW_WORDS];
+        const uint32_t * next = (y < (LIFE_HEIGHT - 1))? (row + LIFE_ROW_WORDS) : zero;
+        memcpy(cur, row, sizeof(save[1]));
+
+        for (int k = 0; k < LIFE_ROW_WORDS; k++) {
+            uint32_t b0, b1, b2, b3;
+            life_count(
+                life_row_west(prev, k), prev[k], life_row_east(prev, k),
+                life_row_west(cur, k),           life_row_east(cur, k),
+                life_row_west(next, k), next[k], life_row_east(next, k),
+                &b0, &b1, &b2, &b3);
+            row[k] = life_rule(cur[k], b0, b1, b2, b3, birth_, survive_);
+        }
+        row[LIFE_ROW_WORDS - 1] &= LIFE_ROW_LAST_MASK;
+
+        uint32_t * t = prev;
+        prev = cur;
+        cur = t;
+    }
+}
+
+// In place, with the copies of the old column (x - 1), x and 0. (wrap)
+void
+LifeGrid::stepColumns(void)
+{
+    uint32_t first[LIFE_COLUMN_WORDS];
+    uint32_t save[2][LIFE_COLUMN_WORDS];
+    uint32_t * prev = save[0];
+    uint32_t * cur = save[1];
+    memcpy(first, &cells_[0], sizeof(first));
+    memcpy(prev, &cells_[(LIFE_WIDTH - 1) * LIFE_COLUMN_WORDS], sizeof(save[0]));
+
+    for (int x = 0; x < LIFE_WIDTH; x++) {
+        uint32_t * column = &cells_[x * LIFE_COLUMN_WORDS];
+        const uint32_t * next = (x < (LIFE_WIDTH - 1))? (column + LIFE_COLUMN_WORDS) : first;
+        memcpy(cur, column, sizeof(save[1]));
+
+        for (int k = 0; k < LIFE_COLUMN_WORDS; k++) {
+            uint32_t b0, b1, b2, b3;
+            life_count(
+                life_column_north(prev, k), prev[k], life_column_south(prev, k),
+                life_column_north(cur, k),           life_column_south(cur, k),
+                life_column_north(next, k), next[k], life_column_south(next, k),
+                &b0, &b1, &b2, &b3);
+            column[k] = life_rule(cur[k], b0, b1, b2, b3, birth_, survive_);
+        }
+
+        uint32_t * t = prev;
+        prev = cur;
+        cur = t;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Render
+ *----------------------------------------------------------------------
+ */
+
+void
+LifeGrid::render(CyclicMonoScreen * screen, int xpos) const
+{
+    if (pack_ == LIFE_PACK_ROWS) renderRows(screen, xpos);
+    else                         renderColumns(screen, xpos);
+}
+
+// 32 cells from x, wraps at LIFE_WIDTH.
+uint32_t
+LifeGrid::rowBits(const uint32_t * row, int x) const
+{
+    int k = x >> 5;
+    int r = x & 31;
+    if ((x + 32) <= LIFE_WIDTH) {
+        uint32_t bits = row[k] >> r;
+        if (r != 0) bits |= row[k + 1] << (32 - r);
+        return bits;
+    }
+    // Tail of the row, then the head.
+    int n = LIFE_WIDTH - x;
+    uint32_t bits = row[k] >> r;
+    if (k + 1 < LIFE_ROW_WORDS && r != 0) bits |= row[k + 1] << (32 - r);
+    bits &= (1UL << n) - 1;
+    return bits | (row[0] << n);
+}
+
+// Panel i column c shows the cell x = (i * CV_DISTANCE + c - xpos).
+void
+LifeGrid::renderRows(CyclicMonoScreen * screen, int xpos) const
+{
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        uint8_t * buffer = screen->getMonoScreen(i)->getBuffer();
+        int x = life_wrap_x((i * CV_DISTANCE) - xpos);
+        for (int y = 0; y < LIFE_HEIGHT; y++) {
+            uint32_t bits = rowBits(&cells_[y * LIFE_ROW_WORDS], x);
+            for (int p = 0; p < (CV_WIDTH / 8); p++) {
+                buffer[(p * CV_HEIGHT) + y] = (uint8_t)(bits >> (p * 8));
+            }
+        }
+    }
+}
+
+void
+LifeGrid::renderColumns(CyclicMonoScreen * screen, int xpos) const
+{
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        uint8_t * buffer = screen->getMonoScreen(i)->getBuffer();
+        int x0 = life_wrap_x((i * CV_DISTANCE) - xpos);
+        for (int p = 0; p < (CV_WIDTH / 8); p++) {
+            const uint8_t * columns[8];
+            for (int j = 0; j < 8; j++) {
+                int x = x0 + (p * 8) + j;
+                if (x >= LIFE_WIDTH) x -= LIFE_WIDTH;
+                columns[j] = (const uint8_t *)&cells_[x * LIFE_COLUMN_WORDS];
+            }
+            // 8 columns x 8 rows per block. (little endian words, byte b is rows 8b ~ 8b+7)
+            for (int b = 0; b < (LIFE_HEIGHT / 8); b++) {
+                uint64_t block = 0;
+                for (int j = 0; j < 8; j++) {
+                    block |= (uint64_t)columns[j][b] << (j * 8);
+                }
+                block = life_transpose8(block);
+                uint8_t * out = &buffer[(p * CV_HEIGHT) + (b * 8)];
+                for (int t = 0; t < 8; t++) {
+                    out[t] = (uint8_t)(block >> (t * 8));
+                }
+            }
+        }
+    }
+}
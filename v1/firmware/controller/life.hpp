@@ -0,0 +1,98 @@
+/**********************************************************************/
+/**
+ * @brief  Bit Parallel Cellular Automaton (Life) on the Cylinder
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// The grid is (CV_V_WIDTH x CV_HEIGHT) cells, x is the screen x (see
+// CyclicMonoScreen::screenX()), so x wraps around the cylinder. y does not
+// wrap, cells out of the grid are dead. (Rules are symmetric, so the
+// mirrored screen x makes no difference)
+//
+// Two packings are supported :
+//   LIFE_PACK_ROWS    : a row is LIFE_ROW_WORDS words, bit x.
+//   LIFE_PACK_COLUMNS : a column is LIFE_COLUMN_WORDS words, bit y.
+// A step takes 32 cells per word. The 8 neighbours are added with carry save
+// adders to a 4 bit sliced count, and the rule is evaluated on the slices.
+//
+// The rule is the masks of the neighbour count (bit n : n neighbours),
+// e.g. Conway's Life B3/S23 is birth (1 << 3), survive (1 << 2) | (1 << 3).
+
+typedef enum life_pack_ {
+    LIFE_PACK_ROWS = 0,
+    LIFE_PACK_COLUMNS,
+} life_pack_t;
+
+#define LIFE_WIDTH              (CV_V_WIDTH)
+#define LIFE_HEIGHT             (CV_HEIGHT)
+#define LIFE_ROW_WORDS          ((LIFE_WIDTH + 31) / 32)
+#define LIFE_ROW_LAST_BITS      (LIFE_WIDTH - ((LIFE_ROW_WORDS - 1) * 32))
+#define LIFE_COLUMN_WORDS       ((LIFE_HEIGHT + 31) / 32)
+#define LIFE_ROWS_SIZE          (LIFE_ROW_WORDS * LIFE_HEIGHT)
+#define LIFE_COLUMNS_SIZE       (LIFE_COLUMN_WORDS * LIFE_WIDTH)
+#define LIFE_WORDS              ((LIFE_ROWS_SIZE > LIFE_COLUMNS_SIZE)? LIFE_ROWS_SIZE : LIFE_COLUMNS_SIZE)
+
+#define LIFE_RULE_CONWAY_BIRTH      (1 << 3)
+#define LIFE_RULE_CONWAY_SURVIVE    ((1 << 2) | (1 << 3))
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class LifeGrid
+{
+public:
+    explicit LifeGrid();
+    virtual ~LifeGrid();
+
+public:
+    void init(life_pack_t pack);
+    void setRule(uint16_t birth, uint16_t survive);
+    bool setRule(const char * rule);    // "B3/S23"
+    void clear(void);
+    void randomize(uint32_t seed);
+    void step(void);
+
+public:
+    bool getCell(int x, int y) const;
+    void setCell(int x, int y, bool alive);
+    int  population(void) const;
+    int  generation(void) const { return generation_; }
+    life_pack_t pack(void) const { return pack_; }
+
+public:
+    // Write the grid to the panel buffers, scrolled by xpos. (same direction
+    // to the drawer, the cell x is at the cylinder x - xpos)
+    void render(CyclicMonoScreen * screen, int xpos) const;
+
+private:
+    void stepRows(void);
+    void stepColumns(void);
+    void renderRows(CyclicMonoScreen * screen, int xpos) const;
+    void renderColumns(CyclicMonoScreen * screen, int xpos) const;
+    uint32_t rowBits(const uint32_t * row, int x) const;
+
+private:
+    life_pack_t pack_ = LIFE_PACK_ROWS;
+    uint16_t birth_ = LIFE_RULE_CONWAY_BIRTH;
+    uint16_t survive_ = LIFE_RULE_CONWAY_SURVIVE;
+    int generation_ = 0;
+    uint32_t cells_[LIFE_WORDS];
+};
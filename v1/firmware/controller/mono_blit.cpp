@@ -0,0 +1,235 @@
+/**********************************************************************/
+/**
+ * @brief  Monochrome Blit Kernels (Panel Native Layout)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstddef>
+#include <cstring>
+
+#include "mono_blit.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef MIN
+#define MIN(x,y)        (((x) <= (y))? (x) : (y))
+#endif
+
+#ifndef MAX
+#define MAX(x,y)        (((x) >= (y))? (x) : (y))
+#endif
+
+#define LANES(v)        (0x01010101UL * (uint32_t)(v))
+
+typedef struct row_src_ {
+    const uint8_t * lo_;    // Page of the source column (nullptr : out of source)
+    const uint8_t * hi_;    // Next page
+    uint32_t loMask_;       // Lanes of (0xFF >> shift)
+    uint32_t hiMask_;       // Lanes of ~(0xFF >> shift)
+    int shift_;
+} row_src_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+template <mono_rop_t ROP>
+static inline uint32_t rop_apply(uint32_t d, uint32_t v, uint32_t m)
+{
+    switch (ROP) {
+    case MONO_ROP_COPY:   return (d & ~m) | (v & m);
+    case MONO_ROP_OR:     return d | (v & m);
+    case MONO_ROP_AND:    return d & (v | ~m);
+    case MONO_ROP_XOR:    return d ^ (v & m);
+    case MONO_ROP_ANDNOT: return d & ~(v & m);
+    }
+    return d;
+}
+
+// Aligned word access. (memcpy is a single ldr / str, without aliasing issues)
+static inline uint32_t load32(const uint8_t * p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store32(uint8_t * p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline bool aligned32(const uint8_t * p)
+{
+    return (p == nullptr) || (((uintptr_t)p & 3) == 0);
+}
+
+// Source byte (or 4 rows) at row i, shifted and merged from 2 pages.
+static inline uint32_t src_byte(const row_src_t * s, int i)
+{
+    uint32_t lo = (s->lo_)? s->lo_[i] : 0;
+    uint32_t hi = (s->hi_)? s->hi_[i] : 0;
+    return ((lo >> s->shift_) & s->loMask_) | ((hi << (8 - s->shift_)) & s->hiMask_);
+}
+
+static inline uint32_t src_word(const row_src_t * s, int i)
+{
+    uint32_t lo = (s->lo_)? load32(s->lo_ + i) : 0;
+    uint32_t hi = (s->hi_)? load32(s->hi_ + i) : 0;
+    return ((lo >> s->shift_) & s->loMask_) | ((hi << (8 - s->shift_)) & s->hiMask_);
+}
+
+static inline bool src_aligned(const row_src_t * s, int i)
+{
+    return aligned32((s->lo_)? s->lo_ + i : nullptr) && aligned32((s->hi_)? s->hi_ + i : nullptr);
+}
+
+// One page of the destination, n rows.
+template <mono_rop_t ROP>
+static void
+blit_rows(uint8_t * d, const row_src_t * s, const row_src_t * m, uint8_t columns, int n)
+{
+    const uint32_t cm = LANES(columns);
+    int i = 0;
+
+    // Bytes until the destination is word aligned.
+    while (i < n && !aligned32(d + i)) {
+        uint32_t mask = (m)? (cm & src_byte(m, i)) : cm;
+        d[i] = (uint8_t)rop_apply<ROP>(d[i], src_byte(s, i), mask);
+        i++;
+    }
+
+    // 4 rows per word, if the sources are also aligned.
+    if (src_aligned(s, i) && (m == nullptr || src_aligned(m, i))) {
+        for (; i + 4 <= n; i += 4) {
+            uint32_t mask = (m)? (cm & src_word(m, i)) : cm;
+            store32(d + i, rop_apply<ROP>(load32(d + i), src_word(s, i), mask));
+        }
+    }
+
+    for (; i < n; i++) {
+        uint32_t mask = (m)? (cm & src_byte(m, i)) : cm;
+        d[i] = (uint8_t)rop_apply<ROP>(d[i], src_byte(s, i), mask);
+    }
+}
+
+template <mono_rop_t ROP>
+static void
+fill_rows(uint8_t * d, uint8_t columns, int n)
+{
+    const uint32_t cm = LANES(columns);
+    int i = 0;
+    while (i < n && !aligned32(d + i)) {
+        d[i] = (uint8_t)rop_apply<ROP>(d[i], 0xFF, cm);
+        i++;
+    }
+    for (; i + 4 <= n; i += 4) {
+        store32(d + i, rop_apply<ROP>(load32(d + i), 0xFFFFFFFFUL, cm));
+    }
+    for (; i < n; i++) {
+        d[i] = (uint8_t)rop_apply<ROP>(d[i], 0xFF, cm);
+    }
+}
+
+static void
+setup_src(row_src_t * s, const mono_plane_t * plane, int column, int row)
+{
+    int pages = (plane->width_ + 7) >> 3;
+    int q = (column >= 0)? (column >> 3) : -((-column + 7) >> 3);
+    int r = column - (q * 8);
+    s->lo_ = (q >= 0 && q < pages)? plane->buffer_ + (q * plane->height_) + row : nullptr;
+    s->hi_ = (r != 0 && (q + 1) >= 0 && (q + 1) < pages)? plane->buffer_ + ((q + 1) * plane->height_) + row : nullptr;
+    s->shift_ = r;
+    s->loMask_ = LANES(0xFF >> r);
+    s->hiMask_ = LANES(0xFF & ~(0xFF >> r));
+}
+
+// Destination column bits of the page p, in [x0, x1).
+static inline uint8_t page_columns(int p, int x0, int x1)
+{
+    int lo = MAX(x0, p * 8) - (p * 8);
+    int hi = MIN(x1, (p * 8) + 8) - (p * 8);
+    return (uint8_t)((0xFF << lo) & (0xFF >> (8 - hi)));
+}
+
+template <mono_rop_t ROP>
+static void
+blit(const mono_surface_t * dst, int dx, int dy,
+     const mono_plane_t * src, int sx, int sy,
+     int width, int height, const mono_plane_t * mask)
+{
+    for (int p = (dx >> 3); p <= ((dx + width - 1) >> 3); p++) {
+        uint8_t columns = page_columns(p, dx, dx + width);
+        // Source column of the destination bit 0 of this page.
+        int column = (p * 8) - dx + sx;
+        row_src_t s, m;
+        setup_src(&s, src, column, sy);
+        if (mask) setup_src(&m, mask, column, sy);
+        uint8_t * d = dst->buffer_ + (p * dst->height_) + dy;
+        blit_rows<ROP>(d, &s, (mask)? &m : nullptr, columns, height);
+    }
+}
+
+void
+mono_blit(
+    const mono_surface_t * dst, int dx, int dy,
+    const mono_plane_t * src, int sx, int sy,
+    int width, int height,
+    mono_rop_t rop,
+    const mono_plane_t * mask
+) {
+    // Clip
+    if (sx < 0) { dx -= sx; width  += sx; sx = 0; }
+    if (sy < 0) { dy -= sy; height += sy; sy = 0; }
+    if (dx < 0) { sx -= dx; width  += dx; dx = 0; }
+    if (dy < 0) { sy -= dy; height += dy; dy = 0; }
+    width  = MIN(width,  MIN(src->width_  - sx, dst->width_  - dx));
+    height = MIN(height, MIN(src->height_ - sy, dst->height_ - dy));
+    if (mask) {
+        width  = MIN(width,  mask->width_  - sx);
+        height = MIN(height, mask->height_ - sy);
+    }
+    if (width <= 0 || height <= 0) return;
+
+    switch (rop) {
+    case MONO_ROP_COPY:   blit<MONO_ROP_COPY>  (dst, dx, dy, src, sx, sy, width, height, mask); break;
+    case MONO_ROP_OR:     blit<MONO_ROP_OR>    (dst, dx, dy, src, sx, sy, width, height, mask); break;
+    case MONO_ROP_AND:    blit<MONO_ROP_AND>   (dst, dx, dy, src, sx, sy, width, height, mask); break;
+    case MONO_ROP_XOR:    blit<MONO_ROP_XOR>   (dst, dx, dy, src, sx, sy, width, height, mask); break;
+    case MONO_ROP_ANDNOT: blit<MONO_ROP_ANDNOT>(dst, dx, dy, src, sx, sy, width, height, mask); break;
+    }
+}
+
+void
+mono_fill(
+    const mono_surface_t * dst, int dx, int dy,
+    int width, int height,
+    mono_rop_t rop
+) {
+    // Clip
+    if (dx < 0) { width  += dx; dx = 0; }
+    if (dy < 0) { height += dy; dy = 0; }
+    width  = MIN(width,  dst->width_  - dx);
+    height = MIN(height, dst->height_ - dy);
+    if (width <= 0 || height <= 0) return;
+
+    for (int p = (dx >> 3); p <= ((dx + width - 1) >> 3); p++) {
+        uint8_t columns = page_columns(p, dx, dx + width);
+        uint8_t * d = dst->buffer_ + (p * dst->height_) + dy;
+        switch (rop) {
+        case MONO_ROP_COPY:   fill_rows<MONO_ROP_COPY>  (d, columns, height); break;
+        case MONO_ROP_OR:     fill_rows<MONO_ROP_OR>    (d, columns, height); break;
+        case MONO_ROP_AND:    fill_rows<MONO_ROP_AND>   (d, columns, height); break;
+        case MONO_ROP_XOR:    fill_rows<MONO_ROP_XOR>   (d, columns, height); break;
+        case MONO_ROP_ANDNOT: fill_rows<MONO_ROP_ANDNOT>(d, columns, height); break;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/**********************************************************************/
+/**
+ * @brief  Monochrome Blit Kernels (Panel Native Layout)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "mono_image.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Kernels for the MonoScreen buffer layout (see mono_plane_t). A byte holds
+// 8 columns of one row, so a column shift is a shift-and-merge of two
+// neighbour bytes. Bytes of a page are contiguous along y, then a 32 bit
+// word holds 4 rows, and the shift-and-merge is done for 4 rows at once.
+
+typedef enum mono_rop_ {
+    MONO_ROP_COPY = 0,      // dst = src
+    MONO_ROP_OR,            // dst = dst | src
+    MONO_ROP_AND,           // dst = dst & src
+    MONO_ROP_XOR,           // dst = dst ^ src
+    MONO_ROP_ANDNOT,        // dst = dst & ~src
+} mono_rop_t;
+
+// Writable panel native bitmap, e.g. MonoScreen buffer (CV_WIDTH x CV_HEIGHT).
+typedef struct mono_surface_ {
+    int width_;
+    int height_;
+    uint8_t * buffer_;
+} mono_surface_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Copy (width x height) from src column sx / row sy to dst column dx / row dy,
+// with the raster operation. Only pixels where mask is 1 are changed, if mask
+// is given (same size to src). Clipped to both src and dst.
+void mono_blit(
+    const mono_surface_t * dst, int dx, int dy,
+    const mono_plane_t * src, int sx, int sy,
+    int width, int height,
+    mono_rop_t rop = MONO_ROP_COPY,
+    const mono_plane_t * mask = nullptr
+);
+
+// Raster operation with a solid source (all 1) to the rectangle.
+void mono_fill(
+    const mono_surface_t * dst, int dx, int dy,
+    int width, int height,
+    mono_rop_t rop
+);
@@ -0,0 +1,291 @@
+/**********************************************************************/
+/**
+ * @brief  Ordered Dither Kernels (Grayscale to Panel Native Layout)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstddef>
+#include <cstring>
+
+#include "mono_dither.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef MIN
+#define MIN(x,y)        (((x) <= (y))? (x) : (y))
+#endif
+
+#ifndef MAX
+#define MAX(x,y)        (((x) >= (y))? (x) : (y))
+#endif
+
+#define LANES(v)        (0x01010101UL * (uint32_t)(v))
+
+// Thresholds of an N x N tile in the lane order of a dst byte. The src
+// pixels of a byte are loaded from the left, the dst column 7 first (the
+// columns are mirrored), so the word [0] holds the columns 7 ~ 4 and the
+// word [1] the columns 3 ~ 0, for the block of 8 columns of a tile row.
+template <int N>
+struct dither_tile_t {
+    uint32_t w_[N][N / 8][2];
+};
+
+// Rank of the cells, 0 ~ N * N - 1.
+typedef struct bayer_rank_ {
+    uint8_t v_[8][8];
+} bayer_rank_t;
+
+// Row, column. Made by void and cluster (sigma 1.9, wrapped around).
+static constexpr uint8_t BLUE_NOISE_RANK[16][16] = {
+    { 252, 131,  58,  10, 227, 146, 191,  81,  40, 204, 106,  29, 229,  42, 164,  66 },
+    {  16, 215,  34, 240,  94,  43, 109, 166,  12,  69, 213, 132,  77, 114,  22, 148 },
+    {  93, 167, 113, 177,  65, 210, 248, 141, 232, 186,  47, 153, 180, 239, 208, 190 },
+    {  46,  75, 202, 135, 157,   3, 124,  24,  88, 119, 245,  98,   2,  56, 138, 105 },
+    { 224,   6, 235,  25,  80, 195,  50, 222,  60, 161,  17, 194, 218,  82,  35, 246 },
+    { 121, 145,  54,  97, 254, 181, 102, 172, 205,  33, 144,  70, 125, 170, 155, 183 },
+    {  28, 192, 168, 129, 217,  37, 150,  74, 241, 111, 228,  44, 255, 100,  11,  67 },
+    { 221, 107, 209,  14,  63, 118,  20, 130,   7,  92, 178, 137,  23, 206, 233,  89 },
+    { 136,  76,  41, 158,  86, 244, 225, 187, 156,  55, 214,  79, 189, 116,  51, 162 },
+    { 250,   1, 238, 185, 203, 140,  48,  99, 199,  30, 163,   5,  64, 149,  36, 198 },
+    { 173,  95,  57, 110,  31, 175,  13,  68, 251, 123, 231, 108, 243, 219, 127,  18 },
+    { 112, 230, 151, 128,  78, 234, 115, 216,  84, 142,  45, 169,  96, 182,  83,  61 },
+    { 212,  27, 188,   8, 211, 165,  38, 152, 184,  21,  72, 207,  32,  15, 247, 159 },
+    {  73, 139,  49, 249,  90,  59, 133, 103,   0, 196, 237, 117, 134,  52, 143, 201 },
+    {  39, 226, 104, 171,  19, 200, 242, 223,  53,  91, 160,  62, 220, 193, 101,   4 },
+    { 179,  85, 197, 154, 120,  71,  26, 174, 126, 253, 147,   9, 176,  87, 236, 122 },
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Tiles
+ *----------------------------------------------------------------------
+ */
+
+// The bits of (x ^ y, y) interleaved and reversed, the recursive Bayer
+// matrix. [[0, 2], [3, 1]] for 2 x 2.
+static constexpr bayer_rank_t
+make_bayer(void)
+{
+    bayer_rank_t t = {};
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            int v = 0;
+            for (int i = 0; i < 3; i++) {
+                int bits = ((((x ^ y) >> i) & 1) << 1) | ((y >> i) & 1);
+                v |= bits << (2 * (2 - i));
+            }
+            t.v_[y][x] = (uint8_t)v;
+        }
+    }
+    return t;
+}
+
+// Rank to the threshold in 7 bits, 1 ~ 127. The intensity 0 is black, and
+// 127 white on every cell.
+template <int N>
+static constexpr uint32_t
+rank_threshold(int rank)
+{
+    return (uint32_t)(1 + ((rank * 127) / (N * N)));
+}
+
+template <int N>
+static constexpr dither_tile_t<N>
+make_tile(const uint8_t (&rank)[N][N])
+{
+    dither_tile_t<N> t = {};
+    for (int r = 0; r < N; r++) {
+        for (int p = 0; p < (N / 8); p++) {
+            for (int k = 0; k < 4; k++) {
+                t.w_[r][p][0] |= rank_threshold<N>(rank[r][(p * 8) + 7 - k]) << (k * 8);
+                t.w_[r][p][1] |= rank_threshold<N>(rank[r][(p * 8) + 3 - k]) << (k * 8);
+            }
+        }
+    }
+    return t;
+}
+
+static constexpr bayer_rank_t BAYER_RANK = make_bayer();
+static constexpr dither_tile_t<8> BAYER_TILE = make_tile<8>(BAYER_RANK.v_);
+static constexpr dither_tile_t<16> BLUE_NOISE_TILE = make_tile<16>(BLUE_NOISE_RANK);
+
+// Threshold of the dst column bit b in the words of a tile row.
+static inline uint32_t tile_threshold(const uint32_t * t, int b)
+{
+    return (t[(b < 4)? 1 : 0] >> (8 * ((7 - b) & 3))) & 0xFF;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Kernels
+ *----------------------------------------------------------------------
+ */
+
+// Aligned word access. (memcpy is a single ldr / str, without aliasing issues)
+static inline uint32_t load32(const uint8_t * p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store32(uint8_t * p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline bool aligned32(const uint8_t * p)
+{
+    return (((uintptr_t)p & 3) == 0);
+}
+
+// A src pixel in 7 bits, scaled.
+template <bool SCALE>
+static inline uint32_t src_level(uint8_t v, int level)
+{
+    uint32_t l = (uint32_t)(v >> 1);
+    return (SCALE)? ((l * (uint32_t)level) >> 8) : l;
+}
+
+// 4 src pixels in 7 bit lanes, scaled. The odd and the even lanes are
+// multiplied apart, 16 bits a lane.
+template <bool SCALE>
+static inline uint32_t src_lanes(const uint8_t * p, int level)
+{
+    uint32_t v = (load32(p) >> 1) & LANES(0x7F);
+    if (SCALE) {
+        uint32_t even = (((v & 0x00FF00FFUL) * (uint32_t)level) >> 8) & 0x00FF00FFUL;
+        uint32_t odd  = (((v >> 8) & 0x00FF00FFUL) * (uint32_t)level) & 0xFF00FF00UL;
+        v = even | odd;
+    }
+    return v;
+}
+
+// 4 lanes against the thresholds, to 4 bits. (v | 0x80) - t never borrows
+// from the next lane, the bit 7 is set if v >= t. The multiply gathers the
+// bit 7 of the lanes 0 ~ 3 to the bits 31 ~ 28, reversed.
+static inline uint32_t lanes_bits(uint32_t v, uint32_t t)
+{
+    uint32_t m = (((v | LANES(0x80)) - t) >> 7) & LANES(0x01);
+    return (uint32_t)(m * 0x80402010UL) >> 28;
+}
+
+// A dst byte of 8 columns, s : the src of the dst column 7.
+template <bool SCALE>
+static inline uint32_t dither_byte(const uint8_t * s, const uint32_t * t, int level)
+{
+    return (lanes_bits(src_lanes<SCALE>(s, level), t[0]) << 4) | lanes_bits(src_lanes<SCALE>(s + 4, level), t[1]);
+}
+
+// One page of the destination, n rows. s : the src row of the first row,
+// c7 : the src column of the dst column 7 of the page, read only for the
+// columns in the page.
+template <int N, bool SCALE>
+static void
+dither_rows(uint8_t * d, const uint8_t * s, int stride, int c7, uint8_t columns, int n,
+            const dither_tile_t<N> * tile, int block, int row, int level)
+{
+    int i = 0;
+
+    if (columns != 0xFF) {
+        // A partial page, a column at a time.
+        for (; i < n; i++, s += stride) {
+            const uint32_t * t = tile->w_[(row + i) & (N - 1)][block];
+            uint8_t v = d[i] & ~columns;
+            for (int b = 0; b < 8; b++) {
+                if ((columns & (1 << b)) == 0) continue;
+                if (src_level<SCALE>(s[c7 + 7 - b], level) >= tile_threshold(t, b)) v |= (uint8_t)(1 << b);
+            }
+            d[i] = v;
+        }
+        return;
+    }
+
+    s += c7;
+
+    // Bytes until the destination is word aligned.
+    for (; i < n && !aligned32(d + i); i++, s += stride) {
+        d[i] = (uint8_t)dither_byte<SCALE>(s, tile->w_[(row + i) & (N - 1)][block], level);
+    }
+
+    // 4 rows (32 pixels) per word, the row i in the byte 0. (little endian)
+    for (; i + 4 <= n; i += 4) {
+        uint32_t w = 0;
+        for (int k = 0; k < 4; k++, s += stride) {
+            w |= dither_byte<SCALE>(s, tile->w_[(row + i + k) & (N - 1)][block], level) << (k * 8);
+        }
+        store32(d + i, w);
+    }
+
+    for (; i < n; i++, s += stride) {
+        d[i] = (uint8_t)dither_byte<SCALE>(s, tile->w_[(row + i) & (N - 1)][block], level);
+    }
+}
+
+// Destination column bits of the page p, in [x0, x1).
+static inline uint8_t page_columns(int p, int x0, int x1)
+{
+    int lo = MAX(x0, p * 8) - (p * 8);
+    int hi = MIN(x1, (p * 8) + 8) - (p * 8);
+    return (uint8_t)((0xFF << lo) & (0xFF >> (8 - hi)));
+}
+
+template <int N, bool SCALE>
+static void
+dither(const mono_surface_t * dst, int dx, int dy,
+       const gray_image_t * src, int sx, int sy,
+       int width, int height, const dither_tile_t<N> * tile, int level)
+{
+    const uint8_t * s = src->buffer_ + (sy * src->stride_);
+    for (int p = (dx >> 3); p <= ((dx + width - 1) >> 3); p++) {
+        uint8_t columns = page_columns(p, dx, dx + width);
+        // Src column of the dst column 7 of this page.
+        int c7 = sx + (dx + width - 1) - ((p * 8) + 7);
+        uint8_t * d = dst->buffer_ + (p * dst->height_) + dy;
+        dither_rows<N, SCALE>(d, s, src->stride_, c7, columns, height, tile, p & ((N / 8) - 1), dy, level);
+    }
+}
+
+void
+mono_dither(
+    const mono_surface_t * dst, int dx, int dy,
+    const gray_image_t * src, int sx, int sy,
+    int width, int height,
+    mono_dither_t method,
+    int level
+) {
+    // Clip, the src columns from sx are the dst columns from (dx + width - 1) down.
+    if (sx < 0) { width  += sx; sx = 0; }
+    if (sy < 0) { dy -= sy; height += sy; sy = 0; }
+    if (dx < 0) { width  += dx; dx = 0; }
+    if (dy < 0) { sy -= dy; height += dy; dy = 0; }
+    if ((sx + width) > src->width_) { dx += (sx + width) - src->width_; width = src->width_ - sx; }
+    if ((dx + width) > dst->width_) { sx += (dx + width) - dst->width_; width = dst->width_ - dx; }
+    height = MIN(height, MIN(src->height_ - sy, dst->height_ - dy));
+    if (width <= 0 || height <= 0) return;
+
+    bool scale = (level < MONO_DITHER_LEVEL_MAX);
+    level = MAX(level, 0);
+
+    if (method == MONO_DITHER_BLUE_NOISE) {
+        if (scale) dither<16, true> (dst, dx, dy, src, sx, sy, width, height, &BLUE_NOISE_TILE, level);
+        else       dither<16, false>(dst, dx, dy, src, sx, sy, width, height, &BLUE_NOISE_TILE, level);
+    } else {
+        if (scale) dither<8, true> (dst, dx, dy, src, sx, sy, width, height, &BAYER_TILE, level);
+        else       dither<8, false>(dst, dx, dy, src, sx, sy, width, height, &BAYER_TILE, level);
+    }
+}
+
+uint8_t
+mono_dither_threshold(mono_dither_t method, int column, int row)
+{
+    if (method == MONO_DITHER_BLUE_NOISE) {
+        return (uint8_t)tile_threshold(BLUE_NOISE_TILE.w_[row & 15][(column >> 3) & 1], column & 7);
+    }
+    return (uint8_t)tile_threshold(BAYER_TILE.w_[row & 7][0], column & 7);
+}
@@ -0,0 +1,57 @@
+/**********************************************************************/
+/**
+ * @brief  Ordered Dither Kernels (Grayscale to Panel Native Layout)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "mono_image.hpp"
+#include "mono_blit.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Kernels from a grayscale image (gray_image_t) to the MonoScreen buffer
+// layout, by a threshold matrix tiled on the panel columns and rows. The 8
+// columns of a destination byte are compared at once, 4 lanes of a 32 bit
+// word in 7 bits (a lane never borrows from the next), and a whole page is
+// stored 4 rows (32 pixels) a word. Error diffusion is serial and left to
+// the host. (assetc -e)
+
+typedef enum mono_dither_ {
+    MONO_DITHER_BAYER = 0,      // 8 x 8 Bayer matrix, 64 levels, a regular pattern
+    MONO_DITHER_BLUE_NOISE,     // 16 x 16 blue noise tile, 128 levels, no visible pattern
+} mono_dither_t;
+
+#define MONO_DITHER_LEVEL_MAX   (256)   // Intensity scale of the source, 1.0
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Dither (width x height) from src column sx / row sy to dst column dx / row
+// dy. The src is in the cylinder x order and the dst columns are mirrored
+// (see mono_plane_t), so the src column sx is at the dst column
+// (dx + width - 1). The src intensity is scaled by level / 256 (fades).
+// Clipped to both src and dst.
+void mono_dither(
+    const mono_surface_t * dst, int dx, int dy,
+    const gray_image_t * src, int sx, int sy,
+    int width, int height,
+    mono_dither_t method = MONO_DITHER_BAYER,
+    int level = MONO_DITHER_LEVEL_MAX
+);
+
+// Threshold (1 ~ 127) of the dst column / row, against the src intensity in
+// 7 bits (v >> 1) : white if the intensity is the threshold or more.
+uint8_t mono_dither_threshold(mono_dither_t method, int column, int row);
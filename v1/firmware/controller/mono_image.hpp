@@ -35,6 +35,26 @@ typedef struct mono_images_ {
     const mono_image_t * images_;
 } mono_images_t;
 
+// Panel native plane. Same layout to MonoScreen buffer, 8 pixels are packed
+// along the screen x axis (LSB first), offset = (column / 8) * height_ + y.
+// The screen x axis is mirrored against the cylinder x axis, so the plane
+// column c is located at cylinder x (x0 + width_ - 1 - c).
+typedef struct mono_plane_ {
+    int width_;             // Columns, ((width_ + 7) / 8) pages
+    int height_;
+    const uint8_t * buffer_;
+} mono_plane_t;
+
+// Grayscale image, a byte a pixel (0 : black ~ 255 : white), row by row in
+// the cylinder x order (not mirrored), stride_ bytes a row. Dithered to the
+// panels on drawing. (mono_dither.hpp)
+typedef struct gray_image_ {
+    int width_;
+    int height_;
+    int stride_;            // Bytes a row, width_ or more
+    const uint8_t * buffer_;
+} gray_image_t;
+
 class MonoImage
 {
 public:
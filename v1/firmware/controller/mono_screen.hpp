@@ -10,6 +10,7 @@
  *----------------------------------------------------------------------
  */
 #include <cstdint>
+#include <cstring>
 #include "screen_base.hpp"
 #include "screen_config.hpp"
 
@@ -38,25 +39,64 @@
  *----------------------------------------------------------------------
  */
 
-class MonoScreen : public ScreenBase<color_t>
+// One panel buffer of the geometry G. (cv_geometry.hpp)
+template <typename G>
+class MonoScreenT : public ScreenBase<color_t>
 {
 public:
-    explicit MonoScreen();
-    virtual ~MonoScreen();
+    explicit MonoScreenT() {}
+    virtual ~MonoScreenT() {}
 
 public:
-    int     width(void) override { return CV_HEIGHT; }
-    int     height(void) override { return CV_WIDTH; }
-    int     pixels(void) override { return CV_PIXELS; }
+    int     width(void) override { return G::HEIGHT; }
+    int     height(void) override { return G::WIDTH; }
+    int     pixels(void) override { return G::PIXELS; }
     color_t getClearColor(void) override { return DISP_COLOR_BLACK; }
     void    clear(color_t c = DISP_COLOR_BLACK) override;
     void    setDot(int x, int y, color_t c) override;
     color_t getDot(int x, int y) override;
 
 public:
-    void      setBuffer(color_t * buffer);
-    color_t * getBuffer(void);
+    void      setBuffer(color_t * buffer) { buffer_ = buffer; }
+    color_t * getBuffer(void) { return buffer_; }
 
 private:
     color_t * buffer_;
 };
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+template <typename G>
+void
+MonoScreenT<G>::clear(color_t c)
+{
+    memset(buffer_, (c == DISP_COLOR_WHITE)? 0xFF : 0x00, G::ONE_FRAME_BYTES);
+}
+
+// x : panel row (along the cylinder), y : panel column. The page stride
+// is a constant, a shift for the 128 column panels.
+template <typename G>
+void
+MonoScreenT<G>::setDot(int x, int y, color_t c)
+{
+    int offset     = G::offset(y, x);
+    int offset_bit = x & 7;
+
+    if (c == DISP_COLOR_WHITE)
+        buffer_[offset] |= (0x01 << offset_bit);
+    else
+        buffer_[offset] &= ~(0x01 << offset_bit);
+}
+
+template <typename G>
+color_t
+MonoScreenT<G>::getDot(int x, int y)
+{
+    return (buffer_[G::offset(y, x)] >> (x & 7)) & 0x01;
+}
+
+typedef MonoScreenT<CvScreenGeometry> MonoScreen;
+extern template class MonoScreenT<CvScreenGeometry>;
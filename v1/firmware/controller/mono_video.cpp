@@ -0,0 +1,136 @@
+/**********************************************************************/
+/**
+ * @brief  Monochrome Video (Keyframe + XOR Delta, Streaming Decoder)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "mono_video.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+mono_video_apply(uint8_t * buffer, size_t size, const uint8_t * data, size_t dataSize)
+{
+    const uint8_t * src    = data;
+    const uint8_t * srcend = data + dataSize;
+    uint8_t * dst    = buffer;
+    uint8_t * dstend = buffer + size;
+
+    while (src < srcend) {
+        uint8_t token = *src++;
+        if (token & MONO_VIDEO_TOKEN_SKIP) {
+            dst += (token & 0x7F) + 1;
+        } else if (token & MONO_VIDEO_TOKEN_FILL) {
+            int n = (token & 0x3F) + MONO_VIDEO_FILL_MIN;
+            if (dst + n > dstend || src >= srcend) break;
+            uint8_t v = *src++;
+            while (n-- > 0) *dst++ ^= v;
+        } else {
+            int n = token + 1;
+            if (dst + n > dstend || src + n > srcend) break;
+            while (n-- > 0) *dst++ ^= *src++;
+        }
+        if (dst >= dstend) break;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+MonoVideo::MonoVideo()
+{
+    plane_.width_ = 0;
+    plane_.height_ = 0;
+    plane_.buffer_ = nullptr;
+}
+
+MonoVideo::~MonoVideo()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+bool
+MonoVideo::init(const mono_video_t * video, uint8_t * buffer, size_t size)
+{
+    if (video == nullptr || buffer == nullptr) return false;
+    if ((video->width_ & 7) != 0 || video->frame_count_ <= 0) return false;
+    if (planeSize(video) > size) return false;
+
+    video_ = video;
+    buffer_ = buffer;
+    size_ = planeSize(video);
+    frameno_ = -1;
+
+    plane_.width_ = video->width_;
+    plane_.height_ = video->height_;
+    plane_.buffer_ = buffer;
+
+    memset(buffer_, 0, size_);
+    return true;
+}
+
+// Decode the frame. Sequential playback decodes only the deltas since the current frame.
+bool
+MonoVideo::seek(int frameno)
+{
+    if (video_ == nullptr) return false;
+    if (frameno < 0 || frameno >= count()) return false;
+    if (frameno == frameno_) return true;
+
+    // Nearest keyframe before the frame.
+    int start = frameno;
+    while (start > 0 && !isKeyframe(start)) start--;
+
+    if (frameno_ < start || frameno_ > frameno) {
+        frameno_ = start - 1;
+    }
+    for (int i = frameno_ + 1; i <= frameno; i++) {
+        decode(i);
+    }
+    frameno_ = frameno;
+    return true;
+}
+
+// Frame number at the elapsed time, loop playback.
+int
+MonoVideo::frameAt(uint32_t elapsedUs) const
+{
+    if (video_ == nullptr) return 0;
+    uint64_t frameno = ((uint64_t)elapsedUs * video_->fps_) / 1000000;
+    return (int)(frameno % video_->frame_count_);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+MonoVideo::decode(int frameno)
+{
+    uint32_t begin = video_->index_[frameno] & MONO_VIDEO_INDEX_OFFSET;
+    uint32_t end   = video_->index_[frameno + 1] & MONO_VIDEO_INDEX_OFFSET;
+    const uint8_t * src    = video_->data_ + begin;
+    const uint8_t * srcend = video_->data_ + end;
+
+    if (isKeyframe(frameno)) {
+        memset(buffer_, 0, size_);
+    }
+
+    mono_video_apply(buffer_, size_, src, srcend - src);
+}
@@ -0,0 +1,101 @@
+/**********************************************************************/
+/**
+ * @brief  Monochrome Video (Keyframe + XOR Delta, Streaming Decoder)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+#include "mono_image.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Video data is made by the host encoder (v1/tools/mvenc), and is read
+// directly from flash (XIP). Only one decoded plane (mono_plane_t) is kept
+// in RAM, so the RAM usage is bounded to (width * height / 8) bytes.
+//
+// Each frame is a token stream, applied to the plane bytes in order :
+//   0x00 - 0x3F : literal, (n + 1) bytes follow. XOR the bytes.
+//   0x40 - 0x7F : fill, ((n & 0x3F) + 2) times, 1 byte follows. XOR the byte.
+//   0x80 - 0xFF : skip ((n & 0x7F) + 1) bytes.
+// A frame may end before the end of the plane, remaining bytes are unchanged.
+// Keyframes are decoded to a cleared plane, so XOR is same to copy.
+//
+// Frame index : (frame_count_ + 1) entries of the data offset. The last one
+// is the total data size. MONO_VIDEO_INDEX_KEYFRAME is set to keyframes.
+
+#define MONO_VIDEO_INDEX_KEYFRAME   (0x80000000UL)
+#define MONO_VIDEO_INDEX_OFFSET     (0x7FFFFFFFUL)
+
+#define MONO_VIDEO_TOKEN_FILL       (0x40)
+#define MONO_VIDEO_TOKEN_SKIP       (0x80)
+#define MONO_VIDEO_LITERAL_MAX      (64)
+#define MONO_VIDEO_FILL_MIN         (2)
+#define MONO_VIDEO_FILL_MAX         (65)
+#define MONO_VIDEO_SKIP_MAX         (128)
+
+typedef struct mono_video_ {
+    int width_;             // Multiple of 8
+    int height_;
+    int fps_;
+    int frame_count_;
+    const uint32_t * index_;
+    const uint8_t * data_;
+} mono_video_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Apply a frame token stream to the plane bytes. (also used for the USB stream)
+void mono_video_apply(uint8_t * buffer, size_t size, const uint8_t * data, size_t dataSize);
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class MonoVideo
+{
+public:
+    explicit MonoVideo();
+    virtual ~MonoVideo();
+
+public:
+    bool init(const mono_video_t * video, uint8_t * buffer, size_t size);
+    bool seek(int frameno);
+    int  frameAt(uint32_t elapsedUs) const;
+
+public:
+    int  width(void) const { return video_->width_; }
+    int  height(void) const { return video_->height_; }
+    int  fps(void) const { return video_->fps_; }
+    int  count(void) const { return video_->frame_count_; }
+    int  frame(void) const { return frameno_; }
+    bool isKeyframe(int frameno) const { return (video_->index_[frameno] & MONO_VIDEO_INDEX_KEYFRAME) != 0; }
+    const mono_plane_t * plane(void) const { return &plane_; }
+
+public:
+    static size_t planeSize(const mono_video_t * video) { return (video->width_ / 8) * video->height_; }
+
+private:
+    void decode(int frameno);
+
+private:
+    const mono_video_t * video_ = nullptr;
+    uint8_t * buffer_ = nullptr;
+    size_t size_ = 0;
+    int frameno_ = -1;
+    mono_plane_t plane_;
+};
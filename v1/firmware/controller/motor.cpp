@@ -12,6 +12,7 @@
 #include <Arduino.h>
 
 #include "motor.hpp"
+#include "trace_recorder.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -40,6 +41,7 @@ void motor_init(
 void motor_set_power(
     int power
 ) {
+    trace_motor(TRACE_MOTOR_POWER, power);
     if (power > 0) {
         analogWrite(pin_in_1_, power);
         analogWrite(pin_in_2_, decay_mode_);
@@ -55,6 +57,7 @@ void motor_set_power(
 void motor_set_brake(
     bool brake
 ) {
+    trace_motor(TRACE_MOTOR_BRAKE, brake);
     int v = (brake)? 255 : 0;
     analogWrite(pin_in_1_, v);
     analogWrite(pin_in_2_, v);
@@ -0,0 +1,130 @@
+/**********************************************************************/
+/**
+ * @brief  Falling Particles (Structure of Arrays, Fixed Point)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+
+#include <cstdbool>
+#include <cstdint>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_drawer.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Particle state is kept in separate arrays (6 bytes per particle) :
+//   x_  : uint16_t, binary angle of the cylinder (65536 = CV_V_WIDTH), wraps by itself
+//   y_  : int16_t, 8.8 fixed point pixel (-128.0 ~ 127.99)
+//   vy_ : int16_t, 8.8 fixed point pixel per frame
+// Random numbers are made inline (xorshift32), two 16 bit values per call,
+// and reduced to a range by multiply and shift, without modulo.
+
+#define PARTICLE_Y_SHIFT            (8)
+#define PARTICLE_X_PER_PIXEL        (65536 / CV_V_WIDTH)    // ~57.7, truncated
+#define PARTICLE_DRAW_CHUNK         (256)
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class Particles
+{
+public:
+    uint16_t * x_ = nullptr;
+    int16_t * y_ = nullptr;
+    int16_t * vy_ = nullptr;
+    int count_ = 0;
+    int capacity_ = 0;
+
+    int fallSpeed_ = 1 << PARTICLE_Y_SHIFT;   // 8.8 pixel per frame
+    int fallSpread_ = 0;                      // 8.8, added [0, spread) per particle
+    int shakeSpan_ = 0;                       // x units
+    int shakeBase_ = 0;
+    uint32_t seed_ = 2463534242UL;
+
+public:
+    // Buffers are owned by the caller, all particles start on the ground.
+    void setBuffers(uint16_t * x, int16_t * y, int16_t * vy, int capacity) {
+        x_ = x;
+        y_ = y;
+        vy_ = vy;
+        capacity_ = capacity;
+        count_ = capacity;
+        for (int i = 0; i < capacity_; i++) {
+            y_[i] = (int16_t)((CV_HEIGHT << PARTICLE_Y_SHIFT) - 1);
+            vy_[i] = (int16_t)fallSpeed_;
+        }
+        setShake(3, -1);
+    }
+    void setCount(int count) {
+        count_ = (count < 0)? 0 : (count > capacity_)? capacity_ : count;
+    }
+    void setSeed(uint32_t seed) {
+        seed_ = (seed != 0)? seed : 2463534242UL;
+    }
+    // Fall speed in 8.8 pixel per frame, applied on respawn.
+    void setFallSpeed(int speed, int spread = 0) {
+        fallSpeed_ = speed;
+        fallSpread_ = spread;
+    }
+    // Horizontal shake per frame, [offset, offset + range - 1] pixel. (same as Snow)
+    void setShake(int range, int offset) {
+        shakeSpan_ = (range - 1) * PARTICLE_X_PER_PIXEL;
+        shakeBase_ = offset * PARTICLE_X_PER_PIXEL;
+    }
+    int getCount(void) {
+        return count_;
+    }
+
+public:
+    void loop() {
+        const int32_t ground = CV_HEIGHT << PARTICLE_Y_SHIFT;
+        const uint32_t span = (uint32_t)shakeSpan_ + 1;
+        uint32_t s = seed_;
+        for (int i = 0; i < count_; i++) {
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            uint32_t r1 = s >> 16;
+            uint32_t r2 = s & 0xFFFF;
+            int32_t y = y_[i] + vy_[i];
+            if (y >= ground) {
+                // On grounded. respawn above the screen.
+                x_[i] = (uint16_t)r1;
+                y_[i] = (int16_t)(-(int32_t)((r2 * CV_HEIGHT) >> (16 - PARTICLE_Y_SHIFT)));
+                vy_[i] = (int16_t)(fallSpeed_ + (int)((r2 * (uint32_t)fallSpread_) >> 16));
+            } else {
+                x_[i] = (uint16_t)(x_[i] + shakeBase_ + (int)((r1 * span) >> 16));
+                y_[i] = (int16_t)y;
+            }
+        }
+        seed_ = s;
+    }
+
+    // Plot all particles at (x - xpos), in chunks through the bulk path.
+    void draw(CyclicMonoDrawer * drawer, int xpos, color_t c = DISP_COLOR_WHITE) {
+        int16_t xs[PARTICLE_DRAW_CHUNK];
+        int16_t ys[PARTICLE_DRAW_CHUNK];
+        for (int i = 0; i < count_; ) {
+            int n = 0;
+            for (; i < count_ && n < PARTICLE_DRAW_CHUNK; i++) {
+                int y = y_[i] >> PARTICLE_Y_SHIFT;
+                if (y < 0) continue;
+                xs[n] = (int16_t)((x_[i] * (uint32_t)CV_V_WIDTH) >> 16);
+                ys[n] = (int16_t)y;
+                n++;
+            }
+            drawer->drawDots(xs, ys, n, -xpos, c);
+        }
+    }
+};
@@ -9,22 +9,30 @@
  * Include files
  *----------------------------------------------------------------------
  */
+#include <cstdint>
+
+#include "cv_geometry.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
-#define CV_HEIGHT           (128)                           // One display height in pixel
-#define CV_WIDTH            (32)                            // One display width in pixel
-#define CV_MARGIN           (39)                            // Margin between displays in pixel
-#define CV_PIXELS           (CV_HEIGHT * CV_WIDTH)          // One display pixels
-#define CV_ONE_FRAME_BYTES  (CV_PIXELS / 8)                 // One display frame data bytes
-#define CV_DISPLAYS         (16)                            // Count of displays
-#define CV_FRAME_BYTES      (CV_ONE_FRAME_BYTES * CV_DISPLAYS)  // Displays frame data bytes (Not include margin pixels)
-#define CV_DISTANCE         (CV_WIDTH + CV_MARGIN)          // Distance between displays in pixel
-#define CV_V_WIDTH          (CV_DISTANCE * CV_DISPLAYS)     // Display width includes margin
-#define CV_V_PIXELS         (CV_V_WIDTH * CV_HEIGHT)        // Display pixels includes margin
+// The geometry of this build, see cv_geometry.hpp to change it.
+typedef CvDefaultGeometry CvScreenGeometry;
+
+#define CV_HEIGHT           (CvScreenGeometry::HEIGHT)          // One display height in pixel
+#define CV_WIDTH            (CvScreenGeometry::WIDTH)           // One display width in pixel
+#define CV_MARGIN           (CvScreenGeometry::MARGIN)          // Margin between displays in pixel
+#define CV_PIXELS           (CvScreenGeometry::PIXELS)          // One display pixels
+#define CV_ONE_FRAME_BYTES  (CvScreenGeometry::ONE_FRAME_BYTES) // One display frame data bytes
+#define CV_DISPLAYS         (CvScreenGeometry::DISPLAYS)        // Count of displays
+#define CV_FRAME_BYTES      (CvScreenGeometry::FRAME_BYTES)     // Displays frame data bytes (Not include margin pixels)
+#define CV_DISTANCE         (CvScreenGeometry::DISTANCE)        // Distance between displays in pixel
+#define CV_V_WIDTH          (CvScreenGeometry::V_WIDTH)         // Display width includes margin
+#define CV_V_PIXELS         (CvScreenGeometry::V_PIXELS)        // Display pixels includes margin
+#define CV_BRIDGES          (CvScreenGeometry::BRIDGES)         // Count of bridge boards
+#define CV_GRAY_PLANES_MAX  (4)                                 // Bit planes of a grayscale frame (SIB_GRAY_PLANES_MAX)
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
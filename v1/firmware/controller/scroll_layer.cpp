@@ -0,0 +1,58 @@
+/**********************************************************************/
+/**
+ * @brief  Scroll Layer (Panel Pages of a Layer Around the Cylinder)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "scroll_layer.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// 8 plane columns from the column c (0 ~ width_ - 1) on every panel
+// column, a shift-and-merge of two neighbour bytes. (wrapped around)
+static void
+layer_bytes(const scroll_layer_t * layer, int32_t column, uint8_t * page)
+{
+    const mono_plane_t * plane = &layer->plane_;
+    int pages = plane->width_ / 8;
+    int shift = column & 7;
+    const uint8_t * src0 = plane->buffer_ + (column >> 3) * plane->height_;
+    const uint8_t * src1 = plane->buffer_ + (((column >> 3) + 1) % pages) * plane->height_;
+
+    memset(page, 0, CV_HEIGHT);
+    int y1 = (layer->y_ < 0)? 0 : layer->y_;
+    int y2 = layer->y_ + plane->height_;
+    if (y2 > CV_HEIGHT) y2 = CV_HEIGHT;
+    for (int y = y1; y < y2; y++) {
+        int row = y - layer->y_;
+        page[y] = (shift == 0)? src0[row] : (uint8_t)((src0[row] >> shift) | (src1[row] << (8 - shift)));
+    }
+}
+
+void
+scroll_layer_page(const scroll_layer_t * layer, int panel, int32_t vpage, uint8_t * page)
+{
+    int32_t width = layer->plane_.width_;
+    int32_t column = ((int32_t)panel * CV_DISTANCE + (vpage % width) * 8) % width;
+    if (column < 0) column += width;
+    layer_bytes(layer, column, page);
+}
+
+void
+scroll_layer_panel(const scroll_layer_t * layer, int panel, uint8_t * buffer)
+{
+    int32_t width = layer->plane_.width_;
+    for (int page = 0; page < CvScreenGeometry::PAGES; page++) {
+        int32_t column = ((int32_t)panel * CV_DISTANCE + page * 8 + layer->row_) % width;
+        layer_bytes(layer, column, buffer + page * CV_HEIGHT);
+    }
+}
@@ -0,0 +1,49 @@
+/**********************************************************************/
+/**
+ * @brief  Scroll Layer (Panel Pages of a Layer Around the Cylinder)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+
+#include "screen_config.hpp"
+#include "mono_image.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// A layer around the cylinder, shown by the start line of the panels on
+// the bridges instead of frames. (SpiI2cBridge::sendScrollFrame) The
+// screen x sx shows the plane column (sx + row_) % width_, the panel
+// columns y_ ~ y_ + height_ - 1 the plane rows, the others are blank.
+//
+// The bridge has the virtual pages of the panel rows : the virtual row v
+// of the panel p is the plane column (p * CV_DISTANCE + v) % width_, shown
+// at the panel row (v - start row). The layer moves by the start row, the
+// pages ahead are loaded while the others are shown.
+typedef struct scroll_layer_ {
+    mono_plane_t plane_;        // width_ : a multiple of 8
+    int y_;
+    int32_t row_;               // 0 ~ width_ - 1
+    uint32_t generation_;       // Changed with the plane pixels, loaded again
+} scroll_layer_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// The virtual page (8 rows) of the panel, CV_HEIGHT bytes. (a page of the
+// panel buffer layout)
+void scroll_layer_page(const scroll_layer_t * layer, int panel, int32_t vpage, uint8_t * page);
+
+// The panel buffer as shown at row_, CV_ONE_FRAME_BYTES. (the frame of the
+// layer, to check it against a rendered one)
+void scroll_layer_panel(const scroll_layer_t * layer, int panel, uint8_t * buffer);
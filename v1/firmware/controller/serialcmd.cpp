@@ -10,6 +10,7 @@
  */
 #include <Arduino.h>
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
 
 #include "serialcmd.hpp"
@@ -27,7 +28,6 @@
 SerialCmd::SerialCmd(HardwareSerial * serial) :
     serial_(serial)
 {
-    clearBuffer();
 }
 
 SerialCmd::~SerialCmd()
@@ -43,43 +43,37 @@ SerialCmd::~SerialCmd()
 int
 SerialCmd::loop(void)
 {
-    if (serial_ == NULL) return 0;
-    if (serial_->available() == 0) return 0;
-
-    char c = serial_->read();
-    if (c == '\n') {
-        // Line feed detected
-        getArg((uint8_t*)cmd_, sizeof(cmd_), 0);
-        for (int i = 0; i < SERIALCMD_MAX_PARAMS_NUM; i++) {
-            getArg((uint8_t*)param_[i], SERIALCMD_ONE_PARAM_LEN, i + 1);
-        }
-        clearBuffer();
-        // command found
-        return 1;
-    } else {
-        // Save into buffer
-        buffer_[buffer_i_] = c;
-        buffer_i_++;
-        if (buffer_i_ >= sizeof(buffer_)) {
-            // overwraped, reset buffer.
-            Serial.println("SerialCmd: mycommand buffer overflow");
-            clearBuffer();
+    if (serial_ == NULL) return SERIALCMD_NONE;
+
+    while (serial_->available() > 0) {
+        int c = serial_->read();
+        if (c < 0) break;
+        switch (parser_.push((uint8_t)c)) {
+        case CMDPARSER_TEXT:
+            return SERIALCMD_TEXT;
+        case CMDPARSER_BINARY:
+            return SERIALCMD_BINARY;
+        case CMDPARSER_ERROR:
+            Serial.println("SerialCmd: command dropped");
+            break;
+        default:
+            break;
         }
     }
 
-    return 0;
+    return SERIALCMD_NONE;
 }
 
 char *
 SerialCmd::getCmd(void)
 {
-    return cmd_;
+    return parser_.arg(0);
 }
 
 char *
 SerialCmd::getParam(int index)
 {
-    return param_[index];
+    return parser_.arg(index + 1);
 }
 
 bool
@@ -94,6 +88,40 @@ SerialCmd::checkParam(int index, const char * param)
     return strcmp(getParam(index), param) == 0;
 }
 
+uint8_t
+SerialCmd::getBinaryCmd(void)
+{
+    return parser_.binaryCmd();
+}
+
+const uint8_t *
+SerialCmd::getPayload(void)
+{
+    return parser_.payload();
+}
+
+int
+SerialCmd::getPayloadSize(void)
+{
+    return parser_.payloadSize();
+}
+
+bool
+SerialCmd::sendBinary(uint8_t cmd, const uint8_t * data, size_t size)
+{
+    if (serial_ == NULL) return false;
+    size_t n = CmdParser::makeFrame(txbuffer_, sizeof(txbuffer_), cmd, data, size);
+    if (n == 0 || serial_->availableForWrite() < (int)n) return false;
+    serial_->write(txbuffer_, n);
+    return true;
+}
+
+uint32_t
+SerialCmd::getErrors(void)
+{
+    return parser_.errors();
+}
+
 void
 SerialCmd::setSerial(HardwareSerial * serial)
 {
@@ -114,13 +142,13 @@ SerialCmd::serial(void)
 int
 SerialCmd::stringToInt(const char * str)
 {
-    return String(str).toInt();
+    return (int)strtol(str, NULL, 10);
 }
 
 char
 SerialCmd::stringToChar(const char * str)
 {
-    return String(str).toInt();
+    return (char)strtol(str, NULL, 10);
 }
 
 uint64_t
@@ -135,7 +163,7 @@ SerialCmd::stringToUInt64(const char * str)
 float
 SerialCmd::stringToFloat(const char * str)
 {
-    return String(str).toFloat();
+    return strtof(str, NULL);
 }
 
 uint32_t
@@ -151,79 +179,3 @@ SerialCmd::stringHexToUInt(const char * str)
     }
     return val;
 }
-
-/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
- * Method Implementation
- *----------------------------------------------------------------------
- */
-
-void
-SerialCmd::clearBuffer(void)
-{
-    buffer_i_ = 0;
-    memset(buffer_, 0, sizeof(buffer_));
-}
-
-void
-SerialCmd::getArg(uint8_t *dst, int size, int index)
-{
-    memset(dst, 0, size);
-
-    uint8_t * start = NULL;
-    uint8_t * end = NULL;
-
-    int curIndex = 0;
-    int bufptr = 0;
-    while (1) {
-        int pos;
-        int startPos = 0;
-        int endPos = 0;
-
-        // Search start position
-        pos = -1;
-        while (1) {
-            if (buffer_[bufptr] != ' ' && buffer_[bufptr] != '\0' && buffer_[bufptr] != '\n') { pos = bufptr; break; }
-            bufptr++;
-            if (bufptr >= sizeof(buffer_)) break;
-        }
-        if (pos == -1) {
-            break;
-        }
-        startPos = pos;
-
-        // Search end position
-        pos = -1;
-        while (1) {
-            if (buffer_[bufptr] == ' ' || buffer_[bufptr] == '\0' || buffer_[bufptr] == '\n') { pos = bufptr; break; }
-            bufptr++;
-            if (bufptr >= sizeof(buffer_)) break;
-        }
-        if (pos == -1) {
-            break;
-        }
-        endPos = pos;
-
-        if (curIndex == index) {
-            start = &buffer_[startPos];
-            end   = &buffer_[endPos];
-            break;
-        } else {
-            curIndex++;
-        }
-    }
-
-    if (start != NULL && end != NULL) {
-        // Copy to dst
-        while (1) {
-            *dst = *start;
-            dst++;
-            start++;
-            if (start == end) {
-                *dst = '\0';
-                break;
-            }
-        }
-    }
-
-    return;
-}
@@ -15,15 +15,20 @@
 #include <Arduino.h>
 #include <cstdint>
 
+#include "cmd_parser.hpp"
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
-#define SERIALCMD_MAX_COMMAND_LEN   (256)
-#define SERIALCMD_MAX_PARAMS_NUM    (16)
+#define SERIALCMD_MAX_COMMAND_LEN   (CMDPARSER_MAX_LINE_LEN)
+#define SERIALCMD_MAX_PARAMS_NUM    (CMDPARSER_MAX_ARGS - 1)
 
-#define SERIALCMD_ONE_PARAM_LEN     (SERIALCMD_MAX_COMMAND_LEN / (SERIALCMD_MAX_PARAMS_NUM + 1 /* Command */) )
+// loop() results
+#define SERIALCMD_NONE              (0)
+#define SERIALCMD_TEXT              (1)
+#define SERIALCMD_BINARY            (2)
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Forword Definitions
@@ -46,12 +51,21 @@ public:
     SerialCmd(HardwareSerial * serial);
     ~SerialCmd();
 
+    // Reads all available bytes, returns at a complete command.
     int loop(void);
     char * getCmd(void);
     char * getParam(int index);
     bool checkCmd(const char * cmd);
     bool checkParam(int index, const char * param);
 
+    // Binary command
+    uint8_t getBinaryCmd(void);
+    const uint8_t * getPayload(void);
+    int getPayloadSize(void);
+    // Send a binary frame, only if it fits to the tx buffer now. (never blocks)
+    bool sendBinary(uint8_t cmd, const uint8_t * data, size_t size);
+    uint32_t getErrors(void);
+
     void setSerial(HardwareSerial * serial);
     HardwareSerial * serial(void);
 
@@ -61,17 +75,9 @@ public:
     static uint64_t stringToUInt64(const char * str);
     static uint32_t stringHexToUInt(const char * str);
 
-private:
-    void clearBuffer(void);
-    void getArg(uint8_t *dst, int size, int index);
-
 private:
     HardwareSerial * serial_ = NULL;
 
-    uint8_t buffer_[SERIALCMD_MAX_COMMAND_LEN];
-    uint32_t buffer_i_ = 0;
-
-    char cmd_[SERIALCMD_ONE_PARAM_LEN];
-    char param_[SERIALCMD_MAX_PARAMS_NUM][SERIALCMD_ONE_PARAM_LEN];
-    int param1int_ = 0;
+    CmdParser parser_;
+    uint8_t txbuffer_[CMDPARSER_HEADER_SIZE + CMDPARSER_MAX_PAYLOAD + CMDPARSER_CRC_SIZE];
 };
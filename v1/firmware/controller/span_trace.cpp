@@ -0,0 +1,233 @@
+/**********************************************************************/
+/**
+ * @brief  Span Trace (Timing Spans of the Stages, a Ring per Core)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstring>
+
+// The Arduino core, or the shim of the host simulation (v1/tools/cvsim).
+#if defined(ARDUINO) || __has_include(<Arduino.h>)
+#include <Arduino.h>
+#define SPAN_TRACE_CLOCK
+#endif
+
+#include "span_trace.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef __time_critical_func
+#define __time_critical_func(x) x
+#endif
+
+// The host converter only formats and parses.
+#if defined(SPAN_TRACE_CLOCK)
+static inline uint32_t span_now(void) { return (uint32_t)micros(); }
+static inline int span_core(void) { return (int)get_core_num(); }
+#else
+static inline uint32_t span_now(void) { return 0; }
+static inline int span_core(void) { return 0; }
+#endif
+
+static const char * const span_stage_names[SPAN_STAGES] = {
+    "none",
+    "App::render",
+    "sendFrameDataParallel",
+    "crc",
+    "waitReady",
+    "sprites",
+    "data",
+    "sendPresent",
+    "sendScrollFrame",
+    "spi irq",
+    "PRESENT",
+    "writeFrameMulti",
+    "gray plane",
+    "scroll pages",
+    "sync",
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Recording
+ *----------------------------------------------------------------------
+ */
+
+SpanTrace::SpanTrace()
+{
+    memset((void*)rings_, 0, sizeof(rings_));
+}
+
+void
+SpanTrace::start(void)
+{
+    recording_ = false;
+    for (int core = 0; core < SPAN_CORES; core++) {
+        ring_t * ring = &rings_[core];
+        ring->head_ = 0;
+        ring->count_ = 0;
+        ring->overwritten_ = 0;
+        ring->open_ = nullptr;
+    }
+    recording_ = true;
+}
+
+void
+SpanTrace::stop(void)
+{
+    recording_ = false;
+}
+
+void
+__time_critical_func(SpanTrace::beginFolded)(uint8_t stage, uint32_t gapUs)
+{
+    if (!recording_) return;
+    ring_t * ring = &rings_[span_core()];
+    uint32_t now = span_now();
+    if (ring->count_ > 0) {
+        span_event_t * last = &ring->events_[(ring->head_ + SPAN_EVENTS - 1) % SPAN_EVENTS];
+        if (last->stage_ == stage && (last->flags_ & SPAN_FLAG_END) && (uint32_t)(now - last->timeUs_) < gapUs) {
+            ring->open_ = last;
+            ring->openStage_ = stage;
+            ring->openUs_ = now;
+            return;
+        }
+    }
+    ring->open_ = nullptr;
+    put(ring, span_core(), stage, SPAN_FLAG_BEGIN, 0, now);
+}
+
+void
+__time_critical_func(SpanTrace::endFolded)(uint8_t stage)
+{
+    if (!recording_) return;
+    ring_t * ring = &rings_[span_core()];
+    span_event_t * open = ring->open_;
+    if (open != nullptr && open->stage_ == stage) {
+        // Still the last event, the end moves.
+        open->timeUs_ = span_now();
+        if (open->arg_ < 0xFFFF) open->arg_++;
+        ring->open_ = nullptr;
+        return;
+    }
+    put(ring, span_core(), stage, SPAN_FLAG_END, 1, span_now());
+}
+
+void
+__time_critical_func(SpanTrace::push)(uint8_t stage, uint8_t flags, uint16_t arg)
+{
+    if (!recording_) return;
+    int core = span_core();
+    ring_t * ring = &rings_[core];
+    if (ring->open_ != nullptr) {
+        // An event in a folded span, it is a span of its own.
+        ring->open_ = nullptr;
+        put(ring, core, ring->openStage_, SPAN_FLAG_BEGIN, 0, ring->openUs_);
+    }
+    put(ring, core, stage, flags, arg, span_now());
+}
+
+void
+__time_critical_func(SpanTrace::put)(ring_t * ring, int core, uint8_t stage, uint8_t flags, uint16_t arg, uint32_t timeUs)
+{
+    span_event_t * event = &ring->events_[ring->head_];
+    event->timeUs_ = timeUs;
+    event->stage_ = stage;
+    event->flags_ = flags | ((core != 0)? SPAN_FLAG_CORE1 : 0);
+    event->arg_ = arg;
+    ring->head_ = (ring->head_ + 1) % SPAN_EVENTS;
+    if (ring->count_ < SPAN_EVENTS) {
+        ring->count_ = ring->count_ + 1;
+    } else {
+        ring->overwritten_++;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Dump
+ *----------------------------------------------------------------------
+ */
+
+uint32_t
+SpanTrace::count(int core) const
+{
+    return (core >= 0 && core < SPAN_CORES)? rings_[core].count_ : 0;
+}
+
+uint32_t
+SpanTrace::overwritten(int core) const
+{
+    return (core >= 0 && core < SPAN_CORES)? rings_[core].overwritten_ : 0;
+}
+
+bool
+SpanTrace::get(int core, uint32_t index, span_event_t * event) const
+{
+    if (core < 0 || core >= SPAN_CORES) return false;
+    const ring_t * ring = &rings_[core];
+    uint32_t count = ring->count_;
+    if (index >= count) return false;
+    *event = ring->events_[(ring->head_ + SPAN_EVENTS - count + index) % SPAN_EVENTS];
+    return true;
+}
+
+void
+SpanTrace::pack(const span_event_t * event, uint8_t * bytes)
+{
+    bytes[0] = (uint8_t)(event->timeUs_ >> 0);
+    bytes[1] = (uint8_t)(event->timeUs_ >> 8);
+    bytes[2] = (uint8_t)(event->timeUs_ >> 16);
+    bytes[3] = (uint8_t)(event->timeUs_ >> 24);
+    bytes[4] = event->stage_;
+    bytes[5] = event->flags_;
+    bytes[6] = (uint8_t)(event->arg_ >> 0);
+    bytes[7] = (uint8_t)(event->arg_ >> 8);
+}
+
+void
+SpanTrace::unpack(const uint8_t * bytes, span_event_t * event)
+{
+    event->timeUs_ = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    event->stage_ = bytes[4];
+    event->flags_ = bytes[5];
+    event->arg_ = (uint16_t)(bytes[6] | bytes[7] << 8);
+}
+
+int
+SpanTrace::format(int source, const span_event_t * event, char * line, size_t size)
+{
+    return snprintf(line, size, SPAN_LINE_PREFIX "%d %08lx %02x %02x %04x",
+        source, (unsigned long)event->timeUs_, event->stage_, event->flags_, event->arg_);
+}
+
+// The event anywhere in the line, a serial log may have a prefix.
+bool
+SpanTrace::parse(const char * line, int * source, span_event_t * event)
+{
+    const char * p = strstr(line, SPAN_LINE_PREFIX);
+    if (p == nullptr) return false;
+    int src;
+    unsigned long t;
+    unsigned stage, flags, arg;
+    if (sscanf(p + strlen(SPAN_LINE_PREFIX), "%d %lx %x %x %x", &src, &t, &stage, &flags, &arg) != 5) return false;
+    if (src < 0 || stage == SPAN_NONE || stage >= SPAN_STAGES || flags > 0xFF || arg > 0xFFFF) return false;
+    *source = src;
+    event->timeUs_ = (uint32_t)t;
+    event->stage_ = (uint8_t)stage;
+    event->flags_ = (uint8_t)flags;
+    event->arg_ = (uint16_t)arg;
+    return true;
+}
+
+const char *
+SpanTrace::stageName(int stage)
+{
+    return (stage >= 0 && stage < SPAN_STAGES)? span_stage_names[stage] : "?";
+}
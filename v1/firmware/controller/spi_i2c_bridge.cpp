@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <SPI.h>
 
+#include "screen_config.hpp"
 #include "spi_i2c_bridge.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -18,6 +19,10 @@
  *----------------------------------------------------------------------
  */
 
+#ifndef MAX
+#define MAX(x,y)        (((x) >= (y))? (x) : (y))
+#endif
+
 static const int SPI_CMD_NONE        = 0x00;
 static const int SPI_CMD_GET_STATUS  = 0x01;
 static const int SPI_CMD_START_FRAME = 0x02;
@@ -27,21 +32,52 @@ static const int SPI_CMD_OB_LED_ON   = 0x05;
 static const int SPI_CMD_OB_LED_OFF  = 0x06;
 static const int SPI_CMD_SET_ID_DIR0 = 0x07;
 static const int SPI_CMD_SET_ID_DIR1 = 0x08;
+static const int SPI_CMD_UPLOAD_ASSET = 0x09;
+static const int SPI_CMD_DRAW_SPRITES = 0x0A;
+static const int SPI_CMD_CLEAR_ASSETS = 0x0B;
+static const int SPI_CMD_LINK_TEST   = 0x0C;
+static const int SPI_CMD_PRESENT     = 0x0D;
+static const int SPI_CMD_GET_PRESENT_STATS = 0x0E;
+static const int SPI_CMD_SET_GRAY    = 0x0F;
+static const int SPI_CMD_SCROLL_PAGES = 0x10;
+static const int SPI_CMD_SCROLL      = 0x11;
+static const int SPI_CMD_SPANS       = 0x12;
+static const int SPI_CMD_GET_SPANS   = 0x13;
 static const int SPI_CMD_HARD_RESET  = 0xFE;
 
 static const int SPI_SYNC1 = 0xAA;
 static const int SPI_SYNC2 = 0x55;
 static const int SPI_TXDATA_VALID_FLAG = 0x80;
+static const int SPI_RSP_DATA_SCROLL_MISS = (1 << 0);
 static const int SPI_RSP_DATA_BUSY  = (1 << 1);
 static const int SPI_RSP_DATA_PING  = (1 << 2);
 static const int SPI_RSP_DATA_ERROR = (1 << 3);
+static const int SPI_RSP_DATA_ASSET_MISS = (1 << 4);
+static const int SPI_RSP_DATA_STATS = (1 << 5);
+static const int SPI_RSP_DATA_SHOWING = (1 << 6);
+static const int SPI_PRESENT_STATS_SIZE = 10;   // Same to the bridge
+static const int SPI_SPANS_STOP  = 0;           // SPANS OPT1, the sequence high << 4
+static const int SPI_SPANS_START = 1;
+static const int SPI_SPANS_SYNC  = 2;
+static const int SPI_SPAN_BLOCK_SIZE = 4 + SIB_SPAN_BLOCK_EVENTS * SPAN_EVENT_SIZE;    // Same to the bridge
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
-static SPISettings spisettings(3000000, MSBFIRST, SPI_MODE0);
+// SPI clocks for the link training. The bridge (PL022 slave) is up to
+// clk_peri / 12, the upper rates are for a faster clk_peri.
+static const uint32_t spi_link_rates[] = {
+    1000000, 2000000, 3000000, 4000000, 6000000, 8000000, 10000000, 12000000, 16000000, 20000000,
+};
+static const int spi_link_base = 2;             // 3 MHz, before the training
+static const int SPI_LINK_TEST_SIZE = 256;      // Same to the bridge
+static const int SPI_LINK_PATTERNS = 4;
+static const int SPI_LINK_FLUSH_SIZE = 4096 + 16;
+
+static SPIClassRP2040 * const sib_spis[SIB_BUSES] = { &SPI, &SPI1 };
+
 static uint16_t   crc16_lu_table[256]; 
 static const uint16_t crc16_polynomial = 0x1021;
 
@@ -52,7 +88,19 @@ static const uint16_t crc16_polynomial = 0x1021;
 
 SpiI2cBridge::SpiI2cBridge()
 {
-
+    memset((void*)&pendingSprites_, 0, sizeof(pendingSprites_));
+    for (int id = 0; id < SIB_ENDPOINTS_MAX; id++) {
+        invalidateAssets(id);
+    }
+    memset((void*)endpoint_, 0, sizeof(endpoint_));
+    memset((void*)presentStats_, 0, sizeof(presentStats_));
+    memset((void*)&scrollStats_, 0, sizeof(scrollStats_));
+    for (int id = 0; id < SIB_ENDPOINTS_MAX; id++) {
+        shared_[id] = false;
+        wave_[id] = 0;
+        link_[id].init(spi_link_rates, sizeof(spi_link_rates) / sizeof(spi_link_rates[0]), spi_link_base);
+        setClock(id, link_[id].clock());
+    }
 }
 
 SpiI2cBridge::~SpiI2cBridge()
@@ -61,28 +109,45 @@ SpiI2cBridge::~SpiI2cBridge()
 }
 
 void
-SpiI2cBridge::init(
-    int pin_spi0_rx,
-    int pin_spi0_cs,
-    int pin_spi0_sck,
-    int pin_spi0_tx,
-    int pin_spi1_rx,
-    int pin_spi1_cs,
-    int pin_spi1_sck,
-    int pin_spi1_tx
-) {
+SpiI2cBridge::init(const sib_bus_t * buses, const sib_endpoint_t * endpoints, int count)
+{
     calc_crc16_lookup_table();
 
-    SPI.setRX(pin_spi0_rx);
-    SPI.setCS(pin_spi0_cs);
-    SPI.setSCK(pin_spi0_sck);
-    SPI.setTX(pin_spi0_tx);
-    SPI.begin(true);
-    SPI1.setRX(pin_spi1_rx);
-    SPI1.setCS(pin_spi1_cs);
-    SPI1.setSCK(pin_spi1_sck);
-    SPI1.setTX(pin_spi1_tx);
-    SPI1.begin(true);
+    endpoints_ = (count < 1)? 1 : (count > SIB_ENDPOINTS_MAX)? SIB_ENDPOINTS_MAX : count;
+
+    // The endpoints of a bus are sent one after another, one a wave.
+    int perBus[SIB_BUSES] = { 0 };
+    waves_ = 0;
+    for (int id = 0; id < endpoints_; id++) {
+        endpoint_[id] = endpoints[id];
+        wave_[id] = perBus[endpoint_[id].bus_]++;
+        waves_ = MAX(waves_, perBus[endpoint_[id].bus_]);
+    }
+    for (int id = 0; id < endpoints_; id++) {
+        shared_[id] = (perBus[endpoint_[id].bus_] > 1);
+        setClock(id, link_[id].clock());
+    }
+
+    for (int bus = 0; bus < SIB_BUSES; bus++) {
+        if (perBus[bus] == 0) continue;
+        SPIClassRP2040 * spi = sib_spis[bus];
+        spi->setRX(buses[bus].pinRX_);
+        spi->setSCK(buses[bus].pinSCK_);
+        spi->setTX(buses[bus].pinTX_);
+        if (perBus[bus] == 1) {
+            for (int id = 0; id < endpoints_; id++) {
+                if (endpoint_[id].bus_ == bus) spi->setCS(endpoint_[id].pinCS_);
+            }
+            spi->begin(true);
+        } else {
+            for (int id = 0; id < endpoints_; id++) {
+                if (endpoint_[id].bus_ != bus) continue;
+                pinMode(endpoint_[id].pinCS_, OUTPUT);
+                digitalWrite(endpoint_[id].pinCS_, HIGH);
+            }
+            spi->begin(false);
+        }
+    }
 }
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -92,12 +157,42 @@ SpiI2cBridge::init(
 
 bool
 SpiI2cBridge::waitReady(int id)
+{
+    return waitStatus(id, SPI_RSP_DATA_BUSY);
+}
+
+// Polls the status until the bits are clear.
+bool
+SpiI2cBridge::waitStatus(int id, uint8_t bits)
 {
     uint32_t retry = 0xFFFFF;
     while (retry > 0) {
         sendCommand(id, SPI_CMD_GET_STATUS);
         uint8_t status = receiveResponse(id);
-        if ((status & SPI_RSP_DATA_BUSY) == 0) {
+        if ((status & SPI_TXDATA_VALID_FLAG) == 0) {
+            // No response, polled again. (the bits are not valid)
+            updateClock(id, link_[id].retry());
+            retry--;
+            continue;
+        }
+        if (status & SPI_RSP_DATA_ERROR) {
+            // A command since the last status was broken. (CRC, header)
+            updateClock(id, link_[id].error());
+            scrollValid_ = false;
+        }
+        if (status & SPI_RSP_DATA_ASSET_MISS) {
+            // An asset of the pending frame was evicted for this frame, as
+            // the mirror tells. Otherwise the bridge lost some, cleared at
+            // the next upload.
+            if (!assetMissExpected_[id]) assetLost_[id] = true;
+            assetMissExpected_[id] = false;
+        }
+        if (status & SPI_RSP_DATA_SCROLL_MISS) {
+            // A row was shown before its pages, the layer is loaded again.
+            scrollValid_ = false;
+            scrollStats_.misses_++;
+        }
+        if ((status & bits) == 0) {
             // receiver is ready.
             break;
         }
@@ -128,67 +223,646 @@ SpiI2cBridge::sendHardReset(int id) {
 }
 
 bool
-SpiI2cBridge::sendFrameDataParallel(uint8_t* buffer, size_t size)
+SpiI2cBridge::sendFrameDataParallel(uint8_t* buffer, size_t size, const sprite_list_t * sprites)
+{
+    spanFrame();
+    spanBegin(SPAN_SEND_FRAME);
+    bool ok = sendFrame(buffer, size, sprites);
+    spanEnd(SPAN_SEND_FRAME, ok);
+    return ok;
+}
+
+// A stage left by a failure is closed by the end of the frame. (spantrace)
+bool
+SpiI2cBridge::sendFrame(uint8_t* buffer, size_t size, const sprite_list_t * sprites)
 {
-    uint16_t blocksize = size / SIB_CHANNELS;
-    uint8_t opt1 = blocksize >> 0;
-    uint8_t opt2 = blocksize >> 8;
+    // The endpoint block of each plane, in one body.
+    size_t planesize = size / grayPlanes_;
+    uint16_t blocksize = planesize / endpoints_;
+    uint16_t bodysize = blocksize * grayPlanes_;
+    uint8_t opt1 = bodysize >> 0;
+    uint8_t opt2 = bodysize >> 8;
     uint8_t cmdbuf[9] = { SPI_SYNC1, SPI_SYNC2, SPI_CMD_SET_DATA, opt1, opt2, (uint8_t)~opt1, (uint8_t)~opt2, 0x00, 0x00 };
 
     // Calculate crc
+    spanBegin(SPAN_FRAME_CRC);
     uint16_t basecrc16 = calc_crc16(cmdbuf, sizeof(cmdbuf) - 2);
-    uint16_t crc16[SIB_CHANNELS];
-    for (int id = 0; id < SIB_CHANNELS; id++) {
-        crc16[id] = calc_crc16(buffer + (blocksize * id), blocksize, basecrc16);
+    uint16_t crc16[SIB_ENDPOINTS_MAX];
+    for (int id = 0; id < endpoints_; id++) {
+        crc16[id] = basecrc16;
+        for (int plane = 0; plane < grayPlanes_; plane++) {
+            crc16[id] = calc_crc16(buffer + (planesize * plane) + (blocksize * id), blocksize, crc16[id]);
+        }
     }
+    spanEnd(SPAN_FRAME_CRC);
 
     // Wait device ready.
-    for (int id = 0; id < SIB_CHANNELS; id++) {
+    spanBegin(SPAN_WAIT_READY);
+    for (int id = 0; id < endpoints_; id++) {
         if (!waitReady(id)) {
             return false;
         }
     }
 
+    // The panel pages are the frame on the bridges.
+    scrollValid_ = false;
+
+    // All ready, the last frame is started on all. (the stats of the same frame)
+    if (present_ && ++presentFrames_ >= SIB_PRESENT_STATS_PERIOD) {
+        presentFrames_ = 0;
+        pollPresentStats();
+    }
+    spanEnd(SPAN_WAIT_READY);
+
+    // Upload sprite assets not resident on the bridge yet.
+    bool useSprites = (sprites != nullptr && spriteRegistry_ != nullptr && sprites->count_ > 0);
+    if (useSprites) {
+        spanBegin(SPAN_SPRITES);
+        for (int id = 0; id < endpoints_; id++) {
+            if (!ensureAssets(id, sprites)) {
+                return false;
+            }
+        }
+    }
+
     // Send start frame command
-    for (int id = 0; id < SIB_CHANNELS; id++) {
+    for (int id = 0; id < endpoints_; id++) {
         sendCommand(id, SPI_CMD_START_FRAME);
     }
+    if (!useSprites) {
+        pendingSprites_.count_ = 0;
+    }
 
-    // Send data command header
-    for (int id = 0; id < SIB_CHANNELS; id++) {
-        transfer(id, cmdbuf, NULL, sizeof(cmdbuf) - 2);
+    // Send sprite instances, these are composited on the bridge before the i2c transfer.
+    if (useSprites) {
+        int panels = blocksize / CV_ONE_FRAME_BYTES;
+        for (int id = 0; id < endpoints_; id++) {
+            sendDrawSprites(id, sprites, panels * id);
+        }
+        pendingSprites_ = *sprites;
+        spanEnd(SPAN_SPRITES);
+        if (sprites->flags_ & SPRITE_LIST_FLAG_CLEAR) {
+            // Frame is committed by the sprite command. No frame data required.
+            for (int id = 0; id < endpoints_; id++) {
+                link_[id].frame();
+            }
+            return (present_)? sendPresent() : true;
+        }
     }
 
-    // Send data async
-    for (int id = 0; id < SIB_CHANNELS; id++) {
-        transferAsync(id, buffer + (blocksize * id), NULL, blocksize);
+    // Send data in waves, one endpoint of each bus a wave. The buses run
+    // in parallel (async), the endpoints sharing a bus one after another.
+    uint8_t tailbuf[2 + 32];
+    memset(tailbuf, 0, sizeof(tailbuf));
+    spanBegin(SPAN_FRAME_DATA, (uint16_t)waves_);
+    for (int wave = 0; wave < waves_; wave++) {
+        // Send data command header, then data async
+        for (int id = 0; id < endpoints_; id++) {
+            if (wave_[id] != wave) continue;
+            transfer(id, cmdbuf, NULL, sizeof(cmdbuf) - 2);
+            transferAsync(id, buffer + (blocksize * id), NULL, blocksize);
+        }
+        for (int plane = 1; plane < grayPlanes_; plane++) {
+            for (int id = 0; id < endpoints_; id++) {
+                if (wave_[id] != wave) continue;
+                transferAsynEnd(id);
+                transferAsync(id, buffer + (planesize * plane) + (blocksize * id), NULL, blocksize);
+            }
+        }
+
+        // Wait send data async, then crc and padding to flush the receiver
+        // fifo. The frame is committed on the bridge when the crc is received.
+        for (int id = 0; id < endpoints_; id++) {
+            if (wave_[id] != wave) continue;
+            transferAsynEnd(id);
+            tailbuf[0] = (uint8_t)(crc16[id] >> 0);
+            tailbuf[1] = (uint8_t)(crc16[id] >> 8);
+            transfer(id, tailbuf, NULL, sizeof(tailbuf));
+            link_[id].frame();
+        }
     }
+    spanEnd(SPAN_FRAME_DATA);
+
+    return (present_)? sendPresent() : true;
+}
 
-    // Wait send data async
-    for (int id = 0; id < SIB_CHANNELS; id++) {
-        transferAsynEnd(id);
+bool
+SpiI2cBridge::setGray(int planes, int steps, uint32_t slotUs)
+{
+    // The bridge resizes its slots on core1, busy until then.
+    grayPlanes_ = (planes < 1)? 1 : (planes > SIB_GRAY_PLANES_MAX)? SIB_GRAY_PLANES_MAX : planes;
+    scrollValid_ = false;
+    uint8_t opt1 = (uint8_t)(grayPlanes_ | ((steps & 0x0F) << 4));
+    uint32_t slot = (slotUs + 99) / 100;
+    uint8_t opt2 = (uint8_t)((slot > 0xFF)? 0xFF : slot);
+    for (int id = 0; id < endpoints_; id++) {
+        sendCommand(id, SPI_CMD_SET_GRAY, opt1, opt2);
+    }
+    bool ok = true;
+    for (int id = 0; id < endpoints_; id++) {
+        if (!waitReady(id)) ok = false;
     }
+    return ok;
+}
 
-    #if 1
-    // Super Dirty Workaround
-    uint8_t tmpbuffer[32];
-    memset(tmpbuffer, 0, sizeof(tmpbuffer));
-    for (int id = 0; id < SIB_CHANNELS; id++) {
-      transfer(id, tmpbuffer, NULL, sizeof(tmpbuffer));
+void
+SpiI2cBridge::setPresent(bool on)
+{
+    // The bridges enter the present mode, or leave it and the staged
+    // slots start.
+    present_ = on;
+    presentFrames_ = 0;
+    broadcast(SPI_CMD_PRESENT, (on)? 1 : 0);
+}
+
+bool
+SpiI2cBridge::sendPresent(void)
+{
+    // All the bridges start the frame at once only if all are idle, a
+    // bridge still transferring the last frame would start late.
+    bool ok = true;
+    spanBegin(SPAN_PRESENT);
+    for (int id = 0; id < endpoints_; id++) {
+        if (!waitStatus(id, SPI_RSP_DATA_SHOWING)) ok = false;
     }
-    #endif
+    broadcast(SPI_CMD_PRESENT, 1);
+    spanEnd(SPAN_PRESENT);
+    return ok;
+}
 
-    // Send crc
-    for (int id = 0; id < SIB_CHANNELS; id++) {
-        uint8_t buf[2];
-        buf[0] = (uint8_t)(crc16[id] >> 0);
-        buf[1] = (uint8_t)(crc16[id] >> 8);
-        transfer(id, buf, NULL, sizeof(buf));
+bool
+SpiI2cBridge::pollPresentStats(void)
+{
+    bool ok = true;
+    for (int id = 0; id < endpoints_; id++) {
+        sendCommand(id, SPI_CMD_GET_PRESENT_STATS);
+        uint8_t status = receiveResponse(id);
+        if ((status & SPI_RSP_DATA_STATS) == 0) {
+            ok = false;
+            continue;
+        }
+        uint8_t rx[SPI_PRESENT_STATS_SIZE];
+        memset(rx, 0, sizeof(rx));
+        transfer(id, rx, rx, sizeof(rx));
+        sib_present_stats_t * stats = &presentStats_[id];
+        stats->presents_     = (uint16_t)(rx[0] | (rx[1] << 8));
+        stats->missed_       = (uint16_t)(rx[2] | (rx[3] << 8));
+        stats->pushed_       = (uint16_t)(rx[4] | (rx[5] << 8));
+        stats->latencyUs_    = (uint16_t)(rx[6] | (rx[7] << 8));
+        stats->maxLatencyUs_ = (uint16_t)(rx[8] | (rx[9] << 8));
     }
+    if (!ok) return false;
+
+    // The transfer start of the last PRESENT, on the controller clock.
+    uint32_t first = UINT32_MAX, last = 0;
+    for (int id = 0; id < endpoints_; id++) {
+        const sib_present_stats_t * stats = &presentStats_[id];
+        if (stats->pushed_ != stats->presents_) return false;
+        uint32_t start = stats->sentUs_ + stats->latencyUs_;
+        if (start < first) first = start;
+        if (start > last) last = start;
+    }
+    presentSkewUs_ = last - first;
+    presentSkewMaxUs_ = MAX(presentSkewMaxUs_, presentSkewUs_);
+    return true;
+}
 
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Scroll Layer
+ *----------------------------------------------------------------------
+ */
+
+static int32_t
+scroll_wrap(int32_t v, int32_t period)
+{
+    v %= period;
+    return (v < 0)? v + period : v;
+}
+
+bool
+SpiI2cBridge::scrollFits(const scroll_layer_t * layer)
+{
+    bool seen = scrollSeen_;
+    int32_t seenRow = scrollSeenRow_;
+    scrollSeen_ = (layer != nullptr);
+    if (layer == nullptr) return false;
+    scrollSeenRow_ = layer->row_;
+
+    // The frames go on while the row jumps, e.g. the angle of a spinning
+    // cylinder, or the layer would be loaded every frame.
+    if (!CvScreenGeometry::SSD1306_SCROLL || grayPlanes_ != 1 || !seen) return false;
+    int32_t width = layer->plane_.width_;
+    if (width <= 0 || (width % 8) != 0) return false;
+    int32_t step = scroll_wrap(layer->row_ - seenRow, width);
+    if (step > width / 2) step -= width;
+    return (step >= -SIB_SCROLL_STEP_MAX && step <= SIB_SCROLL_STEP_MAX);
+}
+
+// The pages of the new row not on the bridges yet, and the pages ahead of
+// it in the direction of the scroll, but no page shown at the last row. Then
+// the row, presented as a frame.
+bool
+SpiI2cBridge::sendScrollFrame(const scroll_layer_t * layer)
+{
+    spanFrame();
+    spanBegin(SPAN_SCROLL_FRAME);
+    bool ok = sendScroll(layer);
+    spanEnd(SPAN_SCROLL_FRAME, ok);
+    return ok;
+}
+
+bool
+SpiI2cBridge::sendScroll(const scroll_layer_t * layer)
+{
+    const int pages = SIB_SCROLL_PAGES;
+    const int panels = CvScreenGeometry::CHANNELS;
+
+    for (int id = 0; id < endpoints_; id++) {
+        if (!waitReady(id)) {
+            return false;
+        }
+    }
+
+    int32_t width = layer->plane_.width_;
+    int32_t lastRow = scrollRow_;
+    bool reload = (!scrollValid_ || layer->generation_ != scrollGeneration_ || width != scrollWidth_);
+    if (reload) {
+        // 65536 / gcd(width, 65536) widths.
+        int32_t g = width & -width;
+        if (g > 65536) g = 65536;
+        scrollPeriod_ = (65536 / g) * width;
+        scrollWidth_ = width;
+        scrollGeneration_ = layer->generation_;
+        scrollRow_ = layer->row_;
+        scrollForward_ = true;
+        for (int i = 0; i < pages; i++) scrollTags_[i] = -1;
+        scrollValid_ = true;
+        scrollStats_.reloads_++;
+    } else {
+        int32_t step = scroll_wrap(layer->row_ - scrollRow_, width);
+        if (step > width / 2) step -= width;
+        if (step != 0) scrollForward_ = (step > 0);
+        scrollRow_ = scroll_wrap(scrollRow_ + step, scrollPeriod_);
+    }
+
+    // The windows, the virtual pages of the panel rows from the row.
+    const int32_t vpages = scrollPeriod_ / 8;
+    int32_t first = scrollRow_ >> 3;
+    int32_t last = (scrollRow_ + CV_WIDTH - 1) >> 3;
+    int32_t lastFirst = lastRow >> 3;
+    int32_t lastLast = (lastRow + CV_WIDTH - 1) >> 3;
+    int32_t from = (scrollForward_)? first : last - (pages - 1);
+
+    int32_t send[SIB_SCROLL_PAGES];
+    int count = 0;
+    for (int i = 0; i < pages; i++) {
+        int32_t vpage = scroll_wrap(from + i, vpages);
+        int page = vpage % pages;
+        if (scrollTags_[page] == vpage) continue;
+        bool window = scroll_wrap(vpage - first, vpages) <= (last - first);
+        bool shown = false;
+        if (!reload) {
+            for (int32_t v = lastFirst; v <= lastLast; v++) {
+                if (scroll_wrap(v, vpages) % pages == page) shown = true;
+            }
+        }
+        if (shown && !window) continue;
+        send[count++] = vpage;
+    }
+
+    // The records of the panels of each endpoint.
+    for (int id = 0; id < endpoints_ && count > 0; id++) {
+        uint8_t * buf = scrollBuffer_;
+        for (int i = 0; i < count; i++) {
+            *buf++ = (uint8_t)(send[i] >> 0);
+            *buf++ = (uint8_t)((send[i] >> 8) & 0x1F);
+            for (int ch = 0; ch < panels; ch++) {
+                scroll_layer_page(layer, (id * panels) + ch, send[i], buf);
+                buf += CV_HEIGHT;
+            }
+        }
+        sendPayload(id, SPI_CMD_SCROLL_PAGES, scrollBuffer_, buf - scrollBuffer_);
+    }
+    for (int i = 0; i < count; i++) {
+        scrollTags_[send[i] % pages] = send[i];
+    }
+    scrollStats_.pages_ += count;
+    scrollStats_.frames_++;
+
+    // The row, staged until the PRESENT in the present mode.
+    uint16_t row = (uint16_t)(scrollRow_ & 0xFFFF);
+    for (int id = 0; id < endpoints_; id++) {
+        sendCommand(id, SPI_CMD_SCROLL, (uint8_t)(row >> 0), (uint8_t)(row >> 8));
+        link_[id].frame();
+    }
+
+    return (present_)? sendPresent() : true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Span Trace
+ *----------------------------------------------------------------------
+ */
+
+void
+SpiI2cBridge::startSpans(bool on)
+{
+    if (spans_ == nullptr) return;
+    if (on) {
+        spans_->start();
+        for (int id = 0; id < endpoints_; id++) {
+            sendCommand(id, SPI_CMD_SPANS, SPI_SPANS_START);
+        }
+        spanFrames_ = 0;
+        syncSpans();
+    } else {
+        syncSpans();
+        for (int id = 0; id < endpoints_; id++) {
+            sendCommand(id, SPI_CMD_SPANS, SPI_SPANS_STOP);
+        }
+        spans_->stop();
+    }
+}
+
+// The SPI frame boundary of a command : the controller marks the end of
+// the transfer, the bridge the command receive. (the rx timeout after it)
+void
+SpiI2cBridge::syncSpans(void)
+{
+    if (spans_ == nullptr || !spans_->recording()) return;
+    spanSeq_ = (spanSeq_ + 1) & SPAN_SYNC_SEQ_MASK;
+    uint8_t opt1 = (uint8_t)(SPI_SPANS_SYNC | ((spanSeq_ >> 8) << 4));
+    uint8_t opt2 = (uint8_t)(spanSeq_ >> 0);
+    for (int id = 0; id < endpoints_; id++) {
+        sendCommand(id, SPI_CMD_SPANS, opt1, opt2);
+        spans_->mark(SPAN_SYNC, (uint16_t)((id << 12) | spanSeq_));
+    }
+}
+
+void
+SpiI2cBridge::spanFrame(void)
+{
+    if (spans_ == nullptr || !spans_->recording()) return;
+    if (++spanFrames_ >= SIB_SPAN_SYNC_PERIOD) {
+        spanFrames_ = 0;
+        syncSpans();
+    }
+}
+
+int
+SpiI2cBridge::readSpans(int id, int core, uint32_t index, span_event_t * events, sib_span_ring_t * ring)
+{
+    uint16_t at = (uint16_t)((index & 0x7FFF) | ((core & 1) << 15));
+    sendCommand(id, SPI_CMD_GET_SPANS, (uint8_t)(at >> 0), (uint8_t)(at >> 8));
+    uint8_t status = receiveResponse(id);
+    if ((status & SPI_RSP_DATA_STATS) == 0) {
+        return -1;
+    }
+    uint8_t rx[SPI_SPAN_BLOCK_SIZE];
+    memset(rx, 0, sizeof(rx));
+    transfer(id, rx, rx, sizeof(rx));
+    ring->events_      = (uint16_t)(rx[0] | (rx[1] << 8));
+    ring->overwritten_ = (uint16_t)(rx[2] | (rx[3] << 8));
+    int n = 0;
+    while (n < SIB_SPAN_BLOCK_EVENTS && index + n < ring->events_) {
+        SpanTrace::unpack(&rx[4 + n * SPAN_EVENT_SIZE], &events[n]);
+        n++;
+    }
+    return n;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Link Rate
+ *----------------------------------------------------------------------
+ */
+
+uint32_t
+SpiI2cBridge::trainLink(int id)
+{
+    SpiLinkRate * link = &link_[id];
+    link->startTraining();
+    while (link->training()) {
+        setClock(id, link->clock());
+        link->testResult(testLink(id));
+    }
+    setClock(id, link->clock());
+
+    // A failed round may have left the bridge in a body, flush it at the
+    // trained clock. Then a status read clears the error flag.
+    memset(assetBuffer_, 0, sizeof(assetBuffer_));
+    for (size_t sent = 0; sent < (size_t)SPI_LINK_FLUSH_SIZE; sent += sizeof(assetBuffer_)) {
+        transfer(id, assetBuffer_, NULL, sizeof(assetBuffer_));
+    }
+    sendCommand(id, SPI_CMD_GET_STATUS);
+    receiveResponse(id);
+
+    return link->clock();
+}
+
+bool
+SpiI2cBridge::testLink(int id)
+{
+    // 0x00 / 0xFF, 0x55 (a toggle on every clock), walking one and pseudo
+    // random. No 0xAA, the body is not taken as a sync after a broken header.
+    uint8_t * pattern = assetBuffer_;
+    uint32_t seed = 0x12345678;
+    for (int p = 0; p < SPI_LINK_PATTERNS; p++) {
+        for (int i = 0; i < SPI_LINK_TEST_SIZE; i++) {
+            uint8_t c;
+            switch (p) {
+            case 0:  c = (i & 1)? 0xFF : 0x00; break;
+            case 1:  c = 0x55; break;
+            case 2:  c = (uint8_t)(1 << (i & 7)); break;
+            default:
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                c = (uint8_t)seed;
+                break;
+            }
+            pattern[i] = (c == SPI_SYNC1)? (uint8_t)~c : c;
+        }
+        sendPayload(id, SPI_CMD_LINK_TEST, pattern, SPI_LINK_TEST_SIZE, false);
+        if ((receiveResponse(id) & 0x7F) != SPI_RSP_DATA_PING) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+SpiI2cBridge::setClock(int id, uint32_t hz)
+{
+    spisettings_[id] = SPISettings(hz, MSBFIRST, (shared_[id])? SPI_MODE3 : SPI_MODE0);
+}
+
+void
+SpiI2cBridge::updateClock(int id, bool changed)
+{
+    if (!changed) return;
+    setClock(id, link_[id].clock());
+    Serial.printf("SPI link %d fell back to %u Hz\n", id, (unsigned)link_[id].clock());
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Bridge Sprites
+ *----------------------------------------------------------------------
+ */
+
+void
+SpiI2cBridge::setSpriteRegistry(SpriteRegistry * registry)
+{
+    spriteRegistry_ = registry;
+    for (int id = 0; id < SIB_ENDPOINTS_MAX; id++) {
+        invalidateAssets(id);
+    }
+}
+
+bool
+SpiI2cBridge::sendUploadAsset(int id, int handle)
+{
+    if (spriteRegistry_ == nullptr) return false;
+
+    size_t size = spriteRegistry_->pack(handle, assetBuffer_, sizeof(assetBuffer_));
+    if (size == 0) return false;
+
+    sendPayload(id, SPI_CMD_UPLOAD_ASSET, assetBuffer_, size);
+    storeAsset(id, handle, size);
+    return true;
+}
+
+void
+SpiI2cBridge::sendDrawSprites(int id, const sprite_list_t * sprites, int panelBase)
+{
+    uint8_t * buf = listBuffer_;
+    buf[0] = (uint8_t)panelBase;
+    buf[1] = sprites->flags_;
+    buf[2] = sprites->count_;
+    buf[3] = 0x00;
+    buf[4] = (uint8_t)(CV_DISTANCE >> 0);
+    buf[5] = (uint8_t)(CV_DISTANCE >> 8);
+    buf[6] = (uint8_t)(CV_V_WIDTH >> 0);
+    buf[7] = (uint8_t)(CV_V_WIDTH >> 8);
+    buf += SPRITE_LIST_HEADER_SIZE;
+    for (int i = 0; i < sprites->count_; i++) {
+        const sprite_instance_t * instance = &sprites->instances_[i];
+        *buf++ = (uint8_t)(instance->handle_ >> 0);
+        *buf++ = (uint8_t)(instance->handle_ >> 8);
+        *buf++ = (uint8_t)(instance->x_ >> 0);
+        *buf++ = (uint8_t)(instance->x_ >> 8);
+        *buf++ = (uint8_t)(instance->y_ >> 0);
+        *buf++ = (uint8_t)(instance->y_ >> 8);
+    }
+    sendPayload(id, SPI_CMD_DRAW_SPRITES, listBuffer_, buf - listBuffer_);
+    useAssets(id, sprites);
+}
+
+void
+SpiI2cBridge::sendClearAssets(int id)
+{
+    sendCommand(id, SPI_CMD_CLEAR_ASSETS);
+    invalidateAssets(id);
+}
+
+bool
+SpiI2cBridge::ensureAssets(int id, const sprite_list_t * sprites)
+{
+    if (assetLost_[id]) {
+        // Start over from an empty cache, the same as the mirror.
+        sendClearAssets(id);
+        if (!waitReady(id)) {
+            return false;
+        }
+    }
+
+    // An upload may evict an asset of the list uploaded before it, so from
+    // the first again after each. (bounded, the list may not fit the cache)
+    int uploads = 0;
+    for (int i = 0; i < sprites->count_ && uploads < 2 * SPRITE_MAX_INSTANCES; i++) {
+        int handle = sprites->instances_[i].handle_;
+        if (handle >= SPRITE_MAX_HANDLES || assetUse_[id][handle] != 0) continue;
+        if (!sendUploadAsset(id, handle)) continue;
+        // The bridge is busy until the asset is stored in its cache.
+        if (!waitReady(id)) {
+            return false;
+        }
+        uploads++;
+        i = -1;
+    }
     return true;
 }
 
+void
+SpiI2cBridge::invalidateAssets(int id)
+{
+    memset((void*)assetUse_[id], 0, sizeof(assetUse_[id]));
+    memset((void*)assetSize_[id], 0, sizeof(assetSize_[id]));
+    assetUsed_[id] = 0;
+    assetCounter_[id] = 0;
+    assetCount_[id] = 0;
+    assetMissExpected_[id] = false;
+    assetLost_[id] = false;
+}
+
+// Same to SpriteCache::store(), the asset is used at the store.
+void
+SpiI2cBridge::storeAsset(int id, int handle, size_t size)
+{
+    if (handle >= SPRITE_MAX_HANDLES || size > SPRITE_CACHE_SIZE) return;
+
+    if (assetUse_[id][handle] != 0) {
+        assetUse_[id][handle] = 0;
+        assetUsed_[id] -= assetSize_[id][handle];
+        assetCount_[id]--;
+    }
+    while (assetCount_[id] >= SPRITE_CACHE_MAX_ENTRIES) {
+        evictAsset(id);
+    }
+    while (SPRITE_CACHE_SIZE - assetUsed_[id] < size) {
+        evictAsset(id);
+    }
+
+    assetUse_[id][handle] = ++assetCounter_[id];
+    assetSize_[id][handle] = (uint16_t)size;
+    assetUsed_[id] += size;
+    assetCount_[id]++;
+}
+
+// Same to SpriteCache::evictLRU().
+void
+SpiI2cBridge::evictAsset(int id)
+{
+    int lru = -1;
+    for (int handle = 0; handle < SPRITE_MAX_HANDLES; handle++) {
+        if (assetUse_[id][handle] == 0) continue;
+        if (lru < 0 || assetUse_[id][handle] < assetUse_[id][lru]) lru = handle;
+    }
+    if (lru < 0) return;
+
+    assetUse_[id][lru] = 0;
+    assetUsed_[id] -= assetSize_[id][lru];
+    assetCount_[id]--;
+
+    // The pending frame misses it, the bridge tells a miss not lost.
+    for (int i = 0; i < pendingSprites_.count_; i++) {
+        if (pendingSprites_.instances_[i].handle_ == lru) {
+            assetMissExpected_[id] = true;
+            break;
+        }
+    }
+}
+
+// Same to SpriteCache::touch(), the list is used at its receive.
+void
+SpiI2cBridge::useAssets(int id, const sprite_list_t * sprites)
+{
+    for (int i = 0; i < sprites->count_; i++) {
+        int handle = sprites->instances_[i].handle_;
+        if (handle >= SPRITE_MAX_HANDLES || assetUse_[id][handle] == 0) continue;
+        assetUse_[id][handle] = ++assetCounter_[id];
+    }
+}
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions
  *----------------------------------------------------------------------
@@ -203,6 +877,27 @@ SpiI2cBridge::sendCommand(int id, uint8_t cmd, uint8_t opt1, uint8_t opt2) {
   transfer(id, buffer, NULL, sizeof(buffer));
 }
 
+void
+SpiI2cBridge::sendPayload(int id, uint8_t cmd, uint8_t * data, size_t size, bool flush)
+{
+    uint8_t opt1 = size >> 0;
+    uint8_t opt2 = size >> 8;
+    uint8_t cmdbuf[7] = { SPI_SYNC1, SPI_SYNC2, cmd, opt1, opt2, (uint8_t)~opt1, (uint8_t)~opt2 };
+    uint16_t crc16 = calc_crc16(cmdbuf, sizeof(cmdbuf));
+    crc16 = calc_crc16(data, size, crc16);
+
+    transfer(id, cmdbuf, NULL, sizeof(cmdbuf));
+    transfer(id, data, NULL, size);
+
+    // crc, and padding to flush the receiver fifo. Without the padding
+    // (a response follows), the rx timeout of the bridge flushes it.
+    uint8_t tailbuf[2 + 16];
+    memset(tailbuf, 0, sizeof(tailbuf));
+    tailbuf[0] = (uint8_t)(crc16 >> 0);
+    tailbuf[1] = (uint8_t)(crc16 >> 8);
+    transfer(id, tailbuf, NULL, (flush)? sizeof(tailbuf) : 2);
+}
+
 uint8_t
 SpiI2cBridge::receiveResponse(int id) {
   int retry = 0x20;
@@ -225,30 +920,72 @@ SpiI2cBridge::receiveResponse(int id) {
 
 void
 SpiI2cBridge::transferAsync(int id, uint8_t* txbuffer, uint8_t* rxbuffer, size_t size) {
-  SPIClassRP2040* spi = (id == 0) ? &SPI : &SPI1;
+  SPIClassRP2040* spi = this->spi(id);
 
-  spi->beginTransaction(spisettings);
+  spi->beginTransaction(spisettings_[id]);
+  select(id, true);
   spi->transferAsync(txbuffer, rxbuffer, size);
 }
 
 void
 SpiI2cBridge::transferAsynEnd(int id) {
-  SPIClassRP2040* spi = (id == 0) ? &SPI : &SPI1;
+  SPIClassRP2040* spi = this->spi(id);
 
   while (!spi->finishedAsync()) {}
+  select(id, false);
   spi->endTransaction();
 }
 
 void
 SpiI2cBridge::transfer(int id, uint8_t* txbuffer, uint8_t* rxbuffer, size_t size) {
-  SPIClassRP2040* spi = (id == 0) ? &SPI : &SPI1;
+  SPIClassRP2040* spi = this->spi(id);
 
-  spi->beginTransaction(spisettings);
+  spi->beginTransaction(spisettings_[id]);
+  select(id, true);
   spi->transferAsync(txbuffer, rxbuffer, size);
   while (!spi->finishedAsync()) {}
+  select(id, false);
   spi->endTransaction();
 }
 
+SPIClassRP2040 *
+SpiI2cBridge::spi(int id)
+{
+    return sib_spis[endpoint_[id].bus_];
+}
+
+// A command to all the endpoints at once, the buses in parallel and the
+// endpoints of a bus one after another. The time sent is on the stats.
+void
+SpiI2cBridge::broadcast(uint8_t cmd, uint8_t opt1)
+{
+    uint8_t opt2 = 0x55;
+    uint8_t buffer[9] = { SPI_SYNC1, SPI_SYNC2, cmd, opt1, opt2, (uint8_t)~opt1, (uint8_t)~opt2, 0x00, 0x00 };
+    uint16_t crc16 = calc_crc16(buffer, sizeof(buffer) - 2);
+    buffer[7] = (uint8_t)(crc16 >> 0);
+    buffer[8] = (uint8_t)(crc16 >> 8);
+
+    uint32_t startUs = micros();
+    for (int wave = 0; wave < waves_; wave++) {
+        for (int id = 0; id < endpoints_; id++) {
+            if (wave_[id] == wave) transferAsync(id, buffer, NULL, sizeof(buffer));
+        }
+        for (int id = 0; id < endpoints_; id++) {
+            if (wave_[id] != wave) continue;
+            transferAsynEnd(id);
+            presentStats_[id].sentUs_ = micros() - startUs;
+        }
+    }
+}
+
+// The GPIO chip select of a shared bus, the hardware one is by the SPI.
+void
+SpiI2cBridge::select(int id, bool on)
+{
+    if (!shared_[id]) return;
+    digitalWrite(endpoint_[id].pinCS_, (on)? LOW : HIGH);
+}
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions
  *----------------------------------------------------------------------
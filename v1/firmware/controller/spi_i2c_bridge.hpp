@@ -10,13 +10,76 @@
  *----------------------------------------------------------------------
  */
 #include <cstdint>
+#include <SPI.h>
+
+#include "screen_config.hpp"
+#include "sprite_format.hpp"
+#include "sprite_registry.hpp"
+#include "spi_link_rate.hpp"
+#include "scroll_layer.hpp"
+#include "span_trace.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
  */
 
-#define SIB_CHANNELS      (2)
+#define SIB_BUSES         (2)     // SPI, SPI1
+#define SIB_ENDPOINTS_MAX (4)     // Bridge boards, 8 panels each
+
+// SPI master pins, the chip selects are per endpoint.
+typedef struct sib_bus_ {
+    int pinRX_;
+    int pinSCK_;
+    int pinTX_;
+} sib_bus_t;
+
+// A bridge board. The only endpoint of a bus has the hardware chip select
+// (SPI mode 0, as before). The endpoints sharing a bus have GPIO chip
+// selects held for a transfer, and run SPI mode 3, the PL022 slave takes
+// the bytes back to back only with CPHA = 1. (SPI_SLAVE_MODE of the bridge)
+typedef struct sib_endpoint_ {
+    int bus_;
+    int pinCS_;
+} sib_endpoint_t;
+
+#define SIB_PRESENT_STATS_PERIOD    (64)    // Frames
+
+#define SIB_GRAY_PLANES_MAX         (4)     // Bit planes of a frame, GRAY_PLANES_MAX of the bridge
+#define SIB_GRAY_SLOT_US            (12500) // A plane shown, over its I2C write (4 KB at 400 kHz)
+
+#define SIB_SCROLL_PAGES            (8)     // GDDRAM pages of a panel, SCROLL_RECORDS_MAX of the bridge
+#define SIB_SCROLL_STEP_MAX         (24)    // Rows a frame, both windows in the GDDRAM pages
+#define SIB_SCROLL_RECORD_SIZE      (2 + CvScreenGeometry::CHANNELS * CV_HEIGHT)
+
+// Scroll layer telemetry, since the start.
+typedef struct sib_scroll_stats_ {
+    uint32_t frames_;           // Shown by the start line
+    uint32_t pages_;            // Virtual pages sent (to all the endpoints)
+    uint32_t reloads_;          // The layer loaded again, a new plane or after a frame
+    uint32_t misses_;           // A row not loaded on a bridge, dropped
+} sib_scroll_stats_t;
+
+// Present telemetry of a bridge, polled every SIB_PRESENT_STATS_PERIOD
+// frames. The bridge times its I2C transfer start from the PRESENT, the
+// controller adds the time PRESENT was sent to it (the same clock for all).
+typedef struct sib_present_stats_ {
+    uint16_t presents_;
+    uint16_t missed_;           // PRESENT with no new frame (lost, or late)
+    uint16_t pushed_;           // PRESENT of the last frame started
+    uint16_t latencyUs_;        // PRESENT to the I2C transfer start, the last frame
+    uint16_t maxLatencyUs_;     // In the period
+    uint32_t sentUs_;           // PRESENT sent, from the first endpoint
+} sib_present_stats_t;
+
+#define SIB_SPAN_SYNC_PERIOD        (32)    // Frames, some in the last SPAN_EVENTS
+#define SIB_SPAN_BLOCK_EVENTS       (8)     // Events a GET_SPANS, SPAN_BLOCK_EVENTS of the bridge
+
+// A span ring of a bridge, with the block read from it.
+typedef struct sib_span_ring_ {
+    uint16_t events_;           // In the ring
+    uint16_t overwritten_;      // Saturated
+} sib_span_ring_t;
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Class definitions
@@ -30,16 +93,10 @@ public:
     virtual ~SpiI2cBridge();
 
 public:
-    void init(
-        int pin_spi0_rx,
-        int pin_spi0_cs,
-        int pin_spi0_sck,
-        int pin_spi0_tx,
-        int pin_spi1_rx,
-        int pin_spi1_cs,
-        int pin_spi1_sck,
-        int pin_spi1_tx
-    );
+    // buses : SIB_BUSES, endpoints : count (<= SIB_ENDPOINTS_MAX), the frame
+    // is sliced to them in the order.
+    void init(const sib_bus_t * buses, const sib_endpoint_t * endpoints, int count);
+    int endpoints(void) const { return endpoints_; }
 
 public:
     bool waitReady(int id);
@@ -47,17 +104,146 @@ public:
     void sendSetLED(int id, bool on);
     void sendSetIDDirection(int id, bool dir);
     void sendHardReset(int id);
-    bool sendFrameDataParallel(uint8_t * buffer, size_t size);
+    bool sendFrameDataParallel(uint8_t * buffer, size_t size, const sprite_list_t * sprites = nullptr);
+
+public:
+    // Grayscale : a frame is the bit planes in a row (LSB first), shown in
+    // turn by the bridges, the steps lower planes by the contrast and the
+    // others by repeated slots. (1 : monochrome, the staged frames dropped)
+    bool setGray(int planes, int steps, uint32_t slotUs = SIB_GRAY_SLOT_US);
+    int grayPlanes(void) const { return grayPlanes_; }
+
+public:
+    // Stage then present : a frame is shown on all the bridges at once,
+    // by a PRESENT after it is sent to all of them and the last frame is
+    // transferred on all. (default on, the bridges from the first PRESENT)
+    void setPresent(bool on);
+    bool sendPresent(void);
+    bool pollPresentStats(void);
+    const sib_present_stats_t * presentStats(int id) const { return &presentStats_[id]; }
+    // The I2C transfer start skew between the bridges, the last frame polled
+    // and the max of the polls. (0 until the last frame of all is started)
+    uint32_t presentSkewUs(void) const { return presentSkewUs_; }
+    uint32_t presentSkewMaxUs(void) const { return presentSkewMaxUs_; }
+
+public:
+    // Scroll layer : the layer is moved by the start line on the bridges,
+    // only the pages ahead of the row are sent. (scroll_layer.hpp) Fits if
+    // monochrome and the row moved SIB_SCROLL_STEP_MAX or less since the
+    // last frame, checked every frame (nullptr : no layer, a frame is sent).
+    bool scrollFits(const scroll_layer_t * layer);
+    bool sendScrollFrame(const scroll_layer_t * layer);
+    const sib_scroll_stats_t * scrollStats(void) const { return &scrollStats_; }
+
+public:
+    // Span trace : the stages of the frames on the timeline (span_trace.hpp).
+    // The bridges record from startSpans(), their clocks are synced at the
+    // start, every SIB_SPAN_SYNC_PERIOD frames and at the stop.
+    void setSpanTrace(SpanTrace * spans) { spans_ = spans; }
+    void startSpans(bool on);
+    void syncSpans(void);
+    // Up to SIB_SPAN_BLOCK_EVENTS events of a bridge core from the index,
+    // the events read or -1. (no response)
+    int readSpans(int id, int core, uint32_t index, span_event_t * events, sib_span_ring_t * ring);
+
+public:
+    // Steps the SPI clock up with test patterns, returns the trained clock.
+    uint32_t trainLink(int id);
+    bool testLink(int id);
+    const SpiLinkRate * link(int id) const { return &link_[id]; }
+
+public:
+    void setSpriteRegistry(SpriteRegistry * registry);
+    bool sendUploadAsset(int id, int handle);
+    void sendDrawSprites(int id, const sprite_list_t * sprites, int panelBase);
+    void sendClearAssets(int id);
 
 public:
     void sendCommand(int id, uint8_t cmd, uint8_t opt1 = 0x55, uint8_t opt2 = 0x55);
     uint8_t receiveResponse(int id);
+    void sendPayload(int id, uint8_t cmd, uint8_t * data, size_t size, bool flush = true);
 
 public:
     void transferAsync(int id, uint8_t * txbuffer, uint8_t * rxbuffer, size_t size);
     void transferAsynEnd(int id);
     void transfer(int id, uint8_t * txbuffer, uint8_t * rxbuffer, size_t size);
 
+private:
+    bool sendFrame(uint8_t * buffer, size_t size, const sprite_list_t * sprites);
+    bool sendScroll(const scroll_layer_t * layer);
+    void spanBegin(uint8_t stage, uint16_t arg = 0) { if (spans_) spans_->begin(stage, arg); }
+    void spanEnd(uint8_t stage, uint16_t arg = 0) { if (spans_) spans_->end(stage, arg); }
+    void spanFrame(void);
+
+private:
+    bool waitStatus(int id, uint8_t bits);
+    bool ensureAssets(int id, const sprite_list_t * sprites);
+    void invalidateAssets(int id);
+    void storeAsset(int id, int handle, size_t size);
+    void evictAsset(int id);
+    void useAssets(int id, const sprite_list_t * sprites);
+    void setClock(int id, uint32_t hz);
+    void updateClock(int id, bool changed);
+    SPIClassRP2040 * spi(int id);
+    void select(int id, bool on);
+    void broadcast(uint8_t cmd, uint8_t opt1);
+
+private:
+    sib_endpoint_t endpoint_[SIB_ENDPOINTS_MAX];
+    bool shared_[SIB_ENDPOINTS_MAX];
+    int wave_[SIB_ENDPOINTS_MAX];   // Order on its bus
+    int endpoints_ = 0;
+    int waves_ = 0;                 // Endpoints on the busiest bus
+
+private:
+    bool present_ = true;
+    int presentFrames_ = 0;
+    sib_present_stats_t presentStats_[SIB_ENDPOINTS_MAX];
+    uint32_t presentSkewUs_ = 0;
+    uint32_t presentSkewMaxUs_ = 0;
+
+private:
+    int grayPlanes_ = 1;
+
+private:
+    // The pages on the bridges, all the same. The row goes on from the
+    // shown one modulo scrollPeriod_, a multiple of the plane width and of
+    // the u16 row of the bridges. (the virtual page & 0x1FFF on the bridge)
+    bool scrollValid_ = false;
+    bool scrollSeen_ = false;       // scrollFits() had the layer last frame
+    int32_t scrollSeenRow_ = 0;
+    int32_t scrollRow_ = 0;
+    int32_t scrollPeriod_ = 0;
+    int32_t scrollWidth_ = 0;
+    uint32_t scrollGeneration_ = 0;
+    bool scrollForward_ = true;
+    int32_t scrollTags_[SIB_SCROLL_PAGES];
+    sib_scroll_stats_t scrollStats_;
+    uint8_t scrollBuffer_[SIB_SCROLL_PAGES * SIB_SCROLL_RECORD_SIZE];
+
+private:
+    SpanTrace * spans_ = nullptr;
+    int spanFrames_ = 0;
+    uint16_t spanSeq_ = 0;
+
+private:
+    SpriteRegistry * spriteRegistry_ = nullptr;
+    // The cache of each bridge, mirrored. (SpriteCache, the same LRU)
+    uint32_t assetUse_[SIB_ENDPOINTS_MAX][SPRITE_MAX_HANDLES];     // 0 : not resident
+    uint16_t assetSize_[SIB_ENDPOINTS_MAX][SPRITE_MAX_HANDLES];
+    uint32_t assetUsed_[SIB_ENDPOINTS_MAX];
+    uint32_t assetCounter_[SIB_ENDPOINTS_MAX];
+    int assetCount_[SIB_ENDPOINTS_MAX];
+    bool assetMissExpected_[SIB_ENDPOINTS_MAX];    // An asset of the pending frame was evicted
+    bool assetLost_[SIB_ENDPOINTS_MAX];            // Not the same as the mirror, cleared
+    sprite_list_t pendingSprites_;                  // The last frame, not composed yet
+    uint8_t assetBuffer_[SPRITE_ASSET_MAX_SIZE];
+    uint8_t listBuffer_[SPRITE_LIST_MAX_SIZE];
+
+private:
+    SpiLinkRate link_[SIB_ENDPOINTS_MAX];
+    SPISettings spisettings_[SIB_ENDPOINTS_MAX];
+
 private:
     static void calc_crc16_lookup_table(void);
     static inline uint16_t calc_crc16(uint8_t * data, size_t size, uint16_t crc = 0xFFFF);
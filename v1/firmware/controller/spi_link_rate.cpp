@@ -0,0 +1,130 @@
+/**********************************************************************/
+/**
+ * @brief  SPI Link Rate Training and Fallback
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "spi_link_rate.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+SpiLinkRate::SpiLinkRate()
+{
+    memset(rates_, 0, sizeof(rates_));
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+SpiLinkRate::~SpiLinkRate()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+SpiLinkRate::init(const uint32_t * rates, int num, int base)
+{
+    if (num > SPI_LINK_RATES_MAX) num = SPI_LINK_RATES_MAX;
+    if (num < 1) num = 1;
+    memcpy(rates_, rates, num * sizeof(rates_[0]));
+    num_ = num;
+    base_ = (base < 0)? 0 : (base >= num)? num - 1 : base;
+
+    state_ = SPI_LINK_UNTRAINED;
+    index_ = base_;
+    trained_ = base_;
+    rounds_ = 0;
+    windowFrames_ = 0;
+    windowErrors_ = 0;
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+void
+SpiLinkRate::startTraining(void)
+{
+    state_ = SPI_LINK_TRAINING;
+    index_ = 0;
+    rounds_ = 0;
+    stats_.trainings_++;
+}
+
+void
+SpiLinkRate::testResult(bool ok)
+{
+    if (state_ != SPI_LINK_TRAINING) return;
+    stats_.testRounds_++;
+
+    if (!ok) {
+        // The rate below is the highest clean one. (the lowest if none)
+        stats_.testErrors_++;
+        if (index_ > 0) index_--;
+    } else if (++rounds_ < SPI_LINK_TEST_ROUNDS) {
+        return;
+    } else if (index_ + 1 < num_) {
+        index_++;
+        rounds_ = 0;
+        return;
+    }
+
+    state_ = SPI_LINK_RUNNING;
+    trained_ = index_;
+    windowFrames_ = 0;
+    windowErrors_ = 0;
+}
+
+void
+SpiLinkRate::frame(void)
+{
+    if (state_ == SPI_LINK_TRAINING) return;
+    stats_.frames_++;
+    if (++windowFrames_ >= SPI_LINK_WINDOW) {
+        windowFrames_ = 0;
+        windowErrors_ = 0;
+    }
+}
+
+bool
+SpiLinkRate::error(void)
+{
+    if (state_ == SPI_LINK_TRAINING) return false;
+    stats_.errors_++;
+    return countError();
+}
+
+bool
+SpiLinkRate::retry(void)
+{
+    if (state_ == SPI_LINK_TRAINING) return false;
+    stats_.retries_++;
+    return countError();
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Private
+ *----------------------------------------------------------------------
+ */
+
+bool
+SpiLinkRate::countError(void)
+{
+    if (++windowErrors_ < SPI_LINK_ERROR_LIMIT) return false;
+
+    // Sustained errors, one step down and a new window.
+    windowFrames_ = 0;
+    windowErrors_ = 0;
+    if (index_ == 0) return false;
+    index_--;
+    stats_.fallbacks_++;
+    return true;
+}
@@ -0,0 +1,107 @@
+/**********************************************************************/
+/**
+ * @brief  SPI Link Rate Training and Fallback
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// The SPI clock of one bridge link, no hardware access. (host testable)
+//
+// Training : from the lowest rate up, each rate is tested with rounds of
+// test patterns (SPI_CMD_LINK_TEST, the bridge answers if the CRC is
+// valid). The first failed round ends the training at the rate below it,
+// the highest rate with no error.
+//
+// Running : the errors reported by the bridge (status error flag) and the
+// lost responses are counted per window of frames. SPI_LINK_ERROR_LIMIT
+// errors in one window is a sustained error, the rate falls back one step.
+// A single error does not, the frame is lost but the next one is sent.
+
+#define SPI_LINK_RATES_MAX      (12)
+#define SPI_LINK_TEST_ROUNDS    (8)     // Clean rounds for a rate to pass
+#define SPI_LINK_WINDOW         (64)    // Frames
+#define SPI_LINK_ERROR_LIMIT    (3)     // Errors in a window to fall back
+
+typedef enum spi_link_state_ {
+    SPI_LINK_UNTRAINED = 0,     // Base rate
+    SPI_LINK_TRAINING,
+    SPI_LINK_RUNNING,
+} spi_link_state_t;
+
+typedef struct spi_link_stats_ {
+    uint32_t frames_;           // Frames while running
+    uint32_t errors_;           // Errors reported by the bridge
+    uint32_t retries_;          // Responses lost, polled again
+    uint32_t fallbacks_;
+    uint32_t trainings_;
+    uint32_t testRounds_;
+    uint32_t testErrors_;
+} spi_link_stats_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class SpiLinkRate
+{
+public:
+    explicit SpiLinkRate();
+    virtual ~SpiLinkRate();
+
+public:
+    // rates : clocks in the ascending order, base : the index before the training.
+    void init(const uint32_t * rates, int num, int base);
+    void startTraining(void);
+
+    // A test round at clock() during the training.
+    void testResult(bool ok);
+
+    // While running, a frame sent. (the window)
+    void frame(void);
+    // While running. true if the rate fell back, clock() is the new one.
+    bool error(void);
+    bool retry(void);
+
+public:
+    spi_link_state_t state(void) const { return state_; }
+    bool training(void) const { return state_ == SPI_LINK_TRAINING; }
+    uint32_t clock(void) const { return rates_[index_]; }
+    int index(void) const { return index_; }
+    // The rate found by the last training, the fallbacks are below it.
+    uint32_t trainedClock(void) const { return rates_[trained_]; }
+    int trainedIndex(void) const { return trained_; }
+    int rates(void) const { return num_; }
+    uint32_t rate(int index) const { return rates_[index]; }
+    const spi_link_stats_t * stats(void) const { return &stats_; }
+
+private:
+    bool countError(void);
+
+private:
+    uint32_t rates_[SPI_LINK_RATES_MAX];
+    int num_ = 0;
+    int base_ = 0;
+
+    spi_link_state_t state_ = SPI_LINK_UNTRAINED;
+    int index_ = 0;
+    int trained_ = 0;
+    int rounds_ = 0;            // Clean rounds at index_
+
+    uint32_t windowFrames_ = 0;
+    uint32_t windowErrors_ = 0;
+    spi_link_stats_t stats_;
+};
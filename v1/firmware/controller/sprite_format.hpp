@@ -0,0 +1,91 @@
+/**********************************************************************/
+/**
+ * @brief  Sprite Asset Format (shared with spi-i2c-bridge)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Sprites are uploaded once to the bridge (SPI_CMD_UPLOAD_ASSET), and are
+// referenced by handle from a per frame instance list (SPI_CMD_DRAW_SPRITES).
+//
+// The bridge keeps the assets in a cache of SPRITE_CACHE_SIZE bytes and
+// SPRITE_CACHE_MAX_ENTRIES assets, the least recently used one is evicted.
+// An asset is used when a list naming it is received, so the cache follows
+// the command order only, and the controller mirrors it.
+//
+// Uploaded sprite data is panel native. Each sprite row is a bit string
+// packed LSB first along the screen x axis, so bit i of a row is located
+// at screen x (x0 + i). Because the screen x axis is mirrored against the
+// cylinder x axis, bit i holds the image pixel at (width - 1 - i).
+//
+// UPLOAD_ASSET payload :
+//   [0-1] handle, [2-3] width, [4-5] height, [6] flags, [7] reserved
+//   data rows  (height * stride bytes)
+//   alpha rows (height * stride bytes, only if SPRITE_FLAG_ALPHA)
+//
+// DRAW_SPRITES payload :
+//   [0] panel base, [1] flags, [2] count, [3] reserved
+//   [4-5] display distance, [6-7] virtual width
+//   instances (count * sprite_instance_t)
+
+#define SPRITE_MAX_HANDLES          (256)   // Max handles (asset id)
+#define SPRITE_MAX_INSTANCES        (32)    // Max instances per frame
+#define SPRITE_MAX_WIDTH            (256)   // Max sprite width in pixel
+#define SPRITE_MAX_HEIGHT           (128)   // Max sprite height in pixel
+#define SPRITE_CACHE_SIZE           (96 * 1024)     // Bridge cache arena
+#define SPRITE_CACHE_MAX_ENTRIES    (128)           // Bridge cache assets
+
+#define SPRITE_ASSET_HEADER_SIZE    (8)
+#define SPRITE_LIST_HEADER_SIZE     (8)
+#define SPRITE_ASSET_MAX_SIZE       (SPRITE_ASSET_HEADER_SIZE + (2 * 1024))
+#define SPRITE_LIST_MAX_SIZE        (SPRITE_LIST_HEADER_SIZE + (SPRITE_MAX_INSTANCES * 6))
+
+#define SPRITE_FLAG_ALPHA           (0x01)  // Asset has alpha rows
+
+#define SPRITE_LIST_FLAG_CLEAR      (0x01)  // Clear the frame on bridge, and commit without frame data
+
+#define SPRITE_INVALID_HANDLE       (0xFFFF)
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Type definitions
+ *----------------------------------------------------------------------
+ */
+
+typedef struct sprite_instance_ {
+    uint16_t handle_;
+    int16_t  x_;            // Screen x of the row bit 0, 0 ~ (virtual width - 1)
+    int16_t  y_;            // Screen y of the first row, may be negative
+} sprite_instance_t;
+
+typedef struct sprite_list_ {
+    uint8_t  flags_;
+    uint8_t  count_;
+    sprite_instance_t instances_[SPRITE_MAX_INSTANCES];
+} sprite_list_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static inline int sprite_stride(int width)
+{
+    return (width + 7) >> 3;
+}
+
+static inline int sprite_asset_size(int width, int height, bool alpha)
+{
+    return SPRITE_ASSET_HEADER_SIZE + (sprite_stride(width) * height * ((alpha)? 2 : 1));
+}
@@ -0,0 +1,137 @@
+/**********************************************************************/
+/**
+ * @brief  Sprite Registry (Image to Bridge Asset Handle)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "sprite_registry.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+SpriteRegistry::SpriteRegistry()
+{
+    reset();
+}
+
+SpriteRegistry::~SpriteRegistry()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+SpriteRegistry::reset(void)
+{
+    count_ = 0;
+    memset((void*)images_, 0, sizeof(images_));
+    memset((void*)hashTable_, 0xFF, sizeof(hashTable_));
+}
+
+int
+SpriteRegistry::getHandle(const mono_image_t * image)
+{
+    if (image == nullptr) return -1;
+    if (image->width_ > SPRITE_MAX_WIDTH || image->height_ > SPRITE_MAX_HEIGHT) return -1;
+    if (sprite_asset_size(image->width_, image->height_, image->has_alpha_) > SPRITE_ASSET_MAX_SIZE) return -1;
+
+    uint32_t i = hash(image);
+    while (1) {
+        int handle = hashTable_[i];
+        if (handle < 0) break;
+        if (images_[handle] == image) return handle;
+        i = (i + 1) & (SPRITE_REGISTRY_HASH_SIZE - 1);
+    }
+
+    // Not registered yet.
+    if (count_ >= SPRITE_MAX_HANDLES) return -1;
+
+    int handle = count_;
+    images_[handle] = image;
+    hashTable_[i] = handle;
+    // Publish after the entry is written, getImage() may be called from the other core.
+    count_ = handle + 1;
+    return handle;
+}
+
+const mono_image_t *
+SpriteRegistry::getImage(int handle) const
+{
+    if (handle < 0 || handle >= count_) return nullptr;
+    return images_[handle];
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Convert mono_image_t (8 bit vertical packed) to the panel native upload payload.
+size_t
+SpriteRegistry::pack(int handle, uint8_t * buffer, size_t size) const
+{
+    const mono_image_t * image = getImage(handle);
+    if (image == nullptr) return 0;
+
+    int w = image->width_;
+    int h = image->height_;
+    bool alpha = image->has_alpha_;
+    int stride = sprite_stride(w);
+    size_t total = sprite_asset_size(w, h, alpha);
+    if (total > size) return 0;
+
+    memset(buffer, 0, total);
+    buffer[0] = (uint8_t)(handle >> 0);
+    buffer[1] = (uint8_t)(handle >> 8);
+    buffer[2] = (uint8_t)(w >> 0);
+    buffer[3] = (uint8_t)(w >> 8);
+    buffer[4] = (uint8_t)(h >> 0);
+    buffer[5] = (uint8_t)(h >> 8);
+    buffer[6] = (alpha)? SPRITE_FLAG_ALPHA : 0x00;
+    buffer[7] = 0x00;
+
+    uint8_t * data = buffer + SPRITE_ASSET_HEADER_SIZE;
+    uint8_t * alphadata = data + (stride * h);
+
+    for (int y = 0; y < h; y++) {
+        int offset_stride = (y >> 3) * w;
+        int offset_bit    = y & 7;
+        for (int x = 0; x < w; x++) {
+            int i = w - 1 - x; // mirrored
+            if ((image->buffer_[x + offset_stride] >> offset_bit) & 0x01) {
+                data[(y * stride) + (i >> 3)] |= (0x01 << (i & 7));
+            }
+            if (alpha && ((image->alphabuffer_[x + offset_stride] >> offset_bit) & 0x01)) {
+                alphadata[(y * stride) + (i >> 3)] |= (0x01 << (i & 7));
+            }
+        }
+    }
+
+    return total;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+uint32_t
+SpriteRegistry::hash(const mono_image_t * image)
+{
+    uint32_t v = (uint32_t)(uintptr_t)image;
+    v ^= (v >> 16);
+    v *= 0x45D9F3B;
+    v ^= (v >> 16);
+    return v & (SPRITE_REGISTRY_HASH_SIZE - 1);
+}
@@ -0,0 +1,53 @@
+/**********************************************************************/
+/**
+ * @brief  Sprite Registry (Image to Bridge Asset Handle)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+#include "mono_image.hpp"
+#include "sprite_format.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define SPRITE_REGISTRY_HASH_SIZE   (SPRITE_MAX_HANDLES * 2)    // Must be power of 2
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class SpriteRegistry
+{
+public:
+    explicit SpriteRegistry();
+    virtual ~SpriteRegistry();
+
+public:
+    void reset(void);
+    int  getHandle(const mono_image_t * image);
+    const mono_image_t * getImage(int handle) const;
+    int  count(void) const { return count_; }
+
+public:
+    size_t pack(int handle, uint8_t * buffer, size_t size) const;
+
+private:
+    static inline uint32_t hash(const mono_image_t * image);
+
+private:
+    const mono_image_t * images_[SPRITE_MAX_HANDLES];
+    int16_t hashTable_[SPRITE_REGISTRY_HASH_SIZE];
+    volatile int count_;
+};
@@ -0,0 +1,180 @@
+/**********************************************************************/
+/**
+ * @brief  Text Rendering (Glyph Cache, Span Renderer)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstddef>
+#include <cstring>
+
+#include "text_render.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef MIN
+#define MIN(x,y)        (((x) <= (y))? (x) : (y))
+#endif
+
+#ifndef MAX
+#define MAX(x,y)        (((x) >= (y))? (x) : (y))
+#endif
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Glyph Cache
+ *----------------------------------------------------------------------
+ */
+
+GlyphCache::GlyphCache()
+{
+    clear();
+    clearStats();
+}
+
+GlyphCache::~GlyphCache()
+{
+}
+
+void
+GlyphCache::clear(void)
+{
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        entries_[i].font_ = nullptr;
+    }
+}
+
+void
+GlyphCache::clearStats(void)
+{
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+const uint8_t *
+GlyphCache::get(const Font * font, uint8_t code, int phase, int * pages)
+{
+    const font_glyph_t * g = font->glyph(code);
+    int height = font->height();
+    int n = (phase + g->width_ + 7) >> 3;
+    if ((n * height) > GLYPH_CACHE_ENTRY_BYTES) {
+        stats_.bypasses_++;
+        return nullptr;
+    }
+
+    uint32_t v = ((uint32_t)code << 3) | (uint32_t)phase;
+    v ^= (uint32_t)(uintptr_t)font->font_;
+    v ^= (v >> 16);
+    v *= 0x45D9F3B;
+    v ^= (v >> 16);
+    entry_t * e = &entries_[v & (GLYPH_CACHE_ENTRIES - 1)];
+
+    *pages = n;
+    if (e->font_ == font->font_ && e->code_ == code && e->phase_ == phase) {
+        stats_.hits_++;
+        return (const uint8_t *)e->data_;
+    }
+    stats_.misses_++;
+
+    // Shift the strips up by the phase, the overflow to the next page.
+    const uint8_t * strips = font->font_->data_ + g->offset_;
+    int count = (g->width_ + 7) >> 3;
+    uint8_t * d = (uint8_t *)e->data_;
+    for (int j = 0; j < n; j++) {
+        const uint8_t * lo = (j > 0 && (j - 1) < count)? strips + ((j - 1) * height) : nullptr;
+        const uint8_t * hi = (j < count)? strips + (j * height) : nullptr;
+        for (int r = 0; r < height; r++) {
+            uint32_t b = (hi)? ((uint32_t)hi[r] << phase) : 0;
+            if (lo && phase > 0) b |= (uint32_t)lo[r] >> (8 - phase);
+            d[(j * height) + r] = (uint8_t)b;
+        }
+    }
+    e->font_ = font->font_;
+    e->code_ = code;
+    e->phase_ = (uint8_t)phase;
+    e->pages_ = (uint8_t)n;
+    return d;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Span Renderer
+ *----------------------------------------------------------------------
+ */
+
+// Aligned word access. (memcpy is a single ldr / str, without aliasing issues)
+static inline uint32_t load32(const uint8_t * p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store32(uint8_t * p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline bool aligned32(const uint8_t * p)
+{
+    return (((uintptr_t)p & 3) == 0);
+}
+
+// n rows of a page ORed, 4 rows a word if both are aligned.
+static inline void
+or_rows(uint8_t * d, const uint8_t * s, int n)
+{
+    int i = 0;
+    if (aligned32(d) && aligned32(s)) {
+        for (; i + 4 <= n; i += 4) {
+            store32(d + i, load32(d + i) | load32(s + i));
+        }
+    }
+    for (; i < n; i++) {
+        d[i] |= s[i];
+    }
+}
+
+int
+text_render_span(
+    const mono_surface_t * span, int x, int y,
+    const Font * font, const char * text,
+    text_layout_t layout,
+    GlyphCache * cache
+) {
+    const int height = font->height();
+    const int spanPages = (span->width_ + 7) >> 3;
+    const int r0 = MAX(0, -y);
+    const int r1 = MIN(height, span->height_ - y);
+
+    int pen = x;
+    for (const char * p = text; *p != '\0'; p++) {
+        const font_glyph_t * g = font->glyph((uint8_t)*p);
+        int gx = pen + font->left(g, layout);
+        pen += font->advance(g, layout);
+        if (g->width_ == 0 || r0 >= r1) continue;
+        if ((gx + g->width_) <= 0 || gx >= span->width_) continue;
+
+        // The glyph column 0 (its right end) at the span column c0.
+        int c0 = span->width_ - gx - g->width_;
+        int phase = c0 & 7;
+        int pages = 0;
+        const uint8_t * s = (cache)? cache->get(font, (uint8_t)*p, phase, &pages) : nullptr;
+        if (s == nullptr) {
+            mono_plane_t plane;
+            font->plane(g, &plane);
+            mono_blit(span, c0, y, &plane, 0, 0, g->width_, height, MONO_ROP_OR);
+            continue;
+        }
+
+        int page0 = c0 >> 3;
+        for (int j = MAX(0, -page0); j < pages && (page0 + j) < spanPages; j++) {
+            uint8_t * d = span->buffer_ + ((page0 + j) * span->height_) + y;
+            or_rows(d + r0, s + (j * height) + r0, r1 - r0);
+        }
+    }
+    return pen;
+}
@@ -0,0 +1,86 @@
+/**********************************************************************/
+/**
+ * @brief  Text Rendering (Glyph Cache, Span Renderer)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "font.hpp"
+#include "mono_blit.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// The cache holds the glyphs shifted to the bit phase of their column on
+// the span (the glyph column 0 at the bit phase of a page), in RAM. The
+// span renderer then ORs whole bytes (4 rows a word), no shift and no
+// flash read for a cached glyph. A glyph is cached once per phase, a
+// monospace text of a cell of 8n columns has one phase for all glyphs.
+
+#define GLYPH_CACHE_ENTRIES         (128)   // Power of 2, direct mapped
+#define GLYPH_CACHE_ENTRY_BYTES     (128)   // Pages x height of a shifted glyph, e.g. 4 x 28 for 20 columns
+
+typedef struct glyph_cache_stats_ {
+    uint32_t hits_;
+    uint32_t misses_;
+    uint32_t bypasses_;         // Too big for an entry, blit from the font
+} glyph_cache_stats_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class GlyphCache
+{
+public:
+    explicit GlyphCache();
+    virtual ~GlyphCache();
+
+public:
+    void clear(void);
+    // The glyph shifted by phase (0 ~ 7) columns, pages x the font height
+    // bytes : the glyph column c is at the bit (phase + c). nullptr if it
+    // does not fit to an entry.
+    const uint8_t * get(const Font * font, uint8_t code, int phase, int * pages);
+    const glyph_cache_stats_t * stats(void) const { return &stats_; }
+    void clearStats(void);
+
+private:
+    typedef struct entry_ {
+        const font_t * font_;   // nullptr : free
+        uint8_t code_;
+        uint8_t phase_;
+        uint8_t pages_;
+        uint32_t data_[GLYPH_CACHE_ENTRY_BYTES / 4];
+    } entry_t;
+
+    entry_t entries_[GLYPH_CACHE_ENTRIES];
+    glyph_cache_stats_t stats_;
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Text ORed into a span, a panel native surface (e.g. a band of the
+// cylinder, drawn by CyclicMonoDrawer::drawPlane). The span x t is the
+// surface column (width_ - 1 - t), the text starts at the span x / row y.
+// Clipped on whole pages, the columns past width_ in the last page may
+// be written. Returns the pen x at the end of the text.
+int text_render_span(
+    const mono_surface_t * span, int x, int y,
+    const Font * font, const char * text,
+    text_layout_t layout,
+    GlyphCache * cache
+);
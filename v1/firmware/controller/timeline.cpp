@@ -0,0 +1,118 @@
+/**********************************************************************/
+/**
+ * @brief  Timeline (Table Driven Scene Sequencer)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include "timeline.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+Timeline::Timeline()
+{
+}
+
+Timeline::~Timeline()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+Timeline::start(const timeline_step_t * steps, int count, void * context, uint32_t nowUs)
+{
+    steps_ = steps;
+    count_ = count;
+    context_ = context;
+    enter(0, nowUs);
+}
+
+void
+Timeline::stop(void)
+{
+    steps_ = nullptr;
+    count_ = 0;
+    step_ = 0;
+}
+
+void
+Timeline::jump(int step, uint32_t nowUs)
+{
+    if (steps_ == nullptr) return;
+    enter(step, nowUs);
+}
+
+bool
+Timeline::update(uint32_t nowUs)
+{
+    // Pass over the timed steps already over, each starts at the end of the previous.
+    while (running()) {
+        const timeline_step_t * s = &steps_[step_];
+        if (s->durationUs_ == 0 || (uint32_t)(nowUs - startUs_) < s->durationUs_) break;
+        enter(step_ + 1, startUs_ + s->durationUs_);
+    }
+    if (!running()) return false;
+
+    const timeline_step_t * s = &steps_[step_];
+    timeline_frame_t frame;
+    frame.step_ = step_;
+    frame.elapsedUs_ = nowUs - startUs_;
+    frame.progress_ = 0;
+    if (s->durationUs_ > 0) {
+        frame.progress_ = (fixed_t)(((uint64_t)frame.elapsedUs_ << FIXED_SHIFT) / s->durationUs_);
+    }
+    frame.value_ = tween(s, frame.progress_);
+
+    if (s->draw_) s->draw_(context_, &frame);
+    if (s->until_ && s->until_(context_, &frame)) {
+        enter(step_ + 1, nowUs);
+    }
+    return true;
+}
+
+void
+Timeline::enter(int step, uint32_t startUs)
+{
+    step_ = (step < 0)? 0 : step;
+    startUs_ = startUs;
+    if (!running()) return;
+
+    // enter_ may stop() or jump(), nothing is touched after it.
+    const timeline_step_t * s = &steps_[step_];
+    if (s->enter_) s->enter_(context_);
+}
+
+fixed_t
+Timeline::ease(timeline_ease_t ease, fixed_t t)
+{
+    if (t <= 0) return 0;
+    if (t >= FIXED_ONE) return FIXED_ONE;
+    switch (ease) {
+    case TIMELINE_EASE_IN:
+        return fixed_mul(t, t);
+    case TIMELINE_EASE_OUT:
+        return FIXED_ONE - fixed_mul(FIXED_ONE - t, FIXED_ONE - t);
+    case TIMELINE_EASE_IN_OUT:
+        return fixed_mul(fixed_mul(t, t), fixed_from_int(3) - (t * 2));
+    default:
+        return t;
+    }
+}
+
+int32_t
+Timeline::tween(const timeline_step_t * step, fixed_t progress)
+{
+    fixed_t e = ease(step->ease_, progress);
+    int64_t d = (int64_t)(step->to_ - step->from_) * e;
+    return step->from_ + (int32_t)(d >> FIXED_SHIFT);
+}
@@ -0,0 +1,102 @@
+/**********************************************************************/
+/**
+ * @brief  Timeline (Table Driven Scene Sequencer)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+
+#include "fixed_math.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// A scene is a const table of steps, played in order by the time given to
+// Timeline::update() (micros()). A step ends when its duration is over, or
+// when its until_ callback returns true. A timed step starts exactly at the
+// end time of the previous one, not at the frame that noticed it, so the
+// sequence does not drift with the frame rate. Steps passed over in a long
+// frame still get their enter_ callback.
+//
+// Callbacks are plain functions with the context pointer given to start(),
+// the engine itself has no heap and no state besides the current step.
+
+#define TIMELINE_US(ms)         ((uint32_t)(ms) * 1000UL)
+
+typedef enum timeline_ease_ {
+    TIMELINE_EASE_LINEAR = 0,
+    TIMELINE_EASE_IN,           // Quadratic
+    TIMELINE_EASE_OUT,
+    TIMELINE_EASE_IN_OUT,       // Smoothstep
+} timeline_ease_t;
+
+// The current step, given to the callbacks.
+typedef struct timeline_frame_ {
+    int step_;
+    uint32_t elapsedUs_;        // From the step start
+    fixed_t progress_;          // 0 ~ FIXED_ONE, (0 if no duration)
+    int32_t value_;             // Tweened parameter, from_ ~ to_ (floor)
+} timeline_frame_t;
+
+typedef void (*timeline_enter_t)(void * context);
+typedef void (*timeline_draw_t)(void * context, const timeline_frame_t * frame);
+typedef bool (*timeline_until_t)(void * context, const timeline_frame_t * frame);
+
+typedef struct timeline_step_ {
+    const char * name_;
+    uint32_t durationUs_;       // 0 : until_ only
+    timeline_enter_t enter_;    // Called once on entering (nullptr : none)
+    timeline_draw_t draw_;      // Called every update (nullptr : none)
+    timeline_until_t until_;    // Checked after draw_, true ends the step (nullptr : none)
+    int32_t from_;
+    int32_t to_;
+    timeline_ease_t ease_;
+} timeline_step_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class Timeline
+{
+public:
+    explicit Timeline();
+    virtual ~Timeline();
+
+public:
+    void start(const timeline_step_t * steps, int count, void * context, uint32_t nowUs);
+    void stop(void);
+    // Advance to nowUs and draw the current step. false if the scene is over.
+    bool update(uint32_t nowUs);
+    // Jump to the step, starts at nowUs.
+    void jump(int step, uint32_t nowUs);
+
+public:
+    bool running(void) const { return steps_ != nullptr && step_ < count_; }
+    int  step(void) const { return step_; }
+    uint32_t stepStartUs(void) const { return startUs_; }
+    const timeline_step_t * current(void) const { return running()? &steps_[step_] : nullptr; }
+
+public:
+    static fixed_t ease(timeline_ease_t ease, fixed_t t);
+    static int32_t tween(const timeline_step_t * step, fixed_t progress);
+
+private:
+    void enter(int step, uint32_t startUs);
+
+private:
+    const timeline_step_t * steps_ = nullptr;
+    int count_ = 0;
+    int step_ = 0;
+    uint32_t startUs_ = 0;
+    void * context_ = nullptr;
+};
@@ -0,0 +1,231 @@
+/**********************************************************************/
+/**
+ * @brief  Trace Recorder (Encoder, Commands, Frames)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "trace_recorder.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+static trace_record_t ring_[TRACE_RECORDS];
+static uint32_t head_ = 0;          // Next record
+static uint32_t count_ = 0;
+static uint32_t overwritten_ = 0;
+static uint32_t frames_ = 0;
+static uint32_t timeUs_ = 0;        // Of the last loop, for the motor
+static bool recording_ = false;
+static bool once_ = false;
+static bool hash_ = false;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Recording
+ *----------------------------------------------------------------------
+ */
+
+static trace_record_t *
+last(void)
+{
+    if (count_ == 0) return nullptr;
+    return &ring_[(head_ + TRACE_RECORDS - 1) % TRACE_RECORDS];
+}
+
+static bool
+push(uint32_t timeUs, trace_type_t type, uint8_t arg, uint16_t value, uint32_t data0, uint32_t data1)
+{
+    if (!recording_) return false;
+    if (count_ == TRACE_RECORDS) {
+        if (once_) {
+            recording_ = false;
+            return false;
+        }
+        overwritten_++;
+    } else {
+        count_++;
+    }
+    trace_record_t * r = &ring_[head_];
+    r->timeUs_ = timeUs;
+    r->type_ = (uint8_t)type;
+    r->arg_ = arg;
+    r->value_ = value;
+    r->data_[0] = data0;
+    r->data_[1] = data1;
+    head_ = (head_ + 1) % TRACE_RECORDS;
+    return true;
+}
+
+// TEXT records after a COMMAND / BINARY, TRACE_TEXT_BYTES each.
+static void
+push_text(const uint8_t * bytes, size_t size)
+{
+    for (size_t i = 0; i < size; i += TRACE_TEXT_BYTES) {
+        uint32_t data[2] = { 0, 0 };
+        size_t n = ((size - i) < TRACE_TEXT_BYTES)? (size - i) : TRACE_TEXT_BYTES;
+        memcpy(data, bytes + i, n);
+        if (!push(timeUs_, TRACE_TEXT, (uint8_t)n, 0, data[0], data[1])) return;
+    }
+}
+
+void
+trace_start(uint32_t timeUs, uint32_t seed, int mode, int grayPlanes, bool hash, bool once)
+{
+    head_ = 0;
+    count_ = 0;
+    overwritten_ = 0;
+    frames_ = 0;
+    timeUs_ = timeUs;
+    once_ = once;
+    hash_ = hash;
+    recording_ = true;
+    push(timeUs, TRACE_SEED, (uint8_t)grayPlanes, (uint16_t)mode, seed, (hash)? TRACE_FLAG_HASH : 0);
+}
+
+void
+trace_stop(void)
+{
+    recording_ = false;
+}
+
+bool
+trace_recording(void)
+{
+    return recording_;
+}
+
+bool
+trace_hashing(void)
+{
+    return recording_ && hash_;
+}
+
+void
+trace_loop(uint32_t timeUs, uint16_t angle)
+{
+    if (!recording_) return;
+    timeUs_ = timeUs;
+    trace_record_t * r = last();
+    if (r && r->type_ == TRACE_LOOP) {
+        // No frame since, the last loop is replaced.
+        r->timeUs_ = timeUs;
+        r->value_ = angle;
+        r->data_[0]++;
+        return;
+    }
+    push(timeUs, TRACE_LOOP, 0, angle, 1, 0);
+}
+
+void
+trace_frame(uint32_t endUs, int mode, int flags, uint32_t hash)
+{
+    if (!recording_) return;
+    push(timeUs_, TRACE_FRAME, (uint8_t)flags, (uint16_t)mode, endUs - timeUs_, hash);
+    frames_++;
+}
+
+void
+trace_command(const char * line)
+{
+    if (!recording_) return;
+    size_t n = strlen(line);
+    if (n > TRACE_TEXT_MAX) n = TRACE_TEXT_MAX;
+    if (!push(timeUs_, TRACE_COMMAND, (uint8_t)n, 0, 0, 0)) return;
+    push_text((const uint8_t *)line, n);
+}
+
+void
+trace_binary(uint8_t cmd, const uint8_t * payload, size_t size)
+{
+    if (!recording_) return;
+    if (size > TRACE_TEXT_MAX) size = TRACE_TEXT_MAX;
+    if (!push(timeUs_, TRACE_BINARY, (uint8_t)size, cmd, 0, 0)) return;
+    push_text(payload, size);
+}
+
+void
+trace_motor(trace_motor_t type, int value)
+{
+    push(timeUs_, TRACE_MOTOR, (uint8_t)type, (uint16_t)value, frames_, 0);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Dump
+ *----------------------------------------------------------------------
+ */
+
+void
+trace_get_stats(trace_stats_t * stats)
+{
+    stats->records_ = count_;
+    stats->overwritten_ = overwritten_;
+    stats->frames_ = frames_;
+    stats->recording_ = recording_;
+}
+
+bool
+trace_get(uint32_t index, trace_record_t * record)
+{
+    if (index >= count_) return false;
+    *record = ring_[(head_ + TRACE_RECORDS - count_ + index) % TRACE_RECORDS];
+    return true;
+}
+
+int
+trace_format(const trace_record_t * r, char * line, size_t size)
+{
+    return snprintf(line, size, TRACE_LINE_PREFIX "%08lx %02x %02x %04x %08lx %08lx",
+        (unsigned long)r->timeUs_, r->type_, r->arg_, r->value_,
+        (unsigned long)r->data_[0], (unsigned long)r->data_[1]);
+}
+
+// The record anywhere in the line, a serial log may have a prefix.
+bool
+trace_parse(const char * line, trace_record_t * r)
+{
+    const char * p = strstr(line, TRACE_LINE_PREFIX);
+    if (p == nullptr) return false;
+    unsigned long t, d0, d1;
+    unsigned type, arg, value;
+    if (sscanf(p + strlen(TRACE_LINE_PREFIX), "%lx %x %x %x %lx %lx", &t, &type, &arg, &value, &d0, &d1) != 6) return false;
+    if (type == TRACE_NONE || type > TRACE_MOTOR || arg > 0xFF || value > 0xFFFF) return false;
+    r->timeUs_ = (uint32_t)t;
+    r->type_ = (uint8_t)type;
+    r->arg_ = (uint8_t)arg;
+    r->value_ = (uint16_t)value;
+    r->data_[0] = (uint32_t)d0;
+    r->data_[1] = (uint32_t)d1;
+    return true;
+}
+
+static uint32_t
+fnv1a(uint32_t h, const uint8_t * p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 16777619UL;
+    }
+    return h;
+}
+
+uint32_t
+trace_hash(const uint8_t * buffer, size_t size, const sprite_list_t * sprites)
+{
+    uint32_t h = fnv1a(2166136261UL, buffer, size);
+    if (sprites) {
+        h = fnv1a(h, &sprites->count_, 1);
+        for (int i = 0; i < sprites->count_; i++) {
+            const sprite_instance_t * s = &sprites->instances_[i];
+            h = fnv1a(h, (const uint8_t *)&s->x_, sizeof(s->x_));
+            h = fnv1a(h, (const uint8_t *)&s->y_, sizeof(s->y_));
+        }
+    }
+    return h;
+}
@@ -0,0 +1,106 @@
+/**********************************************************************/
+/**
+ * @brief  Trace Recorder (Encoder, Commands, Frames)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+
+#include "sprite_format.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// The inputs of App in a RAM ring, to replay them on the host with a
+// virtual clock (v1/tools/tracereplay) :
+//   SEED    : trace start, the App seed and the state to replay from
+//   LOOP    : App::loop(timeUs, angle), the loops without a frame are
+//             folded into the next one (data_[0] : loops)
+//   FRAME   : a rendered frame, its render time and the buffer hash
+//   COMMAND : a text command line, TEXT records follow with the bytes
+//   BINARY  : a binary command, TEXT records follow with the payload
+//   MOTOR   : motor_set_power / motor_set_brake, at the frame count
+//
+// Recorded on core 0 only (the loop, the commands and the render), no lock.
+// The ring overwrites the oldest records, or stops when full (once). The
+// records are dumped as text lines (trace_format), the host parses them
+// from a serial log (trace_parse).
+
+#define TRACE_RECORDS           (2048)  // 16 bytes each
+#define TRACE_TEXT_BYTES        (8)     // Bytes a TEXT record
+#define TRACE_TEXT_MAX          (255)   // A longer command is cut
+#define TRACE_VERSION           (1)
+
+#define TRACE_LINE_PREFIX       "@TR "
+#define TRACE_LINE_SIZE         (48)
+
+typedef enum trace_type_ {
+    TRACE_NONE = 0,
+    TRACE_SEED,                 // value_ : mode, arg_ : gray planes, data_[0] : seed, data_[1] : flags
+    TRACE_LOOP,                 // value_ : angle, data_[0] : loops folded
+    TRACE_FRAME,                // value_ : mode, arg_ : flags, data_[0] : render us, data_[1] : hash
+    TRACE_COMMAND,              // arg_ : length
+    TRACE_BINARY,               // arg_ : length, value_ : command
+    TRACE_TEXT,                 // arg_ : bytes, data_ : bytes
+    TRACE_MOTOR,                // arg_ : trace_motor_t, value_ : value, data_[0] : frame count
+} trace_type_t;
+
+typedef enum trace_motor_ {
+    TRACE_MOTOR_POWER = 0,
+    TRACE_MOTOR_BRAKE,
+} trace_motor_t;
+
+// Flags
+#define TRACE_FLAG_HASH         (0x01)  // SEED : frames are hashed
+#define TRACE_FLAG_STREAM       (0x02)  // FRAME : a streamed frame (not replayed)
+
+typedef struct trace_record_ {
+    uint32_t timeUs_;
+    uint8_t  type_;
+    uint8_t  arg_;
+    uint16_t value_;
+    uint32_t data_[2];
+} trace_record_t;
+
+typedef struct trace_stats_ {
+    uint32_t records_;          // In the ring now
+    uint32_t overwritten_;      // Oldest records lost
+    uint32_t frames_;
+    bool recording_;
+} trace_stats_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// Recording
+void trace_start(uint32_t timeUs, uint32_t seed, int mode, int grayPlanes, bool hash, bool once);
+void trace_stop(void);
+bool trace_recording(void);
+bool trace_hashing(void);
+void trace_loop(uint32_t timeUs, uint16_t angle);
+void trace_frame(uint32_t endUs, int mode, int flags, uint32_t hash);
+void trace_command(const char * line);
+void trace_binary(uint8_t cmd, const uint8_t * payload, size_t size);
+void trace_motor(trace_motor_t type, int value);
+
+// Dump, oldest first
+void trace_get_stats(trace_stats_t * stats);
+bool trace_get(uint32_t index, trace_record_t * record);
+int trace_format(const trace_record_t * record, char * line, size_t size);
+bool trace_parse(const char * line, trace_record_t * record);
+
+// FNV-1a of a frame (the bit planes) and the sprite positions, only if
+// trace_hashing(). The sprite handles are not, they depend on the order the
+// images were registered before the trace.
+uint32_t trace_hash(const uint8_t * buffer, size_t size, const sprite_list_t * sprites);
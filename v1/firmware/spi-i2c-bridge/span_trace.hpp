@@ -0,0 +1,141 @@
+/**********************************************************************/
+/**
+ * @brief  Span Trace (Timing Spans of the Stages, a Ring per Core)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// The begin / end of the stages on the controller and the bridges, to see
+// the frames of both cores and all the boards on one timeline. Same file on
+// the controller and the bridge.
+//
+// An event is stamped by micros() (the 1 MHz timer of the RP2040, the same
+// on both cores) into the ring of the core running it. One writer a ring,
+// no lock : the loop of a core, or the SPI IRQ on the bridge core 0. The
+// count is published after the event (the M0+ does not reorder the
+// stores), the rings are read when stopped. The oldest events are
+// overwritten.
+//
+// The bridges are on their own clock. The controller sends a SYNC command
+// (spi_i2c_bridge.cpp), marked at the end of the transfer on the controller
+// and at the command receive on the bridge, then the host fits the bridge
+// clock to the controller one. (v1/tools/spantrace)
+
+#define SPAN_CORES              (2)
+#define SPAN_EVENTS             (1024)  // A core, 8 bytes each
+#define SPAN_EVENT_SIZE         (8)     // Packed, pack() / unpack()
+#define SPAN_FOLD_US            (16)    // beginFolded(), the IRQs of a transfer
+#define SPAN_VERSION            (1)
+
+#define SPAN_LINE_PREFIX        "@SP "
+#define SPAN_LINE_SIZE          (40)
+
+typedef enum span_stage_ {
+    SPAN_NONE = 0,
+    // Controller core 0
+    SPAN_RENDER,                // App::render, arg : render mode
+    // Controller core 1, SpiI2cBridge
+    SPAN_SEND_FRAME,            // sendFrameDataParallel, arg (end) : ok
+    SPAN_FRAME_CRC,             // The CRC of the endpoint blocks
+    SPAN_WAIT_READY,            // All the bridges ready, and the present stats
+    SPAN_SPRITES,               // The assets uploaded and the sprite lists
+    SPAN_FRAME_DATA,            // The data waves, arg : waves
+    SPAN_PRESENT,               // sendPresent, the bridges idle then PRESENT
+    SPAN_SCROLL_FRAME,          // sendScrollFrame, arg (end) : ok
+    // Bridge core 0
+    SPAN_SPI_IRQ,               // The receive IRQs of a transfer (or back to back ones), arg (end) : IRQs
+    SPAN_PRESENT_RX,            // PRESENT received, arg : presents
+    // Bridge core 1
+    SPAN_WRITE_FRAME,           // writeFrameMulti of a frame
+    SPAN_GRAY_PLANE,            // writeFrameMulti of a grayscale slot, arg : plane
+    SPAN_SCROLL_PAGES,          // The scroll pages and the start line, arg : records
+    // Both
+    SPAN_SYNC,                  // arg : sequence, the endpoint << 12 on the controller
+    SPAN_STAGES,
+} span_stage_t;
+
+// Flags, neither of BEGIN / END : an instant
+#define SPAN_FLAG_BEGIN         (0x01)
+#define SPAN_FLAG_END           (0x02)
+#define SPAN_FLAG_CORE1         (0x80)
+
+#define SPAN_SYNC_SEQ_MASK      (0x0FFF)
+
+typedef struct span_event_ {
+    uint32_t timeUs_;
+    uint8_t  stage_;
+    uint8_t  flags_;
+    uint16_t arg_;
+} span_event_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class SpanTrace
+{
+public:
+    explicit SpanTrace();
+
+public:
+    // Clears the rings.
+    void start(void);
+    void stop(void);
+    bool recording(void) const { return recording_; }
+
+public:
+    // On the core running.
+    void begin(uint8_t stage, uint16_t arg = 0) { push(stage, SPAN_FLAG_BEGIN, arg); }
+    void end(uint8_t stage, uint16_t arg = 0) { push(stage, SPAN_FLAG_END, arg); }
+    void mark(uint8_t stage, uint16_t arg = 0) { push(stage, 0, arg); }
+    // The last span goes on if it is of the stage and ended less than gapUs
+    // ago, nothing in between. The end has the spans folded in it.
+    void beginFolded(uint8_t stage, uint32_t gapUs = SPAN_FOLD_US);
+    void endFolded(uint8_t stage);
+
+public:
+    // Oldest first.
+    uint32_t count(int core) const;
+    uint32_t overwritten(int core) const;
+    bool get(int core, uint32_t index, span_event_t * event) const;
+
+public:
+    // Little endian, for the SPI.
+    static void pack(const span_event_t * event, uint8_t * bytes);
+    static void unpack(const uint8_t * bytes, span_event_t * event);
+    // The source : 0 the controller, 1 + the endpoint a bridge.
+    static int format(int source, const span_event_t * event, char * line, size_t size);
+    static bool parse(const char * line, int * source, span_event_t * event);
+    static const char * stageName(int stage);
+
+private:
+    typedef struct ring_ {
+        span_event_t events_[SPAN_EVENTS];
+        volatile uint32_t head_;    // Next event
+        volatile uint32_t count_;
+        uint32_t overwritten_;
+        span_event_t * open_;       // The end beginFolded() went on with
+        uint8_t openStage_;
+        uint32_t openUs_;
+    } ring_t;
+
+    void push(uint8_t stage, uint8_t flags, uint16_t arg);
+    void put(ring_t * ring, int core, uint8_t stage, uint8_t flags, uint16_t arg, uint32_t timeUs);
+
+    ring_t rings_[SPAN_CORES];
+    volatile bool recording_ = false;
+};
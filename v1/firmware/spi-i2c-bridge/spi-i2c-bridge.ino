@@ -12,11 +12,17 @@
 
 #include <SPI.h>
 #include <SPISlave.h>
+#include <pico/mutex.h>
 
 #include "led.hpp"
 #include "interval_timer.hpp"
 #include "circular_buffer.hpp"
+#include "cv_geometry.hpp"
 #include "ssd1306_multi_pio.hpp"
+#include "sprite_format.hpp"
+#include "sprite_cache.hpp"
+#include "spi_receiver.hpp"
+#include "span_trace.hpp"
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -68,15 +74,31 @@
  *----------------------------------------------------------------------
  */
 
-#define DISPLAY_WIDTH           (32)
-#define DISPLAY_HEIGHT          (128)
-#define DISPLAY_PIXELS          (DISPLAY_WIDTH * DISPLAY_HEIGHT)
-#define DISPLAY_BYTES_PER_PIXEL ((float)1 / 8)
-#define DISPLAY_BYTES           ((int)(DISPLAY_PIXELS * DISPLAY_BYTES_PER_PIXEL))
+// The panels of this bridge, same to the controller. (cv_geometry.hpp)
+#define DISPLAY_WIDTH           (CvDefaultGeometry::WIDTH)
+#define DISPLAY_HEIGHT          (CvDefaultGeometry::HEIGHT)
+#define DISPLAY_PIXELS          (CvDefaultGeometry::PIXELS)
+#define DISPLAY_BYTES           (CvDefaultGeometry::ONE_FRAME_BYTES)
 
 #define CIRCULAR_BUFFER_NUM     (2)
-#define I2C_CHANNELS            (8)
-#define BUFFER_SIZE             (DISPLAY_BYTES * I2C_CHANNELS)
+#define I2C_CHANNELS            (CvDefaultGeometry::CHANNELS)
+#define BUFFER_SIZE             (CvDefaultGeometry::BRIDGE_BYTES)
+
+#define GRAY_PLANES_MAX         (4)     // Bit planes of a grayscale frame, all in one slot
+#define GRAY_SLOTS_MAX          (15)    // Schedule of the planes, 2^GRAY_PLANES_MAX - 1 at most
+
+#define SCROLL_RECORD_SIZE      (2 + I2C_CHANNELS * DISPLAY_HEIGHT)     // Virtual page, a page a channel
+#define SCROLL_RECORDS_MAX      (CvDefaultGeometry::SSD1306_GDDRAM_PAGES)
+#define SCROLL_PAGE_MASK        (0x1FFF)                                // Virtual pages of the u16 rows
+
+#define SPI_LINK_TEST_SIZE      (256)   // Test patterns of the link training, same to the controller
+#define SPI_PRESENT_STATS_SIZE  (10)    // SPI_CMD_GET_PRESENT_STATS response, same to the controller
+#define SPAN_BLOCK_EVENTS       (8)     // SPI_CMD_GET_SPANS response events, same to the controller
+#define SPI_SPAN_BLOCK_SIZE     (4 + SPAN_BLOCK_EVENTS * SPAN_EVENT_SIZE)
+
+// SPI_MODE3 if the bridge shares the controller SPI bus with another one,
+// the chip select is held for a transfer. (sib_endpoint_t of the controller)
+#define SPI_SLAVE_MODE          (SPI_MODE0)
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -97,10 +119,23 @@ static const int pin_buildin_led_   = PIN_LED; // 25
  *----------------------------------------------------------------------
  */
 
-static void calc_crc16_lookup_table(void);
-static inline void calc_crc16(const uint8_t & data);
 static void spiReceivedIrqCallback(uint8_t *data, size_t len);
 static void spiSentIrqCallback();
+static uint8_t * spiPayloadHook(void * context, uint8_t cmd, size_t size);
+static void spiCommandHook(void * context, uint8_t cmd, size_t size);
+static void spiErrorHook(void * context, spirx_error_t error);
+static bool frameReady(void);
+static void presentStart(void);
+static void composeSprites(int planes);
+static void grayApply(void);
+static void grayLoop(void);
+static bool grayNext(void);
+static int32_t grayWaitUs(void);
+static bool scrollReady(void);
+static void scrollLoop(void);
+static bool scrollLoaded(uint32_t row);
+static void scrollShow(uint32_t request);
+static void scrollInvalidate(int pages);
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
@@ -114,69 +149,121 @@ static IntervalTimer debugTimer_;
 
 static SSD1306MultiPIO ssd1306mpio_;
 
-static SPISettings spisettings(50 * 1000 * 1000, MSBFIRST, SPI_MODE0);
-
-static const int SPI_STATE_SYNC1 = 0;
-static const int SPI_STATE_SYNC2 = 1;
-static const int SPI_STATE_CMD   = 2;
-static const int SPI_STATE_OPT1  = 3;
-static const int SPI_STATE_OPT2  = 4;
-static const int SPI_STATE_OPT3  = 5;
-static const int SPI_STATE_OPT4  = 6;
-static const int SPI_STATE_DATA  = 7;
-static const int SPI_STATE_CRC1  = 8;
-static const int SPI_STATE_CRC2  = 9;
-
-static const int SPI_CMD_NONE        = 0x00;
-static const int SPI_CMD_GET_STATUS  = 0x01;
-static const int SPI_CMD_START_FRAME = 0x02;
-static const int SPI_CMD_SET_DATA    = 0x03;
-static const int SPI_CMD_PING        = 0x04;
-static const int SPI_CMD_OB_LED_ON   = 0x05;
-static const int SPI_CMD_OB_LED_OFF  = 0x06;
-static const int SPI_CMD_SET_ID_DIR0 = 0x07;
-static const int SPI_CMD_SET_ID_DIR1 = 0x08;
-static const int SPI_CMD_HARD_RESET  = 0xFE;
-
-static const int SPI_SYNC1 = 0xAA;
-static const int SPI_SYNC2 = 0x55;
+static SPISettings spisettings(50 * 1000 * 1000, MSBFIRST, SPI_SLAVE_MODE);
+
 static const int SPI_TXDATA_VALID_FLAG = 0x80;
+static const int SPI_RSP_DATA_SCROLL_MISS = (1 << 0);   // A scroll row was not loaded, dropped
 static const int SPI_RSP_DATA_BUSY  = (1 << 1);
 static const int SPI_RSP_DATA_PING  = (1 << 2);
 static const int SPI_RSP_DATA_ERROR = (1 << 3);
+static const int SPI_RSP_DATA_ASSET_MISS = (1 << 4);
+static const int SPI_RSP_DATA_STATS = (1 << 5);
+static const int SPI_RSP_DATA_SHOWING = (1 << 6);   // A presented frame is not transferred yet
 
 static const int SPI_RSP_NONE        = 0x00;
 static const int SPI_RSP_GET_STATUS  = 0x01;
 static const int SPI_RSP_PING        = 0x02;
 static const int SPI_RSP_ERROR       = 0x03;
+static const int SPI_RSP_PRESENT_STATS = 0x04;
+static const int SPI_RSP_SPANS       = 0x05;
 
-static int        spiState_;
-static uint8_t    spiCmd_;
-static uint8_t    spiOpt1_;
-static uint8_t    spiOpt2_;
-static uint8_t    spiOpt3_;
-static uint8_t    spiOpt4_;
-static uint       spiDataBlockSize_;
-static uint8_t    spiCrc1_;
-static uint8_t    spiCrc2_;
-static uint16_t   spiCrc_;
-
-static uint8_t    spiTxBuffer_;
+static const int SPI_SPANS_STOP      = 0;           // SPANS OPT1 bits 0-3
+static const int SPI_SPANS_START     = 1;
+static const int SPI_SPANS_SYNC      = 2;
+
+static SpiReceiver spiReceiver_;
+
+static uint8_t    spiTxBuffer_[1 + MAX(SPI_PRESENT_STATS_SIZE, SPI_SPAN_BLOCK_SIZE)];
 static int        spiResponseFlag_;
+static volatile bool spiErrorFlag_ = false;         // Until the next status, for the link rate of the controller
+static uint32_t   spiErrors_ = 0;
+static uint8_t    spiLinkTestBuffer_[SPI_LINK_TEST_SIZE];
 
-static uint8_t        rawbuffer_[BUFFER_SIZE * CIRCULAR_BUFFER_NUM];
+static uint8_t        rawbuffer_[BUFFER_SIZE * GRAY_PLANES_MAX * CIRCULAR_BUFFER_NUM];
 static CircularBuffer buffer_;
-static uint8_t *      wrBufferPtr_;
-static uint           wrBufferAvail_;
+
+static SpriteCache    spriteCache_;
+static uint8_t        spriteArena_[SPRITE_CACHE_SIZE];
+static mutex_t        spriteMutex_;
+static uint8_t        spriteAssetBuffer_[SPRITE_ASSET_MAX_SIZE];
+static uint8_t        spriteListTmpBuffer_[SPRITE_LIST_MAX_SIZE];
+static uint8_t        spriteListBuffer_[CIRCULAR_BUFFER_NUM][SPRITE_LIST_MAX_SIZE];
+static uint           spriteListSize_[CIRCULAR_BUFFER_NUM];
+static volatile uint  spriteAssetPending_ = 0;      // Uploaded asset size, waiting store into the cache.
+static volatile bool  spriteClearRequest_ = false;
+static volatile bool  spriteMiss_ = false;
+static volatile uint32_t spriteFrames_ = 0;         // Sprites only frames committed
+
+// Stage then present. The committed slots wait for a PRESENT, sent to all
+// the bridges at once, so the panels of the cylinder change together. Off
+// until the first PRESENT. (the frame counts wrap, compared by difference)
+static volatile bool     presentMode_ = false;
+static volatile uint32_t presentedFrames_ = 0;      // Committed frames at the last PRESENT
+static uint32_t          pushedFrames_ = 0;         // I2C transfers done (core1)
+static uint32_t          startedFrames_ = 0;        // I2C transfers started (core1)
+static uint32_t          presentAtUs_[CIRCULAR_BUFFER_NUM];
+static uint16_t          presentSeqAt_[CIRCULAR_BUFFER_NUM];
+
+static uint16_t   presents_ = 0;
+static uint16_t   presentMissed_ = 0;               // PRESENT with no new frame (lost, or late)
+static uint16_t   presentPushed_ = 0;               // PRESENT of the last frame started
+static uint16_t   presentLatencyUs_ = 0;            // PRESENT to the I2C transfer start, the last frame
+static uint16_t   presentLatencyMaxUs_ = 0;         // Since the last stats
+
+// Grayscale, the bit planes of a frame (LSB first) shown in turn by binary
+// code modulation : the plane k is shown for a weight of 2^k, the lower
+// planes by the contrast and the upper ones by repeated slots of the full
+// contrast. A plane is written to the back frame (the GDDRAM pages off the
+// panel), then shown by the start line and the contrast at once, so the
+// panel never shows a plane half written in another contrast. The slots
+// flip on a grid from the PRESENT, the same on all the bridges, and the
+// frame is shown again and again until the next one.
+typedef struct gray_slot_ {
+  uint8_t plane_;
+  uint8_t contrast_;
+} gray_slot_t;
+
+static volatile uint32_t grayRequest_ = 0;          // SET_GRAY OPT2:OPT1 | 0x10000, applied on core1
+static int         grayPlanes_ = 1;                 // 1 : monochrome
+static uint32_t    graySlotUs_ = 0;                 // 0 : the flip follows the write
+static gray_slot_t graySchedule_[GRAY_SLOTS_MAX];
+static int         graySlots_ = 0;
+static int         grayStep_ = 0;                   // The next slot written
+static bool        grayHeld_ = false;               // The read slot is shown, until the next one
+static bool        grayWritten_ = false;            // The back frame waits for the flip
+static uint8_t     grayFlipContrast_ = 0;
+static uint8_t     grayFlipLine_ = 0;
+static uint32_t    grayFlipUs_ = 0;
+static uint32_t    grayLateFlips_ = 0;              // The write took longer than the slot
+
+// Scroll layer, a layer larger than the panel moved by the start line. The
+// 8 GDDRAM pages hold the virtual pages (8 rows) of the layer by (virtual
+// page & 7), a panel shows the rows from any line over PAGES + 1 of them.
+// The controller loads the pages ahead of the row (SCROLL_PAGES), then the
+// row is shown by the start line alone (SCROLL), at the PRESENT in the
+// present mode. A row with a page not loaded is dropped and reported, the
+// controller loads it again. A frame (a slot) takes the panel pages back.
+static uint8_t           scrollBuffer_[SCROLL_RECORD_SIZE * SCROLL_RECORDS_MAX];
+static volatile uint     scrollPending_ = 0;        // Records received, waiting the write on core1
+static volatile uint32_t scrollStaged_ = 0;         // SCROLL row | 0x10000, until the PRESENT
+static volatile uint32_t scrollRequest_ = 0;        // Shown on core1
+static volatile bool     scrollMiss_ = false;       // Until the next status
+static volatile bool     scrollLost_ = false;       // A receive error, SCROLL_PAGES may be lost
+static int32_t           scrollTags_[CvDefaultGeometry::SSD1306_GDDRAM_PAGES];   // Virtual page of the GDDRAM page, -1 : none
+static bool              scrollActive_ = false;     // The start line is on the layer
+static uint32_t          scrollFrames_ = 0;
+static uint32_t          scrollMisses_ = 0;
+
+// The stages on the timeline, the SPI IRQ on core0 and the I2C writes on
+// core1. (span_trace.hpp, dumped by the controller)
+static SpanTrace         spans_;
+static volatile uint16_t spanRequest_ = 0;          // GET_SPANS index | core << 15
 
 static uint32_t   xfer_count_ = 0;
 static bool       ob_led_on_ = true;
 
 static uint32_t   fps_ = 0;
 
-static uint16_t   crc16_lu_table[256]; 
-static const uint16_t crc16_polynomial = 0x1021;
-
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions - Core 0
  *----------------------------------------------------------------------
@@ -207,16 +294,18 @@ void setup()
 
   // Init Buffers
   buffer_.setBuffer(rawbuffer_, sizeof(rawbuffer_), CIRCULAR_BUFFER_NUM);
-  wrBufferPtr_   = buffer_.getWriteBufferPtr();
-  wrBufferAvail_ = BUFFER_SIZE;
 
   // Init Display (and PIO I2C)
   ssd1306mpio_.init();
+  scrollInvalidate(CvDefaultGeometry::SSD1306_GDDRAM_PAGES);
+
+  // Init Sprite Cache
+  mutex_init(&spriteMutex_);
+  spriteCache_.init(spriteArena_, sizeof(spriteArena_), DISPLAY_WIDTH, DISPLAY_HEIGHT);
 
   // Init SPI
-  calc_crc16_lookup_table();
-  spiState_ = SPI_STATE_SYNC1;
-  spiCmd_ = SPI_CMD_NONE;
+  spirx_hooks_t hooks = { nullptr, spiPayloadHook, spiCommandHook, spiErrorHook };
+  spiReceiver_.init(&buffer_, BUFFER_SIZE, &hooks);
   spiResponseFlag_ = SPI_RSP_NONE;
 
   SPISlave.setRX(pin_spi_rx_);
@@ -243,6 +332,22 @@ void loop()
 
   // @note core0 handling spi interrupts.
 
+  // Store uploaded assets. (The arena is shared with the compositor on core1)
+  if (spriteClearRequest_) {
+    mutex_enter_blocking(&spriteMutex_);
+    spriteCache_.clear();
+    // The frames on the way lose their sprites, not a miss.
+    memset((void*)spriteListSize_, 0, sizeof(spriteListSize_));
+    mutex_exit(&spriteMutex_);
+    spriteClearRequest_ = false;
+  }
+  if (spriteAssetPending_ > 0) {
+    mutex_enter_blocking(&spriteMutex_);
+    spriteCache_.store(spriteAssetBuffer_, spriteAssetPending_);
+    mutex_exit(&spriteMutex_);
+    spriteAssetPending_ = 0;
+  }
+
   //
   // Debug processes
   //
@@ -334,16 +439,40 @@ void loop1(void)
   // Main processes
   //
 
-  if (buffer_.getReadReady()) {
+  if (grayRequest_ != 0) {
+    grayApply();
+  }
+
+  if (grayPlanes_ > 1) {
+    grayLoop();
+  } else if (frameReady()) {
     //Serial.printf("ReadBuffer Ready\n");
+
+    presentStart();
+
+    // Composite sprites into the frame before i2c transfer.
+    composeSprites(1);
+
+    spans_.begin(SPAN_WRITE_FRAME);
     ssd1306mpio_.writeFrameMulti(buffer_.getReadBufferPtr());
+    spans_.end(SPAN_WRITE_FRAME);
+
+    // The panel pages are the frame now, shown from the line 0.
+    scrollInvalidate(CvDefaultGeometry::PAGES);
+    if (scrollActive_) {
+      ssd1306mpio_.setStartLine(0);
+      scrollActive_ = false;
+    }
 
     // Set buffer status.
     {
       uint32_t irqstatus = save_and_disable_interrupts();
       buffer_.nextReadBuffer();
+      pushedFrames_++;
       restore_interrupts(irqstatus);
     }
+  } else if (scrollReady()) {
+    scrollLoop();
   }
 
   //
@@ -353,40 +482,268 @@ void loop1(void)
 #if 0
   fps_++;
   if (debugTimer_.check()) {
-    Serial.printf("fps_ = %d\n", fps_);
+    Serial.printf("fps_ = %d, spiErrors_ = %u\n", fps_, (unsigned)spiErrors_);
     fps_ = 0;
   }
 #endif
 
 }
 
+// The read slot is committed, and presented in the present mode. (or the
+// grayscale has a slot to show)
+static bool frameReady(void)
+{
+  if (grayRequest_ != 0) return true;
+  if (grayPlanes_ > 1) return (grayHeld_ || grayWritten_ || grayNext());
+  if (!buffer_.getReadReady()) return false;
+  return (!presentMode_ || (int32_t)(presentedFrames_ - pushedFrames_) > 0);
+}
+
+// The I2C transfer of the read slot starts, the present telemetry. Once a frame.
+static void presentStart(void)
+{
+  if (startedFrames_ != pushedFrames_ || !buffer_.getReadReady()) return;
+  startedFrames_++;
+  if (!presentMode_) return;
+
+  int at = pushedFrames_ % CIRCULAR_BUFFER_NUM;
+  uint32_t latency = micros() - presentAtUs_[at];
+  presentLatencyUs_ = (uint16_t)MIN(latency, 0xFFFFu);
+  presentLatencyMaxUs_ = MAX(presentLatencyMaxUs_, presentLatencyUs_);
+  presentPushed_ = presentSeqAt_[at];
+}
+
+// The sprites of the read slot into each plane.
+static void composeSprites(int planes)
+{
+  int slot = buffer_.getReadIndex();
+  if (spriteListSize_[slot] == 0) return;
+
+  bool found = true;
+  mutex_enter_blocking(&spriteMutex_);
+  for (int plane = 0; plane < planes; plane++) {
+    uint8_t * buffer = buffer_.getReadBufferPtr() + (plane * BUFFER_SIZE);
+    found &= spriteCache_.compose(buffer, I2C_CHANNELS, spriteListBuffer_[slot], spriteListSize_[slot]);
+  }
+  mutex_exit(&spriteMutex_);
+  if (!found) {
+    spriteMiss_ = true;
+  }
+}
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
- * Function definitions - Interrupt Callbacks
+ * Function definitions - Grayscale
  *----------------------------------------------------------------------
  */
 
-static void calc_crc16_lookup_table(void)
+// SET_GRAY. The slots are resized, the staged frames are dropped.
+static void grayApply(void)
 {
-  for (uint16_t i = 0; i < 256; i++) {
-    uint16_t crc = i << 8;
-    for (int j = 0; j < 8; j++) {
-      if (crc & 0x8000) crc = (crc << 1) ^ crc16_polynomial;
-      else              crc <<= 1;
+  const bool backFrame = CvDefaultGeometry::SSD1306_BACK_FRAME;
+
+  uint32_t irqstatus = save_and_disable_interrupts();
+  uint32_t request = grayRequest_;
+  int planes = CONSTRAIN((int)(request & 0x0F), 1, GRAY_PLANES_MAX);
+  buffer_.setBuffer(rawbuffer_, BUFFER_SIZE * planes * CIRCULAR_BUFFER_NUM, CIRCULAR_BUFFER_NUM);
+  spiReceiver_.setFrameSize(BUFFER_SIZE * planes);
+  memset(spriteListSize_, 0, sizeof(spriteListSize_));
+  uint32_t staged = spiReceiver_.stats()->frames_ + spriteFrames_;
+  presentedFrames_ = pushedFrames_ = startedFrames_ = staged;
+  grayPlanes_ = planes;
+  grayRequest_ = 0;
+  scrollPending_ = 0;
+  scrollStaged_ = scrollRequest_ = 0;
+  restore_interrupts(irqstatus);
+
+  // The back frame pages are the planes, the layer is loaded again.
+  scrollInvalidate(CvDefaultGeometry::SSD1306_GDDRAM_PAGES);
+  scrollActive_ = false;
+
+  // No back frame, no contrast steps. (the planes are written on the panel)
+  int steps = (backFrame)? CONSTRAIN((int)((request >> 4) & 0x0F), 0, planes - 1) : 0;
+  graySlotUs_ = ((request >> 8) & 0xFF) * 100;
+  grayStep_ = 0;
+  grayHeld_ = false;
+  grayWritten_ = false;
+  grayFlipLine_ = 0;
+
+  // Plane k at the contrast >> (steps - k) up to the steps, then 2^(k - steps)
+  // slots at the contrast, spread over the cycle.
+  uint8_t contrast = ssd1306mpio_.contrast();
+  graySlots_ = 0;
+  for (int round = 0; round < (1 << (planes - 1)); round++) {
+    for (int k = 0; k < planes; k++) {
+      int repeat = (k <= steps)? 1 : (1 << (k - steps));
+      if (round >= repeat) continue;
+      int shift = (k <= steps)? steps - k : 0;
+      gray_slot_t * slot = &graySchedule_[graySlots_++];
+      slot->plane_ = (uint8_t)k;
+      slot->contrast_ = (uint8_t)MAX(1, (contrast + ((1 << shift) >> 1)) >> shift);
     }
-    crc16_lu_table[i] = crc;
   }
+
+  // Back to the panel pages at the contrast.
+  ssd1306mpio_.showFrame(0, contrast);
+  Serial.printf("gray : planes = %d, steps = %d, slots = %d, slot = %u us\n", planes, steps, graySlots_, (unsigned)graySlotUs_);
 }
 
-static inline void calc_crc16(const uint8_t & data)
+// A slot : the flip of the plane written last time, at its time, then the
+// next plane to the back frame. A new frame (committed, and presented in
+// the present mode) starts over at a slot boundary.
+static void grayLoop(void)
 {
-  spiCrc_ = (spiCrc_ << 8) ^ crc16_lu_table[((spiCrc_ >> 8) ^ data) & 0xFF];
+  const bool backFrame = CvDefaultGeometry::SSD1306_BACK_FRAME;
+
+  if (grayWritten_) {
+    if (grayWaitUs() > 0) return;
+    if (grayWaitUs() < -(int32_t)(graySlotUs_ / 2)) grayLateFlips_++;
+    ssd1306mpio_.showFrame(grayFlipLine_, grayFlipContrast_);
+    grayWritten_ = false;
+    grayFlipUs_ += graySlotUs_;
+  }
+
+  if (grayNext()) {
+    if (grayHeld_) {
+      uint32_t irqstatus = save_and_disable_interrupts();
+      buffer_.nextReadBuffer();
+      pushedFrames_++;
+      restore_interrupts(irqstatus);
+    }
+    grayHeld_ = true;
+    grayStep_ = 0;
+    presentStart();
+    composeSprites(grayPlanes_);
+
+    // 2 slots from the PRESENT, one to finish the slot on the way and one
+    // to write the first plane.
+    int at = pushedFrames_ % CIRCULAR_BUFFER_NUM;
+    grayFlipUs_ = ((presentMode_)? presentAtUs_[at] : micros()) + graySlotUs_ * 2;
+  }
+  if (!grayHeld_) return;
+
+  const gray_slot_t * slot = &graySchedule_[grayStep_];
+  uint8_t * plane = buffer_.getReadBufferPtr() + (slot->plane_ * BUFFER_SIZE);
+  spans_.begin(SPAN_GRAY_PLANE, slot->plane_);
+  if (backFrame) {
+    uint8_t page = (grayFlipLine_ == 0)? CvDefaultGeometry::PAGES : 0;
+    ssd1306mpio_.writeFrameMulti(plane, page);
+    grayFlipLine_ = page * 8;
+    grayFlipContrast_ = slot->contrast_;
+    grayWritten_ = true;
+    if (graySlotUs_ == 0) grayFlipUs_ = micros();
+  } else {
+    // On the panel, the slot is the write time.
+    ssd1306mpio_.writeFrameMulti(plane);
+  }
+  spans_.end(SPAN_GRAY_PLANE);
+  grayStep_ = (grayStep_ + 1) % graySlots_;
+}
+
+// The next frame to show. (the read slot is held while shown)
+static bool grayNext(void)
+{
+  uint32_t staged = spiReceiver_.stats()->frames_ + spriteFrames_;
+  uint32_t ready = (presentMode_)? presentedFrames_ : staged;
+  return (int32_t)(ready - pushedFrames_) > ((grayHeld_)? 1 : 0);
+}
+
+// To the flip of the back frame, 0 or less : due.
+static int32_t grayWaitUs(void)
+{
+  return (grayWritten_)? (int32_t)(grayFlipUs_ - micros()) : 0;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Scroll Layer
+ *----------------------------------------------------------------------
+ */
+
+static bool scrollReady(void)
+{
+  return (scrollPending_ > 0 || scrollRequest_ != 0);
+}
+
+// The row is shown as soon as its pages are loaded, before the pages ahead
+// are written, then the pages received. A row still not loaded is a miss.
+static void scrollLoop(void)
+{
+  uint32_t request = scrollRequest_;
+  int records = (int)scrollPending_;
+  spans_.begin(SPAN_SCROLL_PAGES, (uint16_t)records);
+  // A lost SCROLL_PAGES leaves the pages of the last layer with the same
+  // tags. The error is before the SCROLL in the stream, seen with it.
+  if (scrollLost_) {
+    scrollLost_ = false;
+    scrollInvalidate(CvDefaultGeometry::SSD1306_GDDRAM_PAGES);
+  }
+  if (request != 0 && scrollLoaded(request)) {
+    scrollShow(request);
+    request = 0;
+  }
+
+  for (int i = 0; i < records; i++) {
+    uint8_t * record = &scrollBuffer_[i * SCROLL_RECORD_SIZE];
+    int32_t vpage = (int32_t)((record[0] | record[1] << 8) & SCROLL_PAGE_MASK);
+    int page = vpage % CvDefaultGeometry::SSD1306_GDDRAM_PAGES;
+    ssd1306mpio_.writePagesMulti(record + 2, (uint8_t)page, 1, DISPLAY_HEIGHT);
+    scrollTags_[page] = vpage;
+  }
+  if (records > 0) scrollPending_ = 0;
+
+  if (request != 0) {
+    if (scrollLoaded(request)) {
+      scrollShow(request);
+    } else {
+      uint32_t irqstatus = save_and_disable_interrupts();
+      if (scrollRequest_ == request) scrollRequest_ = 0;
+      scrollMiss_ = true;
+      restore_interrupts(irqstatus);
+      scrollMisses_++;
+    }
+  }
+  spans_.end(SPAN_SCROLL_PAGES);
 }
 
+// The virtual pages of the panel rows from the row are in the GDDRAM.
+static bool scrollLoaded(uint32_t row)
+{
+  row &= 0xFFFF;
+  int last = (int)(((row & 7) + DISPLAY_WIDTH - 1) >> 3);
+  for (int i = 0; i <= last; i++) {
+    int32_t vpage = (int32_t)(((row >> 3) + i) & SCROLL_PAGE_MASK);
+    if (scrollTags_[vpage % CvDefaultGeometry::SSD1306_GDDRAM_PAGES] != vpage) return false;
+  }
+  return true;
+}
+
+// The GDDRAM line of the virtual row is (row & 63), by the start line.
+static void scrollShow(uint32_t request)
+{
+  ssd1306mpio_.setStartLine((uint8_t)(request & 0x3F));
+  scrollActive_ = true;
+  scrollFrames_++;
+
+  uint32_t irqstatus = save_and_disable_interrupts();
+  if (scrollRequest_ == request) scrollRequest_ = 0;
+  restore_interrupts(irqstatus);
+}
+
+// The GDDRAM pages from 0 are not the layer.
+static void scrollInvalidate(int pages)
+{
+  for (int i = 0; i < pages; i++) scrollTags_[i] = -1;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Interrupt Callbacks
+ *----------------------------------------------------------------------
+ */
+
 //void spiReceivedIrqCallback(uint8_t *data, size_t len)
 void __time_critical_func(spiReceivedIrqCallback)(uint8_t *data, size_t len)
 {
   //digitalWrite(22, HIGH);
-  
+
   //Serial.printf("rx : %d\n", len);
   //for (int i = 0; i < len; i++) {
   //  Serial.printf("  0x%02x\n", data[i]);
@@ -395,199 +752,187 @@ void __time_critical_func(spiReceivedIrqCallback)(uint8_t *data, size_t len)
   if (len == 0) return;
   //xfer_count_ += len;
 
-  uint8_t * dataend = data + len;
-  while (1) {
-    switch (spiState_)
-    {
-    case SPI_STATE_SYNC1:
-      //Serial.printf("SYNC1\n");
-      spiState_ = (*data == SPI_SYNC1)? SPI_STATE_SYNC2 : SPI_STATE_SYNC1;
-      data++;
-      break;
-    case SPI_STATE_SYNC2:
-      //Serial.printf("SYNC2\n");
-      spiState_ = (*data == SPI_SYNC2)? SPI_STATE_CMD : SPI_STATE_SYNC1;
-      data++;
-      break;
-    case SPI_STATE_CMD:
-      //Serial.printf("CMD 0x%02x\n", *data);
-      spiCmd_ = *data;
-      data++;
-
-      // Command Check
-      switch (spiCmd_)
-      {
-      case SPI_CMD_NONE        :
-      case SPI_CMD_GET_STATUS  :
-      case SPI_CMD_START_FRAME :
-      case SPI_CMD_SET_DATA    :
-      case SPI_CMD_PING        :
-      case SPI_CMD_OB_LED_ON   :
-      case SPI_CMD_OB_LED_OFF  :
-      case SPI_CMD_SET_ID_DIR0 :
-      case SPI_CMD_SET_ID_DIR1 :
-      case SPI_CMD_HARD_RESET  :
-        // valid command
-        spiState_ = SPI_STATE_OPT1;
-        break;
-      default:
-        // unknown command
-        spiState_ = SPI_SYNC1;
-        spiResponseFlag_ = SPI_RSP_ERROR;
-        break;
-      }
+  // The IRQs of a transfer are a span.
+  spans_.beginFolded(SPAN_SPI_IRQ);
+  spiReceiver_.receive(data, len);
+  spans_.endFolded(SPAN_SPI_IRQ);
 
-      spiCrc_ = 0xFFFF;
-      calc_crc16(SPI_SYNC1);
-      calc_crc16(SPI_SYNC2);
-      calc_crc16(spiCmd_);
-
-      break;
-    case SPI_STATE_OPT1:
-      //Serial.printf("OPT1 0x%02x\n", *data);
-      spiOpt1_ = *data;
-      data++;
-      spiState_ = SPI_STATE_OPT2;
-      calc_crc16(spiOpt1_);
-      break;
-    case SPI_STATE_OPT2:
-      //Serial.printf("OPT2 0x%02x\n", *data);
-      spiOpt2_ = *data;
-      data++;
-      spiState_ = SPI_STATE_OPT3;
-      calc_crc16(spiOpt2_);
-      break;
-    case SPI_STATE_OPT3:
-      //Serial.printf("OPT3 0x%02x\n", *data);
-      spiOpt3_ = *data;
-      data++;
-      spiState_ = SPI_STATE_OPT4;
-      calc_crc16(spiOpt3_);
-      break;
-    case SPI_STATE_OPT4:
-      //Serial.printf("OPT4 0x%02x\n", *data);
-      spiOpt4_ = *data;
-      data++;
-      if ( (spiOpt1_ != (uint8_t)~spiOpt3_) || (spiOpt2_ != (uint8_t)~spiOpt4_) ) {
-        //Serial.printf("OPT parity check error.\n");
-        spiState_ = SPI_STATE_SYNC1;
-        spiResponseFlag_ = SPI_RSP_ERROR;
-      } else if (spiCmd_ == SPI_CMD_SET_DATA) {
-        spiState_ = SPI_STATE_DATA;
-        spiDataBlockSize_ = (uint)spiOpt2_ << 8 | (uint)spiOpt1_;
-        calc_crc16(spiOpt4_);
-        //Serial.printf("spiDataBlockSize_ = %d\n", spiDataBlockSize_);
-      } else {
-        spiState_ = SPI_STATE_CRC1;
-        calc_crc16(spiOpt4_);
-      }
-      break;
-    case SPI_STATE_DATA:
-    {
-      if (!buffer_.getWriteReady()) {
-        //Serial.printf("Write buffer overflow\n");
-        // The buffer is currently in I2C transfer standby. Discard data.
-        spiState_ = SPI_STATE_SYNC1;
-      }
+  //digitalWrite(22, LOW);
+}
 
-      uint wrSize = MIN3((dataend - data), wrBufferAvail_, spiDataBlockSize_);
+uint8_t * __time_critical_func(spiPayloadHook)(void * context, uint8_t cmd, size_t size)
+{
+  UNUSED_VAR(context);
 
-      memcpy(wrBufferPtr_, data, wrSize);
-      for (int i = 0; i < wrSize; i++) {
-        calc_crc16(*data);
-        data++;
-      }
-      
-      wrBufferPtr_ += wrSize;
-      wrBufferAvail_ -= wrSize;
-      spiDataBlockSize_ -= wrSize;
-      
-      if (wrBufferAvail_ == 0) {
-        //Serial.printf("Set next buffer to current buffer.\n");
-        buffer_.nextWriteBuffer();
-        wrBufferPtr_   = buffer_.getWriteBufferPtr();
-        wrBufferAvail_ = BUFFER_SIZE;
-      }
-      if (spiDataBlockSize_ == 0) {
-        //Serial.printf("Done data state\n");
-        spiState_ = SPI_STATE_CRC1;
-      }
-    } break;
-    case SPI_STATE_CRC1:
-      //Serial.printf("CRC1 0x%02x\n", *data);
-      spiCrc1_ = *data;
-      data++;
-      spiState_ = SPI_STATE_CRC2;
-      break;
-    case SPI_STATE_CRC2:
-    {
-      //Serial.printf("CRC2 0x%02x\n", *data);
-      spiCrc2_ = *data;
-      data++;
-
-      uint16_t crc = (uint16_t)spiCrc2_ << 8 | (uint16_t)spiCrc1_;
-      //Serial.printf("CRC = 0x%04x\n", crc);
-      if (spiCrc_ != crc) {
-        //Serial.printf("CRC Check Error 0x%04x != 0x%04x\n", spiCrc_, crc);
-        spiState_ = SPI_STATE_SYNC1;
-        spiResponseFlag_ = SPI_RSP_ERROR;
-        break;
-      }
+  if (cmd == SPI_CMD_LINK_TEST) {
+    // Only the CRC is checked.
+    return (size <= sizeof(spiLinkTestBuffer_))? spiLinkTestBuffer_ : nullptr;
+  }
 
-      switch (spiCmd_)
-      {
-      case SPI_CMD_GET_STATUS:
-        //Serial.printf("run command SPI_CMD_GET_STATUS\n");
-        spiResponseFlag_ = SPI_RSP_GET_STATUS;
-        break;
-      case SPI_CMD_START_FRAME:
-        //Serial.printf("run command SPI_CMD_START_FRAME\n");
-        wrBufferPtr_   = buffer_.getWriteBufferPtr();
-        wrBufferAvail_ = BUFFER_SIZE;
-        break;
-      case SPI_CMD_PING:
-        //Serial.printf("run command SPI_CMD_PING\n");
-        spiResponseFlag_ = SPI_RSP_PING;
-        break;
-      case SPI_CMD_OB_LED_ON:
-        //Serial.printf("run command SPI_CMD_OB_LED_ON\n");
-        ob_led_on_ = true;
-        break;
-      case SPI_CMD_OB_LED_OFF:
-        //Serial.printf("run command SPI_CMD_OB_LED_OFF\n");
-        ob_led_on_ = false;
-        break;
-      case SPI_CMD_SET_ID_DIR0:
-        //Serial.printf("run command SPI_CMD_SET_ID_DIR0\n");
-        ssd1306mpio_.setIdDir(false);
-        break;
-      case SPI_CMD_SET_ID_DIR1:
-        //Serial.printf("run command SPI_CMD_SET_ID_DIR1\n");
-        ssd1306mpio_.setIdDir(true);
-        break;
-      case SPI_CMD_HARD_RESET:
-        //Serial.printf("run command SPI_CMD_HARD_RESET\n");
-        watchdog_enable(1, 1);
-        while(1);
-        break;
-      default: break;
-      }
+  if (cmd == SPI_CMD_SCROLL_PAGES) {
+    // Whole records, the previous ones written. No layer on the grayscale.
+    if (!CvDefaultGeometry::SSD1306_SCROLL || grayPlanes_ > 1 || scrollPending_ > 0) return nullptr;
+    return ((size % SCROLL_RECORD_SIZE) == 0 && size <= sizeof(scrollBuffer_))? scrollBuffer_ : nullptr;
+  }
 
-      spiState_ = SPI_STATE_SYNC1;
+  bool upload = (cmd == SPI_CMD_UPLOAD_ASSET);
+  size_t maxSize = (upload)? sizeof(spriteAssetBuffer_) : sizeof(spriteListTmpBuffer_);
+  if (size > maxSize || (upload && spriteAssetPending_ > 0)) {
+    // Too large, or the previous asset is not stored yet.
+    return nullptr;
+  }
+  return (upload)? spriteAssetBuffer_ : spriteListTmpBuffer_;
+}
+
+void __time_critical_func(spiCommandHook)(void * context, uint8_t cmd, size_t size)
+{
+  UNUSED_VAR(context);
 
-      break;
+  switch (cmd)
+  {
+  case SPI_CMD_GET_STATUS:
+    //Serial.printf("run command SPI_CMD_GET_STATUS\n");
+    spiResponseFlag_ = SPI_RSP_GET_STATUS;
+    break;
+  case SPI_CMD_START_FRAME:
+    //Serial.printf("run command SPI_CMD_START_FRAME\n");
+    spiReceiver_.restartFrame();
+    if (buffer_.getWriteReady()) {
+      spriteListSize_[buffer_.getWriteIndex()] = 0;
+    }
+    break;
+  case SPI_CMD_UPLOAD_ASSET:
+    //Serial.printf("run command SPI_CMD_UPLOAD_ASSET\n");
+    // Stored on core0 loop.
+    spriteAssetPending_ = size;
+    break;
+  case SPI_CMD_DRAW_SPRITES:
+    //Serial.printf("run command SPI_CMD_DRAW_SPRITES\n");
+    if (buffer_.getWriteReady()) {
+      int slot = buffer_.getWriteIndex();
+      memcpy(spriteListBuffer_[slot], spriteListTmpBuffer_, size);
+      spriteListSize_[slot] = size;
+      // The LRU of the cache in the command order. (no upload on the way, the
+      // controller waits for the store)
+      spriteCache_.touch(spriteListTmpBuffer_, size);
+      if (spriteListTmpBuffer_[1] & SPRITE_LIST_FLAG_CLEAR) {
+        // Sprites only frame, commit without frame data.
+        memset(buffer_.getWriteBufferPtr(), 0, BUFFER_SIZE * grayPlanes_);
+        buffer_.nextWriteBuffer();
+        spiReceiver_.restartFrame();
+        spriteFrames_++;
+      }
     }
-    default:
-      spiState_ = SPI_STATE_SYNC1;
-      break;
+    break;
+  case SPI_CMD_CLEAR_ASSETS:
+    //Serial.printf("run command SPI_CMD_CLEAR_ASSETS\n");
+    spriteClearRequest_ = true;
+    break;
+  case SPI_CMD_PRESENT:
+  {
+    //Serial.printf("run command SPI_CMD_PRESENT\n");
+    uint8_t on = spiReceiver_.option(0);
+    presents_++;
+    uint32_t staged = spiReceiver_.stats()->frames_ + spriteFrames_;
+    uint32_t now = micros();
+    if (presentMode_ && staged == presentedFrames_ && scrollStaged_ == 0) presentMissed_++;
+    if (scrollStaged_ != 0) {
+      scrollRequest_ = scrollStaged_;
+      scrollStaged_ = 0;
     }
-
-    if (data >= dataend) {
-      break;
+    // The slots staged since the last PRESENT, at most all of them.
+    uint32_t first = (staged - presentedFrames_ > CIRCULAR_BUFFER_NUM)? staged - CIRCULAR_BUFFER_NUM : presentedFrames_;
+    for (uint32_t frame = first; frame != staged; frame++) {
+      presentAtUs_[frame % CIRCULAR_BUFFER_NUM] = now;
+      presentSeqAt_[frame % CIRCULAR_BUFFER_NUM] = presents_;
+    }
+    presentedFrames_ = staged;
+    presentMode_ = (on != 0);
+    spans_.mark(SPAN_PRESENT_RX, presents_);
+  } break;
+  case SPI_CMD_SET_GRAY:
+    //Serial.printf("run command SPI_CMD_SET_GRAY\n");
+    // Applied on core1, busy until then.
+    grayRequest_ = 0x10000u | (uint32_t)spiReceiver_.option(1) << 8 | spiReceiver_.option(0);
+    break;
+  case SPI_CMD_SCROLL_PAGES:
+    //Serial.printf("run command SPI_CMD_SCROLL_PAGES\n");
+    // Written on core1, busy until then.
+    scrollPending_ = size / SCROLL_RECORD_SIZE;
+    break;
+  case SPI_CMD_SCROLL:
+  {
+    //Serial.printf("run command SPI_CMD_SCROLL\n");
+    uint32_t request = 0x10000u | (uint32_t)spiReceiver_.option(1) << 8 | spiReceiver_.option(0);
+    if (presentMode_) scrollStaged_ = request;
+    else              scrollRequest_ = request;
+  } break;
+  case SPI_CMD_GET_PRESENT_STATS:
+    //Serial.printf("run command SPI_CMD_GET_PRESENT_STATS\n");
+    spiResponseFlag_ = SPI_RSP_PRESENT_STATS;
+    break;
+  case SPI_CMD_SPANS:
+  {
+    //Serial.printf("run command SPI_CMD_SPANS\n");
+    // The sync is at the receive of the command, the controller marks the
+    // end of its transfer.
+    uint8_t op = spiReceiver_.option(0);
+    uint16_t seq = (uint16_t)((op >> 4) << 8 | spiReceiver_.option(1));
+    switch (op & 0x0F) {
+    case SPI_SPANS_STOP:  spans_.stop(); break;
+    case SPI_SPANS_START: spans_.start(); break;
+    case SPI_SPANS_SYNC:  spans_.mark(SPAN_SYNC, seq); break;
+    default: break;
     }
+  } break;
+  case SPI_CMD_GET_SPANS:
+    //Serial.printf("run command SPI_CMD_GET_SPANS\n");
+    spanRequest_ = (uint16_t)(spiReceiver_.option(1) << 8 | spiReceiver_.option(0));
+    spiResponseFlag_ = SPI_RSP_SPANS;
+    break;
+  case SPI_CMD_PING:
+    //Serial.printf("run command SPI_CMD_PING\n");
+    spiResponseFlag_ = SPI_RSP_PING;
+    break;
+  case SPI_CMD_LINK_TEST:
+    //Serial.printf("run command SPI_CMD_LINK_TEST\n");
+    // The test pattern came with a valid CRC, answered as a ping.
+    spiResponseFlag_ = SPI_RSP_PING;
+    break;
+  case SPI_CMD_OB_LED_ON:
+    //Serial.printf("run command SPI_CMD_OB_LED_ON\n");
+    ob_led_on_ = true;
+    break;
+  case SPI_CMD_OB_LED_OFF:
+    //Serial.printf("run command SPI_CMD_OB_LED_OFF\n");
+    ob_led_on_ = false;
+    break;
+  case SPI_CMD_SET_ID_DIR0:
+    //Serial.printf("run command SPI_CMD_SET_ID_DIR0\n");
+    ssd1306mpio_.setIdDir(false);
+    break;
+  case SPI_CMD_SET_ID_DIR1:
+    //Serial.printf("run command SPI_CMD_SET_ID_DIR1\n");
+    ssd1306mpio_.setIdDir(true);
+    break;
+  case SPI_CMD_HARD_RESET:
+    //Serial.printf("run command SPI_CMD_HARD_RESET\n");
+    watchdog_enable(1, 1);
+    while(1);
+    break;
+  default: break;
   }
-  
-  //digitalWrite(22, LOW);
+}
+
+void __time_critical_func(spiErrorHook)(void * context, spirx_error_t error)
+{
+  UNUSED_VAR(context);
+  UNUSED_VAR(error);
+
+  spiResponseFlag_ = SPI_RSP_ERROR;
+  spiErrorFlag_ = true;
+  scrollLost_ = true;
+  spiErrors_++;
 }
 
 //void spiSentIrqCallback()
@@ -595,28 +940,75 @@ void __time_critical_func(spiSentIrqCallback)()
 {
   //Serial.printf("tx\n");
 
+  size_t size = 1;
   switch (spiResponseFlag_)
   {
   case SPI_RSP_GET_STATUS:
   {
-    uint8_t spibusy = (!buffer_.getWriteReady())? SPI_RSP_DATA_BUSY : 0x00;
-    spiTxBuffer_ = SPI_TXDATA_VALID_FLAG | ((spibusy) & 0x7F);
+    bool scrolling = (scrollPending_ > 0 || scrollRequest_ != 0);
+    uint8_t spibusy = (!buffer_.getWriteReady() || spriteAssetPending_ > 0 || spriteClearRequest_ || grayRequest_ != 0 || scrolling)? SPI_RSP_DATA_BUSY : 0x00;
+    uint8_t spiscroll = (scrollMiss_)? SPI_RSP_DATA_SCROLL_MISS : 0x00;
+    uint8_t spimiss = (spriteMiss_)? SPI_RSP_DATA_ASSET_MISS : 0x00;
+    uint8_t spierror = (spiErrorFlag_)? SPI_RSP_DATA_ERROR : 0x00;
+    int held = (grayHeld_)? 1 : 0;
+    // The scroll pages are written before the PRESENT, all the bridges
+    // flip the start line at once.
+    bool showing = (int32_t)(presentedFrames_ - pushedFrames_) > held || scrolling;
+    uint8_t spishowing = (presentMode_ && showing)? SPI_RSP_DATA_SHOWING : 0x00;
+    spriteMiss_ = false;
+    spiErrorFlag_ = false;
+    scrollMiss_ = false;
+    spiTxBuffer_[0] = SPI_TXDATA_VALID_FLAG | ((spibusy | spimiss | spierror | spishowing | spiscroll) & 0x7F);
   } break;
   case SPI_RSP_PING:
   {
-    spiTxBuffer_ = SPI_TXDATA_VALID_FLAG | ((SPI_RSP_DATA_PING) & 0x7F);
+    spiTxBuffer_[0] = SPI_TXDATA_VALID_FLAG | ((SPI_RSP_DATA_PING) & 0x7F);
   } break;
   case SPI_RSP_ERROR:
   {
-    spiTxBuffer_ = SPI_TXDATA_VALID_FLAG | ((SPI_RSP_DATA_ERROR) & 0x7F);
+    spiTxBuffer_[0] = SPI_TXDATA_VALID_FLAG | ((SPI_RSP_DATA_ERROR) & 0x7F);
+  } break;
+  case SPI_RSP_PRESENT_STATS:
+  {
+    // The flag, then the stats. (u16 presents, missed, pushed, latency, max latency)
+    uint16_t values[SPI_PRESENT_STATS_SIZE / 2] = {
+      presents_, presentMissed_, presentPushed_, presentLatencyUs_, presentLatencyMaxUs_
+    };
+    spiTxBuffer_[0] = SPI_TXDATA_VALID_FLAG | ((SPI_RSP_DATA_STATS) & 0x7F);
+    for (int i = 0; i < SPI_PRESENT_STATS_SIZE / 2; i++) {
+      spiTxBuffer_[1 + i * 2 + 0] = (uint8_t)(values[i] >> 0);
+      spiTxBuffer_[1 + i * 2 + 1] = (uint8_t)(values[i] >> 8);
+    }
+    presentLatencyMaxUs_ = 0;
+    size = 1 + SPI_PRESENT_STATS_SIZE;
+  } break;
+  case SPI_RSP_SPANS:
+  {
+    // The flag, then u16 events, u16 overwritten of the core and the events
+    // from the index. (zero past the last one)
+    int core = spanRequest_ >> 15;
+    uint32_t index = spanRequest_ & 0x7FFF;
+    uint32_t overwritten = MIN(spans_.overwritten(core), 0xFFFFu);
+    uint16_t count = (uint16_t)spans_.count(core);
+    spiTxBuffer_[0] = SPI_TXDATA_VALID_FLAG | ((SPI_RSP_DATA_STATS) & 0x7F);
+    spiTxBuffer_[1] = (uint8_t)(count >> 0);
+    spiTxBuffer_[2] = (uint8_t)(count >> 8);
+    spiTxBuffer_[3] = (uint8_t)(overwritten >> 0);
+    spiTxBuffer_[4] = (uint8_t)(overwritten >> 8);
+    for (int i = 0; i < SPAN_BLOCK_EVENTS; i++) {
+      span_event_t event;
+      if (!spans_.get(core, index + i, &event)) memset(&event, 0, sizeof(event));
+      SpanTrace::pack(&event, &spiTxBuffer_[5 + i * SPAN_EVENT_SIZE]);
+    }
+    size = 1 + SPI_SPAN_BLOCK_SIZE;
   } break;
   case SPI_RSP_NONE:
   default:
-    spiTxBuffer_ = 0;
+    spiTxBuffer_[0] = 0;
     break;
   }
   spiResponseFlag_ = SPI_RSP_NONE;
 
-  //Serial.printf("  %02x\n", spiTxBuffer_);
-  SPISlave.setData((uint8_t*)&spiTxBuffer_, sizeof(spiTxBuffer_));
+  //Serial.printf("  %02x\n", spiTxBuffer_[0]);
+  SPISlave.setData(spiTxBuffer_, size);
 }
@@ -0,0 +1,311 @@
+/**********************************************************************/
+/**
+ * @brief  SPI Command Receiver (Bridge Side Parser)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+#include "spi_receiver.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef __time_critical_func
+#define __time_critical_func(x) x
+#endif
+
+static uint16_t   crc16_lu_table[256];
+static bool       crc16_lu_table_ready = false;
+static const uint16_t crc16_polynomial = 0x1021;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static void
+calc_crc16_lookup_table(void)
+{
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t crc = i << 8;
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x8000) crc = (crc << 1) ^ crc16_polynomial;
+            else              crc <<= 1;
+        }
+        crc16_lu_table[i] = crc;
+    }
+    crc16_lu_table_ready = true;
+}
+
+static inline uint16_t
+calc_crc16(uint16_t crc, uint8_t data)
+{
+    return (uint16_t)((crc << 8) ^ crc16_lu_table[((crc >> 8) ^ data) & 0xFF]);
+}
+
+SpiReceiver::SpiReceiver()
+{
+    memset(&hooks_, 0, sizeof(hooks_));
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+SpiReceiver::~SpiReceiver()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+SpiReceiver::init(CircularBuffer * buffer, size_t frameSize, const spirx_hooks_t * hooks)
+{
+    if (!crc16_lu_table_ready) calc_crc16_lookup_table();
+    buffer_ = buffer;
+    frameSize_ = frameSize;
+    hooks_ = *hooks;
+    reset();
+}
+
+void
+SpiReceiver::reset(void)
+{
+    state_ = STATE_SYNC1;
+    remain_ = 0;
+    memset(&stats_, 0, sizeof(stats_));
+    restartFrame();
+}
+
+void
+SpiReceiver::restartFrame(void)
+{
+    wrPtr_ = buffer_->getWriteBufferPtr();
+    wrAvail_ = frameSize_;
+}
+
+void
+SpiReceiver::setFrameSize(size_t frameSize)
+{
+    frameSize_ = frameSize;
+    restartFrame();
+}
+
+uint16_t
+SpiReceiver::crc16(const uint8_t * data, size_t size, uint16_t crc)
+{
+    if (!crc16_lu_table_ready) calc_crc16_lookup_table();
+    for (size_t i = 0; i < size; i++) {
+        crc = calc_crc16(crc, data[i]);
+    }
+    return crc;
+}
+
+void
+__time_critical_func(SpiReceiver::receive)(const uint8_t * data, size_t len)
+{
+    const uint8_t * dataend = data + len;
+    stats_.bytes_ += len;
+
+    while (data < dataend) {
+        switch (state_) {
+        case STATE_SYNC1:
+            if (*data++ == SPI_SYNC1) state_ = STATE_SYNC2;
+            break;
+        case STATE_SYNC2:
+        {
+            // "AA AA 55", the second SYNC1 may be the start.
+            uint8_t c = *data++;
+            state_ = (c == SPI_SYNC2)? STATE_CMD : (c == SPI_SYNC1)? STATE_SYNC2 : STATE_SYNC1;
+        } break;
+        case STATE_CMD:
+            cmd_ = *data++;
+            switch (cmd_) {
+            case SPI_CMD_NONE        :
+            case SPI_CMD_GET_STATUS  :
+            case SPI_CMD_START_FRAME :
+            case SPI_CMD_SET_DATA    :
+            case SPI_CMD_PING        :
+            case SPI_CMD_OB_LED_ON   :
+            case SPI_CMD_OB_LED_OFF  :
+            case SPI_CMD_SET_ID_DIR0 :
+            case SPI_CMD_SET_ID_DIR1 :
+            case SPI_CMD_UPLOAD_ASSET:
+            case SPI_CMD_DRAW_SPRITES:
+            case SPI_CMD_CLEAR_ASSETS:
+            case SPI_CMD_LINK_TEST   :
+            case SPI_CMD_PRESENT     :
+            case SPI_CMD_GET_PRESENT_STATS :
+            case SPI_CMD_SET_GRAY    :
+            case SPI_CMD_SCROLL_PAGES:
+            case SPI_CMD_SCROLL      :
+            case SPI_CMD_SPANS       :
+            case SPI_CMD_GET_SPANS   :
+            case SPI_CMD_HARD_RESET  :
+                crc_ = 0xFFFF;
+                crc_ = calc_crc16(crc_, SPI_SYNC1);
+                crc_ = calc_crc16(crc_, SPI_SYNC2);
+                crc_ = calc_crc16(crc_, cmd_);
+                state_ = STATE_OPT1;
+                break;
+            default:
+                error(SPIRX_ERROR_COMMAND);
+                break;
+            }
+            break;
+        case STATE_OPT1:
+        case STATE_OPT2:
+        case STATE_OPT3:
+            opt_[state_ - STATE_OPT1] = *data;
+            crc_ = calc_crc16(crc_, *data++);
+            state_ = (state_t)(state_ + 1);
+            break;
+        case STATE_OPT4:
+            opt_[3] = *data;
+            crc_ = calc_crc16(crc_, *data++);
+            if (opt_[0] != (uint8_t)~opt_[2] || opt_[1] != (uint8_t)~opt_[3]) {
+                error(SPIRX_ERROR_HEADER);
+            } else {
+                header();
+            }
+            break;
+        case STATE_BODY:
+        case STATE_SKIP:
+        {
+            // The bulk of the traffic, one pass for the copy and the CRC.
+            size_t n = (size_t)(dataend - data);
+            if (n > remain_) n = remain_;
+            uint16_t crc = crc_;
+            if (state_ == STATE_BODY) {
+                uint8_t * dst = dst_;
+                for (size_t i = 0; i < n; i++) {
+                    uint8_t c = data[i];
+                    dst[i] = c;
+                    crc = calc_crc16(crc, c);
+                }
+                dst_ += n;
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    crc = calc_crc16(crc, data[i]);
+                }
+            }
+            crc_ = crc;
+            data += n;
+            remain_ -= n;
+            if (remain_ == 0) state_ = STATE_CRC1;
+        } break;
+        case STATE_CRC1:
+            crcL_ = *data++;
+            state_ = STATE_CRC2;
+            break;
+        case STATE_CRC2:
+        {
+            uint16_t crc = (uint16_t)*data++ << 8 | (uint16_t)crcL_;
+            if (crc != crc_) {
+                error(SPIRX_ERROR_CRC);
+            } else if (skip_) {
+                error(skipError_);
+            } else {
+                state_ = STATE_SYNC1;
+                finish();
+            }
+        } break;
+        default:
+            state_ = STATE_SYNC1;
+            break;
+        }
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - Private
+ *----------------------------------------------------------------------
+ */
+
+// After a valid header, where the body goes.
+void
+SpiReceiver::header(void)
+{
+    size_ = (size_t)opt_[1] << 8 | (size_t)opt_[0];
+    dst_ = nullptr;
+    skip_ = false;
+    remain_ = size_;
+
+    switch (cmd_) {
+    case SPI_CMD_SET_DATA:
+        if (size_ == 0 || size_ > wrAvail_) {
+            error(SPIRX_ERROR_SIZE);
+        } else if (!buffer_->getWriteReady()) {
+            // The slot is in the I2C transfer standby, do not touch it.
+            discard(SPIRX_ERROR_OVERFLOW);
+        } else {
+            dst_ = wrPtr_;
+            state_ = STATE_BODY;
+        }
+        break;
+    case SPI_CMD_UPLOAD_ASSET:
+    case SPI_CMD_DRAW_SPRITES:
+    case SPI_CMD_LINK_TEST:
+    case SPI_CMD_SCROLL_PAGES:
+        if (size_ > 0 && hooks_.payload_ != nullptr) {
+            dst_ = hooks_.payload_(hooks_.context_, cmd_, size_);
+        }
+        if (dst_ == nullptr) {
+            error(SPIRX_ERROR_SIZE);
+        } else {
+            state_ = STATE_BODY;
+        }
+        break;
+    default:
+        // No body, the OPTs are parameters.
+        size_ = 0;
+        remain_ = 0;
+        state_ = STATE_CRC1;
+        break;
+    }
+}
+
+// Consume the body by its size, then report the error after the CRC.
+// (the header and the size are valid, only the target is busy)
+void
+SpiReceiver::discard(spirx_error_t error)
+{
+    skip_ = true;
+    skipError_ = error;
+    state_ = (remain_ > 0)? STATE_SKIP : STATE_CRC1;
+}
+
+void
+SpiReceiver::finish(void)
+{
+    stats_.commands_++;
+    if (cmd_ == SPI_CMD_SET_DATA) {
+        wrPtr_ += size_;
+        wrAvail_ -= size_;
+        if (wrAvail_ == 0) {
+            buffer_->nextWriteBuffer();
+            stats_.frames_++;
+            restartFrame();
+        }
+    }
+    if (hooks_.command_ != nullptr) hooks_.command_(hooks_.context_, cmd_, size_);
+}
+
+void
+SpiReceiver::error(spirx_error_t error)
+{
+    stats_.errors_[error]++;
+    state_ = STATE_SYNC1;
+    if (hooks_.error_ != nullptr) hooks_.error_(hooks_.context_, error);
+}
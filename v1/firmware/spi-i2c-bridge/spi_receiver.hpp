@@ -0,0 +1,176 @@
+/**********************************************************************/
+/**
+ * @brief  SPI Command Receiver (Bridge Side Parser)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+#include "circular_buffer.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Commands from the controller (spi_i2c_bridge.cpp), in any split :
+//   SYNC1 SYNC2 CMD OPT1 OPT2 ~OPT1 ~OPT2 [BODY] CRC_L CRC_H
+//   CRC16-CCITT (0x1021, init 0xFFFF) from SYNC1 to the end of BODY.
+//
+// SET_DATA     : BODY is OPT2:OPT1 bytes of the frame, written straight to
+//                the circular buffer write slot. The slot is committed when
+//                it is full and the CRC is valid.
+// UPLOAD_ASSET,
+// DRAW_SPRITES,
+// LINK_TEST,
+// SCROLL_PAGES : BODY is OPT2:OPT1 bytes to the payload hook target.
+// PRESENT      : the staged (committed) slots may start the I2C transfer,
+//                OPT1 0 : no more PRESENT, the slots start when committed.
+// SET_GRAY     : OPT1 bit planes (1 : monochrome) and contrast steps << 4,
+//                OPT2 slot period in 100 us. A frame (a slot) is the planes
+//                in a row, the staged slots are dropped. (setFrameSize())
+// SCROLL       : OPT2:OPT1 the row of the scroll layer to show by the start
+//                line, at the next PRESENT in the present mode. The pages
+//                of the rows are loaded before by SCROLL_PAGES.
+// SPANS        : OPT1 bits 0-3 0 : stop, 1 : start, 2 : sync, the span trace
+//                (span_trace.hpp). A sync has the sequence OPT1 bits 4-7 :
+//                OPT2, marked at the receive.
+// GET_SPANS    : OPT2:OPT1 the index of the events, the core << 15.
+//
+// A SET_DATA without a free slot is consumed by its size and dropped, so
+// the pixels are not scanned for a sync. A body refused for its size (or
+// no payload target) is an error and resyncs at once. Called in the
+// interrupt, no blocking in the hooks.
+
+static const int SPI_CMD_NONE        = 0x00;
+static const int SPI_CMD_GET_STATUS  = 0x01;
+static const int SPI_CMD_START_FRAME = 0x02;
+static const int SPI_CMD_SET_DATA    = 0x03;
+static const int SPI_CMD_PING        = 0x04;
+static const int SPI_CMD_OB_LED_ON   = 0x05;
+static const int SPI_CMD_OB_LED_OFF  = 0x06;
+static const int SPI_CMD_SET_ID_DIR0 = 0x07;
+static const int SPI_CMD_SET_ID_DIR1 = 0x08;
+static const int SPI_CMD_UPLOAD_ASSET = 0x09;
+static const int SPI_CMD_DRAW_SPRITES = 0x0A;
+static const int SPI_CMD_CLEAR_ASSETS = 0x0B;
+static const int SPI_CMD_LINK_TEST   = 0x0C;
+static const int SPI_CMD_PRESENT     = 0x0D;
+static const int SPI_CMD_GET_PRESENT_STATS = 0x0E;
+static const int SPI_CMD_SET_GRAY    = 0x0F;
+static const int SPI_CMD_SCROLL_PAGES = 0x10;
+static const int SPI_CMD_SCROLL      = 0x11;
+static const int SPI_CMD_SPANS       = 0x12;
+static const int SPI_CMD_GET_SPANS   = 0x13;
+static const int SPI_CMD_HARD_RESET  = 0xFE;
+
+static const int SPI_SYNC1 = 0xAA;
+static const int SPI_SYNC2 = 0x55;
+
+typedef enum spirx_error_ {
+    SPIRX_ERROR_COMMAND = 0,    // Unknown command
+    SPIRX_ERROR_HEADER,         // OPT parity
+    SPIRX_ERROR_SIZE,           // Body size, or no payload target
+    SPIRX_ERROR_OVERFLOW,       // SET_DATA without a free slot, discarded
+    SPIRX_ERROR_CRC,
+    SPIRX_ERRORS,
+} spirx_error_t;
+
+// Payload target of UPLOAD_ASSET / DRAW_SPRITES / SCROLL_PAGES, nullptr to refuse.
+typedef uint8_t * (*spirx_payload_t)(void * context, uint8_t cmd, size_t size);
+// A command with a valid CRC. size : the body size.
+typedef void (*spirx_command_t)(void * context, uint8_t cmd, size_t size);
+typedef void (*spirx_error_hook_t)(void * context, spirx_error_t error);
+
+typedef struct spirx_hooks_ {
+    void * context_;
+    spirx_payload_t payload_;
+    spirx_command_t command_;
+    spirx_error_hook_t error_;
+} spirx_hooks_t;
+
+typedef struct spirx_stats_ {
+    uint32_t bytes_;
+    uint32_t commands_;
+    uint32_t frames_;           // Committed slots
+    uint32_t errors_[SPIRX_ERRORS];
+} spirx_stats_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class SpiReceiver
+{
+public:
+    explicit SpiReceiver();
+    virtual ~SpiReceiver();
+
+public:
+    void init(CircularBuffer * buffer, size_t frameSize, const spirx_hooks_t * hooks);
+    void reset(void);
+    void receive(const uint8_t * data, size_t len);
+
+    // SET_DATA from the start of the write slot. (START_FRAME, sprite only frame)
+    void restartFrame(void);
+    // The slot size changed, on core1 with the interrupts disabled.
+    void setFrameSize(size_t frameSize);
+
+public:
+    bool idle(void) const { return state_ == STATE_SYNC1; }
+    // OPT1 / OPT2 of the last command, the parameters of a command with no body.
+    uint8_t option(int i) const { return opt_[i & 1]; }
+    const spirx_stats_t * stats(void) const { return &stats_; }
+
+public:
+    static uint16_t crc16(const uint8_t * data, size_t size, uint16_t crc = 0xFFFF);
+
+private:
+    void header(void);
+    void discard(spirx_error_t error);
+    void finish(void);
+    void error(spirx_error_t error);
+
+private:
+    typedef enum state_ {
+        STATE_SYNC1 = 0,
+        STATE_SYNC2,
+        STATE_CMD,
+        STATE_OPT1,
+        STATE_OPT2,
+        STATE_OPT3,
+        STATE_OPT4,
+        STATE_BODY,
+        STATE_SKIP,
+        STATE_CRC1,
+        STATE_CRC2,
+    } state_t;
+
+    state_t state_ = STATE_SYNC1;
+    uint8_t cmd_ = 0;
+    uint8_t opt_[4];
+    uint16_t crc_ = 0xFFFF;
+    uint8_t crcL_ = 0;
+
+    uint8_t * dst_ = nullptr;   // Body
+    size_t remain_ = 0;
+    size_t size_ = 0;
+    bool skip_ = false;
+    spirx_error_t skipError_ = SPIRX_ERROR_SIZE;
+
+    CircularBuffer * buffer_ = nullptr;
+    size_t frameSize_ = 0;
+    uint8_t * wrPtr_ = nullptr;
+    size_t wrAvail_ = 0;
+
+    spirx_hooks_t hooks_;
+    spirx_stats_t stats_;
+};
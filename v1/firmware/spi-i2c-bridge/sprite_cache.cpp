@@ -0,0 +1,348 @@
+/**********************************************************************/
+/**
+ * @brief  Sprite Cache (Bridge Resident Assets)
+ * @author naoa
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstring>
+
+#include "sprite_cache.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef MIN
+#define MIN(x,y)        (((x) <= (y))? (x) : (y))
+#endif
+
+#ifndef MAX
+#define MAX(x,y)        (((x) >= (y))? (x) : (y))
+#endif
+
+static inline uint16_t get_u16(const uint8_t * p)
+{
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+// Get `count` (<= 8) bits from LSB first packed row at bit index i.
+static inline uint8_t get_bits(const uint8_t * row, int stride, int i, int count)
+{
+    int byte = i >> 3;
+    uint16_t v = row[byte];
+    if (byte + 1 < stride) v |= (uint16_t)row[byte + 1] << 8;
+    return (uint8_t)((v >> (i & 7)) & ((1u << count) - 1));
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+SpriteCache::SpriteCache()
+{
+    clear();
+}
+
+SpriteCache::~SpriteCache()
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+SpriteCache::init(uint8_t * arena, size_t size, int panelWidth, int panelHeight)
+{
+    arena_ = arena;
+    arenaSize_ = size;
+    panelWidth_ = panelWidth;
+    panelHeight_ = panelHeight;
+    panelBytes_ = (panelWidth * panelHeight) / 8;
+    clear();
+}
+
+void
+SpriteCache::clear(void)
+{
+    memset((void*)entries_, 0, sizeof(entries_));
+    memset((void*)index_, 0xFF, sizeof(index_));
+    count_ = 0;
+    used_ = 0;
+    useCounter_ = 0;
+}
+
+// Store an uploaded asset (SPI_CMD_UPLOAD_ASSET payload), evict least recently used assets if required.
+bool
+SpriteCache::store(const uint8_t * payload, size_t size)
+{
+    if (size < SPRITE_ASSET_HEADER_SIZE) return false;
+
+    uint16_t handle = get_u16(payload + 0);
+    uint16_t width  = get_u16(payload + 2);
+    uint16_t height = get_u16(payload + 4);
+    uint8_t  flags  = payload[6];
+
+    if (handle >= SPRITE_MAX_HANDLES) return false;
+    if (width == 0 || width > SPRITE_MAX_WIDTH || height == 0 || height > SPRITE_MAX_HEIGHT) return false;
+    if (size != (size_t)sprite_asset_size(width, height, (flags & SPRITE_FLAG_ALPHA) != 0)) return false;
+    if (size > arenaSize_) return false;
+
+    // Replace the old one.
+    if (index_[handle] >= 0) {
+        remove(index_[handle]);
+    }
+
+    while (count_ >= SPRITE_CACHE_MAX_ENTRIES) {
+        evictLRU();
+    }
+
+    uint32_t offset;
+    if (!allocate(size, &offset)) return false;
+
+    int i = 0;
+    while (entries_[i].used_) i++;
+
+    entry_t * entry = &entries_[i];
+    entry->used_    = true;
+    entry->handle_  = handle;
+    entry->width_   = width;
+    entry->height_  = height;
+    entry->flags_   = flags;
+    entry->offset_  = offset;
+    entry->size_    = size;
+    entry->lastUse_ = ++useCounter_;
+    memcpy(arena_ + offset, payload, size);
+
+    index_[handle] = i;
+    count_++;
+    used_ += size;
+    return true;
+}
+
+// The assets of a list (SPI_CMD_DRAW_SPRITES payload) are used, at its receive.
+// Not at the compose, that runs a frame later or more, after the uploads of
+// the next frames.
+void
+SpriteCache::touch(const uint8_t * list, size_t size)
+{
+    if (size < SPRITE_LIST_HEADER_SIZE) return;
+
+    int count = list[2];
+    if (count > SPRITE_MAX_INSTANCES) return;
+    if (size < (size_t)(SPRITE_LIST_HEADER_SIZE + (count * 6))) return;
+
+    const uint8_t * p = list + SPRITE_LIST_HEADER_SIZE;
+    for (int i = 0; i < count; i++, p += 6) {
+        uint16_t handle = get_u16(p + 0);
+        if (handle >= SPRITE_MAX_HANDLES || index_[handle] < 0) continue;
+        entries_[index_[handle]].lastUse_ = ++useCounter_;
+    }
+}
+
+// Composite sprite instances (SPI_CMD_DRAW_SPRITES payload) into the frame. Returns false if an asset is missing.
+bool
+SpriteCache::compose(uint8_t * frame, int panels, const uint8_t * list, size_t size)
+{
+    if (size < SPRITE_LIST_HEADER_SIZE) return true;
+
+    int panelBase = list[0];
+    int count     = list[2];
+    int distance  = get_u16(list + 4);
+    int vwidth    = get_u16(list + 6);
+
+    if (count > SPRITE_MAX_INSTANCES) return true;
+    if (size < (size_t)(SPRITE_LIST_HEADER_SIZE + (count * 6))) return true;
+    if (distance < panelWidth_ || vwidth <= 0) return true;
+
+    bool found = true;
+    const uint8_t * p = list + SPRITE_LIST_HEADER_SIZE;
+    for (int i = 0; i < count; i++, p += 6) {
+        uint16_t handle = get_u16(p + 0);
+        int x = (int16_t)get_u16(p + 2);
+        int y = (int16_t)get_u16(p + 4);
+        const entry_t * entry = find(handle);
+        if (entry == nullptr) {
+            found = false;
+            continue;
+        }
+        composeOne(frame, panels, panelBase, distance, vwidth, entry, x, y);
+    }
+    return found;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+// No use here, the list was used at its receive. (touch())
+const SpriteCache::entry_t *
+SpriteCache::find(uint16_t handle) const
+{
+    if (handle >= SPRITE_MAX_HANDLES) return nullptr;
+    int i = index_[handle];
+    if (i < 0) return nullptr;
+    return &entries_[i];
+}
+
+bool
+SpriteCache::allocate(size_t size, uint32_t * offset)
+{
+    while (1) {
+        if (findGap(size, offset)) return true;
+        if (arenaSize_ - used_ >= size) {
+            // Enough space, but fragmented.
+            compact();
+            continue;
+        }
+        if (count_ == 0) return false;
+        evictLRU();
+    }
+}
+
+bool
+SpriteCache::findGap(size_t size, uint32_t * offset)
+{
+    // Sort used entries by offset.
+    int order[SPRITE_CACHE_MAX_ENTRIES];
+    int n = 0;
+    for (int i = 0; i < SPRITE_CACHE_MAX_ENTRIES; i++) {
+        if (!entries_[i].used_) continue;
+        int j = n++;
+        while (j > 0 && entries_[order[j - 1]].offset_ > entries_[i].offset_) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    uint32_t pos = 0;
+    for (int k = 0; k < n; k++) {
+        const entry_t * entry = &entries_[order[k]];
+        if (entry->offset_ - pos >= size) {
+            *offset = pos;
+            return true;
+        }
+        pos = entry->offset_ + entry->size_;
+    }
+    if (arenaSize_ - pos >= size) {
+        *offset = pos;
+        return true;
+    }
+    return false;
+}
+
+void
+SpriteCache::evictLRU(void)
+{
+    int lru = -1;
+    for (int i = 0; i < SPRITE_CACHE_MAX_ENTRIES; i++) {
+        if (!entries_[i].used_) continue;
+        if (lru < 0 || entries_[i].lastUse_ < entries_[lru].lastUse_) lru = i;
+    }
+    if (lru >= 0) {
+        remove(lru);
+        evictions_++;
+    }
+}
+
+void
+SpriteCache::remove(int index)
+{
+    entry_t * entry = &entries_[index];
+    if (!entry->used_) return;
+    index_[entry->handle_] = -1;
+    used_ -= entry->size_;
+    count_--;
+    entry->used_ = false;
+}
+
+void
+SpriteCache::compact(void)
+{
+    uint32_t pos = 0;
+    while (1) {
+        // Move the lowest entry above pos down to pos.
+        int next = -1;
+        for (int i = 0; i < SPRITE_CACHE_MAX_ENTRIES; i++) {
+            if (!entries_[i].used_ || entries_[i].offset_ < pos) continue;
+            if (next < 0 || entries_[i].offset_ < entries_[next].offset_) next = i;
+        }
+        if (next < 0) break;
+        entry_t * entry = &entries_[next];
+        if (entry->offset_ != pos) {
+            memmove(arena_ + pos, arena_ + entry->offset_, entry->size_);
+            entry->offset_ = pos;
+        }
+        pos += entry->size_;
+    }
+}
+
+void
+SpriteCache::composeOne(
+    uint8_t * frame, int panels, int panelBase, int distance, int vwidth,
+    const entry_t * entry, int x0, int y0
+) {
+    int w = entry->width_;
+    int h = entry->height_;
+    int stride = sprite_stride(w);
+    const uint8_t * data  = arena_ + entry->offset_ + SPRITE_ASSET_HEADER_SIZE;
+    const uint8_t * alpha = (entry->flags_ & SPRITE_FLAG_ALPHA)? data + (stride * h) : nullptr;
+
+    int r0 = MAX(0, -y0);
+    int r1 = MIN(h, panelHeight_ - y0);
+    if (r0 >= r1) return;
+
+    for (int p = 0; p < panels; p++) {
+        // Sprite bit index at the panel local x = 0.
+        int d = (((panelBase + p) * distance) - x0) % vwidth;
+        if (d < 0) d += vwidth;
+
+        int i0, lx0, n;
+        if (d < w) {
+            i0  = d;
+            lx0 = 0;
+            n   = MIN(panelWidth_, w - d);
+        } else if (d + panelWidth_ > vwidth) {
+            // Sprite starts inside of this panel.
+            i0  = 0;
+            lx0 = vwidth - d;
+            n   = MIN(panelWidth_ - lx0, w);
+        } else {
+            continue;
+        }
+
+        uint8_t * panel = frame + (p * panelBytes_);
+        for (int r = r0; r < r1; r++) {
+            const uint8_t * srcrow   = data + (r * stride);
+            const uint8_t * alpharow = (alpha)? alpha + (r * stride) : nullptr;
+            uint8_t * column = panel + (y0 + r);
+
+            int lx = lx0;
+            int i = i0;
+            int remain = n;
+            while (remain > 0) {
+                int bit = lx & 7;
+                int cnt = MIN(8 - bit, remain);
+                uint8_t mask = (uint8_t)(((1u << cnt) - 1) << bit);
+                uint8_t src  = (uint8_t)(get_bits(srcrow, stride, i, cnt) << bit);
+                if (alpharow) {
+                    mask &= (uint8_t)(get_bits(alpharow, stride, i, cnt) << bit);
+                }
+                uint8_t * dst = column + ((lx >> 3) * panelHeight_);
+                *dst = (*dst & ~mask) | (src & mask);
+                lx += cnt;
+                i += cnt;
+                remain -= cnt;
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/**********************************************************************/
+/**
+ * @brief  Sprite Cache (Bridge Resident Assets)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstdbool>
+#include <cstddef>
+
+#include "sprite_format.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class SpriteCache
+{
+public:
+    typedef struct entry_ {
+        bool     used_;
+        uint16_t handle_;
+        uint16_t width_;
+        uint16_t height_;
+        uint8_t  flags_;
+        uint32_t offset_;
+        uint32_t size_;
+        uint32_t lastUse_;
+    } entry_t;
+
+public:
+    explicit SpriteCache();
+    virtual ~SpriteCache();
+
+public:
+    void init(uint8_t * arena, size_t size, int panelWidth, int panelHeight);
+    void clear(void);
+    bool store(const uint8_t * payload, size_t size);
+    void touch(const uint8_t * list, size_t size);
+    bool compose(uint8_t * frame, int panels, const uint8_t * list, size_t size);
+
+public:
+    int  count(void) const { return count_; }
+    int  evictions(void) const { return evictions_; }
+
+private:
+    const entry_t * find(uint16_t handle) const;
+    bool allocate(size_t size, uint32_t * offset);
+    bool findGap(size_t size, uint32_t * offset);
+    void evictLRU(void);
+    void remove(int index);
+    void compact(void);
+    void composeOne(uint8_t * frame, int panels, int panelBase, int distance, int vwidth,
+                    const entry_t * entry, int x0, int y0);
+
+private:
+    uint8_t * arena_ = nullptr;
+    size_t arenaSize_ = 0;
+    size_t used_ = 0;
+    int panelWidth_ = 0;
+    int panelHeight_ = 0;
+    int panelBytes_ = 0;
+
+    entry_t entries_[SPRITE_CACHE_MAX_ENTRIES];
+    int16_t index_[SPRITE_MAX_HANDLES];
+    int count_ = 0;
+    int evictions_ = 0;
+    uint32_t useCounter_ = 0;
+};
@@ -83,12 +83,14 @@ static uint const * smlistptr_ = smlist0;
  *----------------------------------------------------------------------
  */
 
-SSD1306MultiPIO::SSD1306MultiPIO() :
+template <typename G>
+SSD1306MultiPIOT<G>::SSD1306MultiPIOT() :
     inited_(false)
 {
 }
 
-SSD1306MultiPIO::~SSD1306MultiPIO()
+template <typename G>
+SSD1306MultiPIOT<G>::~SSD1306MultiPIOT()
 {
 }
 
@@ -97,8 +99,9 @@ SSD1306MultiPIO::~SSD1306MultiPIO()
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-SSD1306MultiPIO::init(
+SSD1306MultiPIOT<G>::init(
     uint8_t i2cAddr,
     int ch,
     int pinBase,
@@ -127,17 +130,17 @@ SSD1306MultiPIO::init(
     }
 
     uint8_t precharge = (vccstate == SSD1306MPIO_EXTERNALVCC) ? 0x22 : 0xF1;
-    uint8_t initdata_128_32[] = {
+    uint8_t initdata[] = {
         SSD1306MPIO_DISPLAYOFF,
         SSD1306MPIO_SETDISPLAYCLOCKDIV, 0x80,
-        SSD1306MPIO_SETMULTIPLEX, 32 - 1,
+        SSD1306MPIO_SETMULTIPLEX, G::SSD1306_MULTIPLEX,
         SSD1306MPIO_SETDISPLAYOFFSET, 0x00,
         SSD1306MPIO_SETSTARTLINE | 0x00,
         SSD1306MPIO_CHARGEPUMP, 0x14,
         SSD1306MPIO_SEGREMAP | 0x1,
         SSD1306MPIO_COMSCANDEC,
         SSD1306MPIO_MEMORYMODE, SSD1306MPIO_HORIZONTAL_ADDRESSING_MODE,
-        SSD1306MPIO_SETCOMPINS, 0x02,
+        SSD1306MPIO_SETCOMPINS, G::SSD1306_COMPINS,
         SSD1306MPIO_SETCONTRAST, contrast_,
         SSD1306MPIO_SETPRECHARGE, precharge,
         SSD1306MPIO_SETVCOMDETECT, 0x40,
@@ -147,11 +150,11 @@ SSD1306MultiPIO::init(
         SSD1306MPIO_DISPLAYON
     };
 
-    for (int i = 0; i < sizeof(initdata_128_32); i++) {
-        send_cmd_all(initdata_128_32[i]);
+    for (size_t i = 0; i < sizeof(initdata); i++) {
+        send_cmd_all(initdata[i]);
     }
 
-    uint8_t tmpbuffer[128 * 32 / 8];
+    uint8_t tmpbuffer[G::ONE_FRAME_BYTES];
     memset(tmpbuffer, 0, sizeof(tmpbuffer));
     for (int id = 0; id < ch_; id++) {
         writeFrame(id, tmpbuffer, sizeof(tmpbuffer));
@@ -160,8 +163,9 @@ SSD1306MultiPIO::init(
     inited_ = true;
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::setIdDir(bool dir)
+SSD1306MultiPIOT<G>::setIdDir(bool dir)
 {
     idDir_ = dir;
 
@@ -179,87 +183,120 @@ SSD1306MultiPIO::setIdDir(bool dir)
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-SSD1306MultiPIO::displayOn(void)
+SSD1306MultiPIOT<G>::displayOn(void)
 {
     send_cmd_all(SSD1306MPIO_DISPLAYON);
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::displayOff(void)
+SSD1306MultiPIOT<G>::displayOff(void)
 {
     send_cmd_all(SSD1306MPIO_DISPLAYOFF);
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::setContrast(uint8_t contrast)
+SSD1306MultiPIOT<G>::setContrast(uint8_t contrast)
 {
     uint8_t buffer[] {
         SSD1306MPIO_SETCONTRAST,
         contrast
     };
     send_cmd_all(buffer, sizeof(buffer));
+    contrast_ = contrast;
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::setInvertMode(void)
+SSD1306MultiPIOT<G>::setInvertMode(void)
 {
     send_cmd_all(SSD1306MPIO_INVERTDISPLAY);
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::setNormalMode(void)
+SSD1306MultiPIOT<G>::setNormalMode(void)
 {
     send_cmd_all(SSD1306MPIO_NORMALDISPLAY);
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::flipHorizontal(int mode)
+SSD1306MultiPIOT<G>::flipHorizontal(int mode)
 {
     send_cmd_all(SSD1306MPIO_SEGREMAP | ((mode)? 0 : 1));
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::flipVertical(int mode)
+SSD1306MultiPIOT<G>::flipVertical(int mode)
 {
     send_cmd_all((mode)? SSD1306MPIO_COMSCANINC : SSD1306MPIO_COMSCANDEC);
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::setStartLine(uint8_t line)
+SSD1306MultiPIOT<G>::setStartLine(uint8_t line)
 {
     send_cmd_all(SSD1306MPIO_SETSTARTLINE | (line & 0x3F));
 }
 
+// The start line and the contrast in one transaction, a frame written to
+// the pages off the panel is shown at once. (the contrast is not stored)
+template <typename G>
+void
+SSD1306MultiPIOT<G>::showFrame(uint8_t line, uint8_t contrast)
+{
+    uint8_t buffer[] {
+        (uint8_t)(SSD1306MPIO_SETSTARTLINE | (line & 0x3F)),
+        SSD1306MPIO_SETCONTRAST,
+        contrast
+    };
+    send_cmd_all(buffer, sizeof(buffer));
+}
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Function definitions
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-SSD1306MultiPIO::writeFrame(int id, uint8_t * buffer, size_t size)
+SSD1306MultiPIOT<G>::writeFrame(int id, uint8_t * buffer, size_t size)
 {
     uint8_t cmdbuffer[] {
         SSD1306MPIO_PAGEADDR,
         0x00,
-        0xFF,
+        G::PAGES - 1,
         SSD1306MPIO_COLUMNADDR,
-        0x00,
-        128 - 1
+        G::SSD1306_COLUMN_OFFSET,
+        G::SSD1306_COLUMN_OFFSET + G::HEIGHT - 1
     };
 
     send_cmd(id, cmdbuffer, sizeof(cmdbuffer));
     send_dat(id, buffer, size);
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::writeFrameMulti(uint8_t * buffer)
+SSD1306MultiPIOT<G>::writeFrameMulti(uint8_t * buffer, uint8_t page)
 {
-    uint oneFrameBytes = ((128 * 32) / 8 /* bit */);
+    writePagesMulti(buffer, page, G::PAGES, G::ONE_FRAME_BYTES);
+}
+
+// The pages from the page, the channel id from (buffer + id * stride).
+template <typename G>
+void
+SSD1306MultiPIOT<G>::writePagesMulti(uint8_t * buffer, uint8_t page, int pages, size_t stride)
+{
+    uint oneFrameBytes = pages * G::HEIGHT;
 
     uint8_t * bufptrs[SSD1306MPIO_MAX_CH];
     for (int id = 0; id < ch_; id++) {
-        bufptrs[id] = buffer + (id * oneFrameBytes);
+        bufptrs[id] = buffer + (id * stride);
     }
 
     //
@@ -267,8 +304,8 @@ SSD1306MultiPIO::writeFrameMulti(uint8_t * buffer)
     //
 
     uint8_t cmdbuffer[] {
-        SSD1306MPIO_PAGEADDR,   0x00, 0xFF,
-        SSD1306MPIO_COLUMNADDR, 0x00, 128 - 1
+        SSD1306MPIO_PAGEADDR,   page, (uint8_t)(page + pages - 1),
+        SSD1306MPIO_COLUMNADDR, G::SSD1306_COLUMN_OFFSET, G::SSD1306_COLUMN_OFFSET + G::HEIGHT - 1
     };
     send_cmd_all(cmdbuffer, sizeof(cmdbuffer));
 
@@ -324,32 +361,37 @@ SSD1306MultiPIO::writeFrameMulti(uint8_t * buffer)
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 int
-SSD1306MultiPIO::send_cmd_all(uint8_t cmd)
+SSD1306MultiPIOT<G>::send_cmd_all(uint8_t cmd)
 {
     return send_cmd_all(&cmd, 1);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_cmd_all(uint8_t * cmds, size_t size)
+SSD1306MultiPIOT<G>::send_cmd_all(uint8_t * cmds, size_t size)
 {
     return send_all(cmds, size, true);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_dat_all(uint8_t data)
+SSD1306MultiPIOT<G>::send_dat_all(uint8_t data)
 {
     return send_cmd_all(&data, 1);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_dat_all(uint8_t * data, size_t size)
+SSD1306MultiPIOT<G>::send_dat_all(uint8_t * data, size_t size)
 {
     return send_all(data, size, true);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_all(uint8_t * data, size_t size, bool cmd)
+SSD1306MultiPIOT<G>::send_all(uint8_t * data, size_t size, bool cmd)
 {
 #if 0
     int ret = 0;
@@ -362,32 +404,37 @@ SSD1306MultiPIO::send_all(uint8_t * data, size_t size, bool cmd)
 #endif
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_cmd(int id, uint8_t cmd)
+SSD1306MultiPIOT<G>::send_cmd(int id, uint8_t cmd)
 {
     return send_cmd(id, &cmd, 1);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_cmd(int id, uint8_t * cmds, size_t size)
+SSD1306MultiPIOT<G>::send_cmd(int id, uint8_t * cmds, size_t size)
 {
     return send(id, cmds, size, true);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_dat(int id, uint8_t data)
+SSD1306MultiPIOT<G>::send_dat(int id, uint8_t data)
 {
     return send_dat(id, &data, 1);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_dat(int id, uint8_t * data, size_t size)
+SSD1306MultiPIOT<G>::send_dat(int id, uint8_t * data, size_t size)
 {
     return send(id, data, size, false);
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send(int id, uint8_t * data, size_t size, bool cmd)
+SSD1306MultiPIOT<G>::send(int id, uint8_t * data, size_t size, bool cmd)
 {
     int err = 0;
     uint len;
@@ -438,8 +485,9 @@ SSD1306MultiPIO::send(int id, uint8_t * data, size_t size, bool cmd)
     return err;
 }
 
+template <typename G>
 int
-SSD1306MultiPIO::send_parallel(uint8_t * data, size_t size, bool cmd)
+SSD1306MultiPIOT<G>::send_parallel(uint8_t * data, size_t size, bool cmd)
 {
     int err = 0;
     uint len;
@@ -490,40 +538,45 @@ SSD1306MultiPIO::send_parallel(uint8_t * data, size_t size, bool cmd)
  *----------------------------------------------------------------------
  */
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_start(void)
+SSD1306MultiPIOT<G>::multi_pio_i2c_start(void)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_start(piolistptr_[id], smlistptr_[id]);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_stop(void)
+SSD1306MultiPIOT<G>::multi_pio_i2c_stop(void)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_stop(piolistptr_[id], smlistptr_[id]);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_repstart(void)
+SSD1306MultiPIOT<G>::multi_pio_i2c_repstart(void)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_repstart(piolistptr_[id], smlistptr_[id]);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_rx_enable(bool en)
+SSD1306MultiPIOT<G>::multi_pio_i2c_rx_enable(bool en)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_rx_enable(piolistptr_[id], smlistptr_[id], en);
     }
 }
 
+template <typename G>
 bool
-SSD1306MultiPIO::multi_pio_i2c_check_error(void)
+SSD1306MultiPIOT<G>::multi_pio_i2c_check_error(void)
 {
     for (int id = 0; id < ch_; id++) {
         if (pio_i2c_check_error(piolistptr_[id], smlistptr_[id])) return true;
@@ -531,40 +584,45 @@ SSD1306MultiPIO::multi_pio_i2c_check_error(void)
     return false;
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_resume_after_error(void)
+SSD1306MultiPIOT<G>::multi_pio_i2c_resume_after_error(void)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_resume_after_error(piolistptr_[id], smlistptr_[id]);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_put16(uint16_t data)
+SSD1306MultiPIOT<G>::multi_pio_i2c_put16(uint16_t data)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_put16(piolistptr_[id], smlistptr_[id], data);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_put_or_err(uint16_t data)
+SSD1306MultiPIOT<G>::multi_pio_i2c_put_or_err(uint16_t data)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_put_or_err(piolistptr_[id], smlistptr_[id], data);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_get(uint8_t * buffer)
+SSD1306MultiPIOT<G>::multi_pio_i2c_get(uint8_t * buffer)
 {
     for (int id = 0; id < ch_; id++) {
         buffer[id] = pio_i2c_get(piolistptr_[id], smlistptr_[id]);
     }
 }
 
+template <typename G>
 void
-SSD1306MultiPIO::multi_pio_i2c_wait_idle(void)
+SSD1306MultiPIOT<G>::multi_pio_i2c_wait_idle(void)
 {
     for (int id = 0; id < ch_; id++) {
         pio_i2c_wait_idle(piolistptr_[id], smlistptr_[id]);
@@ -572,11 +630,19 @@ SSD1306MultiPIO::multi_pio_i2c_wait_idle(void)
 }
 
 // Returns true (full) if at least one of the fifo is full.
+template <typename G>
 bool
-SSD1306MultiPIO::multi_pio_sm_is_tx_fifo_full(void)
+SSD1306MultiPIOT<G>::multi_pio_sm_is_tx_fifo_full(void)
 {
     for (int id = 0; id < ch_; id++) {
         if (pio_sm_is_tx_fifo_full(piolistptr_[id], smlistptr_[id])) return true;
     }
     return false;
-}
\ No newline at end of file
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Instantiation
+ *----------------------------------------------------------------------
+ */
+
+template class SSD1306MultiPIOT<CvDefaultGeometry>;
@@ -15,6 +15,8 @@
 #include <Arduino.h>
 #include <cstdint>
 
+#include "cv_geometry.hpp"
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
  * Definitions
  *----------------------------------------------------------------------
@@ -32,16 +34,19 @@
  *----------------------------------------------------------------------
  */
 
-class SSD1306MultiPIO
+// The panels of the geometry G, (G::HEIGHT x G::WIDTH) and G::CHANNELS
+// of them. (cv_geometry.hpp)
+template <typename G>
+class SSD1306MultiPIOT
 {
 public:
-    explicit SSD1306MultiPIO();
-    virtual ~SSD1306MultiPIO();
+    explicit SSD1306MultiPIOT();
+    virtual ~SSD1306MultiPIOT();
 
 public:
     void init(
         uint8_t i2cAddr = 0x3C,
-        int ch = 8,
+        int ch = G::CHANNELS,
         int pinBase = 0,
         int vccstate = SSD1306MPIO_SWITCHCAPVCC
     );
@@ -57,10 +62,13 @@ public:
     void flipHorizontal(int mode);
     void flipVertical(int mode);
     void setStartLine(uint8_t line);
+    void showFrame(uint8_t line, uint8_t contrast);
+    uint8_t contrast(void) const { return contrast_; }
 
 public:
     void writeFrame(int id, uint8_t * buffer, size_t size);
-    void writeFrameMulti(uint8_t * buffer);
+    void writeFrameMulti(uint8_t * buffer, uint8_t page = 0);
+    void writePagesMulti(uint8_t * buffer, uint8_t page, int pages, size_t stride);
 
 private:
     inline int send_cmd_all(uint8_t cmd);
@@ -98,3 +106,5 @@ private:
     uint8_t contrast_;
     bool idDir_ = true;
 };
+
+typedef SSD1306MultiPIOT<CvDefaultGeometry> SSD1306MultiPIO;
@@ -0,0 +1,735 @@
+/**********************************************************************/
+/**
+ * @brief  Asset Compiler (Host Tool)
+ * @author naoa
+ *
+ * Compile sprite animations to a single panel native asset pack
+ * (asset_pack_t) for the controller firmware. See asset_pack.hpp for
+ * the data format.
+ *
+ *  - Data is packed horizontally (8 columns per byte), same to the screen.
+ *  - Frames are trimmed to the bounding box, draw offsets are adjusted.
+ *  - Identical frames and identical 8 column strips are shared.
+ *  - Alpha is stored as run lists, and dropped if the box is opaque.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 assetc.cpp -o assetc
+ *
+ * Inputs are the existing image headers (image_*.h, mono_image_t), and
+ * PNM / PAM frame sequences. An animation of frames starts with -a name.
+ * Grayscale frames are thresholded (-t), or error diffused (-e) for
+ * photos and gradients ; the firmware dithers grayscale images at run time
+ * only by the ordered dither (gray_image_t, mono_dither.hpp).
+ * PAM (P7) with GRAYSCALE_ALPHA or RGB_ALPHA has alpha. e.g. from a GIF :
+ *   convert walk.gif -coalesce walk_%03d.pam
+ *   ./assetc -o ../../firmware/controller/asset_pack.h \
+ *       ../../firmware/controller/image_*.h -d -20,-29 -a walk walk_???.pam
+ *
+ * The flash usage before (mono_image_t) and after (asset pack) is printed.
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <string>
+#include <vector>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Target (RP2040, 32 bit) structure sizes for the flash report.
+#define TARGET_MONO_IMAGE_SIZE      (40)
+#define TARGET_MONO_IMAGES_SIZE     (8)
+#define TARGET_ASSET_FRAME_SIZE     (24)
+#define TARGET_ASSET_ANIM_SIZE      (12)
+#define TARGET_ASSET_PACK_SIZE      (32)
+
+#define MAX_WIDTH                   (256)
+
+typedef struct frame_ {
+    int width = 0;
+    int height = 0;
+    int offset_x = 0;
+    int offset_y = 0;
+    std::vector<uint8_t> pixels;   // 1 = white
+    std::vector<uint8_t> alpha;    // 1 = opaque
+} frame_t;
+
+typedef struct anim_ {
+    std::string name;
+    std::vector<frame_t> frames;
+    size_t before = 0;              // Flash usage as mono_image_t
+} anim_t;
+
+typedef struct options_ {
+    std::string output;
+    int threshold = 128;
+    bool diffuse = false;       // Error diffusion, instead of the threshold
+    bool invert = false;
+    int offset_x = 0;
+    int offset_y = 0;
+} options_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Image headers (mono_image_t)
+ *----------------------------------------------------------------------
+ */
+
+typedef struct header_image_ {
+    int field[7];
+    bool alpha;
+    std::string data;
+    std::string alphadata;
+} header_image_t;
+
+static bool
+read_file(const char * path, std::string * text)
+{
+    FILE * fp = fopen(path, "rb");
+    if (fp == nullptr) return false;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) text->append(buf, n);
+    fclose(fp);
+    return true;
+}
+
+static std::vector<std::string>
+split_fields(const std::string & body)
+{
+    std::vector<std::string> fields;
+    std::string cur;
+    for (char c : body) {
+        if (c == ',') {
+            fields.push_back(cur);
+            cur.clear();
+        } else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            cur += c;
+        }
+    }
+    if (!cur.empty()) fields.push_back(cur);
+    return fields;
+}
+
+static bool
+load_header(const char * path, std::vector<anim_t> * anims)
+{
+    std::string text;
+    if (!read_file(path, &text)) {
+        fprintf(stderr, "assetc: cannot open %s\n", path);
+        return false;
+    }
+
+    std::map<std::string, std::vector<uint8_t>> arrays;
+    std::map<std::string, header_image_t> images;
+    std::map<std::string, std::vector<std::string>> lists;
+    std::vector<std::pair<std::string, std::string>> sets;  // (mono_images_t name, list name)
+
+    size_t pos = 0;
+    while ((pos = text.find("const ", pos)) != std::string::npos) {
+        size_t eq = text.find('=', pos);
+        size_t open = text.find('{', pos);
+        size_t close = text.find('}', open);
+        if (eq == std::string::npos || open == std::string::npos || close == std::string::npos) break;
+
+        std::vector<std::string> decl;
+        {
+            std::string d = text.substr(pos, eq - pos);
+            size_t i = 0;
+            while (i < d.size()) {
+                while (i < d.size() && (d[i] == ' ' || d[i] == '\t')) i++;
+                size_t j = i;
+                while (j < d.size() && d[j] != ' ' && d[j] != '\t') j++;
+                if (j > i) decl.push_back(d.substr(i, j - i));
+                i = j;
+            }
+        }
+        std::string body = text.substr(open + 1, close - open - 1);
+        pos = close + 1;
+        if (decl.size() != 3) continue;
+
+        const std::string & type = decl[1];
+        std::string name = decl[2];
+        bool isArray = (name.size() > 2 && name.compare(name.size() - 2, 2, "[]") == 0);
+        if (isArray) name.resize(name.size() - 2);
+
+        std::vector<std::string> fields = split_fields(body);
+        if (type == "uint8_t" && isArray) {
+            std::vector<uint8_t> & a = arrays[name];
+            for (auto & f : fields) a.push_back((uint8_t)strtoul(f.c_str(), nullptr, 0));
+        } else if (type == "mono_image_t" && isArray) {
+            lists[name] = fields;
+        } else if (type == "mono_image_t" && fields.size() == 10) {
+            header_image_t & image = images[name];
+            for (int i = 0; i < 7; i++) image.field[i] = atoi(fields[i].c_str());
+            image.alpha = (fields[7] == "true");
+            image.data = fields[8];
+            image.alphadata = fields[9];
+        } else if (type == "mono_images_t" && fields.size() == 2) {
+            sets.push_back(std::make_pair(name, fields[1]));
+        }
+    }
+
+    for (auto & set : sets) {
+        anim_t anim;
+        anim.name = set.first;
+        // image_<name>_frames -> <name>
+        if (anim.name.compare(0, 6, "image_") == 0) anim.name = anim.name.substr(6);
+        size_t suffix = anim.name.rfind("_frames");
+        if (suffix != std::string::npos) anim.name.resize(suffix);
+        anim.before = TARGET_MONO_IMAGES_SIZE;
+
+        for (auto & iname : lists[set.second]) {
+            auto it = images.find(iname);
+            if (it == images.end()) {
+                fprintf(stderr, "assetc: %s: image %s not found\n", path, iname.c_str());
+                return false;
+            }
+            const header_image_t & image = it->second;
+            const std::vector<uint8_t> & data  = arrays[image.data];
+            const std::vector<uint8_t> & adata = arrays[image.alphadata];
+
+            frame_t frame;
+            frame.width    = image.field[0];
+            frame.height   = image.field[1];
+            frame.offset_x = image.field[2];
+            frame.offset_y = image.field[3];
+            frame.pixels.assign(frame.width * frame.height, 0);
+            frame.alpha.assign(frame.width * frame.height, 1);
+            for (int y = 0; y < frame.height; y++) {
+                for (int x = 0; x < frame.width; x++) {
+                    size_t offset = x + ((y >> 3) * frame.width);
+                    if (offset < data.size()) {
+                        frame.pixels[(y * frame.width) + x] = (data[offset] >> (y & 7)) & 1;
+                    }
+                    if (image.alpha && offset < adata.size()) {
+                        frame.alpha[(y * frame.width) + x] = (adata[offset] >> (y & 7)) & 1;
+                    }
+                }
+            }
+            anim.frames.push_back(frame);
+
+            // Frame list entries are copies of mono_image_t.
+            anim.before += TARGET_MONO_IMAGE_SIZE + image.field[6] * ((image.alpha)? 2 : 1);
+        }
+        anims->push_back(anim);
+    }
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - PNM / PAM
+ *----------------------------------------------------------------------
+ */
+
+static int
+pnm_token(FILE * fp, std::string * word = nullptr)
+{
+    int c = fgetc(fp);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fgetc(fp);
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            c = fgetc(fp);
+        } else {
+            break;
+        }
+    }
+    std::string s;
+    while (c != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+        s += (char)c;
+        c = fgetc(fp);
+    }
+    if (word) *word = s;
+    if (s.empty() || s[0] < '0' || s[0] > '9') return -1;
+    return atoi(s.c_str());
+}
+
+// Floyd-Steinberg error diffusion, serpentine, in place : every pixel ends
+// 0 or 255. Serial along the rows, so a host asset mode only, the firmware
+// has the ordered dither. (mono_dither.hpp)
+static void
+diffuse(std::vector<int16_t> * gray, int w, int h, int threshold)
+{
+    std::vector<int> err((w + 2) * 2, 0);
+    int * cur = &err[1];
+    int * next = &err[w + 3];
+    for (int y = 0; y < h; y++) {
+        bool rtl = (y & 1) != 0;
+        int step = (rtl)? -1 : 1;
+        for (int i = 0; i < w; i++) {
+            int x = (rtl)? (w - 1 - i) : i;
+            int16_t * p = &(*gray)[(y * w) + x];
+            // Errors are in 1/16.
+            int v = *p + (cur[x] / 16);
+            int out = (v >= threshold)? 255 : 0;
+            int e = v - out;
+            cur[x + step]  += e * 7;
+            next[x - step] += e * 3;
+            next[x]        += e * 5;
+            next[x + step] += e * 1;
+            *p = (int16_t)out;
+        }
+        std::swap(cur, next);
+        for (int x = -1; x <= w; x++) next[x] = 0;
+    }
+}
+
+static bool
+load_pnm(const char * path, const options_t & opt, frame_t * frame)
+{
+    FILE * fp = fopen(path, "rb");
+    if (fp == nullptr) {
+        fprintf(stderr, "assetc: cannot open %s\n", path);
+        return false;
+    }
+
+    char magic[2];
+    if (fread(magic, 1, 2, fp) != 2 || magic[0] != 'P' || magic[1] < '1' || magic[1] > '7') {
+        fprintf(stderr, "assetc: %s is not a PNM / PAM file\n", path);
+        fclose(fp);
+        return false;
+    }
+    int type = magic[1] - '0';
+    int w = 0, h = 0, depth = 1, maxval = 1;
+
+    if (type == 7) {
+        std::string key, value;
+        while (1) {
+            pnm_token(fp, &key);
+            if (key == "ENDHDR" || key.empty()) break;
+            int v = pnm_token(fp, &value);
+            if      (key == "WIDTH")  w = v;
+            else if (key == "HEIGHT") h = v;
+            else if (key == "DEPTH")  depth = v;
+            else if (key == "MAXVAL") maxval = v;
+        }
+    } else {
+        w = pnm_token(fp);
+        h = pnm_token(fp);
+        if (type != 1 && type != 4) maxval = pnm_token(fp);
+        if (type == 3 || type == 6) depth = 3;
+    }
+    if (w <= 0 || h <= 0 || maxval <= 0 || maxval > 255 || depth < 1 || depth > 4) {
+        fprintf(stderr, "assetc: %s unsupported header\n", path);
+        fclose(fp);
+        return false;
+    }
+
+    frame->width  = w;
+    frame->height = h;
+    frame->offset_x = opt.offset_x;
+    frame->offset_y = opt.offset_y;
+    frame->pixels.assign(w * h, 0);
+    frame->alpha.assign(w * h, 1);
+
+    bool ascii = (type <= 3);
+    bool hasAlpha = (type == 7) && (depth == 2 || depth == 4);
+    int colors = (hasAlpha)? depth - 1 : depth;
+    std::vector<int16_t> gray(w * h, 0);
+
+    auto sample = [&](void) {
+        if (type == 1) {
+            int c = fgetc(fp);
+            while (c == ' ' || c == '\t' || c == '\r' || c == '\n') c = fgetc(fp);
+            return (c == '1')? 0 : 255;     // PBM 1 is black
+        }
+        int v = (ascii)? pnm_token(fp) : fgetc(fp);
+        return (v < 0)? 0 : (v * 255 / maxval);
+    };
+
+    for (int y = 0; y < h; y++) {
+        std::vector<uint8_t> row;
+        if (type == 4) {
+            row.resize((w + 7) / 8);
+            if (fread(row.data(), 1, row.size(), fp) != row.size()) break;
+        }
+        for (int x = 0; x < w; x++) {
+            int v;
+            if (type == 4) {
+                v = ((row[x >> 3] >> (7 - (x & 7))) & 1)? 0 : 255;
+            } else if (colors == 3) {
+                int r = sample(), g = sample(), b = sample();
+                v = ((r * 77) + (g * 150) + (b * 29)) >> 8;
+            } else {
+                v = sample();
+            }
+            gray[(y * w) + x] = (int16_t)v;
+            if (hasAlpha) frame->alpha[(y * w) + x] = (sample() >= 128)? 1 : 0;
+        }
+    }
+
+    fclose(fp);
+
+    if (opt.diffuse) diffuse(&gray, w, h, opt.threshold);
+    for (int i = 0; i < (w * h); i++) {
+        bool on = gray[i] >= opt.threshold;
+        if (opt.invert) on = !on;
+        frame->pixels[i] = (on)? 1 : 0;
+    }
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Compiler
+ *----------------------------------------------------------------------
+ */
+
+class Compiler
+{
+public:
+    typedef struct out_frame_ {
+        uint16_t width, height, full_width, full_height;
+        int16_t  trim_x, trim_y, draw_offset_x, draw_offset_y;
+        uint32_t strips, alpha;
+        bool operator<(const out_frame_ & o) const { return memcmp(this, &o, sizeof(*this)) < 0; }
+    } out_frame_t;
+
+public:
+    bool add(const anim_t & anim) {
+        uint32_t first = (uint32_t)frameList_.size();
+        for (const frame_t & frame : anim.frames) {
+            int index = compile(anim.name, frame);
+            if (index < 0) return false;
+            frameList_.push_back((uint16_t)index);
+        }
+        names_.push_back(anim.name);
+        animFrames_.push_back(std::make_pair((uint16_t)anim.frames.size(), first));
+        sourceFrames_ += anim.frames.size();
+        return true;
+    }
+
+    size_t size(void) const {
+        size_t names = 0;
+        for (auto & n : names_) names += n.size() + 1;
+        return TARGET_ASSET_PACK_SIZE
+             + (names_.size() * TARGET_ASSET_ANIM_SIZE) + names
+             + (frameList_.size() * 2)
+             + (frames_.size() * TARGET_ASSET_FRAME_SIZE)
+             + (stripIndex_.size() * 2)
+             + (stripOffsets_.size() * 4)
+             + stripData_.size()
+             + alphaData_.size();
+    }
+
+    void report(void) const {
+        printf("frames : %zu -> %zu unique\n", sourceFrames_, frames_.size());
+        printf("strips : %zu -> %zu unique, %zu bytes\n", stripIndex_.size(), stripOffsets_.size(), stripData_.size());
+        printf("alpha  : %zu bytes (%zu frames with alpha)\n", alphaData_.size(), alphaFrames_);
+        printf("tables : %zu bytes\n", size() - stripData_.size() - alphaData_.size());
+    }
+
+    bool write(const char * path) const {
+        FILE * fp = fopen(path, "w");
+        if (fp == nullptr) {
+            fprintf(stderr, "assetc: cannot create %s\n", path);
+            return false;
+        }
+        fprintf(fp, "// name : asset_pack\n");
+        fprintf(fp, "// %zu animations, %zu frames, %zu bytes\n\n", names_.size(), frames_.size(), size());
+
+        fprintf(fp, "const uint8_t asset_pack_strip_data[] = {");
+        for (size_t i = 0; i < stripData_.size(); i++) {
+            if ((i % 16) == 0) fprintf(fp, "\n    ");
+            fprintf(fp, "0x%02x, ", stripData_[i]);
+        }
+        fprintf(fp, "\n};\n\n");
+
+        fprintf(fp, "const uint8_t asset_pack_alpha_data[] = {");
+        for (size_t i = 0; i < alphaData_.size(); i++) {
+            if ((i % 16) == 0) fprintf(fp, "\n    ");
+            fprintf(fp, "0x%02x, ", alphaData_[i]);
+        }
+        if (alphaData_.empty()) fprintf(fp, " 0x00");
+        fprintf(fp, "\n};\n\n");
+
+        fprintf(fp, "const uint32_t asset_pack_strip_offsets[] = {");
+        for (size_t i = 0; i < stripOffsets_.size(); i++) {
+            if ((i % 8) == 0) fprintf(fp, "\n    ");
+            fprintf(fp, "0x%08x, ", stripOffsets_[i]);
+        }
+        fprintf(fp, "\n};\n\n");
+
+        fprintf(fp, "const uint16_t asset_pack_strip_index[] = {");
+        for (size_t i = 0; i < stripIndex_.size(); i++) {
+            if ((i % 16) == 0) fprintf(fp, "\n    ");
+            fprintf(fp, "%u, ", stripIndex_[i]);
+        }
+        fprintf(fp, "\n};\n\n");
+
+        fprintf(fp, "const asset_frame_t asset_pack_frames[] = {\n");
+        for (const out_frame_t & f : frames_) {
+            fprintf(fp, "    { %u, %u, %u, %u, %d, %d, %d, %d, %u, 0x%08x },\n",
+                    f.width, f.height, f.full_width, f.full_height,
+                    f.trim_x, f.trim_y, f.draw_offset_x, f.draw_offset_y, f.strips, f.alpha);
+        }
+        fprintf(fp, "};\n\n");
+
+        fprintf(fp, "const uint16_t asset_pack_frame_list[] = {");
+        for (size_t i = 0; i < frameList_.size(); i++) {
+            if ((i % 16) == 0) fprintf(fp, "\n    ");
+            fprintf(fp, "%u, ", frameList_[i]);
+        }
+        fprintf(fp, "\n};\n\n");
+
+        fprintf(fp, "const asset_anim_t asset_pack_anims[] = {\n");
+        for (size_t i = 0; i < names_.size(); i++) {
+            fprintf(fp, "    { \"%s\", %u, %u },\n", names_[i].c_str(), animFrames_[i].first, animFrames_[i].second);
+        }
+        fprintf(fp, "};\n\n");
+
+        fprintf(fp, "const asset_pack_t asset_pack = {\n");
+        fprintf(fp, "    %zu,\n", names_.size());
+        fprintf(fp, "    asset_pack_anims,\n");
+        fprintf(fp, "    asset_pack_frame_list,\n");
+        fprintf(fp, "    asset_pack_frames,\n");
+        fprintf(fp, "    asset_pack_strip_index,\n");
+        fprintf(fp, "    asset_pack_strip_offsets,\n");
+        fprintf(fp, "    asset_pack_strip_data,\n");
+        fprintf(fp, "    asset_pack_alpha_data\n");
+        fprintf(fp, "};\n");
+        fclose(fp);
+        return true;
+    }
+
+private:
+    int compile(const std::string & name, const frame_t & frame) {
+        int w = frame.width;
+        int h = frame.height;
+        auto pixel = [&](int x, int y) { return frame.pixels[(y * w) + x] & frame.alpha[(y * w) + x]; };
+        auto alpha = [&](int x, int y) { return frame.alpha[(y * w) + x]; };
+
+        // Bounding box of opaque pixels.
+        int x0 = w, y0 = h, x1 = -1, y1 = -1;
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                if (!alpha(x, y)) continue;
+                if (x < x0) x0 = x;
+                if (x > x1) x1 = x;
+                if (y < y0) y0 = y;
+                if (y > y1) y1 = y;
+            }
+        }
+        if (x1 < 0) {
+            x0 = y0 = 0;
+            x1 = y1 = -1;
+        }
+        int tw = x1 - x0 + 1;
+        int th = y1 - y0 + 1;
+        if (tw > MAX_WIDTH) {
+            fprintf(stderr, "assetc: %s: width %d is too large (max %d)\n", name.c_str(), tw, MAX_WIDTH);
+            return -1;
+        }
+
+        out_frame_t out;
+        memset(&out, 0, sizeof(out));
+        out.width         = (uint16_t)tw;
+        out.height        = (uint16_t)th;
+        out.full_width    = (uint16_t)w;
+        out.full_height   = (uint16_t)h;
+        out.trim_x        = (int16_t)x0;
+        out.trim_y        = (int16_t)y0;
+        out.draw_offset_x = (int16_t)(frame.offset_x + x0);
+        out.draw_offset_y = (int16_t)(frame.offset_y + y0);
+        out.alpha         = 0xFFFFFFFFUL;
+
+        // Strips of 8 columns, column c is the pixel x = (tw - 1 - c). (mirrored)
+        std::vector<uint16_t> strips;
+        for (int s = 0; s < (tw + 7) / 8; s++) {
+            std::vector<uint8_t> strip(th, 0);
+            for (int y = 0; y < th; y++) {
+                for (int b = 0; b < 8; b++) {
+                    int c = (s * 8) + b;
+                    if (c >= tw) break;
+                    if (pixel(x0 + tw - 1 - c, y0 + y)) strip[y] |= (uint8_t)(1 << b);
+                }
+            }
+            strips.push_back(internStrip(strip));
+        }
+
+        // Alpha run lists, only if transparent pixels remain in the box.
+        bool opaque = true;
+        for (int y = y0; y <= y1 && opaque; y++) {
+            for (int x = x0; x <= x1; x++) {
+                if (!alpha(x, y)) { opaque = false; break; }
+            }
+        }
+        if (!opaque) {
+            std::vector<uint8_t> runs;
+            for (int y = 0; y < th; y++) {
+                std::vector<uint8_t> row;
+                int c = 0;
+                while (c < tw) {
+                    if (!alpha(x0 + tw - 1 - c, y0 + y)) { c++; continue; }
+                    int start = c;
+                    while (c < tw && alpha(x0 + tw - 1 - c, y0 + y)) c++;
+                    row.push_back((uint8_t)start);
+                    row.push_back((uint8_t)(c - start - 1));
+                }
+                runs.push_back((uint8_t)(row.size() / 2));
+                runs.insert(runs.end(), row.begin(), row.end());
+            }
+            out.alpha = internAlpha(runs);
+            alphaFrames_++;
+        }
+
+        // Share the strip index of an identical strip sequence.
+        auto sit = stripSeqs_.find(strips);
+        if (sit != stripSeqs_.end()) {
+            out.strips = sit->second;
+        } else {
+            out.strips = (uint32_t)stripIndex_.size();
+            stripIndex_.insert(stripIndex_.end(), strips.begin(), strips.end());
+            stripSeqs_[strips] = out.strips;
+        }
+
+        auto fit = frameMap_.find(out);
+        if (fit != frameMap_.end()) return fit->second;
+        if (frames_.size() >= 0xFFFF) {
+            fprintf(stderr, "assetc: too many frames\n");
+            return -1;
+        }
+        int index = (int)frames_.size();
+        frames_.push_back(out);
+        frameMap_[out] = index;
+        return index;
+    }
+
+    uint16_t internStrip(const std::vector<uint8_t> & strip) {
+        auto it = stripMap_.find(strip);
+        if (it != stripMap_.end()) return it->second;
+        uint16_t index = (uint16_t)stripOffsets_.size();
+        stripOffsets_.push_back((uint32_t)stripData_.size());
+        stripData_.insert(stripData_.end(), strip.begin(), strip.end());
+        stripMap_[strip] = index;
+        return index;
+    }
+
+    uint32_t internAlpha(const std::vector<uint8_t> & runs) {
+        auto it = alphaMap_.find(runs);
+        if (it != alphaMap_.end()) return it->second;
+        uint32_t offset = (uint32_t)alphaData_.size();
+        alphaData_.insert(alphaData_.end(), runs.begin(), runs.end());
+        alphaMap_[runs] = offset;
+        return offset;
+    }
+
+private:
+    std::vector<std::string> names_;
+    std::vector<std::pair<uint16_t, uint32_t>> animFrames_;
+    std::vector<uint16_t> frameList_;
+    std::vector<out_frame_t> frames_;
+    std::map<out_frame_t, int> frameMap_;
+    std::vector<uint16_t> stripIndex_;
+    std::map<std::vector<uint16_t>, uint32_t> stripSeqs_;
+    std::vector<uint32_t> stripOffsets_;
+    std::vector<uint8_t> stripData_;
+    std::map<std::vector<uint8_t>, uint16_t> stripMap_;
+    std::vector<uint8_t> alphaData_;
+    std::map<std::vector<uint8_t>, uint32_t> alphaMap_;
+    size_t sourceFrames_ = 0;
+    size_t alphaFrames_ = 0;
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: assetc [options] [image_*.h ...] [-a name frame.pam ...] ...\n"
+        "  -o file       output asset pack header (e.g. asset_pack.h)\n"
+        "  -a name       start an animation, following PNM / PAM files are frames\n"
+        "  -d x,y        draw offset of the following animations\n"
+        "  -t level      threshold 0-255, default 128\n"
+        "  -e            error diffusion (Floyd-Steinberg) of the grayscale frames\n"
+        "  -i            invert\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    options_t opt;
+    std::vector<anim_t> anims;
+    int current = -1;   // Animation of PNM / PAM frames
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (a == "-o" && hasValue) {
+            opt.output = argv[++i];
+        } else if (a == "-a" && hasValue) {
+            anims.push_back(anim_t());
+            anims.back().name = argv[++i];
+            current = (int)anims.size() - 1;
+        } else if (a == "-d" && hasValue) {
+            if (sscanf(argv[++i], "%d,%d", &opt.offset_x, &opt.offset_y) != 2) { usage(); return 1; }
+        } else if (a == "-t" && hasValue) {
+            opt.threshold = atoi(argv[++i]);
+        } else if (a == "-e") {
+            opt.diffuse = true;
+        } else if (a == "-i") {
+            opt.invert = true;
+        } else if (a[0] == '-') {
+            usage();
+            return 1;
+        } else if (a.size() > 2 && a.compare(a.size() - 2, 2, ".h") == 0) {
+            if (!load_header(a.c_str(), &anims)) return 1;
+            current = -1;
+        } else {
+            if (current < 0) {
+                fprintf(stderr, "assetc: %s: -a name is required before frames\n", a.c_str());
+                return 1;
+            }
+            frame_t frame;
+            if (!load_pnm(a.c_str(), opt, &frame)) return 1;
+            anims[current].frames.push_back(frame);
+        }
+    }
+    if (anims.empty()) {
+        usage();
+        return 1;
+    }
+
+    Compiler compiler;
+    size_t before = 0;
+    bool allHeaders = true;
+    printf("%-24s %8s %10s\n", "animation", "frames", "before");
+    for (const anim_t & anim : anims) {
+        if (anim.frames.empty()) {
+            fprintf(stderr, "assetc: %s has no frames\n", anim.name.c_str());
+            return 1;
+        }
+        if (!compiler.add(anim)) return 1;
+        before += anim.before;
+        if (anim.before > 0) {
+            printf("%-24s %8zu %10zu\n", anim.name.c_str(), anim.frames.size(), anim.before);
+        } else {
+            printf("%-24s %8zu %10s\n", anim.name.c_str(), anim.frames.size(), "-");
+            allHeaders = false;
+        }
+    }
+    compiler.report();
+    if (allHeaders) {
+        printf("flash : %zu -> %zu bytes (%.1f %%)\n", before, compiler.size(), (compiler.size() * 100.0) / before);
+    } else {
+        printf("flash : %zu bytes (mono_image_t part %zu bytes)\n", compiler.size(), before);
+    }
+
+    if (!opt.output.empty()) {
+        if (!compiler.write(opt.output.c_str())) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,238 @@
+/**********************************************************************/
+/**
+ * @brief  Asset Pack Drawing Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Check CyclicMonoDrawer::drawAsset() of an asset pack compiled by assetc
+ * from the image headers against drawImage() with the blending of the
+ * source frames (mono_images_t) : every frame of every animation, plain /
+ * centered / offset / offset centered, at positions over the x wrap and
+ * the clipping, on a cleared and on a random frame. The panel buffers
+ * must be the same.
+ *
+ * Then measures every frame of every animation drawn once, both ways.
+ *
+ * Build (the pack first, into this directory) :
+ *   g++ -O2 -std=c++17 ../assetc/assetc.cpp -o assetc
+ *   ./assetc -o asset_pack.h ../../firmware/controller/image_*.h
+ *   g++ -O2 -std=c++17 -I. -I../../firmware/controller assettest.cpp \
+ *       ../../firmware/controller/image_data.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o assettest
+ *
+ * Run :
+ *   ./assettest [random positions]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+#include "image_data.hpp"
+
+#ifndef IMAGE_DATA_HAS_ASSET_PACK
+#error "asset_pack.h not found, compile it by assetc first (see Build)"
+#endif
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define MODES               (4)     // plain, centered, offset, offset centered
+
+typedef struct source_ {
+    const char * name_;             // Animation name in the pack (assetc)
+    const mono_images_t * images_;
+} source_t;
+
+// Same to the image headers assetc reads (image_<name>_frames -> <name>).
+static const source_t sources_[] = {
+    { "anim_test",          &image_anim_test_frames },
+    { "dispnum",            &image_dispnum_frames },
+    { "title_cylinview",    &image_title_cylinview_frames },
+    { "sky1",               &image_sky1_frames },
+    { "sky2",               &image_sky2_frames },
+    { "entry",              &image_entry_frames },
+    { "idle2",              &image_idle2_frames },
+    { "run1",               &image_run1_frames },
+    { "jump1",              &image_jump1_frames },
+};
+#define SOURCES             ((int)(sizeof(sources_) / sizeof(sources_[0])))
+
+static uint32_t rnd_ = 0x5EED0028UL;
+static volatile uint32_t sink_ = 0;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+static int
+rnd_range(int lo, int hi)
+{
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+static void
+setup(CyclicMonoScreen * screen, uint8_t * frame)
+{
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        screen->getMonoScreen(i)->setBuffer(frame + (i * CV_ONE_FRAME_BYTES));
+    }
+}
+
+static const char *
+mode_name(int mode)
+{
+    static const char * names[MODES] = { "plain", "centered", "offset", "offset centered" };
+    return names[mode];
+}
+
+static bool
+check(int positions)
+{
+    static uint8_t assetFrame[CV_FRAME_BYTES], imageFrame[CV_FRAME_BYTES];
+    CyclicMonoScreen assetScreen, imageScreen;
+    setup(&assetScreen, assetFrame);
+    setup(&imageScreen, imageFrame);
+    CyclicMonoDrawer assetDrawer, imageDrawer;
+    assetDrawer.init(&assetScreen);
+    imageDrawer.init(&imageScreen);
+
+    bool ok = true;
+    long total = 0, totalBad = 0;
+    for (int s = 0; s < SOURCES; s++) {
+        const source_t & src = sources_[s];
+        int anim = AssetImage::find(&asset_pack, src.name_);
+        if (anim < 0 || AssetImage::count(&asset_pack, anim) != src.images_->count_) {
+            printf("%-16s not in the pack, or the frame count differs  NG\n", src.name_);
+            ok = false;
+            continue;
+        }
+        long count = 0, bad = 0;
+        for (int f = 0; f < src.images_->count_; f++) {
+            MonoImage image(&src.images_->images_[f]);
+            AssetImage asset(&asset_pack, anim, f);
+            int w = image.width(), h = image.height();
+            // Fixed positions at the wrap and the borders, then random ones.
+            const int fixed[][2] = {
+                { 0, 0 }, { 37, 13 }, { CV_V_WIDTH - (w / 2), 0 }, { -(w / 2), CV_HEIGHT - (h / 2) },
+                { CV_V_WIDTH - 1, -(h / 2) }, { 2 * CV_V_WIDTH + 5, CV_HEIGHT - 1 },
+            };
+            const int nfixed = (int)(sizeof(fixed) / sizeof(fixed[0]));
+            for (int p = 0; p < nfixed + positions; p++) {
+                int x = (p < nfixed)? fixed[p][0] : rnd_range(-2 * CV_V_WIDTH, 2 * CV_V_WIDTH);
+                int y = (p < nfixed)? fixed[p][1] : rnd_range(-h, CV_HEIGHT);
+                for (int mode = 0; mode < MODES; mode++) {
+                    bool centered = (mode & 1) != 0;
+                    bool offset = (mode & 2) != 0;
+                    for (int bg = 0; bg < 2; bg++) {
+                        for (int i = 0; i < CV_FRAME_BYTES; i++) assetFrame[i] = (bg)? (uint8_t)rnd() : 0x00;
+                        memcpy(imageFrame, assetFrame, sizeof(imageFrame));
+                        assetDrawer.drawAsset(x, y, &asset, centered, offset);
+                        imageDrawer.drawImage(x, y, &image, true, centered, offset);
+                        count++;
+                        if (memcmp(assetFrame, imageFrame, sizeof(assetFrame)) != 0) {
+                            if (bad == 0) {
+                                printf("  %s mismatch : frame %d (%d, %d) %s, %s frame\n",
+                                       src.name_, f, x, y, mode_name(mode), (bg)? "random" : "cleared");
+                            }
+                            bad++;
+                        }
+                    }
+                }
+            }
+        }
+        printf("%-16s %3d frames %7ld cases, %ld differ  %s\n",
+               src.name_, src.images_->count_, count, bad, (bad == 0)? "OK" : "NG");
+        total += count;
+        totalBad += bad;
+        ok &= (bad == 0);
+    }
+    printf("total %ld cases, %ld differ\n", total, totalBad);
+    return ok;
+}
+
+// Every frame of every animation once, at a position moving over the wrap.
+static void
+benchmark(void)
+{
+    static uint8_t frame[CV_FRAME_BYTES];
+    CyclicMonoScreen screen;
+    setup(&screen, frame);
+    CyclicMonoDrawer drawer;
+    drawer.init(&screen);
+
+    using clock = std::chrono::steady_clock;
+    const int rounds = 200;
+    printf("%-16s %10s %10s %7s\n", "animation", "image us", "asset us", "ratio");
+    for (int s = 0; s < SOURCES; s++) {
+        const source_t & src = sources_[s];
+        int anim = AssetImage::find(&asset_pack, src.name_);
+        if (anim < 0) continue;
+        int n = src.images_->count_;
+
+        auto t0 = clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (int f = 0; f < n; f++) {
+                MonoImage image(&src.images_->images_[f]);
+                drawer.drawImage(r * 7, 0, &image, true, false, true);
+            }
+        }
+        auto t1 = clock::now();
+        sink_ = sink_ + frame[0];
+        for (int r = 0; r < rounds; r++) {
+            for (int f = 0; f < n; f++) {
+                AssetImage asset(&asset_pack, anim, f);
+                drawer.drawAsset(r * 7, 0, &asset, false, true);
+            }
+        }
+        auto t2 = clock::now();
+        sink_ = sink_ + frame[0];
+
+        double imageUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / (rounds * n);
+        double assetUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / (rounds * n);
+        printf("%-16s %10.2f %10.2f %6.2fx\n", src.name_, imageUs, assetUs, imageUs / assetUs);
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+int
+main(int argc, char ** argv)
+{
+    int positions = (argc > 1)? atoi(argv[1]) : 20;
+    if (positions < 0) positions = 20;
+
+    bool ok = check(positions);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    benchmark();
+    return (ok)? 0 : 1;
+}
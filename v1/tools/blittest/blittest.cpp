@@ -0,0 +1,346 @@
+/**********************************************************************/
+/**
+ * @brief  Blit Kernel Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Check mono_blit() / mono_fill() (mono_blit.hpp) against a per pixel
+ * reference, every raster op with and without a mask :
+ *   - exhaustive over the source and destination column shifts (0 ~ 7),
+ *     the widths 1 ~ 24 (the edge masks of the head / tail pages, 1 ~ 3
+ *     pages), the row alignments of the word path and some heights
+ *   - clipping at all four borders of the destination, the source and
+ *     the mask, sweeping the position across each border
+ *   - random rectangles on buffers at every byte alignment
+ * then measure a panel wide copy at each shift against the reference.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller blittest.cpp \
+ *       ../../firmware/controller/mono_blit.cpp -o blittest
+ *
+ * Run :
+ *   ./blittest [loops]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "mono_blit.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define ROPS                (5)
+
+// Odd heights, the pages are not word aligned one after another.
+#define DST_WIDTH           (40)
+#define DST_HEIGHT          (13)
+#define SRC_WIDTH           (37)        // Partial last page
+#define SRC_HEIGHT          (12)
+
+static const char * rop_names_[ROPS] = { "copy", "or", "and", "xor", "andnot" };
+
+// A bitmap of the panel layout at a byte offset from a word boundary.
+class Bitmap
+{
+public:
+    Bitmap(int width, int height, int offset = 0) {
+        width_ = width;
+        height_ = height;
+        storage_.resize(bytes() + 8);
+        buffer_ = storage_.data() + offset;
+    }
+    int bytes(void) const { return ((width_ + 7) / 8) * height_; }
+    int get(int c, int y) const { return (buffer_[((c / 8) * height_) + y] >> (c % 8)) & 1; }
+    void set(int c, int y, int v) {
+        uint8_t * p = &buffer_[((c / 8) * height_) + y];
+        *p = (uint8_t)((*p & ~(1 << (c % 8))) | (v << (c % 8)));
+    }
+    void randomize(uint32_t * seed) {
+        for (int i = 0; i < bytes(); i++) buffer_[i] = (uint8_t)(next(seed) >> 24);
+    }
+    mono_plane_t plane(void) const { return { width_, height_, buffer_ }; }
+    mono_surface_t surface(void) { return { width_, height_, buffer_ }; }
+
+    static uint32_t next(uint32_t * seed) {
+        *seed ^= *seed << 13;
+        *seed ^= *seed >> 17;
+        *seed ^= *seed << 5;
+        return *seed;
+    }
+
+    int width_;
+    int height_;
+    uint8_t * buffer_;
+private:
+    std::vector<uint8_t> storage_;
+};
+
+typedef struct result_ {
+    uint64_t blits_ = 0;
+    uint64_t diffs_ = 0;            // Blits with a pixel differ
+} result_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Reference
+ *----------------------------------------------------------------------
+ */
+
+static inline int
+ref_rop(int rop, int d, int s)
+{
+    switch (rop) {
+    case MONO_ROP_COPY:   return s;
+    case MONO_ROP_OR:     return d | s;
+    case MONO_ROP_AND:    return d & s;
+    case MONO_ROP_XOR:    return d ^ s;
+    case MONO_ROP_ANDNOT: return d & !s;
+    }
+    return d;
+}
+
+// A pixel is written if it is in the destination, the source and the mask.
+static void
+ref_blit(Bitmap * dst, int dx, int dy, const Bitmap & src, int sx, int sy,
+         int width, int height, int rop, const Bitmap * mask)
+{
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            int c = dx + i, y = dy + j, u = sx + i, v = sy + j;
+            if (c < 0 || c >= dst->width_ || y < 0 || y >= dst->height_) continue;
+            if (u < 0 || u >= src.width_ || v < 0 || v >= src.height_) continue;
+            if (mask) {
+                if (u >= mask->width_ || v >= mask->height_ || !mask->get(u, v)) continue;
+            }
+            dst->set(c, y, ref_rop(rop, dst->get(c, y), src.get(u, v)));
+        }
+    }
+}
+
+static void
+ref_fill(Bitmap * dst, int dx, int dy, int width, int height, int rop)
+{
+    for (int y = dy; y < dy + height; y++) {
+        for (int c = dx; c < dx + width; c++) {
+            if (c < 0 || c >= dst->width_ || y < 0 || y >= dst->height_) continue;
+            dst->set(c, y, ref_rop(rop, dst->get(c, y), 1));
+        }
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Check
+ *----------------------------------------------------------------------
+ */
+
+// The kernel and the reference from the same destination.
+static void
+blit_case(result_t * r, Bitmap * dst, Bitmap * ref, const std::vector<uint8_t> & init,
+          int dx, int dy, const Bitmap & src, int sx, int sy, int width, int height,
+          int rop, const Bitmap * mask)
+{
+    memcpy(dst->buffer_, init.data(), dst->bytes());
+    memcpy(ref->buffer_, init.data(), ref->bytes());
+    mono_surface_t surface = dst->surface();
+    mono_plane_t plane = src.plane();
+    mono_plane_t maskPlane;
+    if (mask) maskPlane = mask->plane();
+    mono_blit(&surface, dx, dy, &plane, sx, sy, width, height, (mono_rop_t)rop, (mask)? &maskPlane : nullptr);
+    ref_blit(ref, dx, dy, src, sx, sy, width, height, rop, mask);
+    r->blits_++;
+    if (memcmp(dst->buffer_, ref->buffer_, dst->bytes()) != 0) {
+        if (r->diffs_ == 0) {
+            printf("  first diff : %s%s dst %d,%d src %d,%d size %dx%d\n",
+                rop_names_[rop], (mask)? " mask" : "", dx, dy, sx, sy, width, height);
+        }
+        r->diffs_++;
+    }
+}
+
+// Every shift pair, width and row alignment, inside the bitmaps.
+static result_t
+check_shifts(int rop, bool masked)
+{
+    static const int heights[] = { 1, 3, 4, 5, 8, 9 };
+    uint32_t seed = 0x2545F491UL + rop;
+    result_t r;
+    Bitmap dst(DST_WIDTH, DST_HEIGHT), ref(DST_WIDTH, DST_HEIGHT);
+    Bitmap src(SRC_WIDTH, SRC_HEIGHT), mask(SRC_WIDTH, SRC_HEIGHT);
+    src.randomize(&seed);
+    mask.randomize(&seed);
+    std::vector<uint8_t> init(dst.bytes());
+    for (uint8_t & b : init) b = (uint8_t)(Bitmap::next(&seed) >> 24);
+
+    for (int ss = 0; ss < 8; ss++) {
+        for (int ds = 0; ds < 8; ds++) {
+            for (int width = 1; width <= 24; width++) {
+                int sx = (width + ss <= SRC_WIDTH - 8)? 8 + ss : ss;
+                for (int sy = 0; sy < 4; sy++) {
+                    for (int dy = 0; dy < 4; dy++) {
+                        for (int height : heights) {
+                            blit_case(&r, &dst, &ref, init, 8 + ds, dy, src, sx, sy, width, height,
+                                rop, (masked)? &mask : nullptr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return r;
+}
+
+// The rectangle swept across the borders of the destination and the source.
+static result_t
+check_clip(int rop, bool masked)
+{
+    static const int sxs[] = { -9, -3, 0, 5, 20, 34 };
+    static const int sys[] = { -5, 0, 3, 10 };
+    static const int sizes[][2] = { { 20, 9 }, { 45, 15 }, { 1, 1 } };
+    uint32_t seed = 0x9E3779B9UL + rop;
+    result_t r;
+    Bitmap dst(DST_WIDTH, DST_HEIGHT), ref(DST_WIDTH, DST_HEIGHT);
+    Bitmap src(SRC_WIDTH, SRC_HEIGHT), mask(SRC_WIDTH, SRC_HEIGHT);
+    src.randomize(&seed);
+    mask.randomize(&seed);
+    std::vector<uint8_t> init(dst.bytes());
+    for (uint8_t & b : init) b = (uint8_t)(Bitmap::next(&seed) >> 24);
+
+    for (const auto & size : sizes) {
+        for (int dx = -size[0] - 2; dx <= DST_WIDTH + 2; dx++) {
+            for (int dy = -size[1] - 2; dy <= DST_HEIGHT + 2; dy++) {
+                for (int sx : sxs) {
+                    for (int sy : sys) {
+                        blit_case(&r, &dst, &ref, init, dx, dy, src, sx, sy, size[0], size[1],
+                            rop, (masked)? &mask : nullptr);
+                    }
+                }
+            }
+        }
+    }
+    return r;
+}
+
+// Random rectangles, the buffers at every byte offset.
+static result_t
+check_random(int rop, bool masked, int loops)
+{
+    uint32_t seed = 0xB5297A4DUL + rop;
+    result_t r;
+    for (int offset = 0; offset < 16; offset++) {
+        int dw = 1 + (Bitmap::next(&seed) % 64), dh = 1 + (Bitmap::next(&seed) % 40);
+        int sw = 1 + (Bitmap::next(&seed) % 64), sh = 1 + (Bitmap::next(&seed) % 40);
+        Bitmap dst(dw, dh, offset & 3), ref(dw, dh, offset & 3);
+        Bitmap src(sw, sh, offset >> 2), mask(sw, sh, (offset + 1) & 3);
+        src.randomize(&seed);
+        mask.randomize(&seed);
+        std::vector<uint8_t> init(dst.bytes());
+        for (int i = 0; i < loops; i++) {
+            for (uint8_t & b : init) b = (uint8_t)(Bitmap::next(&seed) >> 24);
+            auto rnd = [&](int lo, int hi) { return lo + (int)(Bitmap::next(&seed) % (uint32_t)(hi - lo + 1)); };
+            int width = rnd(0, sw + 8), height = rnd(0, sh + 8);
+            blit_case(&r, &dst, &ref, init, rnd(-width - 4, dw + 4), rnd(-height - 4, dh + 4),
+                src, rnd(-12, sw + 4), rnd(-12, sh + 4), width, height, rop, (masked)? &mask : nullptr);
+        }
+    }
+    return r;
+}
+
+static result_t
+check_fill(int rop)
+{
+    static const int heights[] = { 0, 1, 3, 4, 5, 13, 20 };
+    uint32_t seed = 0x68E31DA4UL + rop;
+    result_t r;
+    for (int offset = 0; offset < 4; offset++) {
+        Bitmap dst(DST_WIDTH, DST_HEIGHT, offset), ref(DST_WIDTH, DST_HEIGHT, offset);
+        std::vector<uint8_t> init(dst.bytes());
+        for (uint8_t & b : init) b = (uint8_t)(Bitmap::next(&seed) >> 24);
+        for (int dx = -10; dx <= DST_WIDTH + 2; dx++) {
+            for (int width = 0; width <= 26; width++) {
+                for (int dy = -6; dy <= DST_HEIGHT + 2; dy++) {
+                    for (int height : heights) {
+                        memcpy(dst.buffer_, init.data(), dst.bytes());
+                        memcpy(ref.buffer_, init.data(), ref.bytes());
+                        mono_surface_t surface = dst.surface();
+                        mono_fill(&surface, dx, dy, width, height, (mono_rop_t)rop);
+                        ref_fill(&ref, dx, dy, width, height, rop);
+                        r.blits_++;
+                        if (memcmp(dst.buffer_, ref.buffer_, dst.bytes()) != 0) {
+                            if (r.diffs_ == 0) {
+                                printf("  first diff : fill %s dst %d,%d size %dx%d offset %d\n",
+                                    rop_names_[rop], dx, dy, width, height, offset);
+                            }
+                            r.diffs_++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return r;
+}
+
+static bool
+report(const char * name, int rop, bool masked, const result_t & r)
+{
+    printf("%-8s %-7s %-5s %9llu blits, %llu differ\n", name, rop_names_[rop], (masked)? "mask" : "",
+        (unsigned long long)r.blits_, (unsigned long long)r.diffs_);
+    return (r.diffs_ == 0);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+int
+main(int argc, char ** argv)
+{
+    int loops = (argc > 1)? atoi(argv[1]) : 20000;
+    if (loops <= 0) loops = 20000;
+
+    bool ok = true;
+    for (int rop = 0; rop < ROPS; rop++) {
+        for (int masked = 0; masked < 2; masked++) {
+            ok &= report("shifts", rop, masked, check_shifts(rop, masked));
+            ok &= report("clip", rop, masked, check_clip(rop, masked));
+            ok &= report("random", rop, masked, check_random(rop, masked, loops));
+        }
+        ok &= report("fill", rop, false, check_fill(rop));
+    }
+    printf("check : %s\n", (ok)? "OK" : "NG");
+
+    // A 128 wide plane onto a panel at each column shift.
+    using clock = std::chrono::steady_clock;
+    uint32_t seed = 1;
+    Bitmap panel(CV_WIDTH, CV_HEIGHT), src(128, CV_HEIGHT);
+    src.randomize(&seed);
+    mono_surface_t surface = panel.surface();
+    mono_plane_t plane = src.plane();
+    const int reps = 20000;
+    for (int shift = 0; shift < 8; shift++) {
+        auto t0 = clock::now();
+        for (int i = 0; i < reps; i++) {
+            mono_blit(&surface, 0, 0, &plane, 40 + shift + (i & 8), 0, CV_WIDTH, CV_HEIGHT);
+        }
+        double kernelNs = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / reps;
+        t0 = clock::now();
+        for (int i = 0; i < reps / 10; i++) {
+            ref_blit(&panel, 0, 0, src, 40 + shift + (i & 8), 0, CV_WIDTH, CV_HEIGHT, MONO_ROP_COPY, nullptr);
+        }
+        double refNs = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / (reps / 10);
+        printf("panel %dx%d shift %d : kernel %8.1f ns, per pixel %9.1f ns, %5.1fx\n",
+            CV_WIDTH, CV_HEIGHT, shift, kernelNs, refNs, refNs / kernelNs);
+    }
+    return (ok)? 0 : 1;
+}
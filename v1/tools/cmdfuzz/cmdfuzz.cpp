@@ -0,0 +1,297 @@
+/**********************************************************************/
+/**
+ * @brief  Command Parser Fuzz Test (Host Tool)
+ * @author naoa
+ *
+ * Feed CmdParser (the serial command parser of the controller) with
+ *   - random text lines, checked against a reference split
+ *   - random binary frames, checked byte by byte
+ *   - both interleaved, overlong lines, non printable text and corrupted frames
+ *   - random noise, then a resync (newlines) and valid commands
+ * and check the CRC against the bitwise and the bridge table versions.
+ *
+ * Build :
+ *   g++ -O1 -g -std=c++17 -fsanitize=address,undefined -I../../firmware/controller \
+ *       cmdfuzz.cpp ../../firmware/controller/cmd_parser.cpp -o cmdfuzz
+ *
+ * Run :
+ *   ./cmdfuzz [iterations] [seed]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cmd_parser.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Expected command
+typedef struct expect_ {
+    bool binary_;
+    std::vector<std::string> args_;     // Text, up to CMDPARSER_MAX_ARGS
+    uint8_t cmd_;                       // Binary
+    std::vector<uint8_t> payload_;
+} expect_t;
+
+static uint32_t seed_ = 1;
+static int fails_ = 0;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
+
+static int
+rnd(int n)
+{
+    return (int)(rnd() % (uint32_t)n);
+}
+
+static uint16_t
+crc16_bitwise(const uint8_t * data, size_t size)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 0x8000)? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Same to SpiI2cBridge::calc_crc16()
+static uint16_t
+crc16_table(const uint8_t * data, size_t size)
+{
+    static uint16_t table[256];
+    static bool inited = false;
+    if (!inited) {
+        inited = true;
+        for (uint16_t i = 0; i < 256; i++) {
+            uint16_t crc = i << 8;
+            for (int j = 0; j < 8; j++) {
+                crc = (crc & 0x8000)? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+            }
+            table[i] = crc;
+        }
+    }
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc = (uint16_t)((crc << 8) ^ table[((crc >> 8) ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+// A valid text line, and its expected tokens.
+static void
+makeText(std::vector<uint8_t> * out, expect_t * e)
+{
+    static const char spaces[] = { ' ', ' ', ' ', '\t', '\r', '\0' };
+    e->binary_ = false;
+    e->args_.clear();
+
+    int tokens = 1 + rnd(20);
+    std::string line;
+    if (rnd(4) == 0) line += ' ';
+    for (int t = 0; t < tokens; t++) {
+        std::string token;
+        int len = 1 + rnd(10);
+        for (int i = 0; i < len; i++) {
+            token += (char)(0x21 + rnd(0x7F - 0x21));
+        }
+        if ((int)line.size() + (int)token.size() + 2 >= CMDPARSER_MAX_LINE_LEN) break;
+        if (e->args_.size() < CMDPARSER_MAX_ARGS) e->args_.push_back(token);
+        line += token;
+        int n = 1 + rnd(2);
+        for (int i = 0; i < n; i++) line += spaces[rnd(sizeof(spaces))];
+    }
+    out->insert(out->end(), line.begin(), line.end());
+    out->push_back('\n');
+}
+
+static void
+makeBinary(std::vector<uint8_t> * out, expect_t * e)
+{
+    e->binary_ = true;
+    e->cmd_ = (uint8_t)rnd();
+    e->payload_.resize(rnd(4) == 0 ? 0 : rnd(CMDPARSER_MAX_PAYLOAD + 1));
+    for (auto & b : e->payload_) b = (uint8_t)rnd();
+
+    uint8_t frame[CMDPARSER_HEADER_SIZE + CMDPARSER_MAX_PAYLOAD + CMDPARSER_CRC_SIZE];
+    size_t n = CmdParser::makeFrame(frame, sizeof(frame), e->cmd_, e->payload_.data(), e->payload_.size());
+    out->insert(out->end(), frame, frame + n);
+}
+
+// Resync after garbage, enough newlines to finish the longest frame.
+static void
+makeFlush(std::vector<uint8_t> * out)
+{
+    out->insert(out->end(), CMDPARSER_HEADER_SIZE + CMDPARSER_MAX_PAYLOAD + CMDPARSER_CRC_SIZE + 2, '\n');
+}
+
+static bool
+matches(CmdParser * parser, cmdparser_result_t result, const expect_t * e)
+{
+    if (e->binary_) {
+        if (result != CMDPARSER_BINARY) return false;
+        if (parser->binaryCmd() != e->cmd_) return false;
+        if (parser->payloadSize() != (int)e->payload_.size()) return false;
+        return e->payload_.empty() || memcmp(parser->payload(), e->payload_.data(), e->payload_.size()) == 0;
+    }
+    if (result != CMDPARSER_TEXT) return false;
+    if (parser->argc() != (int)e->args_.size()) return false;
+    for (int i = 0; i < parser->argc(); i++) {
+        if (e->args_[i] != parser->arg(i)) return false;
+    }
+    return parser->arg(parser->argc())[0] == '\0';
+}
+
+// Feed the stream, the commands must come out in order. Returns the errors reported.
+static int
+run(const char * label, const std::vector<uint8_t> & stream, const std::vector<expect_t> & expects, bool exact)
+{
+    CmdParser parser;
+    size_t next = 0;
+    int errors = 0;
+    for (uint8_t c : stream) {
+        cmdparser_result_t r = parser.push(c);
+        if (r == CMDPARSER_ERROR) errors++;
+        if (r != CMDPARSER_TEXT && r != CMDPARSER_BINARY) continue;
+
+        // Invariants
+        if (parser.argc() > CMDPARSER_MAX_ARGS || parser.payloadSize() > CMDPARSER_MAX_PAYLOAD) {
+            printf("%s : out of range\n", label);
+            fails_++;
+            return errors;
+        }
+        if (!exact && next < expects.size() && !matches(&parser, r, &expects[next])) continue;
+        if (next >= expects.size() || !matches(&parser, r, &expects[next])) {
+            printf("%s : command %zu mismatch\n", label, next);
+            fails_++;
+            return errors;
+        }
+        next++;
+    }
+    if (next != expects.size()) {
+        printf("%s : %zu / %zu commands\n", label, next, expects.size());
+        fails_++;
+    }
+    return errors;
+}
+
+int
+main(int argc, char ** argv)
+{
+    int iterations = (argc > 1)? atoi(argv[1]) : 2000;
+    seed_ = (argc > 2)? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+    if (seed_ == 0) seed_ = 1;
+
+    // CRC
+    for (int i = 0; i < 1000; i++) {
+        uint8_t data[64];
+        int n = rnd(sizeof(data));
+        for (int j = 0; j < n; j++) data[j] = (uint8_t)rnd();
+        uint16_t a = CmdParser::crc16(data, n);
+        if (a != crc16_bitwise(data, n) || a != crc16_table(data, n)) {
+            printf("crc mismatch\n");
+            fails_++;
+            break;
+        }
+    }
+
+    int commands = 0;
+    int corrupted = 0;
+    int errors = 0;
+    for (int it = 0; it < iterations; it++) {
+        std::vector<uint8_t> stream;
+        std::vector<expect_t> expects;
+
+        // Mixed text and binary
+        int n = 1 + rnd(20);
+        for (int i = 0; i < n; i++) {
+            expect_t e;
+            if (rnd(2)) makeText(&stream, &e); else makeBinary(&stream, &e);
+            if (rnd(8) == 0) stream.push_back('\n');  // Empty line
+            expects.push_back(e);
+        }
+        run("mixed", stream, expects, true);
+        commands += n;
+
+        // Overlong line, corrupted frame, then resync. A broken header may
+        // leave a printable piece of the payload between two '\n' as a text
+        // command, then only the valid commands are checked in order.
+        stream.clear();
+        expects.clear();
+        {
+            expect_t e;
+            int len = CMDPARSER_MAX_LINE_LEN + rnd(100);
+            for (int i = 0; i < len; i++) stream.push_back((uint8_t)('a' + rnd(26)));
+            stream.push_back('\n');
+            makeText(&stream, &e);
+            expects.push_back(e);
+
+            std::vector<uint8_t> frame;
+            makeBinary(&frame, &e);
+            // Not SYNC1, the frame would be a text line.
+            frame[1 + rnd(frame.size() - 1)] ^= (uint8_t)(1 + rnd(255));
+            stream.insert(stream.end(), frame.begin(), frame.end());
+            makeFlush(&stream);
+            corrupted++;
+
+            makeBinary(&stream, &e);
+            expects.push_back(e);
+        }
+        int err = run("corrupt", stream, expects, false);
+        if (err < 2) {
+            printf("corrupt : %d errors reported, expected 2+\n", err);
+            fails_++;
+        }
+        errors += err;
+
+        // Noise, resync, then valid commands. (a garbage command may pass in the noise)
+        stream.clear();
+        expects.clear();
+        int noise = rnd(2000);
+        for (int i = 0; i < noise; i++) {
+            uint8_t c = (uint8_t)rnd();
+            if (rnd(16) == 0) c = '\n';
+            if (rnd(32) == 0) c = CMDPARSER_SYNC1;
+            stream.push_back(c);
+        }
+        makeFlush(&stream);
+        for (int i = 0; i < 3; i++) {
+            expect_t e;
+            if (rnd(2)) makeText(&stream, &e); else makeBinary(&stream, &e);
+            expects.push_back(e);
+        }
+        errors += run("noise", stream, expects, false);
+
+        if (fails_ > 10) break;
+    }
+
+    printf("%d iterations, %d commands, %d corrupted frames, %d errors reported\n",
+        iterations, commands, corrupted, errors);
+    printf("check : %s\n", (fails_ == 0)? "OK" : "NG");
+    return (fails_ == 0)? 0 : 1;
+}
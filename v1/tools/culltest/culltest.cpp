@@ -0,0 +1,372 @@
+/**********************************************************************/
+/**
+ * @brief  Drawer Margin Culling Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Check CyclicMonoDrawer (the visible spans, the column table and the
+ * panel fills) against the drawer before the culling : every primitive
+ * plotted dot by dot through CyclicMonoScreen::setDot(), which drops the
+ * margin dots after the mapping. Random primitives over the x wrap and the
+ * clipping, in both colors on a random frame.
+ *
+ * Then measures a frame of the wide content on both : full width rect
+ * fills, 128 wide images (copy and blend) and the render mode 2 concentric
+ * circles, with the dots plotted and the time.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller culltest.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o culltest
+ *
+ * Run :
+ *   ./culltest [primitives]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define IMAGE_WIDTH         (128)
+#define IMAGE_HEIGHT        (64)
+#define IMAGE_BYTES         (IMAGE_WIDTH * ((IMAGE_HEIGHT + 7) / 8))
+
+static uint32_t rnd_ = 0x5EED0031UL;
+static volatile uint32_t sink_ = 0;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+// The drawer before the culling, a dot at a time through the screen.
+// (same rasterization, so the dots are the same)
+class DotDrawer
+{
+public:
+    // cull : only to count the dots on the panels
+    explicit DotDrawer(CyclicMonoScreen * screen, const CyclicMonoDrawer * cull) : screen_(screen), cull_(cull) {}
+
+public:
+    void drawDot(int x, int y, color_t c) {
+        dots_++;
+        if (0 <= y && y < CV_HEIGHT && cull_->isVisible(x)) shown_++;
+        screen_->setDot(x, y, c);
+    }
+    void drawHLine(int x1, int x2, int y, color_t c) {
+        if (y < 0 || CV_HEIGHT <= y) return;
+        if (x1 > x2) std::swap(x1, x2);
+        for (int x = x1; x <= x2; x++) drawDot(x, y, c);
+    }
+    void drawVLine(int x, int y1, int y2, color_t c) {
+        if ((y1 < 0 && y2 < 0) || (CV_HEIGHT <= y1 && CV_HEIGHT <= y2)) return;
+        if (y1 > y2) std::swap(y1, y2);
+        if (y1 < 0) y1 = 0;
+        if (y2 >= CV_HEIGHT) y2 = CV_HEIGHT - 1;
+        for (int y = y1; y <= y2; y++) drawDot(x, y, c);
+    }
+    void drawLine(int x1, int y1, int x2, int y2, color_t c) {
+        int xinc1 = (x2 >= x1)? 1 : -1, xinc2 = xinc1;
+        int yinc1 = (y2 >= y1)? 1 : -1, yinc2 = yinc1;
+        int deltax = abs(x2 - x1);
+        int deltay = abs(y2 - y1);
+        int den, num, numadd, numpixels;
+        if (deltax >= deltay) {
+            xinc1 = 0; yinc2 = 0;
+            den = deltax; num = deltax / 2; numadd = deltay; numpixels = deltax;
+        } else {
+            xinc2 = 0; yinc1 = 0;
+            den = deltay; num = deltay / 2; numadd = deltax; numpixels = deltay;
+        }
+        int x = x1, y = y1;
+        for (int i = 0; i <= numpixels; i++) {
+            drawDot(x, y, c);
+            num += numadd;
+            if (num >= den) { num -= den; x += xinc1; y += yinc1; }
+            x += xinc2; y += yinc2;
+        }
+    }
+    void drawRectNoFill(int x1, int y1, int x2, int y2, color_t c) {
+        drawHLine(x1, x2, y1, c);
+        drawHLine(x1, x2, y2, c);
+        drawVLine(x1, y1, y2, c);
+        drawVLine(x2, y1, y2, c);
+    }
+    void drawRectFill(int x1, int y1, int x2, int y2, color_t c) {
+        if (y1 > y2) std::swap(y1, y2);
+        for (int y = y1; y <= y2; y++) drawHLine(x1, x2, y, c);
+    }
+    void drawCircle(int x0, int y0, int radius, color_t c) {
+        int x = radius - 1, y = 0, dx = 1, dy = 1;
+        int err = dx - (radius << 1);
+        while (x >= y) {
+            drawDot(x0 + x, y0 + y, c);
+            drawDot(x0 + y, y0 + x, c);
+            drawDot(x0 - y, y0 + x, c);
+            drawDot(x0 - x, y0 + y, c);
+            drawDot(x0 - x, y0 - y, c);
+            drawDot(x0 - y, y0 - x, c);
+            drawDot(x0 + y, y0 - x, c);
+            drawDot(x0 + x, y0 - y, c);
+            if (err <= 0) { y++; err += dy; dy += 2; }
+            if (err > 0) { x--; dx += 2; err += dx - (radius << 1); }
+        }
+    }
+    void drawCircleFill(int x0, int y0, int radius, color_t c) {
+        int x = radius - 1, y = 0, dx = 1, dy = 1;
+        int err = dx - (radius << 1);
+        while (x >= y) {
+            drawHLine(x0 - x, x0 + x, y0 + y, c);
+            drawHLine(x0 - x, x0 + x, y0 - y, c);
+            drawVLine(x0 - y, y0 - x, y0 + x, c);
+            drawVLine(x0 + y, y0 - x, y0 + x, c);
+            if (err <= 0) { y++; err += dy; dy += 2; }
+            if (err > 0) { x--; dx += 2; err += dx - (radius << 1); }
+        }
+    }
+    void drawImage(int x, int y, MonoImage * image, bool blend) {
+        for (int y2 = 0; y2 < image->height(); y2++) {
+            for (int x2 = 0; x2 < image->width(); x2++) {
+                if (blend && image->hasAlpha() && image->getDotAlpha(x2, y2) == 0) continue;
+                drawDot(x + x2, y + y2, (color_t)image->getDot(x2, y2));
+            }
+        }
+    }
+
+public:
+    long dots_ = 0;
+    long shown_ = 0;            // Dots on the panels
+
+private:
+    CyclicMonoScreen * screen_;
+    const CyclicMonoDrawer * cull_;
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+static int
+rnd_range(int lo, int hi)
+{
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+template <typename F>
+static double
+measure(int count, F func)
+{
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    func(count);
+    return std::chrono::duration<double, std::micro>(clock::now() - t0).count() / count;
+}
+
+static void
+setup(CyclicMonoScreen * screen, uint8_t * frame)
+{
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        screen->getMonoScreen(i)->setBuffer(frame + (i * CV_ONE_FRAME_BYTES));
+    }
+}
+
+static const char *
+primitive_name(int kind)
+{
+    static const char * names[] = {
+        "dot", "hline", "vline", "line", "rect", "rect fill", "circle", "circle fill", "image", "image blend",
+    };
+    return names[kind];
+}
+
+static bool
+check(int primitives, MonoImage * image)
+{
+    static uint8_t cullFrame[CV_FRAME_BYTES], dotFrame[CV_FRAME_BYTES];
+    CyclicMonoScreen cullScreen, dotScreen;
+    setup(&cullScreen, cullFrame);
+    setup(&dotScreen, dotFrame);
+    CyclicMonoDrawer drawer;
+    drawer.init(&cullScreen);
+    DotDrawer ref(&dotScreen, &drawer);
+
+    const int kinds = 10;
+    int count[kinds] = {}, bad[kinds] = {};
+    for (int n = 0; n < primitives; n++) {
+        for (int i = 0; i < CV_FRAME_BYTES; i++) cullFrame[i] = (uint8_t)rnd();
+        memcpy(dotFrame, cullFrame, sizeof(dotFrame));
+
+        int kind = n % kinds;
+        color_t c = (rnd() & 1)? DISP_COLOR_WHITE : DISP_COLOR_BLACK;
+        // Around the x wrap and over the top / bottom, some wider than the cylinder.
+        int x1 = rnd_range(-2 * CV_V_WIDTH, 2 * CV_V_WIDTH);
+        int y1 = rnd_range(-40, CV_HEIGHT + 40);
+        int w = (rnd() & 7)? rnd_range(-CV_V_WIDTH / 2, CV_V_WIDTH / 2) : rnd_range(-2 * CV_V_WIDTH, 2 * CV_V_WIDTH);
+        int x2 = x1 + w;
+        int y2 = rnd_range(-40, CV_HEIGHT + 40);
+        int r = rnd_range(1, 100);
+
+        switch (kind) {
+        case 0: drawer.drawDot(x1, y1, c);                      ref.drawDot(x1, y1, c); break;
+        case 1: drawer.drawHLine(x1, x2, y1, c);                ref.drawHLine(x1, x2, y1, c); break;
+        case 2: drawer.drawVLine(x1, y1, y2, c);                ref.drawVLine(x1, y1, y2, c); break;
+        case 3: drawer.drawLine(x1, y1, x2, y2, c);             ref.drawLine(x1, y1, x2, y2, c); break;
+        case 4: drawer.drawRectNoFill(x1, y1, x2, y2, c);       ref.drawRectNoFill(x1, y1, x2, y2, c); break;
+        case 5: drawer.drawRectFill(x1, y1, x2, y2, c);         ref.drawRectFill(x1, y1, x2, y2, c); break;
+        case 6: drawer.drawCircle(x1, y1, r, c);                ref.drawCircle(x1, y1, r, c); break;
+        case 7: drawer.drawCircleFill(x1, y1, r, c);            ref.drawCircleFill(x1, y1, r, c); break;
+        case 8: drawer.drawImage(x1, y1, image);                ref.drawImage(x1, y1, image, false); break;
+        case 9: drawer.drawImageBlend(x1, y1, image);           ref.drawImage(x1, y1, image, true); break;
+        }
+        count[kind]++;
+        if (memcmp(cullFrame, dotFrame, sizeof(cullFrame)) != 0) {
+            if (bad[kind] == 0) {
+                printf("  %s mismatch : (%d, %d) (%d, %d) r %d c %d\n", primitive_name(kind), x1, y1, x2, y2, r, (int)c);
+            }
+            bad[kind]++;
+        }
+    }
+
+    bool ok = true;
+    for (int k = 0; k < kinds; k++) {
+        printf("%-12s %7d primitives, %d differ  %s\n", primitive_name(k), count[k], bad[k], (bad[k] == 0)? "OK" : "NG");
+        ok &= (bad[k] == 0);
+    }
+    return ok;
+}
+
+// A frame of each wide content, culled drawer against the dot drawer.
+static void
+benchmark(MonoImage * image)
+{
+    static uint8_t cullFrame[CV_FRAME_BYTES], dotFrame[CV_FRAME_BYTES];
+    CyclicMonoScreen cullScreen, dotScreen;
+    setup(&cullScreen, cullFrame);
+    setup(&dotScreen, dotFrame);
+    CyclicMonoDrawer drawer;
+    drawer.init(&cullScreen);
+    DotDrawer ref(&dotScreen, &drawer);
+
+    long visible = 0;
+    for (int x = 0; x < CV_V_WIDTH; x++) visible += drawer.isVisible(x)? 1 : 0;
+    printf("visible columns %ld / %d (%.1f %%)\n", visible, CV_V_WIDTH, (100.0 * visible) / CV_V_WIDTH);
+
+    struct {
+        const char * name;
+        int frames;
+        void (*cull)(CyclicMonoDrawer * d, MonoImage * image, int f);
+        void (*dot)(DotDrawer * d, MonoImage * image, int f);
+    } cases[] = {
+        { "rect fill (full width, 8 rows x 8)", 2000,
+          [](CyclicMonoDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) d->drawRectFill(f, i * 16, f + CV_V_WIDTH - 1, i * 16 + 7, DISP_COLOR_WHITE);
+          },
+          [](DotDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) d->drawRectFill(f, i * 16, f + CV_V_WIDTH - 1, i * 16 + 7, DISP_COLOR_WHITE);
+          } },
+        { "image 128 x 64 x 8", 2000,
+          [](CyclicMonoDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) d->drawImage(f + (i * IMAGE_WIDTH), (i & 1) * 64, image);
+          },
+          [](DotDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) d->drawImage(f + (i * IMAGE_WIDTH), (i & 1) * 64, image, false);
+          } },
+        { "image blend 128 x 64 x 8", 2000,
+          [](CyclicMonoDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) d->drawImageBlend(f + (i * IMAGE_WIDTH), (i & 1) * 64, image);
+          },
+          [](DotDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) d->drawImage(f + (i * IMAGE_WIDTH), (i & 1) * 64, image, true);
+          } },
+        { "render mode 2 circles (40)", 20000,
+          [](CyclicMonoDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) {
+                  const int r = 50;
+                  int x = (((r * 2) + 3) * i) - f;
+                  for (int k = 0; k < 5; k++) d->drawCircle(x, 128 / 2, r - (k * 10), 1);
+              }
+          },
+          [](DotDrawer * d, MonoImage * image, int f) {
+              for (int i = 0; i < 8; i++) {
+                  const int r = 50;
+                  int x = (((r * 2) + 3) * i) - f;
+                  for (int k = 0; k < 5; k++) d->drawCircle(x, 128 / 2, r - (k * 10), 1);
+              }
+          } },
+    };
+
+    printf("%-36s %8s %10s %10s %10s %7s\n", "frame", "dots", "on panels", "dot us", "culled us", "ratio");
+    for (auto & t : cases) {
+        // The dots plotted of a frame, and the ones left after the culling.
+        ref.dots_ = 0;
+        ref.shown_ = 0;
+        t.dot(&ref, image, 0);
+        long dots = ref.dots_, shown = ref.shown_;
+
+        double dotUs = measure(t.frames, [&](int n) { for (int f = 0; f < n; f++) t.dot(&ref, image, f); });
+        sink_ = sink_ + dotFrame[0];
+        double cullUs = measure(t.frames, [&](int n) { for (int f = 0; f < n; f++) t.cull(&drawer, image, f); });
+        sink_ = sink_ + cullFrame[0];
+        printf("%-36s %8ld %10ld %10.2f %10.2f %6.2fx\n", t.name, dots, shown, dotUs, cullUs, cullUs / dotUs);
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+int
+main(int argc, char ** argv)
+{
+    int primitives = (argc > 1)? atoi(argv[1]) : 200000;
+    if (primitives <= 0) primitives = 200000;
+
+    // A 128 wide image with a random alpha.
+    static uint8_t imageData[IMAGE_BYTES], imageAlpha[IMAGE_BYTES];
+    for (int i = 0; i < IMAGE_BYTES; i++) {
+        imageData[i] = (uint8_t)rnd();
+        imageAlpha[i] = (uint8_t)rnd();
+    }
+    const mono_image_t imageSpec = {
+        IMAGE_WIDTH, IMAGE_HEIGHT, 0, 0, IMAGE_WIDTH, ((IMAGE_HEIGHT + 7) / 8) * 8, IMAGE_BYTES,
+        true, imageData, imageAlpha,
+    };
+    MonoImage image(&imageSpec);
+
+    bool ok = check(primitives, &image);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    benchmark(&image);
+    return (ok)? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/**********************************************************************/
+/**
+ * @brief  Arduino Core Stand-in for the Host Simulator (cvsim)
+ * @author naoa
+ *
+ * Only what the controller SPI bridge and the bridge firmware use. The
+ * time is the simulated time of the running core. (see cvsim.hpp)
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#ifndef ARDUINO
+#define ARDUINO                 (10819)
+#endif
+
+#define HIGH                    (1)
+#define LOW                     (0)
+#define INPUT                   (0)
+#define OUTPUT                  (1)
+#define PIN_LED                 (25)
+#define MSBFIRST                (1)
+#define SPI_MODE0               (0)
+#define SPI_MODE3               (3)
+
+#define __time_critical_func(x) x
+
+typedef unsigned int uint;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+uint64_t cvsim_now_ns(void);
+void cvsim_reset_request(void);
+uint get_core_num(void);                    // Of the controller or the bridge code running
+
+inline unsigned long millis(void) { return (unsigned long)(cvsim_now_ns() / 1000000ULL); }
+inline unsigned long micros(void) { return (unsigned long)(cvsim_now_ns() / 1000ULL); }
+inline void pinMode(int, int) {}
+void digitalWrite(int pin, int value);     // The chip selects of a shared bus
+inline void delay(unsigned long) {}
+
+inline void watchdog_enable(uint32_t, bool) { cvsim_reset_request(); }
+inline uint32_t save_and_disable_interrupts(void) { return 0; }
+inline void restore_interrupts(uint32_t) {}
+inline void tight_loop_contents(void) {}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+// Printed with cvsim -v only.
+class HardwareSerial
+{
+public:
+    void begin(unsigned long) {}
+    int printf(const char * format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,55 @@
+/**********************************************************************/
+/**
+ * @brief  SPI Master Stand-in for the Host Simulator (cvsim)
+ * @author naoa
+ *
+ * SPI is bus 0 and SPI1 is bus 1, to the simulated bridge selected by the
+ * hardware chip select or a GPIO one (digitalWrite()). Bytes are exchanged
+ * at the transfer, the time is taken in finishedAsync().
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <Arduino.h>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+class SPISettings
+{
+public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, int, int) : clock_(clock) {}
+    uint32_t clock_ = 4000000;
+};
+
+class SPIClassRP2040
+{
+public:
+    explicit SPIClassRP2040(int bus) : bus_(bus) {}
+
+    void setRX(int) {}
+    void setCS(int pin) { csPin_ = pin; }
+    void setSCK(int) {}
+    void setTX(int) {}
+    void begin(bool hwCS = false) { hwCS_ = hwCS; }
+
+    void beginTransaction(SPISettings settings) { clock_ = settings.clock_; }
+    void endTransaction(void) {}
+    void transferAsync(const void * txbuffer, void * rxbuffer, size_t size);
+    bool finishedAsync(void);
+
+private:
+    int bus_;
+    uint32_t clock_ = 4000000;
+    int csPin_ = -1;
+    bool hwCS_ = false;
+};
+
+extern SPIClassRP2040 SPI;
+extern SPIClassRP2040 SPI1;
@@ -0,0 +1,39 @@
+/**********************************************************************/
+/**
+ * @brief  SPI Slave Stand-in for the Host Simulator (cvsim)
+ * @author naoa
+ *
+ * One object for all the simulated bridges, the calls go to the bridge
+ * running now. (see cvsim_bridge.cpp)
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <SPI.h>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+typedef void (*SPISlaveRecvHandler)(uint8_t * data, size_t len);
+typedef void (*SPISlaveSentHandler)(void);
+
+class SPISlaveClass
+{
+public:
+    void setRX(int) {}
+    void setCS(int) {}
+    void setSCK(int) {}
+    void setTX(int) {}
+
+    void onDataRecv(SPISlaveRecvHandler handler);
+    void onDataSent(SPISlaveSentHandler handler);
+    void begin(SPISettings) {}
+    void setData(const uint8_t * data, size_t size);
+};
+
+extern SPISlaveClass SPISlave;
@@ -0,0 +1,81 @@
+/**********************************************************************/
+/**
+ * @brief  PIO Stand-in for the Host Simulator (cvsim)
+ * @author naoa
+ *
+ * Enough to build i2c.pio.h. The I2C transfers are the pio_i2c functions
+ * in cvsim_bridge.cpp, each state machine drives one SSD1306 model.
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <Arduino.h>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define NUM_PIOS                    (2)
+#define NUM_PIO_STATE_MACHINES      (4)
+
+typedef struct pio_hw_ {
+    int index_;
+} pio_hw_t;
+
+typedef pio_hw_t * PIO;
+
+extern pio_hw_t cvsim_pio_hw_[NUM_PIOS];
+#define pio0                        (&cvsim_pio_hw_[0])
+#define pio1                        (&cvsim_pio_hw_[1])
+
+struct pio_program {
+    const uint16_t * instructions;
+    uint8_t length;
+    int8_t origin;
+};
+
+typedef struct pio_sm_config_ {
+    uint32_t unused_;
+} pio_sm_config;
+
+enum pio_interrupt_source {
+    pis_interrupt0 = 8,
+};
+
+#define GPIO_OVERRIDE_INVERT        (1)
+#define clk_sys                     (0)
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+inline uint pio_add_program(PIO, const pio_program *) { return 0; }
+inline bool pio_sm_is_tx_fifo_full(PIO, uint) { return false; }
+inline pio_sm_config pio_get_default_sm_config(void) { return pio_sm_config(); }
+inline uint32_t clock_get_hz(int) { return 125000000; }
+
+inline void sm_config_set_wrap(pio_sm_config *, uint, uint) {}
+inline void sm_config_set_sideset(pio_sm_config *, uint, bool, bool) {}
+inline void sm_config_set_out_pins(pio_sm_config *, uint, uint) {}
+inline void sm_config_set_set_pins(pio_sm_config *, uint, uint) {}
+inline void sm_config_set_in_pins(pio_sm_config *, uint) {}
+inline void sm_config_set_sideset_pins(pio_sm_config *, uint) {}
+inline void sm_config_set_jmp_pin(pio_sm_config *, uint) {}
+inline void sm_config_set_out_shift(pio_sm_config *, bool, bool, uint) {}
+inline void sm_config_set_in_shift(pio_sm_config *, bool, bool, uint) {}
+inline void sm_config_set_clkdiv(pio_sm_config *, float) {}
+inline void gpio_pull_up(uint) {}
+inline void gpio_set_oeover(uint, uint) {}
+inline void pio_gpio_init(PIO, uint) {}
+inline void pio_sm_set_pins_with_mask(PIO, uint, uint32_t, uint32_t) {}
+inline void pio_sm_set_pindirs_with_mask(PIO, uint, uint32_t, uint32_t) {}
+inline void pio_set_irq0_source_enabled(PIO, enum pio_interrupt_source, bool) {}
+inline void pio_set_irq1_source_enabled(PIO, enum pio_interrupt_source, bool) {}
+inline void pio_interrupt_clear(PIO, uint) {}
+inline void pio_sm_init(PIO, uint, uint, const pio_sm_config *) {}
+inline void pio_sm_set_enabled(PIO, uint, bool) {}
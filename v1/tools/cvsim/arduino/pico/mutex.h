@@ -0,0 +1,16 @@
+/**********************************************************************/
+/**
+ * @brief  Pico Mutex Stand-in for the Host Simulator (cvsim)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+
+// The cores run one at a time.
+typedef struct mutex_ {
+    int owner_;
+} mutex_t;
+
+inline void mutex_init(mutex_t *) {}
+inline void mutex_enter_blocking(mutex_t *) {}
+inline void mutex_exit(mutex_t *) {}
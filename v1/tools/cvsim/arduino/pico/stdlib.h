@@ -0,0 +1,10 @@
+/**********************************************************************/
+/**
+ * @brief  Pico SDK Stand-in for the Host Simulator (cvsim)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include "hardware/pio.h"
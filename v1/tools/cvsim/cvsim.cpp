@@ -0,0 +1,1201 @@
+/**********************************************************************/
+/**
+ * @brief  Host Simulator of the Controller, SPI Link and Bridges (cvsim)
+ * @author naoa
+ *
+ * The controller SpiI2cBridge and 1 ~ 4 bridge firmwares (spi-i2c-bridge.ino,
+ * cvsim_bridge.cpp) linked through a byte accurate SPI bus model :
+ *   - master : each transfer starts after a fixed overhead, one byte per
+ *     8 SPI clocks, the two buses run in parallel on transferAsync()
+ *   - select : the bridge k is on the bus (k % buses). The bytes go to the
+ *     bridge of the hardware chip select, or the GPIO one driven low on a
+ *     shared bus. None or two selected is counted as a select error
+ *   - slave  : the PL022 fifos. The rx fifo goes to onDataRecv at the rx
+ *     level or after the rx timeout (in bit periods, 0 : never, the tail
+ *     of a transfer stays in the fifo). The tx fifo is refilled at half
+ *     empty, from setData() then onDataSent
+ *   - core1  : loop1() is deferred to the end of the I2C frame time, the
+ *     time measured from the bytes of the previous frame. The transfer
+ *     start is told to the bridge, for the present telemetry
+ * The writeFrameMulti() output goes to SSD1306 GDDRAM models, checked
+ * against the frames sent after every loop1().
+ *
+ *   - link   : clean up to a clock limit (the PL022 slave, clk_peri / 12),
+ *     above it a bit of a byte is flipped at a rate, both directions. The
+ *     limit can drop while running, and a background error rate can be set
+ *
+ * The controller trains the link rate (trainLink()) unless the clock is
+ * fixed. Random frames are sent with sendFrameDataParallel(), back to back
+ * or at a render period, then reports the frames shown / dropped / corrupt,
+ * the frame rate, the latency (send start to the last display written),
+ * the bus use and the link rate.
+ *
+ * The frames are presented (stage then present) unless -a. The skew is
+ * the spread of the I2C transfer starts of a frame over the bridges, and
+ * checked against the SPI side of the PRESENT broadcast (the command on
+ * each endpoint of the busiest bus, and the bridge rx timeout).
+ *
+ * Grayscale (-g) : the frames are bit planes, the bridges show them in
+ * turn from the back frame of the GDDRAM. A loop1() waiting for its flip
+ * starts at the flip time. The panel after each flip shows a plane of a
+ * frame, and the light of the pixels (Ssd1306Model) over a cycle, plane 0
+ * flip to plane 0 flip, is checked against the level of the planes.
+ *
+ * Scroll (-S) : a random layer around the cylinder moves by up to the
+ * rows a frame, sent by sendScrollFrame() while it fits, else rendered
+ * to a frame. Now and then the layer changes or a random frame is put in
+ * between. The panels are read through the start line, a page loaded
+ * ahead must not change the rows shown. Reports the I2C bytes a frame
+ * against the full frames.
+ *
+ * Sprites (-P count) : up to count sprites on the random frames, from a
+ * set of random assets larger than the bridge cache. The window of the
+ * assets moves, the old ones are evicted on the bridges and come again.
+ * The frames are checked as composed by a cache of all the assets.
+ *
+ * Spans (-T file) : the controller and the bridges record the span trace
+ * (span_trace.hpp), dumped to the file as SPANS DUMP does, for spantrace.
+ * The bridges run on their own clocks, an offset and a drift each. The
+ * syncs of the bridges on the controller clock are checked against the
+ * controller ones. (the CRC is timed before the frame, and the loop1()
+ * spans are at the end of the I2C frame time : zero long)
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -Iarduino -I../../firmware/controller cvsim.cpp cvsim_bridge.cpp \
+ *       ../../firmware/controller/spi_i2c_bridge.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp \
+ *       ../../firmware/controller/spi_link_rate.cpp \
+ *       ../../firmware/controller/scroll_layer.cpp \
+ *       ../../firmware/controller/span_trace.cpp \
+ *       ../../firmware/spi-i2c-bridge/circular_buffer.cpp \
+ *       ../../firmware/spi-i2c-bridge/sprite_cache.cpp \
+ *       ../../firmware/spi-i2c-bridge/spi_receiver.cpp -o cvsim
+ *
+ * Run :
+ *   ./cvsim [options]    (see usage)
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPISlave.h>
+
+#include "screen_config.hpp"
+#include "spi_i2c_bridge.hpp"
+#include "scroll_layer.hpp"
+#include "span_trace.hpp"
+#include "sprite_registry.hpp"
+#include "cvsim.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define BRIDGE_BYTES            (CVSIM_CHANNELS * CV_ONE_FRAME_BYTES)
+#define CVSIM_PINS              (32)
+#define SPI_RSP_ERROR_BYTE      (0x80 | (1 << 3))       // Same to the bridge
+#define SPRITE_ASSETS           (120)   // Over the bridge cache (96 KB), under its entries
+#define SPRITE_WINDOW           (12)    // Assets of a frame, moves by one every 2 frames
+
+typedef struct options_ {
+    uint32_t spiHz = 0;         // 0 : spisettings of the controller
+    uint32_t i2cHz = 400000;
+    int rxLevel = 4;            // PL022 rx interrupt, half full
+    int timeoutBits = 32;       // PL022 rx timeout
+    int overheadNs = 2000;      // Per transfer, beginTransaction to the first clock
+    int crcNs = 75;             // Controller CRC, per byte
+    int frames = 300;
+    int periodUs = 0;           // 0 : back to back
+    uint32_t limitHz = 125000000 / 12;  // Clean up to
+    double errorRate = 0.001;   // Per byte above the limit
+    double noiseRate = 0;       // Per byte at any clock
+    int degradeMs = 0;          // The limit halves at, 0 : never
+    uint32_t seed = 1;
+    int bridges = 2;
+    int buses = 2;
+    bool present = true;
+    int planes = 1;             // Grayscale bit planes, 1 : monochrome
+    int steps = -1;             // Planes by the contrast, -1 : planes - 1
+    int slotUs = SIB_GRAY_SLOT_US;
+    int scroll = 0;             // Scroll layer rows a frame, 0 : random frames
+    int sprites = 0;            // Sprites a frame up to, 0 : none
+    const char * spans = nullptr;   // Span trace dump
+    bool verbose = false;
+} options_t;
+
+typedef struct slave_ {
+    std::deque<uint8_t> rx_;
+    std::deque<uint8_t> tx_;
+    const uint8_t * data_ = nullptr;
+    size_t dataLeft_ = 0;
+    SPISlaveRecvHandler recv_ = nullptr;
+    SPISlaveSentHandler sent_ = nullptr;
+    uint64_t lastRxNs_ = 0;
+    uint32_t timeouts_ = 0;
+} slave_t;
+
+typedef struct core1_ {
+    bool busy_ = false;
+    uint64_t startNs_ = 0;
+    uint64_t endNs_ = 0;
+    uint64_t frameNs_ = 0;      // I2C frame time, from the previous frame
+    uint32_t frames_ = 0;
+} core1_t;
+
+typedef struct bus_clocked_ {
+    uint64_t startNs_;
+    uint64_t endNs_;
+    uint32_t bytes_;
+} bus_clocked_t;
+
+typedef struct bus_ {
+    uint64_t busyNs_ = 0;       // Busy until
+    std::vector<bus_clocked_t> clocked_;    // Every transfer, measured over the frames window
+    uint32_t transfers_ = 0;
+    uint32_t polls_ = 0;        // One byte transfers (response polls)
+    uint32_t errorRsp_ = 0;     // Error responses seen on MISO
+    uint32_t selectErrors_ = 0; // Transfers to none or two bridges
+} bus_t;
+
+typedef enum frame_state_ {
+    FRAME_PENDING = 0,
+    FRAME_SHOWN,
+    FRAME_DROPPED,
+} frame_state_t;
+
+typedef struct frame_ {
+    std::vector<uint8_t> data_;
+    uint64_t sendNs_;
+    uint64_t shownNs_[CVSIM_BRIDGES_MAX];
+    uint64_t startNs_[CVSIM_BRIDGES_MAX];    // I2C transfer start
+    frame_state_t state_[CVSIM_BRIDGES_MAX];
+    bool scroll_;               // A scroll layer step, no reload
+    uint32_t shownWrites_[CVSIM_BRIDGES_MAX];   // Of the loop1() writing it
+} frame_t;
+
+// The code running, the controller (sending on its core 1) or a bridge core.
+typedef struct context_ {
+    int bridge_;                // -1 : the controller
+    uint core_;
+} context_t;
+
+// Grayscale cycles of a bridge, from a flip of the plane 0 to the next one
+// of the same frame. The light of the cycle to the level of the planes.
+typedef struct gray_ {
+    uint32_t flips_ = 0;
+    long frame_ = -1;           // Of the plane 0 flip, -1 : none
+    uint64_t flipNs_ = 0;
+    std::vector<double> light_; // At the plane 0 flip, channel by channel
+    std::vector<double> ref_;
+    uint32_t cycles_ = 0;
+    double cycleNs_ = 0;        // Sum
+    double error_ = 0;          // Sum of the pixels
+    double maxError_ = 0;
+    uint64_t pixels_ = 0;
+} gray_t;
+
+static options_t opt_;
+static uint64_t now_ = 0;           // Controller
+static uint64_t time_ = 0;          // Seen by millis() / micros()
+static uint32_t seed_ = 1;
+static uint32_t flips_ = 0;
+
+static slave_t slaves_[CVSIM_BRIDGES_MAX];
+static core1_t cores_[CVSIM_BRIDGES_MAX];
+static bus_t buses_[CVSIM_BUSES];
+static bool pinLow_[CVSIM_PINS];
+
+// Same to controller.ino, the bridge k on the bus (k % buses).
+static const int bridge_cs_[CVSIM_BRIDGES_MAX] = { 17, 13, 20, 21 };
+static const sib_bus_t bus_pins_[CVSIM_BUSES] = { { 16, 18, 19 }, { 12, 14, 15 } };
+
+static std::vector<frame_t> frames_;
+static size_t pending_[CVSIM_BRIDGES_MAX];
+static uint32_t corrupt_ = 0;
+static gray_t grays_[CVSIM_BRIDGES_MAX];
+
+// The bridge clocks with -T, from the controller one.
+static context_t context_ = { -1, 1 };
+static int64_t clockOffsetNs_[CVSIM_BRIDGES_MAX];
+static double clockPpm_[CVSIM_BRIDGES_MAX];
+static const double clock_ppm_[CVSIM_BRIDGES_MAX] = { 40, -25, 12, -48 };
+static SpanTrace spans_;
+
+HardwareSerial Serial;
+SPIClassRP2040 SPI(0);
+SPIClassRP2040 SPI1(1);
+SPISlaveClass SPISlave;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Arduino
+ *----------------------------------------------------------------------
+ */
+
+uint64_t
+cvsim_now_ns(void)
+{
+    int k = context_.bridge_;
+    if (k < 0) return time_;
+    return time_ + clockOffsetNs_[k] + (int64_t)(time_ * clockPpm_[k] / 1e6);
+}
+
+uint
+get_core_num(void)
+{
+    return context_.core_;
+}
+
+static context_t
+enter(int k, uint core)
+{
+    context_t last = context_;
+    context_.bridge_ = k;
+    context_.core_ = core;
+    return last;
+}
+
+void
+cvsim_reset_request(void)
+{
+    fprintf(stderr, "hard reset requested at %.3f ms\n", time_ / 1e6);
+    exit(2);
+}
+
+void
+digitalWrite(int pin, int value)
+{
+    if (pin >= 0 && pin < CVSIM_PINS) pinLow_[pin] = (value == LOW);
+}
+
+int
+HardwareSerial::printf(const char * format, ...)
+{
+    if (!opt_.verbose) return 0;
+    va_list ap;
+    va_start(ap, format);
+    ::printf("%10.3f ms : ", time_ / 1e6);
+    int n = vprintf(format, ap);
+    va_end(ap);
+    return n;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Bridge Timing
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t rnd(void);
+
+// A bit error on the wire at the clock.
+static uint8_t
+line(uint8_t c, uint32_t hz, uint64_t t)
+{
+    uint32_t limit = opt_.limitHz;
+    if (opt_.degradeMs > 0 && t >= (uint64_t)opt_.degradeMs * 1000000) limit /= 2;
+    double rate = opt_.noiseRate + ((hz > limit)? opt_.errorRate : 0.0);
+    if (rate <= 0 || (rnd() & 0xFFFFFF) >= rate * 0x1000000) return c;
+    flips_++;
+    return c ^ (uint8_t)(1 << (rnd() & 7));
+}
+
+static uint64_t
+spi_bit_ns(uint32_t hz)
+{
+    return (1000000000ULL + hz / 2) / hz;
+}
+
+// The panel rows through the start line, the panel buffer layout.
+static void
+shown_panel(const Ssd1306Model * display, uint8_t * buffer)
+{
+    const uint8_t * gddram = display->gddram();
+    memset(buffer, 0, CV_ONE_FRAME_BYTES);
+    for (int r = 0; r < CV_WIDTH; r++) {
+        int line = (r + display->startLine()) & (CVSIM_SSD1306_LINES - 1);
+        for (int c = 0; c < CV_HEIGHT; c++) {
+            if ((gddram[(line >> 3) * CVSIM_SSD1306_COLUMNS + c] >> (line & 7)) & 1) {
+                buffer[(r >> 3) * CV_HEIGHT + c] |= (uint8_t)(1 << (r & 7));
+            }
+        }
+    }
+}
+
+static void
+check_frame(int k, uint64_t t)
+{
+    uint8_t shown[BRIDGE_BYTES];
+    for (int id = 0; id < CVSIM_CHANNELS; id++) {
+        shown_panel(cvsim_bridge_display(k, id), &shown[id * CV_ONE_FRAME_BYTES]);
+    }
+
+    // The oldest frame shown, the frames skipped before it are dropped.
+    for (size_t i = pending_[k]; i < frames_.size(); i++) {
+        if (memcmp(shown, &frames_[i].data_[k * BRIDGE_BYTES], BRIDGE_BYTES) != 0) continue;
+        for (size_t j = pending_[k]; j < i; j++) frames_[j].state_[k] = FRAME_DROPPED;
+        frames_[i].state_[k] = FRAME_SHOWN;
+        frames_[i].shownNs_[k] = t;
+        frames_[i].startNs_[k] = cores_[k].startNs_;
+        pending_[k] = i + 1;
+        return;
+    }
+    corrupt_++;
+    if (opt_.verbose) ::printf("bridge %d : corrupt frame at %.3f ms\n", k, t / 1e6);
+}
+
+// The light of a complete cycle, the pixel level against the planes.
+static void
+check_cycle(int k, const frame_t & frame)
+{
+    gray_t * gray = &grays_[k];
+    size_t planeBytes = frame.data_.size() / opt_.planes;
+    double full = (1 << opt_.planes) - 1;
+    for (int id = 0; id < CVSIM_CHANNELS; id++) {
+        const Ssd1306Model * display = cvsim_bridge_display(k, id);
+        double ref = display->flipRef() - gray->ref_[id];
+        if (ref <= 0) continue;
+        for (int r = 0; r < CV_WIDTH; r++) {
+            for (int c = 0; c < CV_HEIGHT; c++) {
+                size_t at = (size_t)k * BRIDGE_BYTES + id * CV_ONE_FRAME_BYTES + (r >> 3) * CV_HEIGHT + c;
+                int level = 0;
+                for (int p = 0; p < opt_.planes; p++) {
+                    level |= ((frame.data_[p * planeBytes + at] >> (r & 7)) & 1) << p;
+                }
+                size_t i = ((size_t)id * CV_WIDTH + r) * CV_HEIGHT + c;
+                double light = display->flipLight(r, c) - gray->light_[i];
+                double error = fabs(light / ref * full - level);
+                gray->error_ += error;
+                gray->maxError_ = std::max(gray->maxError_, error);
+                gray->pixels_++;
+            }
+        }
+    }
+    gray->cycles_++;
+    gray->cycleNs_ += cvsim_bridge_display(k, 0)->flipNs() - gray->flipNs_;
+}
+
+// The panel shows a plane of a frame after each flip. The frame is shown
+// at its first plane, the cycles of the plane 0 are checked.
+static void
+check_gray(int k, uint64_t t)
+{
+    gray_t * gray = &grays_[k];
+    const Ssd1306Model * display0 = cvsim_bridge_display(k, 0);
+    if (display0->flips() == gray->flips_) return;
+    gray->flips_ = display0->flips();
+
+    uint8_t shown[BRIDGE_BYTES];
+    for (int id = 0; id < CVSIM_CHANNELS; id++) {
+        const Ssd1306Model * display = cvsim_bridge_display(k, id);
+        memcpy(&shown[id * CV_ONE_FRAME_BYTES], display->gddram() + (display->startLine() / 8) * CVSIM_SSD1306_COLUMNS, CV_ONE_FRAME_BYTES);
+    }
+
+    size_t first = (pending_[k] > 0)? pending_[k] - 1 : 0;
+    for (size_t i = first; i < frames_.size(); i++) {
+        size_t planeBytes = frames_[i].data_.size() / opt_.planes;
+        int plane = -1;
+        for (int p = 0; p < opt_.planes && plane < 0; p++) {
+            if (memcmp(shown, &frames_[i].data_[p * planeBytes + k * BRIDGE_BYTES], BRIDGE_BYTES) == 0) plane = p;
+        }
+        if (plane < 0) continue;
+        if (i >= pending_[k]) {
+            for (size_t j = pending_[k]; j < i; j++) frames_[j].state_[k] = FRAME_DROPPED;
+            frames_[i].state_[k] = FRAME_SHOWN;
+            frames_[i].shownNs_[k] = t;
+            frames_[i].startNs_[k] = cores_[k].startNs_;
+            pending_[k] = i + 1;
+        }
+        if (plane != 0) return;
+        if (gray->frame_ == (long)i) check_cycle(k, frames_[i]);
+        gray->frame_ = (long)i;
+        gray->flipNs_ = display0->flipNs();
+        for (int id = 0; id < CVSIM_CHANNELS; id++) {
+            const Ssd1306Model * display = cvsim_bridge_display(k, id);
+            gray->ref_[id] = display->flipRef();
+            for (int r = 0; r < CV_WIDTH; r++) {
+                for (int c = 0; c < CV_HEIGHT; c++) {
+                    gray->light_[((size_t)id * CV_WIDTH + r) * CV_HEIGHT + c] = display->flipLight(r, c);
+                }
+            }
+        }
+        return;
+    }
+    corrupt_++;
+    if (opt_.verbose) ::printf("bridge %d : corrupt plane at %.3f ms\n", k, t / 1e6);
+}
+
+static void
+start_core1(int k, uint64_t t)
+{
+    core1_t * core = &cores_[k];
+    if (core->busy_ || !cvsim_bridge_read_ready(k)) return;
+    // The grayscale flip is on time, loop1() spins until then.
+    time_ = t;
+    context_t last = enter(k, 1);
+    int32_t waitUs = cvsim_bridge_wait_us(k);
+    if (waitUs > 0) t += (uint64_t)waitUs * 1000;
+    core->busy_ = true;
+    core->startNs_ = t;
+    core->endNs_ = t + core->frameNs_;
+    time_ = t;
+    for (int id = 0; id < CVSIM_CHANNELS; id++) cvsim_bridge_display(k, id)->setClock(t, opt_.i2cHz);
+    cvsim_bridge_start(k);
+    context_ = last;
+}
+
+static void
+end_core1(int k)
+{
+    core1_t * core = &cores_[k];
+    time_ = core->endNs_;
+
+    uint64_t bits[CVSIM_CHANNELS];
+    uint32_t shows = cvsim_bridge_shows(k);
+    uint32_t shownWrites = 0;
+    for (int id = 0; id < CVSIM_CHANNELS; id++) {
+        bits[id] = cvsim_bridge_display(k, id)->bits();
+        shownWrites -= cvsim_bridge_display(k, id)->shownWrites();
+    }
+    context_t last = enter(k, 1);
+    cvsim_bridge_loop1(k);
+    context_ = last;
+    uint64_t maxBits = 0;
+    for (int id = 0; id < CVSIM_CHANNELS; id++) {
+        maxBits = std::max(maxBits, cvsim_bridge_display(k, id)->bits() - bits[id]);
+        shownWrites += cvsim_bridge_display(k, id)->shownWrites();
+    }
+    // The channels run in parallel, the slowest one.
+    core->frameNs_ = maxBits * 1000000000ULL / opt_.i2cHz;
+    core->busy_ = false;
+    core->frames_++;
+
+    if (opt_.planes > 1) {
+        check_gray(k, core->endNs_);
+    } else {
+        // The writes of the frame shown, or of the next one. (the scroll
+        // pages loaded ahead, the panels not checked until its row)
+        size_t i = pending_[k];
+        if (cvsim_bridge_shows(k) != shows) {
+            check_frame(k, core->endNs_);
+            if (pending_[k] > i) i = pending_[k] - 1;
+        }
+        if (i < frames_.size()) frames_[i].shownWrites_[k] += shownWrites;
+    }
+    start_core1(k, core->endNs_);
+}
+
+static void
+deliver(int k, uint64_t t)
+{
+    slave_t * slave = &slaves_[k];
+    uint8_t buffer[CVSIM_FIFO_DEPTH];
+    size_t len = 0;
+    while (!slave->rx_.empty()) {
+        buffer[len++] = slave->rx_.front();
+        slave->rx_.pop_front();
+    }
+    time_ = t;
+    context_t last = enter(k, 0);
+    cvsim_bridge_enter(k);
+    if (slave->recv_ != nullptr) slave->recv_(buffer, len);
+    cvsim_bridge_loop(k);
+    context_ = last;
+    start_core1(k, t);
+}
+
+// Run the bridge events (core1 frame end, rx timeout) up to t, in order.
+static void
+advance(int k, uint64_t t, uint64_t bitNs)
+{
+    slave_t * slave = &slaves_[k];
+    core1_t * core = &cores_[k];
+    while (1) {
+        uint64_t timeoutNs = UINT64_MAX;
+        if (!slave->rx_.empty() && opt_.timeoutBits > 0) {
+            timeoutNs = slave->lastRxNs_ + opt_.timeoutBits * bitNs;
+        }
+        uint64_t coreNs = (core->busy_)? core->endNs_ : UINT64_MAX;
+        if (coreNs <= t && coreNs <= timeoutNs) {
+            end_core1(k);
+        } else if (timeoutNs <= t) {
+            slave->timeouts_++;
+            deliver(k, timeoutNs);
+        } else {
+            break;
+        }
+    }
+}
+
+static void
+refill(int k, uint64_t t)
+{
+    slave_t * slave = &slaves_[k];
+    while (slave->tx_.size() < CVSIM_FIFO_DEPTH) {
+        if (slave->dataLeft_ == 0) {
+            time_ = t;
+            context_t last = enter(k, 0);
+            cvsim_bridge_enter(k);
+            if (slave->sent_ != nullptr) slave->sent_();
+            context_ = last;
+            if (slave->dataLeft_ == 0) break;
+        }
+        slave->tx_.push_back(*slave->data_++);
+        slave->dataLeft_--;
+    }
+}
+
+// One byte to the bridge k, ends at t.
+static uint8_t
+exchange(int k, uint64_t t, uint32_t hz, uint64_t bitNs, uint8_t mosi)
+{
+    slave_t * slave = &slaves_[k];
+    advance(k, t, bitNs);
+
+    uint8_t miso = 0;
+    if (!slave->tx_.empty()) {
+        miso = slave->tx_.front();
+        slave->tx_.pop_front();
+    }
+    miso = line(miso, hz, t);
+    slave->rx_.push_back(line(mosi, hz, t));
+    slave->lastRxNs_ = t;
+    if ((int)slave->rx_.size() >= opt_.rxLevel) deliver(k, t);
+    if (slave->tx_.size() <= CVSIM_FIFO_DEPTH / 2) refill(k, t);
+    return miso;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Method definitions - SPI
+ *----------------------------------------------------------------------
+ */
+
+// The bridge selected on the bus, -1 on none or two.
+static int
+selected(int b, int csPin, bool hwCS)
+{
+    int k = -1;
+    for (int i = 0; i < opt_.bridges; i++) {
+        if ((i % opt_.buses) != b) continue;
+        bool on = (hwCS)? (bridge_cs_[i] == csPin) : pinLow_[bridge_cs_[i]];
+        if (!on) continue;
+        if (k >= 0) return -1;
+        k = i;
+    }
+    return k;
+}
+
+void
+SPIClassRP2040::transferAsync(const void * txbuffer, void * rxbuffer, size_t size)
+{
+    bus_t * bus = &buses_[bus_];
+    int k = selected(bus_, csPin_, hwCS_);
+    if (k < 0) bus->selectErrors_++;
+    uint32_t hz = (opt_.spiHz > 0)? opt_.spiHz : clock_;
+    uint64_t bitNs = spi_bit_ns(hz);
+    const uint8_t * tx = (const uint8_t *)txbuffer;
+    uint8_t * rx = (uint8_t *)rxbuffer;
+
+    uint64_t start = std::max(now_, bus->busyNs_) + opt_.overheadNs;
+    for (size_t i = 0; i < size; i++) {
+        uint8_t miso = 0xFF;
+        if (k >= 0) miso = exchange(k, start + (i + 1) * 8 * bitNs, hz, bitNs, (tx != nullptr)? tx[i] : 0xFF);
+        if (rx != nullptr) rx[i] = miso;
+        if (miso == SPI_RSP_ERROR_BYTE) bus->errorRsp_++;
+    }
+    bus->busyNs_ = start + size * 8 * bitNs;
+    bus->clocked_.push_back({ start, bus->busyNs_, (uint32_t)size });
+    bus->transfers_++;
+    if (size == 1) bus->polls_++;
+}
+
+bool
+SPIClassRP2040::finishedAsync(void)
+{
+    now_ = std::max(now_, buses_[bus_].busyNs_);
+    time_ = now_;
+    return true;
+}
+
+void
+SPISlaveClass::onDataRecv(SPISlaveRecvHandler handler)
+{
+    slaves_[cvsim_bridge_current()].recv_ = handler;
+}
+
+void
+SPISlaveClass::onDataSent(SPISlaveSentHandler handler)
+{
+    slaves_[cvsim_bridge_current()].sent_ = handler;
+}
+
+void
+SPISlaveClass::setData(const uint8_t * data, size_t size)
+{
+    slave_t * slave = &slaves_[cvsim_bridge_current()];
+    slave->data_ = data;
+    slave->dataLeft_ = size;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
+
+static double
+percentile(std::vector<double> & values, double p)
+{
+    if (values.empty()) return 0;
+    size_t i = (size_t)(p * (values.size() - 1) + 0.5);
+    return values[std::min(i, values.size() - 1)];
+}
+
+// SPANS DUMP of controller.ino to the file, the bridge rings read by SPI.
+// Then the bridge syncs on the controller clock, by the clock of the bridge.
+// DRAW_SPRITES payload of the bridge at panelBase, same to sendDrawSprites().
+static size_t
+sprite_payload(const sprite_list_t * sprites, int panelBase, uint8_t * buf)
+{
+    uint8_t * p = buf;
+    *p++ = (uint8_t)panelBase;
+    *p++ = sprites->flags_;
+    *p++ = sprites->count_;
+    *p++ = 0x00;
+    *p++ = (uint8_t)(CV_DISTANCE >> 0);
+    *p++ = (uint8_t)(CV_DISTANCE >> 8);
+    *p++ = (uint8_t)(CV_V_WIDTH >> 0);
+    *p++ = (uint8_t)(CV_V_WIDTH >> 8);
+    for (int i = 0; i < sprites->count_; i++) {
+        const sprite_instance_t * instance = &sprites->instances_[i];
+        *p++ = (uint8_t)(instance->handle_ >> 0);
+        *p++ = (uint8_t)(instance->handle_ >> 8);
+        *p++ = (uint8_t)(instance->x_ >> 0);
+        *p++ = (uint8_t)(instance->x_ >> 8);
+        *p++ = (uint8_t)(instance->y_ >> 0);
+        *p++ = (uint8_t)(instance->y_ >> 8);
+    }
+    return p - buf;
+}
+
+static bool
+dump_spans(SpiI2cBridge & sib, double limitUs)
+{
+    sib.startSpans(false);
+    FILE * fp = fopen(opt_.spans, "w");
+    if (fp == nullptr) {
+        printf("spans     : cannot write %s\n", opt_.spans);
+        return false;
+    }
+
+    std::vector<double> syncUs[CVSIM_BRIDGES_MAX][SPAN_SYNC_SEQ_MASK + 1];
+    char line[SPAN_LINE_SIZE];
+    span_event_t event;
+    fprintf(fp, "@SPANS %d %d\n", SPAN_VERSION, 1 + opt_.bridges);
+    uint32_t events = 0;
+    for (int core = 0; core < SPAN_CORES; core++) {
+        fprintf(fp, "@SPANS RING 0 %d %u %u\n", core, spans_.count(core), spans_.overwritten(core));
+        for (uint32_t i = 0; spans_.get(core, i, &event); i++) {
+            SpanTrace::format(0, &event, line, sizeof(line));
+            fprintf(fp, "%s\n", line);
+            if (event.stage_ == SPAN_SYNC && (event.arg_ >> 12) < opt_.bridges) {
+                syncUs[event.arg_ >> 12][event.arg_ & SPAN_SYNC_SEQ_MASK].push_back(event.timeUs_);
+            }
+            events++;
+        }
+    }
+    printf("spans     : controller %u events, %u / %u overwritten\n", events, spans_.overwritten(0), spans_.overwritten(1));
+
+    bool ok = (events > 0);
+    for (int k = 0; k < opt_.bridges; k++) {
+        uint32_t syncs = 0;
+        double sum = 0, low = 0, high = 0;
+        uint32_t counts[SPAN_CORES] = { 0, 0 }, overwritten[SPAN_CORES] = { 0, 0 };
+        for (int core = 0; core < SPAN_CORES; core++) {
+            span_event_t block[SIB_SPAN_BLOCK_EVENTS];
+            sib_span_ring_t ring = { 0, 0 };
+            uint32_t index = 0;
+            int n = sib.readSpans(k, core, index, block, &ring);
+            fprintf(fp, "@SPANS RING %d %d %u %u\n", 1 + k, core, ring.events_, ring.overwritten_);
+            overwritten[core] = ring.overwritten_;
+            while (n > 0) {
+                for (int i = 0; i < n; i++) {
+                    SpanTrace::format(1 + k, &block[i], line, sizeof(line));
+                    fprintf(fp, "%s\n", line);
+                    counts[core]++;
+                    const std::vector<double> & at = syncUs[k][block[i].arg_ & SPAN_SYNC_SEQ_MASK];
+                    if (block[i].stage_ != SPAN_SYNC || at.size() != 1) continue;
+                    // The bridge time to the controller one.
+                    double ns = ((double)block[i].timeUs_ * 1000 - clockOffsetNs_[k]) / (1 + clockPpm_[k] / 1e6);
+                    double d = ns / 1000 - at[0];
+                    sum += d;
+                    low = (syncs == 0)? d : std::min(low, d);
+                    high = (syncs == 0)? d : std::max(high, d);
+                    syncs++;
+                }
+                index += n;
+                n = sib.readSpans(k, core, index, block, &ring);
+            }
+        }
+        printf("spans %d   : %u / %u events (%u / %u overwritten), clock +%.3f s %+.0f ppm, %u syncs after the controller avg %.1f, min %.1f, max %.1f us (limit %.1f us)\n",
+            k, counts[0], counts[1], overwritten[0], overwritten[1], clockOffsetNs_[k] / 1e9, clockPpm_[k],
+            syncs, (syncs > 0)? sum / syncs : 0.0, low, high, limitUs);
+        // micros() on both sides, 1 us each.
+        if (syncs < 2 || low < -2.0 || high > limitUs + 2.0 || counts[0] == 0 || counts[1] == 0) ok = false;
+    }
+    fprintf(fp, "@SPANS END\n");
+    fclose(fp);
+    return ok;
+}
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: cvsim [options]\n"
+        "  -s hz         SPI clock, default the controller spisettings\n"
+        "  -i hz         I2C clock, default 400000\n"
+        "  -l bytes      bridge rx fifo level, default 4\n"
+        "  -t bits       bridge rx timeout, 0 : none (stuck tail), default 32\n"
+        "  -o ns         master overhead per transfer, default 2000\n"
+        "  -c ns         controller CRC per byte, default 75\n"
+        "  -n frames     frames to send, default 300\n"
+        "  -p us         render period, 0 : back to back, default 0 (grayscale 200000)\n"
+        "  -e hz         link clean up to, default 10416666 (clk_peri / 12)\n"
+        "  -b rate       bit errors per byte above the limit, default 0.001\n"
+        "  -x rate       bit errors per byte at any clock, default 0\n"
+        "  -d ms         the limit halves at, default never\n"
+        "  -r seed       random seed, default 1\n"
+        "  -k bridges    bridges (8 panels each), 1 ~ 4, default 2\n"
+        "  -m buses      SPI buses, 1 ~ 2, default 2\n"
+        "  -a            no present, a bridge starts a frame when it is committed\n"
+        "  -g planes     grayscale bit planes, 1 ~ 4, default 1 (monochrome)\n"
+        "  -w steps      grayscale planes by the contrast, default planes - 1\n"
+        "  -u us         grayscale slot period, 0 : the write time, default 12500\n"
+        "  -S rows       scroll layer, rows a frame up to, default 0 (random frames)\n"
+        "  -P sprites    sprites a frame up to (1 ~ 32), default 0\n"
+        "  -T file       span trace dump (for spantrace), the bridges on their own clocks\n"
+        "  -v            bridge and controller logs\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if      (a == "-s" && hasValue) opt_.spiHz = (uint32_t)atoi(argv[++i]);
+        else if (a == "-i" && hasValue) opt_.i2cHz = (uint32_t)atoi(argv[++i]);
+        else if (a == "-l" && hasValue) opt_.rxLevel = atoi(argv[++i]);
+        else if (a == "-t" && hasValue) opt_.timeoutBits = atoi(argv[++i]);
+        else if (a == "-o" && hasValue) opt_.overheadNs = atoi(argv[++i]);
+        else if (a == "-c" && hasValue) opt_.crcNs = atoi(argv[++i]);
+        else if (a == "-n" && hasValue) opt_.frames = atoi(argv[++i]);
+        else if (a == "-p" && hasValue) opt_.periodUs = atoi(argv[++i]);
+        else if (a == "-e" && hasValue) opt_.limitHz = (uint32_t)atoi(argv[++i]);
+        else if (a == "-b" && hasValue) opt_.errorRate = atof(argv[++i]);
+        else if (a == "-x" && hasValue) opt_.noiseRate = atof(argv[++i]);
+        else if (a == "-d" && hasValue) opt_.degradeMs = atoi(argv[++i]);
+        else if (a == "-r" && hasValue) opt_.seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (a == "-k" && hasValue) opt_.bridges = atoi(argv[++i]);
+        else if (a == "-m" && hasValue) opt_.buses = atoi(argv[++i]);
+        else if (a == "-g" && hasValue) opt_.planes = atoi(argv[++i]);
+        else if (a == "-w" && hasValue) opt_.steps = atoi(argv[++i]);
+        else if (a == "-u" && hasValue) opt_.slotUs = atoi(argv[++i]);
+        else if (a == "-S" && hasValue) opt_.scroll = atoi(argv[++i]);
+        else if (a == "-P" && hasValue) opt_.sprites = atoi(argv[++i]);
+        else if (a == "-T" && hasValue) opt_.spans = argv[++i];
+        else if (a == "-a") opt_.present = false;
+        else if (a == "-v") opt_.verbose = true;
+        else { usage(); return 1; }
+    }
+    if (opt_.i2cHz == 0 || opt_.rxLevel < 1 || opt_.rxLevel > CVSIM_FIFO_DEPTH || opt_.frames <= 0 ||
+        opt_.bridges < 1 || opt_.bridges > CVSIM_BRIDGES_MAX || opt_.buses < 1 || opt_.buses > CVSIM_BUSES ||
+        opt_.planes < 1 || opt_.planes > SIB_GRAY_PLANES_MAX || opt_.steps >= opt_.planes || opt_.slotUs < 0 ||
+        opt_.scroll < 0 || (opt_.scroll > 0 && opt_.planes > 1) ||
+        opt_.sprites < 0 || opt_.sprites > SPRITE_MAX_INSTANCES || (opt_.sprites > 0 && opt_.planes > 1)) {
+        usage();
+        return 1;
+    }
+    seed_ = (opt_.seed != 0)? opt_.seed : 1;
+    if (opt_.steps < 0) opt_.steps = opt_.planes - 1;
+    // A frame is shown for some cycles of the planes.
+    if (opt_.planes > 1 && opt_.periodUs == 0) opt_.periodUs = 200000;
+
+    //
+    // Bridges, then the controller setup. (same to controller.ino)
+    //
+
+    for (int k = 0; k < opt_.bridges; k++) {
+        if (opt_.spans != nullptr) {
+            clockOffsetNs_[k] = (int64_t)(k + 1) * 987654321;
+            clockPpm_[k] = clock_ppm_[k];
+        }
+        context_t last = enter(k, 0);
+        cvsim_bridge_setup(k);
+        context_ = last;
+        refill(k, 0);
+        // Address, control and 6 command bytes, then address, control and the data.
+        cores_[k].frameNs_ = ((2 + 6) * 9 + 2 + (2 + CV_ONE_FRAME_BYTES) * 9 + 2) * 1000000000ULL / opt_.i2cHz;
+    }
+
+    sib_endpoint_t endpoints[CVSIM_BRIDGES_MAX];
+    for (int k = 0; k < opt_.bridges; k++) {
+        endpoints[k].bus_ = k % opt_.buses;
+        endpoints[k].pinCS_ = bridge_cs_[k];
+    }
+    SpiI2cBridge sib;
+    sib.init(bus_pins_, endpoints, opt_.bridges);
+    for (int k = 0; k < opt_.bridges; k++) {
+        int retry = 100;
+        while (!sib.sendPing(k) && --retry > 0) {}
+        if (retry == 0) {
+            printf("bridge %d : no ping response\n", k);
+            printf("check : NG\n");
+            return 1;
+        }
+    }
+    for (int k = 0; k < opt_.bridges; k++) sib.sendSetIDDirection(k, (k & 1) == 0);
+    sib.setPresent(opt_.present);
+    if (opt_.spiHz == 0) {
+        for (int k = 0; k < opt_.bridges; k++) sib.trainLink(k);
+    }
+    if (opt_.planes > 1) {
+        for (int k = 0; k < opt_.bridges; k++) {
+            for (int id = 0; id < CVSIM_CHANNELS; id++) cvsim_bridge_display(k, id)->integrate(true);
+            grays_[k].light_.resize((size_t)CVSIM_CHANNELS * CV_WIDTH * CV_HEIGHT);
+            grays_[k].ref_.resize(CVSIM_CHANNELS);
+        }
+        if (!sib.setGray(opt_.planes, opt_.steps, opt_.slotUs)) {
+            printf("gray : bridges not ready\n");
+            printf("check : NG\n");
+            return 1;
+        }
+    }
+
+    if (opt_.spans != nullptr) {
+        sib.setSpanTrace(&spans_);
+        sib.startSpans(true);
+    }
+
+    // The sprite assets, random pixels and alpha, 64 ~ 128 x 32 ~ 64.
+    static SpriteRegistry registry;
+    static mono_image_t spriteImages[SPRITE_ASSETS];
+    std::vector<std::vector<uint8_t>> spritePixels;
+    if (opt_.sprites > 0) {
+        spritePixels.resize(SPRITE_ASSETS * 2);
+        for (int i = 0; i < SPRITE_ASSETS; i++) {
+            int w = 64 + (int)(rnd() % 65);
+            int h = 32 + (int)(rnd() % 5) * 8;
+            int bytes = w * (h / 8);
+            for (int j = 0; j < 2; j++) {
+                spritePixels[i * 2 + j].resize(bytes);
+                for (auto & b : spritePixels[i * 2 + j]) b = (uint8_t)rnd();
+            }
+            spriteImages[i] = { w, h, 0, 0, w, h, bytes, true, spritePixels[i * 2].data(), spritePixels[i * 2 + 1].data() };
+            int handle = registry.getHandle(&spriteImages[i]);
+            uint8_t payload[SPRITE_ASSET_MAX_SIZE];
+            size_t size = registry.pack(handle, payload, sizeof(payload));
+            cvsim_sprites_store(payload, size);
+        }
+        sib.setSpriteRegistry(&registry);
+    }
+    uint32_t spriteFrames = 0, spriteInstances = 0;
+
+    //
+    // Frames
+    //
+
+    size_t frameBytes = (size_t)opt_.bridges * BRIDGE_BYTES * opt_.planes;
+    uint32_t failed = 0;
+    uint64_t firstNs = 0;
+
+    // The scroll layer, random pixels over the middle of the panel columns.
+    std::vector<uint8_t> layerPixels((size_t)(CV_V_WIDTH / 8) * (CV_HEIGHT / 2));
+    for (auto & b : layerPixels) b = (uint8_t)rnd();
+    scroll_layer_t layer;
+    layer.plane_.width_ = CV_V_WIDTH;
+    layer.plane_.height_ = CV_HEIGHT / 2;
+    layer.plane_.buffer_ = layerPixels.data();
+    layer.y_ = CV_HEIGHT / 4;
+    layer.row_ = 0;
+    layer.generation_ = 1;
+    uint32_t layerFrames = 0, randomFrames = 0;
+
+    for (int f = 0; f < opt_.frames; f++) {
+        if (opt_.periodUs > 0) {
+            if (f == 0) firstNs = now_;
+            now_ = std::max(now_, firstNs + (uint64_t)f * opt_.periodUs * 1000);
+        }
+
+        // The layer moves, changes 1 in 50, a random frame 1 in 25.
+        uint32_t r = (opt_.scroll > 0)? rnd() % 100 : 0;
+        bool scroll = (opt_.scroll > 0 && r >= 4);
+        if (scroll && r < 6) {
+            for (auto & b : layerPixels) b = (uint8_t)rnd();
+            layer.generation_++;
+        } else if (scroll) {
+            int32_t step = (int32_t)(rnd() % opt_.scroll) + 1;
+            if (rnd() & 1) step = -step;
+            layer.row_ = (layer.row_ + step + CV_V_WIDTH) % CV_V_WIDTH;
+        }
+
+        frame_t frame;
+        frame.data_.resize(frameBytes);
+        if (scroll) {
+            for (int p = 0; p < opt_.bridges * CVSIM_CHANNELS; p++) {
+                scroll_layer_panel(&layer, p, &frame.data_[p * CV_ONE_FRAME_BYTES]);
+            }
+        } else {
+            for (auto & b : frame.data_) b = (uint8_t)rnd();
+        }
+
+        // The sprites of the window, composed into the frame to check.
+        sprite_list_t sprites;
+        sprites.flags_ = 0;
+        sprites.count_ = 0;
+        std::vector<uint8_t> sent;
+        if (opt_.sprites > 0 && !scroll) {
+            sprites.count_ = (uint8_t)(1 + rnd() % opt_.sprites);
+            for (int i = 0; i < sprites.count_; i++) {
+                sprite_instance_t * instance = &sprites.instances_[i];
+                instance->handle_ = (uint16_t)(((f / 2) + rnd() % SPRITE_WINDOW) % SPRITE_ASSETS);
+                instance->x_ = (int16_t)(rnd() % CV_V_WIDTH);
+                instance->y_ = (int16_t)((int)(rnd() % (CV_HEIGHT + 32)) - 32);
+            }
+            sent = frame.data_;
+            for (int k = 0; k < opt_.bridges; k++) {
+                uint8_t list[SPRITE_LIST_MAX_SIZE];
+                size_t size = sprite_payload(&sprites, k * CVSIM_CHANNELS, list);
+                cvsim_sprites_compose(&frame.data_[k * BRIDGE_BYTES], CVSIM_CHANNELS, list, size);
+            }
+            spriteFrames++;
+            spriteInstances += sprites.count_;
+        }
+        frame.sendNs_ = now_;
+        for (int k = 0; k < opt_.bridges; k++) {
+            frame.shownNs_[k] = 0;
+            frame.startNs_[k] = 0;
+            frame.state_[k] = FRAME_PENDING;
+            frame.shownWrites_[k] = 0;
+        }
+        frame.scroll_ = false;
+        frames_.push_back(frame);
+        if (f == 0 && opt_.periodUs == 0) firstNs = now_;
+
+        if (opt_.scroll > 0 && sib.scrollFits((scroll)? &layer : nullptr)) {
+            uint32_t reloads = sib.scrollStats()->reloads_;
+            if (!sib.sendScrollFrame(&layer)) failed++;
+            frames_.back().scroll_ = (sib.scrollStats()->reloads_ == reloads);
+            layerFrames++;
+            continue;
+        }
+        if (opt_.scroll > 0 && !scroll) randomFrames++;
+        now_ += (uint64_t)opt_.crcNs * frameBytes;
+        if (sprites.count_ > 0) {
+            if (!sib.sendFrameDataParallel(sent.data(), frameBytes, &sprites)) failed++;
+            continue;
+        }
+        if (!sib.sendFrameDataParallel(frames_.back().data_.data(), frameBytes)) failed++;
+    }
+
+    // Flush, the last frames and the stuck fifo tails.
+    uint64_t endNs = now_ + 1000000000ULL;
+    for (int k = 0; k < opt_.bridges; k++) {
+        uint32_t hz = (opt_.spiHz > 0)? opt_.spiHz : sib.link(k)->clock();
+        advance(k, endNs, spi_bit_ns(hz));
+    }
+
+    //
+    // Report
+    //
+
+    uint32_t shown = 0, dropped = 0, lost = 0;
+    uint64_t lastNs = firstNs;
+    std::vector<double> latency;
+    std::vector<double> skew;
+    for (const auto & frame : frames_) {
+        bool isShown = true, isDropped = false;
+        uint64_t t = 0, start1 = UINT64_MAX, start2 = 0;
+        for (int k = 0; k < opt_.bridges; k++) {
+            if (frame.state_[k] != FRAME_SHOWN) isShown = false;
+            if (frame.state_[k] == FRAME_DROPPED) isDropped = true;
+            t = std::max(t, frame.shownNs_[k]);
+            start1 = std::min(start1, frame.startNs_[k]);
+            start2 = std::max(start2, frame.startNs_[k]);
+        }
+        if (isShown) {
+            shown++;
+            latency.push_back((t - frame.sendNs_) / 1e6);
+            skew.push_back((start2 - start1) / 1e3);
+            lastNs = std::max(lastNs, t);
+        } else if (isDropped) {
+            dropped++;
+        } else {
+            lost++;
+        }
+    }
+    std::sort(latency.begin(), latency.end());
+    std::sort(skew.begin(), skew.end());
+    double sum = 0;
+    for (double l : latency) sum += l;
+
+    double simMs = (lastNs - firstNs) / 1e6;
+    printf("frames    : %d sent, %u shown, %u dropped, %u corrupt, %u lost, %u send failed\n",
+        opt_.frames, shown, dropped, corrupt_, lost, failed);
+    printf("rate      : %.1f fps over %.1f ms\n", (simMs > 0)? shown * 1000.0 / simMs : 0.0, simMs);
+    if (!latency.empty()) {
+        printf("latency   : min %.2f, avg %.2f, p50 %.2f, p99 %.2f, max %.2f ms\n",
+            latency.front(), sum / latency.size(), percentile(latency, 0.5), percentile(latency, 0.99), latency.back());
+    }
+    // The PRESENT broadcast, one command a wave, then the rx timeout (or
+    // the fifo level) on the bridge. A bridge busy with the last frame
+    // starts late, the frame times are the same on all. (2 transfers slack)
+    uint32_t slowHz = UINT32_MAX;
+    for (int k = 0; k < opt_.bridges; k++) {
+        slowHz = std::min(slowHz, (opt_.spiHz > 0)? opt_.spiHz : sib.link(k)->clock());
+    }
+    int waves = (opt_.bridges + opt_.buses - 1) / opt_.buses;
+    double presentUs = (opt_.overheadNs + (9 * 8 + opt_.timeoutBits) * spi_bit_ns(slowHz)) / 1e3;
+    double skewLimitUs = (waves + 2) * presentUs;
+    bool skewOk = true;
+    if (!skew.empty()) {
+        double skewSum = 0;
+        for (double v : skew) skewSum += v;
+        printf("skew      : avg %.1f, p50 %.1f, p99 %.1f, max %.1f us (%s, limit %.1f us)\n",
+            skewSum / skew.size(), percentile(skew, 0.5), percentile(skew, 0.99), skew.back(), (opt_.present)? "present" : "no present", skewLimitUs);
+        if (opt_.present && skew.back() > skewLimitUs) skewOk = false;
+    }
+    if (opt_.present) {
+        for (int k = 0; k < opt_.bridges; k++) {
+            const sib_present_stats_t * stats = sib.presentStats(k);
+            printf("present %d : %u presents, %u missed, sent +%u us, latency %u us (max %u us)\n",
+                k, stats->presents_, stats->missed_, stats->sentUs_, stats->latencyUs_, stats->maxLatencyUs_);
+        }
+        printf("present   : telemetry skew %u us, max %u us\n", sib.presentSkewUs(), sib.presentSkewMaxUs());
+    }
+
+    // The bus use in the same window as the frame rate, without the link
+    // training, the asset uploads and the flush.
+    uint32_t selectErrors = 0;
+    for (int b = 0; b < opt_.buses; b++) {
+        const bus_t * bus = &buses_[b];
+        uint64_t activeNs = 0;
+        double bytes = 0;
+        for (const auto & c : bus->clocked_) {
+            uint64_t s1 = std::max(c.startNs_, firstNs);
+            uint64_t s2 = std::min(c.endNs_, lastNs);
+            if (s1 >= s2) continue;
+            activeNs += s2 - s1;
+            bytes += (double)c.bytes_ * (s2 - s1) / (c.endNs_ - c.startNs_);
+        }
+        printf("bus %d     : %.2f MB/s, %.1f %% clocked, %u transfers, %u polls (%.1f / frame), %u error responses, %u select errors\n",
+            b, (simMs > 0)? bytes / (simMs * 1000.0) : 0.0, (simMs > 0)? activeNs / (simMs * 10000.0) : 0.0,
+            bus->transfers_, bus->polls_, (double)bus->polls_ / opt_.frames, bus->errorRsp_, bus->selectErrors_);
+        selectErrors += bus->selectErrors_;
+    }
+    for (int k = 0; k < opt_.bridges; k++) {
+        uint32_t i2cErrors = 0;
+        for (int id = 0; id < CVSIM_CHANNELS; id++) i2cErrors += cvsim_bridge_display(k, id)->errors();
+        printf("bridge %d  : %u i2c frames, %.2f ms / frame, %u rx timeouts, %u i2c errors\n",
+            k, cores_[k].frames_, cores_[k].frameNs_ / 1e6, slaves_[k].timeouts_, i2cErrors);
+    }
+
+    // The trained rate is the highest one up to the limit, if the error
+    // rate is seen in the training rounds (about 1000 bytes each). The rate
+    // is under the limit at the end, after it dropped.
+    bool linkOk = true;
+    for (int k = 0; k < opt_.bridges && opt_.spiHz == 0; k++) {
+        const SpiLinkRate * link = sib.link(k);
+        const spi_link_stats_t * stats = link->stats();
+        printf("link %d    : trained %.1f MHz, now %.1f MHz, %u errors, %u retries, %u fallbacks, %u / %u test rounds failed\n",
+            k, link->trainedClock() / 1e6, link->clock() / 1e6, stats->errors_, stats->retries_, stats->fallbacks_,
+            stats->testErrors_, stats->testRounds_);
+        if (opt_.noiseRate > 0) continue;
+        int next = link->trainedIndex() + 1;
+        bool highest = (link->trainedClock() <= opt_.limitHz && (next >= link->rates() || link->rate(next) > opt_.limitHz));
+        if (opt_.errorRate >= 0.001 && !highest) linkOk = false;
+        uint32_t limit = (opt_.degradeMs > 0 && opt_.degradeMs * 1000000ULL < lastNs)? opt_.limitHz / 2 : opt_.limitHz;
+        if (link->clock() > limit) linkOk = false;
+    }
+    if (flips_ > 0) printf("line      : %u bit errors\n", flips_);
+
+    // On a clean link, the scroll steps only write the pages out of the rows
+    // shown and the pages are loaded in time. (an error loads the layer
+    // again, the pages of a missed row are not told from the reload)
+    bool scrollOk = true;
+    if (opt_.scroll > 0) {
+        uint64_t i2cBytes = 0;
+        uint32_t tears = 0;
+        for (int k = 0; k < opt_.bridges; k++) {
+            for (int id = 0; id < CVSIM_CHANNELS; id++) i2cBytes += cvsim_bridge_display(k, id)->bytes();
+        }
+        for (const auto & frame : frames_) {
+            for (int k = 0; k < opt_.bridges && frame.scroll_; k++) tears += frame.shownWrites_[k];
+        }
+        const sib_scroll_stats_t * stats = sib.scrollStats();
+        printf("scroll    : %u layer frames (%u steps, %u reloads), %u rendered, %u random, %u pages, %u misses\n",
+            layerFrames, stats->frames_ - stats->reloads_, stats->reloads_, opt_.frames - layerFrames - randomFrames,
+            randomFrames, stats->pages_, stats->misses_);
+        printf("scroll    : %.0f i2c bytes / panel a frame shown (%d pixel bytes a frame), %u shown bytes written by the steps\n",
+            (shown > 0)? (double)i2cBytes / shown / (opt_.bridges * CVSIM_CHANNELS) : 0.0, CV_ONE_FRAME_BYTES, tears);
+        bool clean = (opt_.noiseRate <= 0 && opt_.degradeMs == 0);
+        if ((clean && (tears > 0 || stats->misses_ > 0)) || layerFrames == 0) scrollOk = false;
+    }
+
+    // The light of a cycle is the level of the pixel, off by less than a
+    // half level. (the contrast steps rounded, the flip command bytes)
+    bool grayOk = true;
+    for (int k = 0; k < opt_.bridges && opt_.planes > 1; k++) {
+        const gray_t * gray = &grays_[k];
+        double cycleMs = (gray->cycles_ > 0)? gray->cycleNs_ / gray->cycles_ / 1e6 : 0;
+        printf("gray %d    : %d planes, %d steps, %u cycles, %.2f ms (%.1f Hz), level error avg %.3f, max %.3f (limit 0.5)\n",
+            k, opt_.planes, opt_.steps, gray->cycles_, cycleMs, (cycleMs > 0)? 1000.0 / cycleMs : 0.0,
+            (gray->pixels_ > 0)? gray->error_ / gray->pixels_ : 0.0, gray->maxError_);
+        if (gray->cycles_ == 0 || gray->maxError_ >= 0.5) grayOk = false;
+    }
+
+    // The old assets come again after they were evicted, the frames are
+    // checked with them.
+    bool spritesOk = true;
+    if (opt_.sprites > 0) {
+        uint32_t evictions = 0;
+        for (int k = 0; k < opt_.bridges; k++) evictions += cvsim_bridge_evictions(k);
+        printf("sprites   : %u frames, %.1f sprites a frame, %d assets, %u evictions on the bridges\n",
+            spriteFrames, (spriteFrames > 0)? (double)spriteInstances / spriteFrames : 0.0, SPRITE_ASSETS, evictions);
+        if (evictions == 0) spritesOk = false;
+    }
+
+    // The spans after the frames on the bus, the sync of a bridge is the
+    // command received, up to the PRESENT time after the controller one.
+    bool spansOk = true;
+    if (opt_.spans != nullptr) {
+        now_ = endNs;
+        spansOk = dump_spans(sib, presentUs);
+    }
+
+    bool ok = (corrupt_ == 0 && shown > 0 && linkOk && selectErrors == 0 && skewOk && grayOk && scrollOk && spritesOk && spansOk);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    return (ok)? 0 : 1;
+}
@@ -0,0 +1,347 @@
+/**********************************************************************/
+/**
+ * @brief  Host Simulator of the Controller, SPI Link and Bridges (cvsim)
+ * @author naoa
+ */
+/**********************************************************************/
+#pragma once
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define CVSIM_BRIDGES_MAX       (4)     // Bridge boards, SIB_ENDPOINTS_MAX
+#define CVSIM_BUSES             (2)     // SPI, SPI1
+#define CVSIM_CHANNELS          (8)     // SSD1306 per bridge (pio0 / pio1 x 4 sm)
+
+#define CVSIM_SSD1306_ADDR      (0x3C)
+#define CVSIM_SSD1306_PAGES     (8)
+#define CVSIM_SSD1306_COLUMNS   (128)
+#define CVSIM_SSD1306_LINES     (64)
+
+#define CVSIM_FIFO_DEPTH        (8)     // PL022 rx / tx fifo
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+// SSD1306 at the end of one PIO I2C channel. Only the write direction,
+// the commands the bridge sends and the GDDRAM.
+//
+// The light of the panel can be integrated, for the grayscale : a lit
+// pixel gives the contrast over the time, the time of a byte is the bits
+// on the wire from setClock(). The row r of the panel (up to the multiplex
+// ratio) shows the GDDRAM line (r + start line) % 64. The contrast is
+// taken as linear.
+class Ssd1306Model
+{
+public:
+    void reset(void)
+    {
+        memset(gddram_, 0, sizeof(gddram_));
+        mux_ = CVSIM_SSD1306_LINES - 1;
+        mode_ = 2;
+        colStart_ = col_ = 0;
+        colEnd_ = CVSIM_SSD1306_COLUMNS - 1;
+        pageStart_ = page_ = 0;
+        pageEnd_ = CVSIM_SSD1306_PAGES - 1;
+        startLine_ = 0;
+        contrast_ = 0x7F;
+        displayOn_ = false;
+        state_ = STATE_IDLE;
+        cmdLen_ = cmdNeed_ = 0;
+        bits_ = bytes_ = transactions_ = errors_ = 0;
+        shownWrites_ = 0;
+        baseNs_ = lastNs_ = 0;
+        baseBits_ = 0;
+        hz_ = 400000;
+        ref_ = 0;
+        refNs_ = 0;
+        flips_ = 0;
+        flipNs_ = 0;
+        flipRef_ = 0;
+        for (int r = 0; r < CVSIM_SSD1306_LINES; r++) {
+            for (int c = 0; c < CVSIM_SSD1306_COLUMNS; c++) {
+                acc_[r][c] = flipAcc_[r][c] = 0;
+                onRef_[r][c] = -1;
+            }
+        }
+    }
+
+    // The bits from now on are timed from ns.
+    void setClock(uint64_t ns, uint32_t hz)
+    {
+        baseNs_ = (ns > lastNs_)? ns : lastNs_;
+        baseBits_ = bits_;
+        hz_ = hz;
+    }
+
+    void integrate(bool on) { integrate_ = on; }
+
+    void start(void)
+    {
+        state_ = STATE_ADDR;
+        bits_ += 1;
+        transactions_++;
+    }
+
+    void stop(void)
+    {
+        state_ = STATE_IDLE;
+        bits_ += 1;
+    }
+
+    void write(uint8_t data)
+    {
+        bits_ += 9;
+        bytes_++;
+        switch (state_) {
+        case STATE_ADDR:
+            state_ = (data == (CVSIM_SSD1306_ADDR << 1))? STATE_CONTROL : STATE_NACK;
+            if (state_ == STATE_NACK) errors_++;
+            break;
+        case STATE_CONTROL:
+            // Co = 0 : the rest is a stream, Co = 1 : one byte then a control byte.
+            single_ = (data & 0x80) != 0;
+            state_ = (data & 0x40)? STATE_DATA : STATE_CMD;
+            break;
+        case STATE_CMD:
+            command(data);
+            if (single_) state_ = STATE_CONTROL;
+            break;
+        case STATE_DATA:
+            ram(data);
+            if (single_) state_ = STATE_CONTROL;
+            break;
+        default:
+            break;
+        }
+    }
+
+public:
+    // Horizontal addressing from page 0 column 0, the panel buffer layout.
+    const uint8_t * gddram(void) const { return &gddram_[0][0]; }
+    uint8_t startLine(void) const { return startLine_; }
+    uint8_t contrast(void) const { return contrast_; }
+    // The light at the last start line change (flip) : the contrast time
+    // of a pixel lit all the time, and of the pixel at (row, column).
+    uint32_t flips(void) const { return flips_; }
+    uint64_t flipNs(void) const { return flipNs_; }
+    double flipRef(void) const { return flipRef_; }
+    double flipLight(int row, int column) const { return flipAcc_[row][column]; }
+    bool displayOn(void) const { return displayOn_; }
+    uint64_t bits(void) const { return bits_; }
+    uint32_t bytes(void) const { return bytes_; }
+    uint32_t transactions(void) const { return transactions_; }
+    uint32_t errors(void) const { return errors_; }
+    // GDDRAM bytes changed on the rows shown. (a scroll page loaded ahead
+    // is not shown yet, a frame is)
+    uint32_t shownWrites(void) const { return shownWrites_; }
+
+private:
+    void command(uint8_t data)
+    {
+        if (cmdNeed_ > 0) {
+            cmd_[cmdLen_++] = data;
+            if (--cmdNeed_ > 0) return;
+            switch (cmd_[0]) {
+            case 0x20: mode_ = cmd_[1] & 0x03; break;
+            case 0x21: colStart_ = col_ = cmd_[1] & 0x7F; colEnd_ = cmd_[2] & 0x7F; break;
+            case 0x22: pageStart_ = page_ = cmd_[1] & 0x07; pageEnd_ = cmd_[2] & 0x07; break;
+            case 0x81: light(); contrast_ = cmd_[1]; break;
+            case 0xA8: mux_ = cmd_[1] & 0x3F; break;
+            default: break;
+            }
+            return;
+        }
+        cmd_[0] = data;
+        cmdLen_ = 1;
+        if (data >= 0xB0 && data <= 0xB7) { page_ = data & 0x07; return; }
+        if (data <= 0x0F) { col_ = (col_ & 0xF0) | data; return; }
+        if (data >= 0x10 && data <= 0x1F) { col_ = (col_ & 0x0F) | ((data & 0x0F) << 4); return; }
+        if (data >= 0x40 && data <= 0x7F) { flip(data & 0x3F); return; }
+        switch (data) {
+        case 0xAE: light(); displayOn_ = false; break;
+        case 0xAF: light(); displayOn_ = true; break;
+        case 0x21: case 0x22:
+            cmdNeed_ = 2; break;
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5:
+        case 0xD9: case 0xDA: case 0xDB:
+            cmdNeed_ = 1; break;
+        default: break;
+        }
+    }
+
+    void ram(uint8_t data)
+    {
+        if (gddram_[page_][col_] != data && visible(page_)) shownWrites_++;
+        if (integrate_ && visible(page_)) {
+            light();
+            for (int b = 0; b < 8; b++) pixel(((page_ * 8 + b) - startLine_) & 0x3F, col_, false);
+            gddram_[page_][col_] = data;
+            for (int b = 0; b < 8; b++) pixel(((page_ * 8 + b) - startLine_) & 0x3F, col_, true);
+        } else {
+            gddram_[page_][col_] = data;
+        }
+        if (mode_ == 0) {
+            // Horizontal
+            if (col_++ >= colEnd_) {
+                col_ = colStart_;
+                page_ = (page_ >= pageEnd_)? pageStart_ : page_ + 1;
+            }
+        } else if (mode_ == 1) {
+            // Vertical
+            if (page_++ >= pageEnd_) {
+                page_ = pageStart_;
+                col_ = (col_ >= colEnd_)? colStart_ : col_ + 1;
+            }
+        } else {
+            // Page
+            if (col_ < CVSIM_SSD1306_COLUMNS - 1) col_++;
+        }
+    }
+
+    // The model time, the bits since setClock().
+    uint64_t now(void)
+    {
+        uint64_t ns = baseNs_ + (bits_ - baseBits_) * 1000000000ULL / hz_;
+        if (ns > lastNs_) lastNs_ = ns;
+        return lastNs_;
+    }
+
+    // The contrast time up to now, of a pixel lit all the time.
+    void light(void)
+    {
+        if (!integrate_) return;
+        uint64_t ns = now();
+        if (displayOn_) ref_ += (double)contrast_ * (ns - refNs_);
+        refNs_ = ns;
+    }
+
+    bool visible(int page) const
+    {
+        for (int b = 0; b < 8; b++) {
+            if ((((page * 8 + b) - startLine_) & 0x3F) <= mux_) return true;
+        }
+        return false;
+    }
+
+    // The pixel of the row goes dark (off) or starts (on) its light.
+    void pixel(int row, int column, bool on)
+    {
+        if (row > mux_) return;
+        if (!on) {
+            if (onRef_[row][column] >= 0) acc_[row][column] += ref_ - onRef_[row][column];
+            onRef_[row][column] = -1;
+            return;
+        }
+        int line = (row + startLine_) & 0x3F;
+        bool lit = (gddram_[line >> 3][column] >> (line & 7)) & 1;
+        onRef_[row][column] = (lit)? ref_ : -1;
+    }
+
+    void flip(uint8_t line)
+    {
+        if (!integrate_ || line == startLine_) {
+            startLine_ = line;
+            return;
+        }
+        light();
+        for (int r = 0; r <= mux_; r++) {
+            for (int c = 0; c < CVSIM_SSD1306_COLUMNS; c++) pixel(r, c, false);
+        }
+        startLine_ = line;
+        for (int r = 0; r <= mux_; r++) {
+            for (int c = 0; c < CVSIM_SSD1306_COLUMNS; c++) {
+                pixel(r, c, true);
+                flipAcc_[r][c] = acc_[r][c];
+            }
+        }
+        flips_++;
+        flipNs_ = now();
+        flipRef_ = ref_;
+    }
+
+private:
+    typedef enum state_ {
+        STATE_IDLE = 0,
+        STATE_ADDR,
+        STATE_CONTROL,
+        STATE_CMD,
+        STATE_DATA,
+        STATE_NACK,
+    } state_t;
+
+    uint8_t gddram_[CVSIM_SSD1306_PAGES][CVSIM_SSD1306_COLUMNS];
+    uint8_t mode_;
+    uint8_t colStart_, colEnd_, col_;
+    uint8_t pageStart_, pageEnd_, page_;
+    uint8_t startLine_;
+    uint8_t contrast_;
+    uint8_t mux_;
+    bool displayOn_;
+
+    bool integrate_ = false;
+    uint64_t baseNs_, lastNs_;
+    uint64_t baseBits_;
+    uint32_t hz_;
+    double ref_;
+    uint64_t refNs_;
+    double acc_[CVSIM_SSD1306_LINES][CVSIM_SSD1306_COLUMNS];
+    double onRef_[CVSIM_SSD1306_LINES][CVSIM_SSD1306_COLUMNS];     // ref_ at the light on, -1 : off
+    double flipAcc_[CVSIM_SSD1306_LINES][CVSIM_SSD1306_COLUMNS];
+    uint32_t flips_;
+    uint64_t flipNs_;
+    double flipRef_;
+
+    state_t state_;
+    bool single_ = false;
+    uint8_t cmd_[4];
+    int cmdLen_;
+    int cmdNeed_;
+
+    uint64_t bits_;
+    uint32_t bytes_;
+    uint32_t transactions_;
+    uint32_t errors_;
+    uint32_t shownWrites_;
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - cvsim_bridge.cpp
+ *----------------------------------------------------------------------
+ */
+
+// The bridge firmware (spi-i2c-bridge.ino) built once per bridge. Every
+// call switches the SPISlave and the PIO channels to bridge k, enter() is
+// for the SPISlave callbacks called from the bus.
+void cvsim_bridge_enter(int k);
+void cvsim_bridge_setup(int k);
+void cvsim_bridge_loop(int k);
+void cvsim_bridge_loop1(int k);
+bool cvsim_bridge_read_ready(int k);        // A slot committed (and presented) for loop1()
+void cvsim_bridge_start(int k);             // loop1() starts the transfer, run at the end
+int32_t cvsim_bridge_wait_us(int k);        // loop1() waits to flip the grayscale back frame
+uint32_t cvsim_bridge_shows(int k);         // Frames and scroll rows shown by loop1(), not the scroll pages
+
+int cvsim_bridge_evictions(int k);          // Sprite cache evictions
+
+// A sprite cache of all the assets, the frames as the bridges compose
+// them. (the payloads of UPLOAD_ASSET and DRAW_SPRITES)
+void cvsim_sprites_store(const uint8_t * payload, size_t size);
+bool cvsim_sprites_compose(uint8_t * frame, int panels, const uint8_t * list, size_t size);
+
+// The SSD1306 on the buffer channel id (the SET_ID_DIR mapping applied).
+Ssd1306Model * cvsim_bridge_display(int k, int id);
+
+// The bridge running now, for the SPISlave calls.
+int cvsim_bridge_current(void);
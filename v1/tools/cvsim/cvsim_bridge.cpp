@@ -0,0 +1,236 @@
+/**********************************************************************/
+/**
+ * @brief  Host Simulator - Bridge Firmware Instances (cvsim)
+ * @author naoa
+ *
+ * spi-i2c-bridge.ino is built as is, once per bridge in its own namespace,
+ * so each bridge has its own state machine, buffers and sprite cache. The
+ * PIO I2C functions write to one SSD1306 model per state machine.
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <utility>
+
+#include <SPI.h>
+#include <SPISlave.h>
+#include <pico/mutex.h>
+
+// The headers of the sketch at global scope, included once. (#pragma once)
+#include "../../firmware/spi-i2c-bridge/led.hpp"
+#include "../../firmware/spi-i2c-bridge/interval_timer.hpp"
+#include "../../firmware/spi-i2c-bridge/circular_buffer.hpp"
+#include "../../firmware/spi-i2c-bridge/ssd1306_multi_pio.hpp"
+#include "../../firmware/spi-i2c-bridge/sprite_format.hpp"
+#include "../../firmware/spi-i2c-bridge/sprite_cache.hpp"
+#include "../../firmware/spi-i2c-bridge/spi_receiver.hpp"
+#include "../../firmware/spi-i2c-bridge/span_trace.hpp"
+
+// The PIO channel lists are file statics, shared by the two instances and
+// swapped in cvsim_bridge_enter().
+#include "../../firmware/spi-i2c-bridge/ssd1306_multi_pio.cpp"
+
+#include "cvsim.hpp"
+
+namespace bridge0 {
+#include "../../firmware/spi-i2c-bridge/spi-i2c-bridge.ino"
+}
+
+namespace bridge1 {
+#include "../../firmware/spi-i2c-bridge/spi-i2c-bridge.ino"
+}
+
+namespace bridge2 {
+#include "../../firmware/spi-i2c-bridge/spi-i2c-bridge.ino"
+}
+
+namespace bridge3 {
+#include "../../firmware/spi-i2c-bridge/spi-i2c-bridge.ino"
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+pio_hw_t cvsim_pio_hw_[NUM_PIOS] = { { 0 }, { 1 } };
+
+static int current_ = 0;
+static PIO  const * piolists_[CVSIM_BRIDGES_MAX] = { piolist0, piolist0, piolist0, piolist0 };
+static uint const * smlists_[CVSIM_BRIDGES_MAX] = { smlist0, smlist0, smlist0, smlist0 };
+
+static Ssd1306Model displays_[CVSIM_BRIDGES_MAX][NUM_PIOS * NUM_PIO_STATE_MACHINES];
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+void
+cvsim_bridge_enter(int k)
+{
+    if (k == current_) return;
+    piolists_[current_] = piolistptr_;
+    smlists_[current_] = smlistptr_;
+    piolistptr_ = piolists_[k];
+    smlistptr_ = smlists_[k];
+    current_ = k;
+}
+
+int
+cvsim_bridge_current(void)
+{
+    return current_;
+}
+
+void
+cvsim_bridge_setup(int k)
+{
+    cvsim_bridge_enter(k);
+    for (auto & display : displays_[k]) display.reset();
+    switch (k) {
+    case 0:  bridge0::setup(); bridge0::setup1(); break;
+    case 1:  bridge1::setup(); bridge1::setup1(); break;
+    case 2:  bridge2::setup(); bridge2::setup1(); break;
+    default: bridge3::setup(); bridge3::setup1(); break;
+    }
+}
+
+void
+cvsim_bridge_loop(int k)
+{
+    cvsim_bridge_enter(k);
+    switch (k) {
+    case 0:  bridge0::loop(); break;
+    case 1:  bridge1::loop(); break;
+    case 2:  bridge2::loop(); break;
+    default: bridge3::loop(); break;
+    }
+}
+
+void
+cvsim_bridge_loop1(int k)
+{
+    cvsim_bridge_enter(k);
+    switch (k) {
+    case 0:  bridge0::loop1(); break;
+    case 1:  bridge1::loop1(); break;
+    case 2:  bridge2::loop1(); break;
+    default: bridge3::loop1(); break;
+    }
+}
+
+// loop1() has a frame, a grayscale slot or a scroll to show.
+bool
+cvsim_bridge_read_ready(int k)
+{
+    switch (k) {
+    case 0:  return bridge0::frameReady() || bridge0::scrollReady();
+    case 1:  return bridge1::frameReady() || bridge1::scrollReady();
+    case 2:  return bridge2::frameReady() || bridge2::scrollReady();
+    default: return bridge3::frameReady() || bridge3::scrollReady();
+    }
+}
+
+void
+cvsim_bridge_start(int k)
+{
+    switch (k) {
+    case 0:  bridge0::presentStart(); break;
+    case 1:  bridge1::presentStart(); break;
+    case 2:  bridge2::presentStart(); break;
+    default: bridge3::presentStart(); break;
+    }
+}
+
+uint32_t
+cvsim_bridge_shows(int k)
+{
+    switch (k) {
+    case 0:  return bridge0::pushedFrames_ + bridge0::scrollFrames_;
+    case 1:  return bridge1::pushedFrames_ + bridge1::scrollFrames_;
+    case 2:  return bridge2::pushedFrames_ + bridge2::scrollFrames_;
+    default: return bridge3::pushedFrames_ + bridge3::scrollFrames_;
+    }
+}
+
+int32_t
+cvsim_bridge_wait_us(int k)
+{
+    switch (k) {
+    case 0:  return bridge0::grayWaitUs();
+    case 1:  return bridge1::grayWaitUs();
+    case 2:  return bridge2::grayWaitUs();
+    default: return bridge3::grayWaitUs();
+    }
+}
+
+int
+cvsim_bridge_evictions(int k)
+{
+    switch (k) {
+    case 0:  return bridge0::spriteCache_.evictions();
+    case 1:  return bridge1::spriteCache_.evictions();
+    case 2:  return bridge2::spriteCache_.evictions();
+    default: return bridge3::spriteCache_.evictions();
+    }
+}
+
+Ssd1306Model *
+cvsim_bridge_display(int k, int id)
+{
+    PIO  const * piolist = (k == current_)? piolistptr_ : piolists_[k];
+    uint const * smlist  = (k == current_)? smlistptr_ : smlists_[k];
+    return &displays_[k][piolist[id]->index_ * NUM_PIO_STATE_MACHINES + smlist[id]];
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Sprites
+ *----------------------------------------------------------------------
+ */
+
+// All the assets in one cache, large enough to never evict.
+static uint8_t refArena_[SPRITE_CACHE_MAX_ENTRIES * SPRITE_ASSET_MAX_SIZE];
+static SpriteCache spriteRef_;
+static bool spriteRefInit_ = false;
+
+void
+cvsim_sprites_store(const uint8_t * payload, size_t size)
+{
+    if (!spriteRefInit_) {
+        spriteRef_.init(refArena_, sizeof(refArena_), CvDefaultGeometry::WIDTH, CvDefaultGeometry::HEIGHT);
+        spriteRefInit_ = true;
+    }
+    spriteRef_.store(payload, size);
+}
+
+bool
+cvsim_sprites_compose(uint8_t * frame, int panels, const uint8_t * list, size_t size)
+{
+    return spriteRef_.compose(frame, panels, list, size);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - PIO I2C (pio_i2c.h)
+ *----------------------------------------------------------------------
+ */
+
+static inline Ssd1306Model *
+display(PIO pio, uint sm)
+{
+    return &displays_[current_][pio->index_ * NUM_PIO_STATE_MACHINES + sm];
+}
+
+// The words are the PIO I2C program words : data << 1 | final << 9 | nak.
+void pio_i2c_start(PIO pio, uint sm) { display(pio, sm)->start(); }
+void pio_i2c_stop(PIO pio, uint sm) { display(pio, sm)->stop(); }
+void pio_i2c_repstart(PIO pio, uint sm) { display(pio, sm)->start(); }
+void pio_i2c_rx_enable(PIO, uint, bool) {}
+bool pio_i2c_check_error(PIO, uint) { return false; }
+void pio_i2c_resume_after_error(PIO, uint) {}
+void pio_i2c_put16(PIO pio, uint sm, uint16_t data) { display(pio, sm)->write((uint8_t)(data >> PIO_I2C_DATA_LSB)); }
+void pio_i2c_put_or_err(PIO pio, uint sm, uint16_t data) { display(pio, sm)->write((uint8_t)(data >> PIO_I2C_DATA_LSB)); }
+uint8_t pio_i2c_get(PIO, uint) { return 0; }
+void pio_i2c_wait_idle(PIO, uint) {}
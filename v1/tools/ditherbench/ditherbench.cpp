@@ -0,0 +1,320 @@
+/**********************************************************************/
+/**
+ * @brief  Dither Kernel Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Check mono_dither (mono_dither.hpp) against a naive per pixel dither :
+ * the threshold tiles (the Bayer matrix, the blue noise ranks, the levels
+ * of a flat gray), random rectangles with the clipping, the mirrored
+ * columns, the row alignments and the level scale, and
+ * CyclicMonoDrawer::drawGray around the cylinder. Then measure the
+ * throughput in Mpixels/s, the word (whole page) path, the partial pages,
+ * the level scale and the blue noise against the per pixel dither.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller ditherbench.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o ditherbench
+ *
+ * Run :
+ *   ./ditherbench [rounds]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+#include "mono_dither.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+typedef CvScreenGeometry G;
+
+typedef struct gray_buffer_ {
+    std::vector<uint8_t> data_;
+    gray_image_t image_;
+} gray_buffer_t;
+
+static uint32_t rnd_ = 2463534242UL;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Reference
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+static int
+rnd_range(int lo, int hi)
+{
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+// Random image, smooth or noise, with some stride.
+static void
+make_gray(gray_buffer_t * g, int w, int h, bool noise)
+{
+    int stride = w + rnd_range(0, 5);
+    g->data_.assign((size_t)stride * h + 4, 0);
+    int fx = rnd_range(1, 9), fy = rnd_range(1, 9);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            g->data_[(y * stride) + x] = (noise)? (uint8_t)rnd() : (uint8_t)(((x * fx) + (y * fy)) & 0xFF);
+        }
+    }
+    g->image_ = { w, h, stride, g->data_.data() };
+}
+
+// Bayer matrix by the recursion M(2n) = [[4M, 4M + 2], [4M + 3, 4M + 1]],
+// the quadrants of M(n).
+static int
+bayer(int x, int y, int n)
+{
+    if (n == 1) return 0;
+    int h = n / 2;
+    int q = ((x / h) == 0)? (((y / h) == 0)? 0 : 3) : (((y / h) == 0)? 2 : 1);
+    return (4 * bayer(x % h, y % h, h)) + q;
+}
+
+static bool
+white(const gray_image_t * src, int x, int y, int column, int row, mono_dither_t method, int level)
+{
+    int v = src->buffer_[(y * src->stride_) + x] >> 1;
+    if (level < MONO_DITHER_LEVEL_MAX) v = (v * ((level < 0)? 0 : level)) >> 8;
+    return v >= mono_dither_threshold(method, column, row);
+}
+
+// Per pixel, every src pixel to its mirrored dst column.
+static void
+naive_dither(const mono_surface_t * dst, int dx, int dy, const gray_image_t * src, int sx, int sy,
+             int width, int height, mono_dither_t method, int level)
+{
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            int x = sx + i, y = sy + j;
+            int column = dx + width - 1 - i, row = dy + j;
+            if (x < 0 || y < 0 || x >= src->width_ || y >= src->height_) continue;
+            if (column < 0 || row < 0 || column >= dst->width_ || row >= dst->height_) continue;
+            uint8_t * d = &dst->buffer_[((column >> 3) * dst->height_) + row];
+            if (white(src, x, y, column, row, method, level)) *d |= (uint8_t)(1 << (column & 7));
+            else *d &= (uint8_t)~(1 << (column & 7));
+        }
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Checks
+ *----------------------------------------------------------------------
+ */
+
+static bool
+check_tiles(void)
+{
+    bool ok = true;
+    // Thresholds of the ranks.
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            int t = 1 + ((bayer(c, r, 8) * 127) / 64);
+            if (mono_dither_threshold(MONO_DITHER_BAYER, c, r) != t || mono_dither_threshold(MONO_DITHER_BAYER, c + 40, r + 16) != t) {
+                printf("NG : bayer (%d, %d) %d != %d\n", c, r, mono_dither_threshold(MONO_DITHER_BAYER, c, r), t);
+                ok = false;
+            }
+        }
+    }
+    // The levels of a flat gray on a tile : the white cells grow with the
+    // intensity, 0 is black and 255 white, within a cell of the level.
+    const struct { mono_dither_t method_; int n_; } tiles[] = {
+        { MONO_DITHER_BAYER, 8 }, { MONO_DITHER_BLUE_NOISE, 16 },
+    };
+    for (auto & tile : tiles) {
+        int last = -1;
+        double maxErr = 0;
+        for (int v = 0; v < 256; v++) {
+            int on = 0;
+            for (int r = 0; r < tile.n_; r++) {
+                for (int c = 0; c < tile.n_; c++) {
+                    on += ((v >> 1) >= mono_dither_threshold(tile.method_, c, r))? 1 : 0;
+                }
+            }
+            int cells = tile.n_ * tile.n_;
+            double err = ((double)on / cells) - (v / 255.0);
+            if (err < 0) err = -err;
+            if (err > maxErr) maxErr = err;
+            if (on < last || (v == 0 && on != 0) || (v == 255 && on != cells) || err > (2.5 / cells) + (2.0 / 255)) {
+                printf("NG : %s level %d, %d cells\n", (tile.method_ == MONO_DITHER_BAYER)? "bayer" : "blue noise", v, on);
+                ok = false;
+                break;
+            }
+            last = on;
+        }
+        printf("tile %-10s %2d x %-2d : max level error %.4f\n",
+            (tile.method_ == MONO_DITHER_BAYER)? "bayer" : "blue noise", tile.n_, tile.n_, maxErr);
+    }
+    return ok;
+}
+
+static bool
+check_kernel(int rounds)
+{
+    std::vector<uint8_t> a(G::ONE_FRAME_BYTES + 8), b(G::ONE_FRAME_BYTES + 8);
+    for (int n = 0; n < rounds; n++) {
+        gray_buffer_t g;
+        make_gray(&g, rnd_range(1, 80), rnd_range(1, 150), (rnd() & 1) != 0);
+        // Also the dst not word aligned.
+        int offset = rnd_range(0, 3);
+        for (size_t i = 0; i < a.size(); i++) a[i] = b[i] = (uint8_t)rnd();
+        mono_surface_t sa = { G::WIDTH, G::HEIGHT, a.data() + offset };
+        mono_surface_t sb = { G::WIDTH, G::HEIGHT, b.data() + offset };
+        int dx = rnd_range(-40, 50), dy = rnd_range(-20, 140);
+        int sx = rnd_range(-10, 20), sy = rnd_range(-10, 20);
+        int w = rnd_range(0, 90), h = rnd_range(0, 160);
+        mono_dither_t method = (mono_dither_t)(rnd() & 1);
+        const int levels[] = { MONO_DITHER_LEVEL_MAX, MONO_DITHER_LEVEL_MAX, 0, 128, 200, 300, -5 };
+        int level = levels[rnd() % 7];
+        mono_dither(&sa, dx, dy, &g.image_, sx, sy, w, h, method, level);
+        naive_dither(&sb, dx, dy, &g.image_, sx, sy, w, h, method, level);
+        if (a != b) {
+            printf("NG : kernel dst (%d, %d) src (%d, %d) %d x %d, src %d x %d, method %d, level %d, offset %d\n",
+                dx, dy, sx, sy, w, h, g.image_.width_, g.image_.height_, method, level, offset);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+check_drawer(int rounds)
+{
+    std::vector<uint8_t> a(G::FRAME_BYTES), b(G::FRAME_BYTES);
+    CyclicMonoScreen sa, sb;
+    CyclicMonoDrawer drawer;
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        sa.getMonoScreen(i)->setBuffer(a.data() + (i * G::ONE_FRAME_BYTES));
+        sb.getMonoScreen(i)->setBuffer(b.data() + (i * G::ONE_FRAME_BYTES));
+    }
+    drawer.init(&sa);
+
+    for (int n = 0; n < rounds; n++) {
+        gray_buffer_t g;
+        make_gray(&g, rnd_range(1, G::V_WIDTH), rnd_range(1, 140), (rnd() & 1) != 0);
+        for (size_t i = 0; i < a.size(); i++) a[i] = b[i] = (uint8_t)rnd();
+        int x = rnd_range(-2 * G::V_WIDTH, 2 * G::V_WIDTH), y = rnd_range(-40, 140);
+        mono_dither_t method = (mono_dither_t)(rnd() & 1);
+        int level = ((rnd() & 1) == 0)? MONO_DITHER_LEVEL_MAX : rnd_range(0, 255);
+        bool centered = (rnd() & 1) != 0;
+        drawer.drawGray(x, y, &g.image_, method, level, centered);
+
+        // Per dot, the panel column of the cylinder x.
+        int x0 = (centered)? x - (g.image_.width_ / 2) : x;
+        int y0 = (centered)? y - (g.image_.height_ / 2) : y;
+        for (int j = 0; j < g.image_.height_; j++) {
+            for (int i = 0; i < g.image_.width_; i++) {
+                int v = G::COLUMNS.v_[G::wrap(x0 + i)];
+                int row = y0 + j;
+                if (v < 0 || row < 0 || row >= G::HEIGHT) continue;
+                int column = v % G::WIDTH;
+                sb.getMonoScreen(v / G::WIDTH)->setDot(column, row,
+                    (white(&g.image_, i, j, column, row, method, level))? DISP_COLOR_WHITE : DISP_COLOR_BLACK);
+            }
+        }
+        if (a != b) {
+            printf("NG : drawGray (%d, %d) %d x %d, method %d, level %d, centered %d\n",
+                x, y, g.image_.width_, g.image_.height_, method, level, centered);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+template <typename F>
+static double
+mpixels(int pixels, F func)
+{
+    using clock = std::chrono::steady_clock;
+    int n = 0;
+    auto t0 = clock::now();
+    double us = 0;
+    do {
+        for (int i = 0; i < 64; i++) func();
+        n += 64;
+        us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+    } while (us < 200000.0);
+    return ((double)pixels * n) / us;
+}
+
+int
+main(int argc, char ** argv)
+{
+    int rounds = (argc > 1)? atoi(argv[1]) : 20000;
+    if (rounds <= 0) rounds = 20000;
+
+    bool ok = check_tiles();
+    ok = ok && check_kernel(rounds);
+    ok = ok && check_drawer(rounds / 20);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+
+    // A panel, and the whole cylinder through the drawer.
+    gray_buffer_t g;
+    make_gray(&g, G::V_WIDTH, G::HEIGHT, false);
+    g.image_.stride_ = G::V_WIDTH;
+    static uint8_t frame[G::FRAME_BYTES];
+    mono_surface_t panel = { G::WIDTH, G::HEIGHT, frame };
+    CyclicMonoScreen screen;
+    CyclicMonoDrawer drawer;
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frame + (i * G::ONE_FRAME_BYTES));
+    }
+    drawer.init(&screen);
+
+    const int P = G::WIDTH * G::HEIGHT;
+    const int C = P * G::DISPLAYS;     // The visible pixels
+    printf("%-32s %8.1f Mpixels/s\n", "per pixel", mpixels(P, [&]() {
+        naive_dither(&panel, 0, 0, &g.image_, 0, 0, G::WIDTH, G::HEIGHT, MONO_DITHER_BAYER, MONO_DITHER_LEVEL_MAX);
+    }));
+    printf("%-32s %8.1f Mpixels/s\n", "bayer, whole pages", mpixels(P, [&]() {
+        mono_dither(&panel, 0, 0, &g.image_, 0, 0, G::WIDTH, G::HEIGHT, MONO_DITHER_BAYER);
+    }));
+    printf("%-32s %8.1f Mpixels/s\n", "bayer, level scale", mpixels(P, [&]() {
+        mono_dither(&panel, 0, 0, &g.image_, 0, 0, G::WIDTH, G::HEIGHT, MONO_DITHER_BAYER, 160);
+    }));
+    printf("%-32s %8.1f Mpixels/s\n", "bayer, partial pages (3, 26)", mpixels(26 * G::HEIGHT, [&]() {
+        mono_dither(&panel, 3, 0, &g.image_, 0, 0, 26, G::HEIGHT, MONO_DITHER_BAYER);
+    }));
+    printf("%-32s %8.1f Mpixels/s\n", "blue noise, whole pages", mpixels(P, [&]() {
+        mono_dither(&panel, 0, 0, &g.image_, 0, 0, G::WIDTH, G::HEIGHT, MONO_DITHER_BLUE_NOISE);
+    }));
+    printf("%-32s %8.1f Mpixels/s\n", "drawGray, cylinder", mpixels(C, [&]() {
+        drawer.drawGray(0, 0, &g.image_);
+    }));
+    return (ok)? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/**********************************************************************/
+/**
+ * @brief  Fixed Point Math Check (Host Tool)
+ * @author naoa
+ *
+ * Check the fixed point paths (fixed_math.hpp) against the float / double
+ * versions they replaced :
+ *   - fixed_sin / fixed_cos over every binary angle, the error bounded
+ *   - fixed_tan of the integer degrees of render mode 1, the error bounded
+ *     by the slope of tan (1 + tan^2), and the saturation at the limit
+ *   - the App::angle2xpos() mapping (copied, app.cpp needs the Arduino
+ *     core) of every encoder count against the float radians path, equal
+ *     but at the columns the float rounds below
+ *   - drawTriangleFill (16.16 edges) against the previous double edge walk
+ *     through the same drawHLine, random triangles over the cylinder x wrap
+ *     and the top / bottom clipping. A frame may only differ by one pixel
+ *     at a span end on an exact .5 tie, where the double result is the
+ *     rounding noise of the accumulated slope.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller fixedtest.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o fixedtest
+ *
+ * Run :
+ *   ./fixedtest [triangles]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "fixed_math.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define SIN_ERROR_MAX       (3.0e-5)    // 2 LSB of 16.16
+#define TAN_ERROR_MAX       (1.4e-4)    // Times (1 + tan^2) : the degree truncated to the
+                                        // binary angle (9.6e-5 rad) and sqrt(2) x the sin error
+#define TAN_LIMIT           (CV_HEIGHT) // Render mode 1
+
+#define ENCODER_COUNT_BITS  (14)        // Same to encoder.hpp
+#define ENCODER_COUNTS      (1 << ENCODER_COUNT_BITS)
+
+static uint32_t rnd_ = 0x5EED0029UL;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Float references
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+// Same to App::angle2xpos()
+static int
+angle2xpos(uint32_t count)
+{
+    return (int)((count * CV_V_WIDTH) >> ENCODER_COUNT_BITS);
+}
+
+// encoder_get_angle_spi() then App::angle2xpos(float), before the fixed point.
+static int
+float_angle2xpos(uint32_t count)
+{
+    float angle = ((float)count / 0x4000) * (2.0 * M_PI);
+    return (angle / (2 * M_PI)) * CV_V_WIDTH;
+}
+
+static void
+double_scan_line(CyclicMonoDrawer * drawer, double & l_x, double & l_a, double & r_x, double & r_a,
+                 int & sy, int ey, color_t c)
+{
+    int width_m1 = drawer->width() - 1;
+    for ( ; sy < ey ; ++sy ) {
+        int sx = (int)(l_x + 0.5);
+        int ex = (int)(r_x + 0.5);
+        sx = (l_x < 0)? 0 : sx;
+        if ( ex > width_m1 ) ex = width_m1;
+        drawer->drawHLine(sx, ex, sy, c);
+        l_x += l_a; r_x += r_a;
+    }
+}
+
+// The double drawTriangleFill, as it was.
+static void
+double_triangle_fill(CyclicMonoDrawer * drawer, int x1, int y1, int x2, int y2, int x3, int y3, color_t c)
+{
+    if ( y1 > y2 ) { std::swap(x1, x2); std::swap(y1, y2); }
+    if ( y1 > y3 ) { std::swap(x1, x3); std::swap(y1, y3); }
+    if ( y2 > y3 ) { std::swap(x2, x3); std::swap(y2, y3); }
+    int top_x = x1, top_y = y1;
+    int mid_x = x2, mid_y = y2;
+    int btm_x = x3, btm_y = y3;
+
+    if ( top_y >= drawer->height() ) return;
+    if ( btm_y < 0 ) return;
+
+    double top_mid_x = top_x;
+    double top_btm_x = top_x;
+
+    if ( top_y == mid_y ) top_mid_x = mid_x;
+
+    int sy = top_y;
+    int my = mid_y;
+    int ey = btm_y;
+
+    if ( top_y < 0 ) {
+        sy = 0;
+        if ( mid_y >= 0 ) {
+            if ( top_y != mid_y )
+                top_mid_x = (double)( mid_x - top_x ) * (double)mid_y / (double)( top_y - mid_y ) + (double)mid_x;
+        } else {
+            if ( mid_y != btm_y )
+                top_mid_x = (double)( btm_x - mid_x ) * (double)btm_y / (double)( mid_y - btm_y ) + (double)btm_x;
+        }
+        if ( top_y != btm_y )
+            top_btm_x = (double)( btm_x - top_x ) * (double)btm_y / (double)( top_y - btm_y ) + (double)btm_x;
+    }
+
+    if ( btm_y >= drawer->height() ) ey = drawer->height() - 1;
+
+    double top_mid_a = ( mid_y != top_y ) ?
+      (double)( mid_x - top_x ) / (double)( mid_y - top_y ) : 0;
+    double mid_btm_a = ( mid_y != btm_y ) ?
+      (double)( mid_x - btm_x ) / (double)( mid_y - btm_y ) : 0;
+    double top_btm_a = ( top_y != btm_y ) ?
+      (double)( top_x - btm_x ) / (double)( top_y - btm_y ) : 0;
+
+    int splitLine_x = ( top_y != btm_y ) ?
+      ( top_x - btm_x ) * ( mid_y - top_y ) / ( top_y - btm_y ) + top_x :
+      btm_x;
+
+    double l_x, l_a, r_x, r_a;
+    if ( mid_x < splitLine_x) {
+        l_x = top_mid_x; l_a = top_mid_a;
+        r_x = top_btm_x; r_a = top_btm_a;
+    } else {
+        l_x = top_btm_x; l_a = top_btm_a;
+        r_x = top_mid_x; r_a = top_mid_a;
+    }
+
+    double_scan_line(drawer, l_x, l_a, r_x, r_a, sy, my, c);
+    if ( mid_x < splitLine_x) {
+        l_a = mid_btm_a;
+    } else {
+        r_a = mid_btm_a;
+    }
+    double_scan_line(drawer, l_x, l_a, r_x, r_a, sy, ey + 1, c);
+}
+
+// The edge (xa, ya) - (xb, yb) is exactly on k + 0.5 at the row y.
+static bool
+edge_tie(int xa, int ya, int xb, int yb, int y)
+{
+    if (ya == yb || y < std::min(ya, yb) || y > std::max(ya, yb)) return false;
+    int64_t num = 2 * (int64_t)(xb - xa) * (y - ya);
+    int64_t den = yb - ya;
+    if (num % den != 0) return false;
+    return ((2 * (int64_t)xa + (num / den)) & 1) != 0;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Check
+ *----------------------------------------------------------------------
+ */
+
+static bool
+check_sin(void)
+{
+    double sinMax = 0, cosMax = 0;
+    for (uint32_t a = 0; a < FIXED_ANGLE_FULL; a++) {
+        double rad = (2 * M_PI) * a / FIXED_ANGLE_FULL;
+        sinMax = std::max(sinMax, fabs((double)fixed_sin(a) / FIXED_ONE - sin(rad)));
+        cosMax = std::max(cosMax, fabs((double)fixed_cos(a) / FIXED_ONE - cos(rad)));
+    }
+    bool ok = (sinMax <= SIN_ERROR_MAX) && (cosMax <= SIN_ERROR_MAX);
+    printf("sin / cos     %6u angles, max error %.2e / %.2e (limit %.1e)  %s\n",
+        (unsigned)FIXED_ANGLE_FULL, sinMax, cosMax, SIN_ERROR_MAX, (ok)? "OK" : "NG");
+    return ok;
+}
+
+static bool
+check_tan(void)
+{
+    double errMax = 0;
+    int bad = 0, saturated = 0;
+    const fixed_t limit = fixed_from_int(TAN_LIMIT);
+    for (int deg = 0; deg < 360; deg++) {
+        double t = tan((2 * M_PI) * (deg / 360.0));
+        double f = (double)fixed_tan(fixed_angle_from_deg(deg), limit) / FIXED_ONE;
+        if (fabs(t) >= TAN_LIMIT) {
+            // Saturated to the limit, the sign of tan. 90 and 270 degrees have no sign.
+            saturated++;
+            if (fabs(f) != TAN_LIMIT || ((deg % 90) != 0 && (t < 0) != (f < 0))) bad++;
+            continue;
+        }
+        double err = fabs(f - t) / (1 + (t * t));
+        errMax = std::max(errMax, err);
+        if (fabs(f - t) > (TAN_ERROR_MAX * (1 + (t * t))) + (1.0 / FIXED_ONE)) bad++;
+    }
+    printf("tan           %6d degrees, max error / (1 + tan^2) %.2e, %d saturated, %d out of bounds  %s\n",
+        360, errMax, saturated, bad, (bad == 0)? "OK" : "NG");
+    return (bad == 0);
+}
+
+static bool
+check_angle2xpos(void)
+{
+    int differ = 0, notExact = 0, maxDiff = 0;
+    for (uint32_t count = 0; count < ENCODER_COUNTS; count++) {
+        int x = angle2xpos(count);
+        int f = float_angle2xpos(count);
+        if (x == f) continue;
+        differ++;
+        maxDiff = std::max(maxDiff, abs(x - f));
+        // The float lands just below a whole column.
+        if (((count * CV_V_WIDTH) % ENCODER_COUNTS) != 0 || f != x - 1) notExact++;
+    }
+    bool ok = (notExact == 0);
+    printf("angle2xpos    %6d counts, %d differ (max %d column), %d not a float round down  %s\n",
+        ENCODER_COUNTS, differ, maxDiff, notExact, (ok)? "OK" : "NG");
+    return ok;
+}
+
+static bool
+check_triangles(int triangles)
+{
+    static uint8_t fixedFrame[CV_FRAME_BYTES], doubleFrame[CV_FRAME_BYTES];
+    CyclicMonoScreen fixedScreen, doubleScreen;
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        fixedScreen.getMonoScreen(i)->setBuffer(fixedFrame + (i * CV_ONE_FRAME_BYTES));
+        doubleScreen.getMonoScreen(i)->setBuffer(doubleFrame + (i * CV_ONE_FRAME_BYTES));
+    }
+    CyclicMonoDrawer fixedDrawer, doubleDrawer;
+    fixedDrawer.init(&fixedScreen);
+    doubleDrawer.init(&doubleScreen);
+
+    int exact = 0, ties = 0, bad = 0, pixels = 0;
+    for (int n = 0; n < triangles; n++) {
+        // Large ones over the wrap and the clipping, and small ones.
+        int spread = ((n & 3) == 0)? 8 : 160;
+        int x[3], y[3];
+        x[0] = (int)(rnd() % (CV_V_WIDTH * 2)) - (CV_V_WIDTH / 2);
+        y[0] = (int)(rnd() % (CV_HEIGHT + 128)) - 64;
+        for (int i = 1; i < 3; i++) {
+            x[i] = x[0] + (int)(rnd() % (spread * 2 + 1)) - spread;
+            y[i] = y[0] + (int)(rnd() % (spread * 2 + 1)) - spread;
+        }
+        memset(fixedFrame, 0, sizeof(fixedFrame));
+        memset(doubleFrame, 0, sizeof(doubleFrame));
+        fixedDrawer.drawTriangleFill(x[0], y[0], x[1], y[1], x[2], y[2], DISP_COLOR_WHITE);
+        double_triangle_fill(&doubleDrawer, x[0], y[0], x[1], y[1], x[2], y[2], DISP_COLOR_WHITE);
+        if (memcmp(fixedFrame, doubleFrame, sizeof(fixedFrame)) == 0) {
+            exact++;
+            continue;
+        }
+
+        // Each row differing by one pixel a span end, on a tie of an edge.
+        bool tie = true;
+        for (int row = 0; row < CV_HEIGHT; row++) {
+            int d = 0;
+            for (int col = 0; col < CV_V_WIDTH; col++) {
+                if (fixedDrawer.getDot(col, row) != doubleDrawer.getDot(col, row)) d++;
+            }
+            if (d == 0) continue;
+            pixels += d;
+            bool onTie = edge_tie(x[0], y[0], x[1], y[1], row) || edge_tie(x[1], y[1], x[2], y[2], row) ||
+                         edge_tie(x[0], y[0], x[2], y[2], row);
+            if (d > 2 || !onTie) tie = false;
+        }
+        if (tie) {
+            ties++;
+        } else {
+            if (bad == 0) {
+                printf("  first mismatch : (%d, %d) (%d, %d) (%d, %d)\n", x[0], y[0], x[1], y[1], x[2], y[2]);
+            }
+            bad++;
+        }
+    }
+    bool ok = (bad == 0);
+    printf("triangle fill %6d triangles, %d pixel exact, %d differ at .5 ties only (%d pixels), %d otherwise  %s\n",
+        triangles, exact, ties, pixels, bad, (ok)? "OK" : "NG");
+    return ok;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+int
+main(int argc, char ** argv)
+{
+    int triangles = (argc > 1)? atoi(argv[1]) : 200000;
+    if (triangles <= 0) triangles = 200000;
+
+    bool ok = true;
+    ok &= check_sin();
+    ok &= check_tan();
+    ok &= check_angle2xpos();
+    ok &= check_triangles(triangles);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    return (ok)? 0 : 1;
+}
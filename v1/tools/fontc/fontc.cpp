@@ -0,0 +1,354 @@
+/**********************************************************************/
+/**
+ * @brief  Font Compiler (Host Tool)
+ * @author naoa
+ *
+ * Compile a bitmap font to a panel native font (font_t) for the
+ * controller firmware. See font.hpp for the data format.
+ *
+ *  - Glyphs are trimmed to the ink columns, all glyphs are the font height.
+ *  - Data is packed horizontally (8 columns per byte), same to the screen,
+ *    so a glyph is a mono_plane_t as is.
+ *  - The monospace cell and the ink left in the cell are kept, the text
+ *    is drawn monospace or proportional at run time.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 fontc.cpp -o fontc
+ *
+ * Input is the built-in 5x7 ASCII font (0x20 ~ 0x7E), or a BDF font (the
+ * same range, other codes are dropped). Integer scaled by -s. e.g. :
+ *   ./fontc -n small -o ../../firmware/controller/font_small.h
+ *   ./fontc -n ticker -s 4 -o ../../firmware/controller/font_ticker.h
+ *   ./fontc -n tamzen -o font_tamzen.h Tamzen8x16r.bdf
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define FONT_FIRST                  (0x20)
+#define FONT_LAST                   (0x7E)
+#define FONT_COUNT                  (FONT_LAST - FONT_FIRST + 1)
+
+#define MAX_SIZE                    (255)   // font_t fields are 8 bit
+
+// Target (RP2040, 32 bit) structure sizes for the flash report.
+#define TARGET_FONT_GLYPH_SIZE      (8)
+#define TARGET_FONT_SIZE            (20)
+
+// Built-in 5x7 font, 5 columns a glyph, bit y of a column (LSB top).
+static const uint8_t builtin_5x7[FONT_COUNT][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, //   !
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // " #
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, // $ %
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, // & '
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // ( )
+    { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // * +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, // , -
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 }, // . /
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // 0 1
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // 2 3
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, // 4 5
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 6 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, // 8 9
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 }, // : ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, // < =
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, // > ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, // @ A
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // B C
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // D E
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // F G
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // H I
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // J K
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, // L M
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // N O
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // P Q
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 }, // R S
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // T U
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // V W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, // X Y
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // Z [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, // \ ]
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 }, // ^ _
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, // ` a
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, // b c
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, // d e
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E }, // f g
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, // h i
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 }, // j k
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, // l m
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, // n o
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, // p q
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 }, // r s
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, // t u
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C }, // v w
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, // x y
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, // z {
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, // | }
+    { 0x08, 0x04, 0x08, 0x10, 0x08 },                                   // ~
+};
+
+// Source glyph in its cell, a byte a pixel (1 = ink).
+typedef struct glyph_ {
+    bool present = false;
+    int advance = 0;            // Proportional advance of a blank glyph
+    std::vector<uint8_t> pixels;
+} glyph_t;
+
+typedef struct source_ {
+    int width = 0;              // Cell
+    int height = 0;
+    int spacing = 1;
+    int space = 0;
+    glyph_t glyphs[FONT_COUNT];
+} source_t;
+
+typedef struct options_ {
+    std::string name = "small";
+    std::string output;
+    int scale = 1;
+} options_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Input
+ *----------------------------------------------------------------------
+ */
+
+static void
+load_builtin(source_t * src)
+{
+    src->width = 6;         // 5 columns and a gap
+    src->height = 7;
+    src->spacing = 1;
+    src->space = 3;
+    for (int i = 0; i < FONT_COUNT; i++) {
+        glyph_t * g = &src->glyphs[i];
+        g->present = true;
+        g->pixels.assign(src->width * src->height, 0);
+        for (int x = 0; x < 5; x++) {
+            for (int y = 0; y < src->height; y++) {
+                g->pixels[(y * src->width) + x] = (builtin_5x7[i][x] >> y) & 1;
+            }
+        }
+    }
+}
+
+// BDF : glyphs are placed on the font bounding box by BBX, on the baseline.
+static bool
+load_bdf(const char * path, source_t * src)
+{
+    FILE * fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "fontc: %s: cannot open\n", path);
+        return false;
+    }
+    int fbw = 0, fbh = 0, fbx = 0, fby = 0;
+    int code = -1, dwidth = 0, bw = 0, bh = 0, bx = 0, by = 0;
+    int row = -1;
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        if (row >= 0) {
+            if (strncmp(line, "ENDCHAR", 7) == 0) {
+                row = -1;
+                continue;
+            }
+            if (code < FONT_FIRST || code > FONT_LAST) continue;
+            glyph_t * g = &src->glyphs[code - FONT_FIRST];
+            unsigned long bits = strtoul(line, nullptr, 16);
+            int digits = (int)strspn(line, "0123456789abcdefABCDEF");
+            int y = (fbh + fby) - (by + bh) + row;
+            for (int i = 0; i < bw; i++) {
+                int x = (bx - fbx) + i;
+                if (x < 0 || x >= src->width || y < 0 || y >= src->height) continue;
+                if ((bits >> ((digits * 4) - 1 - i)) & 1) g->pixels[(y * src->width) + x] = 1;
+            }
+            row++;
+        } else if (sscanf(line, "FONTBOUNDINGBOX %d %d %d %d", &fbw, &fbh, &fbx, &fby) == 4) {
+            if (fbw <= 0 || fbh <= 0 || fbw > MAX_SIZE || fbh > MAX_SIZE) break;
+            src->width = fbw;
+            src->height = fbh;
+        } else if (sscanf(line, "ENCODING %d", &code) == 1) {
+        } else if (sscanf(line, "DWIDTH %d", &dwidth) == 1) {
+        } else if (sscanf(line, "BBX %d %d %d %d", &bw, &bh, &bx, &by) == 4) {
+        } else if (strncmp(line, "BITMAP", 6) == 0) {
+            if (src->width == 0) break;
+            row = 0;
+            if (code >= FONT_FIRST && code <= FONT_LAST) {
+                glyph_t * g = &src->glyphs[code - FONT_FIRST];
+                g->present = true;
+                g->advance = dwidth;
+                g->pixels.assign(src->width * src->height, 0);
+            }
+        }
+    }
+    fclose(fp);
+    if (src->width == 0) {
+        fprintf(stderr, "fontc: %s: no FONTBOUNDINGBOX\n", path);
+        return false;
+    }
+    src->spacing = 1;
+    const glyph_t * space = &src->glyphs[' ' - FONT_FIRST];
+    src->space = (space->present && space->advance > 0)? space->advance : ((src->width + 1) / 2);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Output
+ *----------------------------------------------------------------------
+ */
+
+static bool
+write_font(const source_t & src, const options_t & opt)
+{
+    const int s = opt.scale;
+    const int height = src.height * s;
+    const int cell = src.width * s;
+    if (height > MAX_SIZE || cell > MAX_SIZE) {
+        fprintf(stderr, "fontc: %d x %d is too big for font_t\n", cell, height);
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> offsets(FONT_COUNT, 0);
+    std::vector<int> widths(FONT_COUNT, 0), lefts(FONT_COUNT, 0);
+    int widthMax = 0;
+    int glyphs = 0;
+    for (int i = 0; i < FONT_COUNT; i++) {
+        const glyph_t & g = src.glyphs[i];
+        if (!g.present) continue;
+        // Ink columns.
+        int x0 = src.width, x1 = -1;
+        for (int x = 0; x < src.width; x++) {
+            for (int y = 0; y < src.height; y++) {
+                if (g.pixels[(y * src.width) + x]) {
+                    if (x < x0) x0 = x;
+                    if (x > x1) x1 = x;
+                }
+            }
+        }
+        if (x1 < 0) continue;
+        int w = (x1 - x0 + 1) * s;
+        widths[i] = w;
+        lefts[i] = x0 * s;
+        offsets[i] = (uint32_t)data.size();
+        if (w > widthMax) widthMax = w;
+        glyphs++;
+        // Panel native strips, column c is the glyph x (w - 1 - c).
+        for (int page = 0; page < (w + 7) / 8; page++) {
+            for (int y = 0; y < height; y++) {
+                uint8_t b = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    int c = (page * 8) + bit;
+                    if (c >= w) break;
+                    int x = x0 + ((w - 1 - c) / s);
+                    if (src.glyphs[i].pixels[((y / s) * src.width) + x]) b |= (uint8_t)(1 << bit);
+                }
+                data.push_back(b);
+            }
+        }
+    }
+
+    size_t flash = data.size() + (FONT_COUNT * TARGET_FONT_GLYPH_SIZE) + TARGET_FONT_SIZE;
+    printf("font %s : %d glyphs, height %d, cell %d, widest %d, %zu bytes\n",
+        opt.name.c_str(), glyphs, height, cell, widthMax, flash);
+    if (opt.output.empty()) return true;
+
+    FILE * fp = fopen(opt.output.c_str(), "w");
+    if (!fp) {
+        fprintf(stderr, "fontc: %s: cannot open\n", opt.output.c_str());
+        return false;
+    }
+    const char * name = opt.name.c_str();
+    fprintf(fp, "// name : font_%s\n", name);
+    fprintf(fp, "// %d glyphs, height %d, cell %d, %zu bytes\n\n", glyphs, height, cell, flash);
+
+    fprintf(fp, "const uint8_t font_%s_data[] = {", name);
+    for (size_t i = 0; i < data.size(); i++) {
+        if ((i % 16) == 0) fprintf(fp, "\n    ");
+        fprintf(fp, "0x%02x, ", data[i]);
+    }
+    if (data.empty()) fprintf(fp, " 0x00");
+    fprintf(fp, "\n};\n\n");
+
+    fprintf(fp, "const font_glyph_t font_%s_glyphs[] = {\n", name);
+    for (int i = 0; i < FONT_COUNT; i++) {
+        int code = FONT_FIRST + i;
+        fprintf(fp, "    { 0x%08x, %d, %d },  // 0x%02x", offsets[i], widths[i], lefts[i], code);
+        if (code != '\\') fprintf(fp, " %c", code);
+        fprintf(fp, "\n");
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "const font_t font_%s = {\n", name);
+    fprintf(fp, "    \"%s\",\n", name);
+    fprintf(fp, "    0x%02x, %d,\n", FONT_FIRST, FONT_COUNT);
+    fprintf(fp, "    %d, %d, %d, %d, %d,\n", height, cell, src.spacing * s, src.space * s, widthMax);
+    fprintf(fp, "    font_%s_glyphs,\n", name);
+    fprintf(fp, "    font_%s_data\n", name);
+    fprintf(fp, "};\n");
+    fclose(fp);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: fontc [options] [font.bdf]\n"
+        "  -o file       output font header (e.g. font_small.h)\n"
+        "  -n name       font name, default small\n"
+        "  -s scale      integer scale, default 1\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    options_t opt;
+    std::string input;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (a == "-o" && hasValue) {
+            opt.output = argv[++i];
+        } else if (a == "-n" && hasValue) {
+            opt.name = argv[++i];
+        } else if (a == "-s" && hasValue) {
+            opt.scale = atoi(argv[++i]);
+        } else if (a[0] == '-' || !input.empty()) {
+            usage();
+            return 1;
+        } else {
+            input = a;
+        }
+    }
+    if (opt.scale < 1) {
+        usage();
+        return 1;
+    }
+
+    source_t src;
+    if (input.empty()) {
+        load_builtin(&src);
+    } else if (!load_bdf(input.c_str(), &src)) {
+        return 1;
+    }
+    return write_font(src, opt)? 0 : 1;
+}
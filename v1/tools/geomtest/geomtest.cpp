@@ -0,0 +1,335 @@
+/**********************************************************************/
+/**
+ * @brief  Cylinder Geometry Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Instantiate the screens and the drawer on some geometries (cv_geometry.hpp)
+ * and check them against a naive mapping with the geometry at runtime (the
+ * previous per dot division and modulo). Checks the SSD1306 setup values,
+ * and measures the dot plot time of the template against the runtime one.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller geomtest.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o geomtest
+ *
+ * Run :
+ *   ./geomtest [rounds]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "cv_geometry.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+
+// The drawer of the other geometries. (the template definitions)
+#include "../../firmware/controller/cyclic_mono_drawer.cpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+typedef CvGeometry<128, 64, 20, 8, 8> Geometry128x64;
+typedef CvGeometry<96, 32, 10, 12, 4> Geometry96x32;
+typedef CvGeometry<64, 16, 0, 4, 4> Geometry64x16;
+typedef CvGeometry<128, 24, 5, 6, 2> Geometry128x24;
+
+static uint32_t rnd_ = 2463534242u;
+
+static int errors_ = 0;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Class definitions
+ *----------------------------------------------------------------------
+ */
+
+// The cylinder with the geometry at runtime, as the previous screens.
+class NaiveCylinder
+{
+public:
+    NaiveCylinder(int height, int width, int margin, int displays) :
+        height_(height), width_(width), margin_(margin), displays_(displays),
+        buffer_(((height * width) / 8) * displays, 0) {}
+
+    int vWidth(void) const { return (width_ + margin_) * displays_; }
+    uint8_t * buffer(void) { return buffer_.data(); }
+    void clear(void) { std::fill(buffer_.begin(), buffer_.end(), 0); }
+
+    // Cylinder x to (panel, column), false on margin.
+    bool map(int x, int * panel, int * column) const {
+        x = -x;
+        x -= (margin_ + 1);
+        x %= vWidth();
+        if (x < 0) x += vWidth();
+        *column = x % (width_ + margin_);
+        *panel = (x / (width_ + margin_)) % displays_;
+        return *column < width_;
+    }
+
+    void setDot(int x, int y, bool c) {
+        int panel, column;
+        if (y < 0 || height_ <= y || !map(x, &panel, &column)) return;
+        uint8_t * p = &buffer_[(panel * ((height_ * width_) / 8)) + ((column / 8) * height_) + y];
+        if (c) *p |= (uint8_t)(0x01 << (column % 8));
+        else   *p &= (uint8_t)~(0x01 << (column % 8));
+    }
+
+public:
+    int height_;
+    int width_;
+    int margin_;
+    int displays_;
+    std::vector<uint8_t> buffer_;
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+static int
+rndRange(int lo, int hi)
+{
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+static void
+expect(const char * name, const char * what, bool ok)
+{
+    if (!ok) {
+        printf("  NG : %s %s\n", name, what);
+        errors_++;
+    }
+}
+
+template <typename G>
+static bool
+same(CyclicMonoScreenT<G> * screen, NaiveCylinder * naive)
+{
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        if (memcmp(screen->getMonoScreen(i)->getBuffer(), naive->buffer() + (i * G::ONE_FRAME_BYTES), G::ONE_FRAME_BYTES) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename G>
+static void
+checkGeometry(const char * name, int rounds)
+{
+    std::vector<uint8_t> frame(G::FRAME_BYTES);
+    CyclicMonoScreenT<G> screen;
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frame.data() + (i * G::ONE_FRAME_BYTES));
+    }
+    CyclicMonoDrawerT<G> drawer;
+    drawer.init(&screen);
+    NaiveCylinder naive(G::HEIGHT, G::WIDTH, G::MARGIN, G::DISPLAYS);
+    int vw = G::V_WIDTH;
+
+    // Tables against the runtime mapping.
+    int visible = 0;
+    bool columns = true;
+    for (int x = 0; x < vw; x++) {
+        int panel, column;
+        bool v = naive.map(x, &panel, &column);
+        int expected = (v)? (panel * G::WIDTH) + column : -1;
+        if (G::COLUMNS.v_[x] != expected) columns = false;
+        if (G::screenX(x) != G::screenX(x + vw) || G::wrap(x - vw) != x || G::wrap(x + vw) != x) columns = false;
+        visible += (v)? 1 : 0;
+    }
+    int spanned = 0;
+    bool spans = (G::SPANS.count_ <= G::VISIBLE_SPANS_MAX);
+    for (int i = 0; i < G::SPANS.count_; i++) {
+        const cv_visible_span_t * span = &G::SPANS.s_[i];
+        for (int x = span->x1_; x <= span->x2_; x++) {
+            int v = G::COLUMNS.v_[x];
+            if (v != (span->panel_ * G::WIDTH) + span->column_ - (x - span->x1_)) spans = false;
+        }
+        spanned += span->x2_ - span->x1_ + 1;
+    }
+    expect(name, "columns", columns && visible == G::DISPLAYS * G::WIDTH);
+    expect(name, "spans", spans && spanned == visible);
+
+    // Random dots, both colors, also far out of the cylinder.
+    bool dots = true;
+    for (int r = 0; r < rounds && dots; r++) {
+        int x = rndRange(-3 * vw, 3 * vw);
+        int y = rndRange(-4, G::HEIGHT + 3);
+        bool c = (rnd() & 3) != 0;
+        screen.setDot(x, y, c);
+        naive.setDot(x, y, c);
+        int panel, column;
+        bool v = (0 <= y && y < G::HEIGHT && naive.map(x, &panel, &column));
+        if (screen.getDot(x, y) != (v && c)) dots = false;
+    }
+    expect(name, "screen setDot / getDot", dots && same(&screen, &naive));
+
+    // Drawer primitives, one shape a round.
+    screen.clear();
+    naive.clear();
+    bool drawn = true;
+    for (int r = 0; r < rounds / 16 && drawn; r++) {
+        int x1 = rndRange(-2 * vw, 2 * vw);
+        int x2 = x1 + rndRange(-vw - 8, vw + 8);
+        int y1 = rndRange(-8, G::HEIGHT + 8);
+        int y2 = rndRange(-8, G::HEIGHT + 8);
+        color_t c = (rnd() & 3)? DISP_COLOR_WHITE : DISP_COLOR_BLACK;
+        switch (r % 4) {
+        case 0:
+            drawer.drawDot(x1, y1, c);
+            naive.setDot(x1, y1, c == DISP_COLOR_WHITE);
+            break;
+        case 1:
+        {
+            int16_t xs[32], ys[32];
+            int offset = rndRange(-vw, vw);
+            for (int i = 0; i < 32; i++) {
+                xs[i] = (int16_t)rndRange(-vw, 2 * vw);
+                ys[i] = (int16_t)rndRange(-2, G::HEIGHT + 1);
+                naive.setDot(xs[i] + offset, ys[i], c == DISP_COLOR_WHITE);
+            }
+            drawer.drawDots(xs, ys, 32, offset, c);
+        } break;
+        case 2:
+            drawer.drawHLine(x1, x2, y1, c);
+            if ((unsigned)y1 < (unsigned)G::HEIGHT) {
+                int lo = std::min(x1, x2), hi = std::min(std::max(x1, x2), lo + vw - 1);
+                for (int x = lo; x <= hi; x++) naive.setDot(x, y1, c == DISP_COLOR_WHITE);
+            }
+            break;
+        case 3:
+        {
+            int lo = std::min(x1, x2), hi = std::min(std::max(x1, x2), lo + vw - 1);
+            drawer.drawRectFill(lo, y1, hi, y2, c);
+            for (int x = lo; x <= hi; x++) {
+                for (int y = std::min(y1, y2); y <= std::max(y1, y2); y++) naive.setDot(x, y, c == DISP_COLOR_WHITE);
+            }
+        } break;
+        }
+        drawn = same(&screen, &naive);
+    }
+    expect(name, "drawer dot / dots / hline / rect", drawn);
+
+    // Panel planes, across the seam of the cylinder.
+    screen.clear();
+    naive.clear();
+    std::vector<uint8_t> planeBuffer(((G::WIDTH + 7) / 8) * 24 * 2);
+    for (auto & b : planeBuffer) b = (uint8_t)rnd();
+    mono_plane_t plane = { G::WIDTH + 5, 24, planeBuffer.data() };
+    int px = vw - 9, py = G::HEIGHT - 20;
+    drawer.drawPlane(px, py, &plane);
+    for (int c = 0; c < plane.width_; c++) {
+        for (int y = 0; y < plane.height_; y++) {
+            if ((plane.buffer_[((c / 8) * plane.height_) + y] >> (c % 8)) & 0x01) {
+                naive.setDot(px + plane.width_ - 1 - c, py + y, true);
+            }
+        }
+    }
+    expect(name, "drawer plane", same(&screen, &naive));
+
+    printf("%-10s %3d x %2d, margin %2d, %2d panels, %d / bridge : %2d spans, SSD1306 mux %2d, com 0x%02X, columns %3d ~ %3d, %s\n",
+        name, G::HEIGHT, G::WIDTH, G::MARGIN, G::DISPLAYS, G::CHANNELS, G::SPANS.count_,
+        G::SSD1306_MULTIPLEX + 1, G::SSD1306_COMPINS, G::SSD1306_COLUMN_OFFSET, G::SSD1306_COLUMN_OFFSET + G::HEIGHT - 1,
+        (errors_ == 0)? "OK" : "NG");
+}
+
+static void
+checkSsd1306(void)
+{
+    // The values of the panels in use and the SSD1306 datasheet.
+    expect("SSD1306", "128 x 32", CvDefaultGeometry::SSD1306_MULTIPLEX == 31 && CvDefaultGeometry::SSD1306_COMPINS == 0x02 && CvDefaultGeometry::SSD1306_COLUMN_OFFSET == 0);
+    expect("SSD1306", "128 x 64", Geometry128x64::SSD1306_MULTIPLEX == 63 && Geometry128x64::SSD1306_COMPINS == 0x12 && Geometry128x64::SSD1306_COLUMN_OFFSET == 0);
+    expect("SSD1306", "64 x 16", Geometry64x16::SSD1306_MULTIPLEX == 15 && Geometry64x16::SSD1306_COLUMN_OFFSET == 32);
+    expect("SSD1306", "frame bytes", CvDefaultGeometry::ONE_FRAME_BYTES == 512 && CvDefaultGeometry::BRIDGE_BYTES == 4096 && CvDefaultGeometry::BRIDGES == 2);
+}
+
+// Returns ns per dot.
+template <typename F>
+static double
+measure(int count, F func)
+{
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    func(count);
+    return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / count;
+}
+
+static void
+benchmark(int rounds)
+{
+    typedef CvDefaultGeometry G;
+    std::vector<uint8_t> frame(G::FRAME_BYTES);
+    CyclicMonoScreen screen;
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frame.data() + (i * G::ONE_FRAME_BYTES));
+    }
+    CyclicMonoDrawer drawer;
+    drawer.init(&screen);
+    NaiveCylinder naive(G::HEIGHT, G::WIDTH, G::MARGIN, G::DISPLAYS);
+
+    int count = rounds * 64;
+    std::vector<int16_t> xs(count), ys(count);
+    for (int i = 0; i < count; i++) {
+        xs[i] = (int16_t)rndRange(0, G::V_WIDTH - 1);
+        ys[i] = (int16_t)rndRange(0, G::HEIGHT - 1);
+    }
+
+    // volatile sink, keep the buffers alive.
+    volatile uint8_t sink = 0;
+    double runtime = measure(count, [&](int n) { for (int i = 0; i < n; i++) naive.setDot(xs[i], ys[i], true); });
+    sink = sink + naive.buffer()[0];
+    double screenDot = measure(count, [&](int n) { for (int i = 0; i < n; i++) screen.setDot(xs[i], ys[i], true); });
+    sink = sink + frame[0];
+    double drawerDot = measure(count, [&](int n) { for (int i = 0; i < n; i++) drawer.drawDot(xs[i], ys[i]); });
+    sink = sink + frame[0];
+    double bulkDot = measure(count, [&](int n) { drawer.drawDots(xs.data(), ys.data(), n); });
+    sink = sink + frame[0];
+
+    printf("setDot ns / dot : runtime geometry %.2f, screen %.2f, drawDot %.2f, drawDots %.2f\n",
+        runtime, screenDot, drawerDot, bulkDot);
+}
+
+int
+main(int argc, char ** argv)
+{
+    int rounds = (argc > 1)? atoi(argv[1]) : 20000;
+    if (rounds < 64) rounds = 20000;
+
+    checkGeometry<CvDefaultGeometry>("default", rounds);
+    checkGeometry<Geometry128x64>("128x64", rounds);
+    checkGeometry<Geometry96x32>("96x32", rounds);
+    checkGeometry<Geometry64x16>("64x16", rounds);
+    checkGeometry<Geometry128x24>("128x24", rounds);
+    checkSsd1306();
+    benchmark(rounds);
+
+    printf("check : %s\n", (errors_ == 0)? "OK" : "NG");
+    return (errors_ == 0)? 0 : 1;
+}
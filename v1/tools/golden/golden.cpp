@@ -0,0 +1,762 @@
+/**********************************************************************/
+/**
+ * @brief  Golden Image Regression (Host Tool)
+ * @author naoa
+ *
+ * Render every App render mode (app.cpp) and every CyclicMonoDrawer
+ * primitive for a fixed number of frames, with a fixed seed (App::setSeed),
+ * scripted angles and frame times, and compare the 16 panel buffers with
+ * the checked-in goldens :
+ *   golden.txt        : FNV-1a of the panel buffers, every frame of every case
+ *   images/<case>.pbm : the last frame of every case, the visible pixels in
+ *                   the cylinder x order (CV_DISPLAYS * CV_WIDTH x CV_HEIGHT)
+ *
+ * The grayscale mode is a case of GOLDEN_GRAY_PLANES bit planes, hashed
+ * on all of them, the image is the plane 0.
+ *
+ * On a mismatch, <case>_diff.png is written with the golden, the rendered
+ * frame and the difference (red : golden only, green : rendered only).
+ * Sprites are drawn into the buffers (no sprite list, as with no bridge
+ * sprite cache). The motor is stubbed, the angle is scripted.
+ *
+ * A frame of a mode with a scroll layer (App::scrollLayer) is also compared
+ * with the layer as the bridges show it by the start line.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../cvsim/arduino -I../../firmware/controller golden.cpp \
+ *       ../../firmware/controller/app.cpp \
+ *       ../../firmware/controller/life.cpp \
+ *       ../../firmware/controller/timeline.cpp \
+ *       ../../firmware/controller/intro_scene.cpp \
+ *       ../../firmware/controller/image_data.cpp \
+ *       ../../firmware/controller/mono_video.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/text_render.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/scroll_layer.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o golden
+ *
+ * Run (in this directory) :
+ *   ./golden [-v]      compare
+ *   ./golden -u        regenerate the goldens, after checking the diffs
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cstdarg>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "screen_config.hpp"
+#include "encoder.hpp"
+#include "image_data.hpp"
+#include "motor.hpp"
+#include "app.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define GOLDEN_SEED             (0x5EED0001UL)
+#define GOLDEN_MODE_FRAMES      (64)
+#define GOLDEN_DRAW_FRAMES      (16)
+#define GOLDEN_GRAY_PLANES      (3)
+#define GOLDEN_FRAME_US         (1000000UL / 70)
+#define GOLDEN_START_US         (0xFFFFFFFFUL - 500000UL)  // Wraps in the mode cases
+
+#define GOLDEN_IMAGE_W          (CV_DISPLAYS * CV_WIDTH)
+#define GOLDEN_IMAGE_H          (CV_HEIGHT)
+#define GOLDEN_DIFF_GAP         (4)
+
+typedef struct options_ {
+    std::string golden = ".";   // golden.txt and images/
+    std::string out = ".";      // Diff images
+    bool update = false;
+    bool verbose = false;
+} options_t;
+
+typedef struct golden_case_ {
+    std::string name_;
+    int mode_;                  // App render mode, -1 : drawer primitive
+    void (*draw_)(CyclicMonoDrawer * drawer);
+    int frames_;
+    int planes_;                // Grayscale bit planes, 1 : monochrome
+    const char * ticker_ = nullptr;     // Ticker text of the case, then back
+} golden_case_t;
+
+typedef struct golden_result_ {
+    std::vector<uint32_t> hashes_;
+    std::vector<uint8_t> image_;    // Last frame, a byte a pixel
+    int layerFrames_ = 0;           // Frames with a scroll layer
+    int layerErrors_ = 0;           // Of them, the layer is not the frame
+} golden_result_t;
+
+static options_t opt_;
+static uint32_t nowUs_ = 0;
+static uint32_t rnd_ = 1;
+
+static App app_;
+static uint8_t frameBuffer_[CV_FRAME_BYTES * CV_GRAY_PLANES_MAX];
+
+HardwareSerial Serial;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Arduino and motor stand-ins
+ *----------------------------------------------------------------------
+ */
+
+uint64_t
+cvsim_now_ns(void)
+{
+    return (uint64_t)nowUs_ * 1000ULL;
+}
+
+void
+cvsim_reset_request(void)
+{
+}
+
+void
+digitalWrite(int pin, int value)
+{
+}
+
+int
+HardwareSerial::printf(const char * format, ...)
+{
+    if (!opt_.verbose) return 0;
+    va_list ap;
+    va_start(ap, format);
+    int n = vprintf(format, ap);
+    va_end(ap);
+    return n;
+}
+
+void motor_init(int pin_in_1, int pin_in_2) {}
+void motor_set_power(int power) {}
+void motor_set_brake(bool brake) {}
+void motor_set_decay_mode(bool slow) {}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Drawer primitives
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+// Over the cylinder x wrap and the top / bottom edges.
+static int rx(void) { return (int)(rnd() % (CV_V_WIDTH * 2)) - (CV_V_WIDTH / 2); }
+static int ry(void) { return (int)(rnd() % (CV_HEIGHT + 32)) - 16; }
+static color_t rc(void) { return ((rnd() & 7) == 0)? DISP_COLOR_BLACK : DISP_COLOR_WHITE; }
+
+// Random points, in this order. (the argument order is unspecified)
+typedef struct rpoints_ {
+    int x_[3];
+    int y_[3];
+    color_t c_;
+} rpoints_t;
+
+static rpoints_t
+rpoints(int spread = 0)
+{
+    rpoints_t p;
+    for (int i = 0; i < 3; i++) {
+        p.x_[i] = rx();
+        p.y_[i] = ry();
+        if (spread > 0 && i > 0) p.x_[i] = p.x_[0] + (int)(rnd() % (spread * 2)) - spread;
+    }
+    p.c_ = rc();
+    return p;
+}
+
+static MonoImage
+rimage(void)
+{
+    const mono_images_t * sets[] = { &image_anim_test_frames, &image_title_cylinview_frames, &image_run1_frames };
+    const mono_images_t * set = sets[rnd() % 3];
+    return MonoImage(&set->images_[rnd() % set->count_]);
+}
+
+static void
+draw_dot(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 256; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawDot(p.x_[0], p.y_[0], p.c_);
+    }
+}
+
+static void
+draw_dots(CyclicMonoDrawer * drawer)
+{
+    int16_t x[64], y[64];
+    for (int i = 0; i < 64; i++) {
+        x[i] = (int16_t)(rnd() % CV_V_WIDTH);
+        y[i] = (int16_t)ry();
+    }
+    drawer->drawDots(x, y, 64, rx(), DISP_COLOR_WHITE);
+}
+
+static void
+draw_hline(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 16; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawHLine(p.x_[0], p.x_[1], p.y_[0], p.c_);
+    }
+}
+
+static void
+draw_vline(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 16; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawVLine(p.x_[0], p.y_[0], p.y_[1], p.c_);
+    }
+}
+
+static void
+draw_line(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 16; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawLine(p.x_[0], p.y_[0], p.x_[1], p.y_[1], p.c_);
+    }
+}
+
+static void
+draw_rect(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawRectNoFill(p.x_[0], p.y_[0], p.x_[1], p.y_[1], p.c_);
+    }
+}
+
+static void
+draw_rect_fill(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawRectFill(p.x_[0], p.y_[0], p.x_[1], p.y_[1], p.c_);
+    }
+}
+
+static void
+draw_triangle(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        rpoints_t p = rpoints(100);
+        drawer->drawTriangle(p.x_[0], p.y_[0], p.x_[1], p.y_[1], p.x_[2], p.y_[2], p.c_);
+    }
+}
+
+static void
+draw_triangle_fill(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        rpoints_t p = rpoints(100);
+        drawer->drawTriangleFill(p.x_[0], p.y_[0], p.x_[1], p.y_[1], p.x_[2], p.y_[2], p.c_);
+    }
+}
+
+static void
+draw_circle(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawCircle(p.x_[0], p.y_[0], (int)(rnd() % 60), p.c_);
+    }
+}
+
+static void
+draw_circle_fill(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawCircleFill(p.x_[0], p.y_[0], (int)(rnd() % 60), p.c_);
+    }
+}
+
+static void
+draw_image(CyclicMonoDrawer * drawer)
+{
+    drawer->clearFrame(((rnd() & 1) == 0)? DISP_COLOR_BLACK : DISP_COLOR_WHITE);
+    for (int i = 0; i < 8; i++) {
+        MonoImage image = rimage();
+        rpoints_t p = rpoints();
+        uint32_t r = rnd();
+        drawer->drawImage(p.x_[0], p.y_[0], &image, (r & 1) != 0, (r & 2) != 0, (r & 4) != 0);
+    }
+}
+
+static void
+draw_sprite(CyclicMonoDrawer * drawer)
+{
+    for (int i = 0; i < 8; i++) {
+        MonoImage image = rimage();
+        rpoints_t p = rpoints();
+        uint32_t r = rnd();
+        drawer->drawSprite(p.x_[0], p.y_[0], &image, (r & 1) != 0, (r & 2) != 0);
+    }
+}
+
+static void
+draw_plane(CyclicMonoDrawer * drawer)
+{
+    static uint8_t buffer[((80 + 7) / 8) * 48];
+    for (size_t i = 0; i < sizeof(buffer); i++) buffer[i] = (uint8_t)rnd();
+    const mono_plane_t plane = { 80, 48, buffer };
+    for (int i = 0; i < 4; i++) {
+        rpoints_t p = rpoints();
+        drawer->drawPlane(p.x_[0], p.y_[0], &plane, (rnd() & 1) != 0);
+    }
+}
+
+static void
+draw_gray(CyclicMonoDrawer * drawer)
+{
+    // A gradient over rings, both dithers, faded.
+    static uint8_t buffer[120 * 96];
+    for (int y = 0; y < 96; y++) {
+        for (int x = 0; x < 120; x++) {
+            int dx = x - 60, dy = y - 48;
+            buffer[(y * 120) + x] = (uint8_t)((x * 2) ^ (((dx * dx) + (dy * dy)) >> 4));
+        }
+    }
+    const gray_image_t image = { 120, 96, 120, buffer };
+    for (int i = 0; i < 4; i++) {
+        rpoints_t p = rpoints();
+        uint32_t r = rnd();
+        drawer->drawGray(p.x_[0], p.y_[0], &image, (mono_dither_t)(r & 1), (int)((r >> 1) % 257), (r & 0x400) != 0);
+    }
+}
+
+static void
+draw_text(CyclicMonoDrawer * drawer)
+{
+    // Both fonts and layouts, over the seam and centered.
+    static const Font small(&font_small);
+    static const Font ticker(&font_ticker);
+    static const char * texts[] = { "CylinView", "Hello, world!", "0123456789 {|}~", "jump -> run" };
+    for (int i = 0; i < 4; i++) {
+        rpoints_t p = rpoints();
+        uint32_t r = rnd();
+        const Font * font = (r & 1)? &ticker : &small;
+        drawer->drawText(p.x_[0], p.y_[0], font, texts[(r >> 1) & 3], (text_layout_t)((r >> 3) & 1), (r & 0x400) != 0);
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Images
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+fnv1a(uint32_t h, const uint8_t * p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 16777619UL;
+    }
+    return h;
+}
+
+// The visible pixels in the cylinder x order, the margins skipped.
+static std::vector<uint8_t>
+frame_image(CyclicMonoDrawer * drawer)
+{
+    std::vector<uint8_t> image(GOLDEN_IMAGE_W * GOLDEN_IMAGE_H, 0);
+    const auto & spans = CvScreenGeometry::SPANS;
+    for (int y = 0; y < GOLDEN_IMAGE_H; y++) {
+        int u = 0;
+        for (int s = 0; s < spans.count_; s++) {
+            for (int x = spans.s_[s].x1_; x <= spans.s_[s].x2_; x++) {
+                image[y * GOLDEN_IMAGE_W + u++] = (drawer->getDot(x, y) != 0)? 1 : 0;
+            }
+        }
+    }
+    return image;
+}
+
+// PBM (P4), a lit pixel is white.
+static bool
+write_pbm(const std::string & path, const std::vector<uint8_t> & image)
+{
+    FILE * fp = fopen(path.c_str(), "wb");
+    if (fp == NULL) return false;
+    fprintf(fp, "P4\n%d %d\n", GOLDEN_IMAGE_W, GOLDEN_IMAGE_H);
+    for (int y = 0; y < GOLDEN_IMAGE_H; y++) {
+        for (int x = 0; x < GOLDEN_IMAGE_W; x += 8) {
+            uint8_t b = 0;
+            for (int i = 0; i < 8; i++) {
+                if (image[y * GOLDEN_IMAGE_W + x + i] == 0) b |= (uint8_t)(0x80 >> i);
+            }
+            fputc(b, fp);
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+static bool
+read_pbm(const std::string & path, std::vector<uint8_t> * image)
+{
+    FILE * fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) return false;
+    int w = 0, h = 0;
+    bool ok = (fscanf(fp, "P4 %d %d", &w, &h) == 2) && (fgetc(fp) != EOF);
+    ok = ok && (w == GOLDEN_IMAGE_W) && (h == GOLDEN_IMAGE_H);
+    image->assign(GOLDEN_IMAGE_W * GOLDEN_IMAGE_H, 0);
+    for (int y = 0; ok && y < GOLDEN_IMAGE_H; y++) {
+        for (int x = 0; ok && x < GOLDEN_IMAGE_W; x += 8) {
+            int b = fgetc(fp);
+            if (b == EOF) { ok = false; break; }
+            for (int i = 0; i < 8; i++) {
+                (*image)[y * GOLDEN_IMAGE_W + x + i] = ((b & (0x80 >> i)) == 0)? 1 : 0;
+            }
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+static uint32_t
+crc32(uint32_t crc, const uint8_t * p, size_t n)
+{
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1)? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void
+put_be32(std::vector<uint8_t> * v, uint32_t x)
+{
+    v->push_back((uint8_t)(x >> 24));
+    v->push_back((uint8_t)(x >> 16));
+    v->push_back((uint8_t)(x >> 8));
+    v->push_back((uint8_t)x);
+}
+
+static void
+put_chunk(FILE * fp, const char * type, const std::vector<uint8_t> & data)
+{
+    std::vector<uint8_t> c;
+    put_be32(&c, (uint32_t)data.size());
+    c.insert(c.end(), type, type + 4);
+    c.insert(c.end(), data.begin(), data.end());
+    put_be32(&c, crc32(0, &c[4], c.size() - 4));
+    fwrite(c.data(), 1, c.size(), fp);
+}
+
+// RGB PNG, no compression (zlib stored blocks), so no dependencies.
+static bool
+write_png(const std::string & path, int w, int h, const std::vector<uint8_t> & rgb)
+{
+    FILE * fp = fopen(path.c_str(), "wb");
+    if (fp == NULL) return false;
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, sizeof(signature), fp);
+
+    std::vector<uint8_t> ihdr;
+    put_be32(&ihdr, (uint32_t)w);
+    put_be32(&ihdr, (uint32_t)h);
+    ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });    // 8 bit RGB
+    put_chunk(fp, "IHDR", ihdr);
+
+    std::vector<uint8_t> raw;
+    for (int y = 0; y < h; y++) {
+        raw.push_back(0);   // Filter none
+        raw.insert(raw.end(), rgb.begin() + (size_t)y * w * 3, rgb.begin() + (size_t)(y + 1) * w * 3);
+    }
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    uint32_t a = 1, b = 0;
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t n = raw.size() - pos;
+        if (n > 65535) n = 65535;
+        z.push_back((pos + n == raw.size())? 1 : 0);
+        z.insert(z.end(), { (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)~n, (uint8_t)(~n >> 8) });
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+        for (size_t i = pos; i < pos + n; i++) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        pos += n;
+    }
+    put_be32(&z, (b << 16) | a);
+    put_chunk(fp, "IDAT", z);
+    put_chunk(fp, "IEND", {});
+    fclose(fp);
+    return true;
+}
+
+// The golden, the rendered frame and the difference, top to bottom.
+static bool
+write_diff(const std::string & path, const std::vector<uint8_t> & golden, const std::vector<uint8_t> & image)
+{
+    const int w = GOLDEN_IMAGE_W;
+    const int h = (GOLDEN_IMAGE_H * 3) + (GOLDEN_DIFF_GAP * 2);
+    std::vector<uint8_t> rgb((size_t)w * h * 3, 0x40);
+    auto put = [&](int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+        uint8_t * p = &rgb[((size_t)y * w + x) * 3];
+        p[0] = r; p[1] = g; p[2] = b;
+    };
+    for (int y = 0; y < GOLDEN_IMAGE_H; y++) {
+        for (int x = 0; x < w; x++) {
+            bool g = golden[y * w + x] != 0;
+            bool i = image[y * w + x] != 0;
+            uint8_t gv = (g)? 0xFF : 0x00;
+            uint8_t iv = (i)? 0xFF : 0x00;
+            put(x, y, gv, gv, gv);
+            put(x, y + GOLDEN_IMAGE_H + GOLDEN_DIFF_GAP, iv, iv, iv);
+            int dy = y + (GOLDEN_IMAGE_H + GOLDEN_DIFF_GAP) * 2;
+            if (g && i)       put(x, dy, 0x60, 0x60, 0x60);
+            else if (g)       put(x, dy, 0xFF, 0x00, 0x00);
+            else if (i)       put(x, dy, 0x00, 0xFF, 0x00);
+            else              put(x, dy, 0x00, 0x00, 0x00);
+        }
+    }
+    return write_png(path, w, h, rgb);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Cases
+ *----------------------------------------------------------------------
+ */
+
+static std::vector<golden_case_t>
+make_cases(void)
+{
+    std::vector<golden_case_t> cases;
+    for (int m = 0; m <= 8; m++) {
+        cases.push_back({ "mode" + std::to_string(m), m, nullptr, GOLDEN_MODE_FRAMES, 1 });
+    }
+    struct { const char * name_; void (*draw_)(CyclicMonoDrawer *); } prims[] = {
+        { "dot",            draw_dot },
+        { "dots",           draw_dots },
+        { "hline",          draw_hline },
+        { "vline",          draw_vline },
+        { "line",           draw_line },
+        { "rect",           draw_rect },
+        { "rect_fill",      draw_rect_fill },
+        { "triangle",       draw_triangle },
+        { "triangle_fill",  draw_triangle_fill },
+        { "circle",         draw_circle },
+        { "circle_fill",    draw_circle_fill },
+        { "image",          draw_image },
+        { "sprite",         draw_sprite },
+        { "plane",          draw_plane },
+    };
+    for (auto & p : prims) {
+        cases.push_back({ std::string("draw_") + p.name_, -1, p.draw_, GOLDEN_DRAW_FRAMES, 1 });
+    }
+    cases.push_back({ "mode9_gray", 9, nullptr, GOLDEN_MODE_FRAMES, GOLDEN_GRAY_PLANES });
+    cases.push_back({ "draw_gray", -1, draw_gray, GOLDEN_DRAW_FRAMES, 1 });
+    cases.push_back({ "draw_text", -1, draw_text, GOLDEN_DRAW_FRAMES, 1 });
+    cases.push_back({ "mode10", 10, nullptr, GOLDEN_MODE_FRAMES, 1 });
+    cases.push_back({ "mode10_layer", 10, nullptr, GOLDEN_MODE_FRAMES, 1, "CylinView scroll layer" });
+    return cases;
+}
+
+// Spinning, not on a whole pixel per frame, with a wobble.
+static uint16_t
+script_angle(int frame)
+{
+    uint32_t a = (uint32_t)frame * ((ENCODER_COUNTS / 50) + 7) + ((uint32_t)(frame * frame) % 13) * 31;
+    return (uint16_t)(a & (ENCODER_COUNTS - 1));
+}
+
+// The panels of the scroll layer as shown, against the rendered frame.
+static void
+check_layer(golden_result_t * r)
+{
+    scroll_layer_t layer;
+    if (!app_.scrollLayer(&layer)) return;
+    static uint8_t panel[CV_ONE_FRAME_BYTES];
+    bool same = true;
+    for (int p = 0; p < CV_DISPLAYS; p++) {
+        scroll_layer_panel(&layer, p, panel);
+        same = same && (memcmp(panel, frameBuffer_ + (p * CV_ONE_FRAME_BYTES), CV_ONE_FRAME_BYTES) == 0);
+    }
+    r->layerFrames_++;
+    if (!same) r->layerErrors_++;
+}
+
+// Cases run in this order in one App, the render modes keep their state.
+static golden_result_t
+run_case(const golden_case_t & c, int index)
+{
+    golden_result_t r;
+    memset(frameBuffer_, 0, sizeof(frameBuffer_));
+    app_.setSeed(GOLDEN_SEED + (uint32_t)index);
+    rnd_ = GOLDEN_SEED + (uint32_t)index;
+    if (c.mode_ >= 0) app_.setMode(c.mode_);
+    app_.setGrayPlanes(c.planes_);
+    std::string ticker = app_.tickerText_;
+    if (c.ticker_ != nullptr) app_.setTickerText(c.ticker_);
+
+    for (int f = 0; f < c.frames_; f++) {
+        if (c.mode_ >= 0) {
+            app_.loop(nowUs_, script_angle(f));
+            app_.render(frameBuffer_, nullptr);
+            check_layer(&r);
+        } else {
+            app_.setupRender(frameBuffer_, nullptr);
+            app_.drawer_.clearFrame();
+            c.draw_(&app_.drawer_);
+        }
+        r.hashes_.push_back(fnv1a(2166136261UL, frameBuffer_, CV_FRAME_BYTES * c.planes_));
+        nowUs_ += GOLDEN_FRAME_US + (uint32_t)(f % 5) * 997;
+    }
+    app_.setupRender(frameBuffer_, nullptr);
+    r.image_ = frame_image(&app_.drawer_);
+    if (c.ticker_ != nullptr) app_.setTickerText(ticker.c_str());
+    return r;
+}
+
+static bool
+read_golden(const std::string & path, std::map<std::string, std::vector<uint32_t>> * golden)
+{
+    FILE * fp = fopen(path.c_str(), "r");
+    if (fp == NULL) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char name[64];
+        int frame;
+        unsigned hash;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%63s %d %x", name, &frame, &hash) != 3) continue;
+        std::vector<uint32_t> & v = (*golden)[name];
+        if ((int)v.size() == frame) v.push_back(hash);
+    }
+    fclose(fp);
+    return true;
+}
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: golden [options]\n"
+        "  -g dir        golden.txt and images/, default .\n"
+        "  -o dir        diff images, default .\n"
+        "  -u            regenerate the goldens\n"
+        "  -v            hashes and App logs\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if      (a == "-g" && hasValue) opt_.golden = argv[++i];
+        else if (a == "-o" && hasValue) opt_.out = argv[++i];
+        else if (a == "-u") opt_.update = true;
+        else if (a == "-v") opt_.verbose = true;
+        else { usage(); return 1; }
+    }
+
+    const std::string goldenPath = opt_.golden + "/golden.txt";
+    std::map<std::string, std::vector<uint32_t>> golden;
+    if (!opt_.update && !read_golden(goldenPath, &golden)) {
+        printf("%s : not found, make it with -u\n", goldenPath.c_str());
+        printf("check : NG\n");
+        return 1;
+    }
+
+    nowUs_ = GOLDEN_START_US;
+    app_.init();
+
+    std::vector<golden_case_t> cases = make_cases();
+    std::vector<golden_result_t> results;
+    bool ok = true;
+    for (size_t k = 0; k < cases.size(); k++) {
+        const golden_case_t & c = cases[k];
+        golden_result_t r = run_case(c, (int)k);
+        results.push_back(r);
+        if (opt_.update) continue;
+
+        // First frame off the golden hashes, and the last frame image.
+        const std::vector<uint32_t> & g = golden[c.name_];
+        int first = -1;
+        for (int f = 0; f < c.frames_; f++) {
+            if (f >= (int)g.size() || g[f] != r.hashes_[f]) { first = f; break; }
+        }
+        std::vector<uint8_t> image;
+        const std::string imagePath = opt_.golden + "/images/" + c.name_ + ".pbm";
+        bool hasImage = read_pbm(imagePath, &image);
+        bool same = (first < 0) && hasImage && (image == r.image_) && (r.layerErrors_ == 0);
+
+        printf("%-20s %3d frames  last %08x  %s", c.name_.c_str(), c.frames_, (unsigned)r.hashes_.back(), (same)? "OK" : "NG");
+        if (first >= 0) printf(", frame %d differs", first);
+        if (!hasImage) printf(", no %s", imagePath.c_str());
+        if (r.layerFrames_ > 0) printf(", layer %d/%d", r.layerFrames_ - r.layerErrors_, r.layerFrames_);
+        if (!same && hasImage) {
+            const std::string diffPath = opt_.out + "/" + c.name_ + "_diff.png";
+            if (write_diff(diffPath, image, r.image_)) printf(", %s", diffPath.c_str());
+        }
+        printf("\n");
+        if (opt_.verbose) {
+            for (int f = 0; f < c.frames_; f++) {
+                printf("  %3d  %08x  %08x\n", f, (unsigned)r.hashes_[f], (f < (int)g.size())? (unsigned)g[f] : 0u);
+            }
+        }
+        ok = ok && same;
+    }
+
+    if (opt_.update) {
+        FILE * fp = fopen(goldenPath.c_str(), "w");
+        if (fp == NULL) {
+            printf("%s : can not write\n", goldenPath.c_str());
+            return 1;
+        }
+        fprintf(fp, "# Golden frames, <case> <frame> <FNV-1a of the %d panel buffers> (v1/tools/golden)\n", CV_DISPLAYS);
+        for (size_t k = 0; k < cases.size(); k++) {
+            for (size_t f = 0; f < results[k].hashes_.size(); f++) {
+                fprintf(fp, "%s %zu %08x\n", cases[k].name_.c_str(), f, (unsigned)results[k].hashes_[f]);
+            }
+            const std::string imagePath = opt_.golden + "/images/" + cases[k].name_ + ".pbm";
+            if (!write_pbm(imagePath, results[k].image_)) {
+                printf("%s : can not write\n", imagePath.c_str());
+                fclose(fp);
+                return 1;
+            }
+        }
+        fclose(fp);
+        printf("%zu cases written to %s\n", cases.size(), opt_.golden.c_str());
+        return 0;
+    }
+
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    return (ok)? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/**********************************************************************/
+/**
+ * @brief  Life Kernel Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Check LifeGrid (both packings, some rules, render to the panel buffers)
+ * against a naive per cell implementation, then measure the generations
+ * per second of the bit parallel step.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller lifebench.cpp \
+ *       ../../firmware/controller/life.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp -o lifebench
+ *
+ * Run :
+ *   ./lifebench [generations]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "life.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+static const char * rules_[] = {
+    "B3/S23",           // Conway
+    "B36/S23",          // HighLife
+    "B2/S",             // Seeds
+    "B3678/S34678",     // Day & Night
+    "B1357/S1357",      // Replicator
+    "B0/S8",            // Birth on 0 (dead border)
+};
+
+static uint8_t frameBuffer_[CV_FRAME_BYTES];
+
+// Per cell reference.
+class NaiveLife
+{
+public:
+    std::vector<uint8_t> cells_ = std::vector<uint8_t>(LIFE_WIDTH * LIFE_HEIGHT);
+    uint16_t birth_ = 0;
+    uint16_t survive_ = 0;
+
+    int get(int x, int y) const {
+        if (y < 0 || y >= LIFE_HEIGHT) return 0;
+        x = ((x % LIFE_WIDTH) + LIFE_WIDTH) % LIFE_WIDTH;
+        return cells_[(y * LIFE_WIDTH) + x];
+    }
+    void step(void) {
+        std::vector<uint8_t> next(cells_.size());
+        for (int y = 0; y < LIFE_HEIGHT; y++) {
+            for (int x = 0; x < LIFE_WIDTH; x++) {
+                int n = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if (dx != 0 || dy != 0) n += get(x + dx, y + dy);
+                    }
+                }
+                int alive = get(x, y);
+                next[(y * LIFE_WIDTH) + x] = (alive)? ((survive_ >> n) & 1) : ((birth_ >> n) & 1);
+            }
+        }
+        cells_.swap(next);
+    }
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static int
+compareCells(const LifeGrid & grid, const NaiveLife & ref)
+{
+    int diff = 0;
+    for (int y = 0; y < LIFE_HEIGHT; y++) {
+        for (int x = 0; x < LIFE_WIDTH; x++) {
+            if ((int)grid.getCell(x, y) != ref.get(x, y)) diff++;
+        }
+    }
+    return diff;
+}
+
+static int
+compareRender(CyclicMonoScreen * screen, const LifeGrid & grid, const NaiveLife & ref, int xpos)
+{
+    memset(frameBuffer_, 0xA5, sizeof(frameBuffer_));
+    grid.render(screen, xpos);
+    int diff = 0;
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        MonoScreen * mono = screen->getMonoScreen(i);
+        for (int c = 0; c < CV_WIDTH; c++) {
+            for (int y = 0; y < CV_HEIGHT; y++) {
+                int expect = ref.get((i * CV_DISTANCE) + c - xpos, y);
+                if ((int)mono->getDot(c, y) != expect) diff++;
+            }
+        }
+    }
+    return diff;
+}
+
+static bool
+check(CyclicMonoScreen * screen)
+{
+    static LifeGrid grid;
+    NaiveLife ref;
+    bool ok = true;
+    for (int pack = 0; pack < 2; pack++) {
+        for (const char * rule : rules_) {
+            grid.init((life_pack_t)pack);
+            grid.setRule(rule);
+            grid.randomize(0x12345678UL + pack);
+            ref.birth_ = 0;
+            ref.survive_ = 0;
+            for (const char * p = rule, * t = nullptr; *p; p++) {
+                if (*p == 'B' || *p == 'S') t = p;
+                else if (*p >= '0' && *p <= '8') ((*t == 'B')? ref.birth_ : ref.survive_) |= (1 << (*p - '0'));
+            }
+            for (int y = 0; y < LIFE_HEIGHT; y++) {
+                for (int x = 0; x < LIFE_WIDTH; x++) ref.cells_[(y * LIFE_WIDTH) + x] = grid.getCell(x, y);
+            }
+            int cellDiff = 0, renderDiff = 0;
+            for (int g = 0; g < 16; g++) {
+                grid.step();
+                ref.step();
+                cellDiff += compareCells(grid, ref);
+                renderDiff += compareRender(screen, grid, ref, (g * 97) % CV_V_WIDTH);
+            }
+            printf("%-8s %-14s cells diff %d, render diff %d, population %d\n",
+                (pack == LIFE_PACK_ROWS)? "rows" : "columns", rule, cellDiff, renderDiff, grid.population());
+            if (cellDiff != 0 || renderDiff != 0) ok = false;
+        }
+    }
+    return ok;
+}
+
+int
+main(int argc, char ** argv)
+{
+    int generations = (argc > 1)? atoi(argv[1]) : 2000;
+    if (generations <= 0) generations = 2000;
+
+    CyclicMonoScreen screen;
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frameBuffer_ + (i * CV_ONE_FRAME_BYTES));
+    }
+
+    bool ok = check(&screen);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+
+    using clock = std::chrono::steady_clock;
+    static LifeGrid grid;
+    for (int pack = 0; pack < 2; pack++) {
+        for (int conway = 1; conway >= 0; conway--) {
+            grid.init((life_pack_t)pack);
+            // B3/S23 takes the fast path, HighLife takes the generic one.
+            grid.setRule((conway)? "B3/S23" : "B36/S23");
+            grid.randomize(1);
+            auto t0 = clock::now();
+            for (int g = 0; g < generations; g++) grid.step();
+            double stepUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / generations;
+            t0 = clock::now();
+            for (int g = 0; g < generations; g++) grid.render(&screen, g);
+            double renderUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / generations;
+            printf("%-8s %-8s step %8.1f us (%6.0f gen/s, %5.2f ns/cell), render %6.1f us\n",
+                (pack == LIFE_PACK_ROWS)? "rows" : "columns", (conway)? "B3/S23" : "B36/S23",
+                stepUs, 1e6 / stepUs, (stepUs * 1000.0) / (LIFE_WIDTH * LIFE_HEIGHT), renderUs);
+        }
+    }
+    return (ok)? 0 : 1;
+}
@@ -0,0 +1,416 @@
+/**********************************************************************/
+/**
+ * @brief  Monochrome Video Encoder (Host Tool)
+ * @author naoa
+ *
+ * Encode a frame sequence to mono_video_t (keyframe + XOR delta, RLE),
+ * for the controller firmware. See mono_video.hpp for the data format.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller \
+ *       mvenc.cpp ../../firmware/controller/mono_video.cpp -o mvenc
+ *
+ * Frames are binary/gray/color PNM (PBM, PGM, PPM). e.g. from a video :
+ *   ffmpeg -i badapple.mp4 -vf "fps=30,scale=-2:128" -pix_fmt gray frames/%05d.pgm
+ *   ./mvenc -n badapple -r 30 -o ../../firmware/controller/video_badapple.h frames/?????.pgm
+ *
+ * Decode benchmark (frames/s) and round trip check on the host :
+ *   ./mvenc -n badapple -r 30 -b 10 frames/?????.pgm
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "mono_video.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+typedef struct options_ {
+    std::string name = "video";
+    std::string output;
+    int fps = 30;
+    int keyint = 300;
+    int threshold = 128;
+    bool invert = false;
+    int bench = 0;
+    std::vector<std::string> inputs;
+} options_t;
+
+typedef struct pnm_image_ {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;   // 0 - 255
+} pnm_image_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - PNM
+ *----------------------------------------------------------------------
+ */
+
+static int
+pnm_token(FILE * fp)
+{
+    int c = fgetc(fp);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fgetc(fp);
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            c = fgetc(fp);
+        } else {
+            break;
+        }
+    }
+    int v = 0;
+    bool found = false;
+    while (c >= '0' && c <= '9') {
+        v = (v * 10) + (c - '0');
+        found = true;
+        c = fgetc(fp);
+    }
+    return (found)? v : -1;
+}
+
+static int
+pnm_bit(FILE * fp)
+{
+    int c = fgetc(fp);
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n') c = fgetc(fp);
+    return (c == '1')? 1 : 0;
+}
+
+static bool
+load_pnm(const char * path, pnm_image_t * image)
+{
+    FILE * fp = fopen(path, "rb");
+    if (fp == nullptr) {
+        fprintf(stderr, "mvenc: cannot open %s\n", path);
+        return false;
+    }
+
+    char magic[2];
+    if (fread(magic, 1, 2, fp) != 2 || magic[0] != 'P' || magic[1] < '1' || magic[1] > '6') {
+        fprintf(stderr, "mvenc: %s is not a PNM file\n", path);
+        fclose(fp);
+        return false;
+    }
+    int type = magic[1] - '0';
+    int w = pnm_token(fp);
+    int h = pnm_token(fp);
+    int maxval = (type == 1 || type == 4)? 1 : pnm_token(fp);
+    if (w <= 0 || h <= 0 || maxval <= 0 || maxval > 255) {
+        fprintf(stderr, "mvenc: %s unsupported PNM header\n", path);
+        fclose(fp);
+        return false;
+    }
+
+    image->width = w;
+    image->height = h;
+    image->pixels.assign(w * h, 0);
+
+    for (int y = 0; y < h; y++) {
+        std::vector<uint8_t> row;
+        if (type == 4) {
+            row.resize((w + 7) / 8);
+            if (fread(row.data(), 1, row.size(), fp) != row.size()) break;
+        }
+        for (int x = 0; x < w; x++) {
+            int v = 0;
+            switch (type) {
+            case 1: v = pnm_bit(fp) ? 0 : 255; break;           // PBM 1 is black
+            case 2: v = pnm_token(fp) * 255 / maxval; break;
+            case 3: {
+                int r = pnm_token(fp), g = pnm_token(fp), b = pnm_token(fp);
+                v = ((r * 77) + (g * 150) + (b * 29)) / 256 * 255 / maxval;
+            } break;
+            case 4: v = ((row[x >> 3] >> (7 - (x & 7))) & 1)? 0 : 255; break;
+            case 5: v = fgetc(fp) * 255 / maxval; break;
+            case 6: {
+                int r = fgetc(fp), g = fgetc(fp), b = fgetc(fp);
+                v = ((r * 77) + (g * 150) + (b * 29)) / 256 * 255 / maxval;
+            } break;
+            }
+            image->pixels[(y * w) + x] = (uint8_t)((v < 0)? 0 : v);
+        }
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Encoder
+ *----------------------------------------------------------------------
+ */
+
+// Convert to the panel native plane. (see mono_plane_t)
+static void
+to_plane(const pnm_image_t & image, int width, const options_t & opt, std::vector<uint8_t> * plane)
+{
+    int h = image.height;
+    plane->assign((width / 8) * h, 0);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < image.width; x++) {
+            bool on = image.pixels[(y * image.width) + x] >= opt.threshold;
+            if (opt.invert) on = !on;
+            if (!on) continue;
+            int c = width - 1 - x; // mirrored
+            (*plane)[((c >> 3) * h) + y] |= (uint8_t)(1 << (c & 7));
+        }
+    }
+}
+
+// Encode XOR difference to the token stream.
+static void
+encode_tokens(const std::vector<uint8_t> & diff, std::vector<uint8_t> * out)
+{
+    size_t n = diff.size();
+    size_t i = 0;
+
+    auto same_run = [&](size_t pos) {
+        size_t r = 1;
+        while (pos + r < n && diff[pos + r] == diff[pos] && r < MONO_VIDEO_FILL_MAX) r++;
+        return r;
+    };
+
+    while (i < n) {
+        if (diff[i] == 0) {
+            size_t z = 0;
+            while (i + z < n && diff[i + z] == 0) z++;
+            if (i + z >= n) break;  // Remaining bytes are unchanged
+            i += z;
+            while (z > 0) {
+                size_t k = (z > MONO_VIDEO_SKIP_MAX)? MONO_VIDEO_SKIP_MAX : z;
+                out->push_back((uint8_t)(MONO_VIDEO_TOKEN_SKIP | (k - 1)));
+                z -= k;
+            }
+            continue;
+        }
+
+        size_t r = same_run(i);
+        if (r >= 3) {
+            out->push_back((uint8_t)(MONO_VIDEO_TOKEN_FILL | (r - MONO_VIDEO_FILL_MIN)));
+            out->push_back(diff[i]);
+            i += r;
+            continue;
+        }
+
+        // Literal, until a zero pair or a fill run.
+        size_t l = 0;
+        while (i + l < n && l < MONO_VIDEO_LITERAL_MAX) {
+            if (l > 0 && diff[i + l] == 0 && (i + l + 1 >= n || diff[i + l + 1] == 0)) break;
+            if (l > 0 && same_run(i + l) >= 3) break;
+            l++;
+        }
+        out->push_back((uint8_t)(l - 1));
+        out->insert(out->end(), diff.begin() + i, diff.begin() + i + l);
+        i += l;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Output
+ *----------------------------------------------------------------------
+ */
+
+static bool
+write_header(const options_t & opt, int width, int height, int frames,
+             const std::vector<uint32_t> & index, const std::vector<uint8_t> & data)
+{
+    FILE * fp = fopen(opt.output.c_str(), "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "mvenc: cannot create %s\n", opt.output.c_str());
+        return false;
+    }
+    const char * name = opt.name.c_str();
+
+    fprintf(fp, "// name : %s\n", name);
+    fprintf(fp, "// %d x %d, %d fps, %d frames, %zu bytes\n\n", width, height, opt.fps, frames, data.size());
+
+    fprintf(fp, "const uint32_t video_index_%s[] = {", name);
+    for (size_t i = 0; i < index.size(); i++) {
+        if ((i % 8) == 0) fprintf(fp, "\n    ");
+        fprintf(fp, "0x%08x, ", index[i]);
+    }
+    fprintf(fp, "\n};\n\n");
+
+    fprintf(fp, "const uint8_t video_data_%s[] = {", name);
+    for (size_t i = 0; i < data.size(); i++) {
+        if ((i % 16) == 0) fprintf(fp, "\n    ");
+        fprintf(fp, "0x%02x, ", data[i]);
+    }
+    fprintf(fp, "\n};\n\n");
+
+    fprintf(fp, "const mono_video_t video_%s = { %d, %d, %d, %d, video_index_%s, video_data_%s };\n",
+            name, width, height, opt.fps, frames, name, name);
+    fclose(fp);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Benchmark
+ *----------------------------------------------------------------------
+ */
+
+static bool
+bench(const mono_video_t * video, const std::vector<std::vector<uint8_t>> & planes, int loops)
+{
+    std::vector<uint8_t> buffer(MonoVideo::planeSize(video));
+    MonoVideo decoder;
+    decoder.init(video, buffer.data(), buffer.size());
+
+    // Round trip check
+    for (int i = 0; i < video->frame_count_; i++) {
+        decoder.seek(i);
+        if (memcmp(buffer.data(), planes[i].data(), buffer.size()) != 0) {
+            fprintf(stderr, "mvenc: round trip mismatch at frame %d\n", i);
+            return false;
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+    volatile uint8_t sink = 0;
+
+    // Sequential playback
+    auto t0 = clock::now();
+    for (int l = 0; l < loops; l++) {
+        for (int i = 0; i < video->frame_count_; i++) {
+            decoder.seek(i);
+            sink ^= buffer[i % buffer.size()];
+        }
+    }
+    double sec = std::chrono::duration<double>(clock::now() - t0).count();
+    double frames = (double)loops * video->frame_count_;
+    printf("decode sequential : %.0f frames/s (%.3f us/frame)\n", frames / sec, (sec * 1e6) / frames);
+
+    // Random seek (worst case decodes from the keyframe)
+    uint32_t seed = 1;
+    int seeks = loops * 64;
+    t0 = clock::now();
+    for (int l = 0; l < seeks; l++) {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        decoder.seek((int)(seed % video->frame_count_));
+        sink ^= buffer[0];
+    }
+    sec = std::chrono::duration<double>(clock::now() - t0).count();
+    printf("decode random seek : %.0f seeks/s (%.3f us/seek)\n", seeks / sec, (sec * 1e6) / seeks);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: mvenc [options] frame0.pgm frame1.pgm ...\n"
+        "  -n name       symbol name (video_<name>), default video\n"
+        "  -o file       output header (e.g. video_badapple.h)\n"
+        "  -r fps        frame rate, default 30\n"
+        "  -k frames     keyframe interval, default 300\n"
+        "  -t level      threshold 0-255, default 128\n"
+        "  -i            invert\n"
+        "  -b loops      decode benchmark and round trip check\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    options_t opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if      (a == "-n" && hasValue) opt.name = argv[++i];
+        else if (a == "-o" && hasValue) opt.output = argv[++i];
+        else if (a == "-r" && hasValue) opt.fps = atoi(argv[++i]);
+        else if (a == "-k" && hasValue) opt.keyint = atoi(argv[++i]);
+        else if (a == "-t" && hasValue) opt.threshold = atoi(argv[++i]);
+        else if (a == "-b" && hasValue) opt.bench = atoi(argv[++i]);
+        else if (a == "-i") opt.invert = true;
+        else if (a[0] == '-') { usage(); return 1; }
+        else opt.inputs.push_back(a);
+    }
+    if (opt.inputs.empty() || opt.fps <= 0 || opt.keyint <= 0) {
+        usage();
+        return 1;
+    }
+
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<uint8_t>> planes;
+    std::vector<uint32_t> index;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> prev;
+    int keyframes = 0;
+    int lastKey = 0;
+
+    for (size_t f = 0; f < opt.inputs.size(); f++) {
+        pnm_image_t image;
+        if (!load_pnm(opt.inputs[f].c_str(), &image)) return 1;
+        if (f == 0) {
+            width = (image.width + 7) & ~7;
+            height = image.height;
+        } else if (((image.width + 7) & ~7) != width || image.height != height) {
+            fprintf(stderr, "mvenc: %s frame size mismatch\n", opt.inputs[f].c_str());
+            return 1;
+        }
+
+        std::vector<uint8_t> plane;
+        to_plane(image, width, opt, &plane);
+
+        std::vector<uint8_t> key;
+        encode_tokens(plane, &key);
+
+        bool isKey = (f == 0) || (((int)f - lastKey) >= opt.keyint);
+        std::vector<uint8_t> tokens;
+        if (!isKey) {
+            std::vector<uint8_t> diff(plane.size());
+            for (size_t i = 0; i < plane.size(); i++) diff[i] = plane[i] ^ prev[i];
+            encode_tokens(diff, &tokens);
+            // Scene change, the keyframe is smaller.
+            if (key.size() <= tokens.size()) isKey = true;
+        }
+        if (isKey) {
+            tokens.swap(key);
+            lastKey = (int)f;
+            keyframes++;
+        }
+
+        index.push_back((uint32_t)data.size() | ((isKey)? MONO_VIDEO_INDEX_KEYFRAME : 0));
+        data.insert(data.end(), tokens.begin(), tokens.end());
+        prev = plane;
+        planes.push_back(plane);
+    }
+    index.push_back((uint32_t)data.size());
+
+    int frames = (int)planes.size();
+    size_t raw = (size_t)frames * (width / 8) * height;
+    size_t total = data.size() + (index.size() * 4);
+    printf("%s : %d x %d, %d frames (%d keyframes), %.1f s\n", opt.name.c_str(), width, height, frames, keyframes, (double)frames / opt.fps);
+    printf("raw %zu bytes -> %zu bytes (data %zu + index %zu), %.2f %%, %.0f bytes/s\n",
+           raw, total, data.size(), index.size() * 4, (total * 100.0) / raw, (double)total * opt.fps / frames);
+
+    if (!opt.output.empty()) {
+        if (!write_header(opt, width, height, frames, index, data)) return 1;
+    }
+
+    if (opt.bench > 0) {
+        mono_video_t video = { width, height, opt.fps, frames, index.data(), data.data() };
+        if (!bench(&video, planes, opt.bench)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**********************************************************************/
+/**
+ * @brief  Particle Engine Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Compare the update + plot time of the old Snow (array of Grain objects,
+ * rand callback and modulo per grain, drawDot per grain) and Particles
+ * (structure of arrays, inline xorshift, bulk plot), for some counts.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller pbench.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o pbench
+ *
+ * Run :
+ *   ./pbench [frames]
+ *
+ * The host is much faster than the RP2040, see the ratio between the two
+ * and the time per particle. The PBENCH command of the controller times
+ * Particles on the RP2040, against the frame interval.
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "pseudo_rand.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+#include "particles.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+static PseudoRand rnd_;
+static uint8_t frameBuffer_[CV_FRAME_BYTES];
+
+// Previous Snow, as the baseline.
+class LegacySnow
+{
+public:
+    typedef uint32_t (*RandCallback)(void);
+
+    class Grain
+    {
+    public:
+        int x_ = 0;
+        int y_ = CV_HEIGHT;
+    };
+
+public:
+    int fallSpeed_ = 1;
+    int shakeRange_ = 3;
+    int shakeOffset_ = -1;
+    RandCallback rnd_;
+    Grain * grains_;
+    int count_;
+
+public:
+    void loop() {
+        for (int i = 0; i < count_; i++) {
+            Grain * grain = &grains_[i];
+            if (grain->y_ >= CV_HEIGHT) {
+                uint32_t rnd = rnd_();
+                uint16_t rnd1 = rnd >> 16;
+                uint16_t rnd2 = rnd >>  0;
+                grain->x_ = rnd1 % CV_V_WIDTH;
+                grain->y_ = -(rnd2 % CV_HEIGHT);
+            } else {
+                grain->x_ += ((rnd_() % shakeRange_) + shakeOffset_);
+                grain->y_ += fallSpeed_;
+            }
+        }
+    }
+};
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+getRand(void)
+{
+    return rnd_.rand();
+}
+
+// Returns ns per frame.
+template <typename F>
+static double
+measure(int frames, F func)
+{
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    for (int i = 0; i < frames; i++) {
+        func(i);
+    }
+    return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / frames;
+}
+
+int
+main(int argc, char ** argv)
+{
+    int frames = (argc > 1)? atoi(argv[1]) : 1000;
+    if (frames <= 0) frames = 1000;
+
+    CyclicMonoScreen screen;
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frameBuffer_ + (i * CV_ONE_FRAME_BYTES));
+    }
+    CyclicMonoDrawer drawer;
+    drawer.init(&screen);
+
+    printf("%8s %14s %14s %10s %10s\n", "count", "Snow ns/frame", "SoA ns/frame", "SoA ns/pt", "speedup");
+    static const int counts[] = { 100, 1000, 10000, 20000 };
+    for (int count : counts) {
+        std::vector<LegacySnow::Grain> grains(count);
+        LegacySnow snow;
+        snow.rnd_ = getRand;
+        snow.grains_ = grains.data();
+        snow.count_ = count;
+
+        std::vector<uint16_t> x(count);
+        std::vector<int16_t> y(count), vy(count);
+        Particles particles;
+        particles.setSeed(rnd_.rand());
+        particles.setBuffers(x.data(), y.data(), vy.data(), count);
+
+        // Warm up, all particles are on the screen.
+        for (int i = 0; i < CV_HEIGHT * 2; i++) {
+            snow.loop();
+            particles.loop();
+        }
+
+        double legacy = measure(frames, [&](int i) {
+            drawer.clearFrame();
+            snow.loop();
+            for (int j = 0; j < count; j++) {
+                drawer.drawDot(grains[j].x_ - (i % CV_V_WIDTH), grains[j].y_);
+            }
+        });
+        double soa = measure(frames, [&](int i) {
+            drawer.clearFrame();
+            particles.loop();
+            particles.draw(&drawer, i % CV_V_WIDTH);
+        });
+        printf("%8d %14.0f %14.0f %10.2f %9.1fx\n", count, legacy, soa, soa / count, legacy / soa);
+    }
+    return 0;
+}
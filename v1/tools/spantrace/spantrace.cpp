@@ -0,0 +1,425 @@
+/**********************************************************************/
+/**
+ * @brief  Span Trace Converter (Host Tool)
+ * @author naoa
+ *
+ * Convert a span dump (span_trace.hpp, the "SPANS DUMP" of the controller,
+ * or cvsim -T) to the Chrome trace JSON, to see the frames of both cores
+ * of the controller and the bridges on one timeline in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing.
+ *
+ * The bridge clocks are fitted to the controller one (an offset and a
+ * drift, least squares) by the SYNC marks, the same sequence on both ends.
+ * A begin is matched with the next end of its stage on the core, the
+ * stages begun in between and not ended are closed there. (an early
+ * return) The spans begun before the oldest event of a ring are dropped.
+ *
+ * Reports per process and stage the spans, the average and the longest.
+ * With -c, checks every bridge has 2 syncs or more, the sync residuals
+ * within the limit, and spans from every process.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller spantrace.cpp \
+ *       ../../firmware/controller/span_trace.cpp -o spantrace
+ *
+ * Run :
+ *   ./spantrace [-c] [-o trace.json] serial.log   the last dump in the log
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "span_trace.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define SOURCES_MAX             (1 + 4)     // The controller and the bridges
+#define RESIDUAL_US             (50.0)      // -r default
+
+typedef struct options_ {
+    std::string input;
+    std::string output;
+    bool check = false;
+    double residualUs = RESIDUAL_US;
+} options_t;
+
+// A ring of the dump, the times unwrapped.
+typedef struct ring_ {
+    bool dumped_ = false;
+    uint32_t events_ = 0;
+    uint32_t overwritten_ = 0;
+    std::vector<span_event_t> list_;
+    std::vector<int64_t> us_;
+} ring_t;
+
+typedef struct dump_ {
+    int sources_ = 0;
+    bool complete_ = false;         // @SPANS END
+    ring_t rings_[SOURCES_MAX][SPAN_CORES];
+} dump_t;
+
+// The bridge clock to the controller one, controller = offset + scale * bridge.
+typedef struct clock_fit_ {
+    int syncs_ = 0;
+    double offsetUs_ = 0;
+    double scale_ = 1.0;
+    double originUs_ = 0;           // The bridge time the fit is around
+    double residualUs_ = 0;         // The largest
+} clock_fit_t;
+
+typedef struct span_ {
+    int source_;
+    int core_;
+    uint8_t stage_;
+    bool instant_;
+    double us_;                     // On the controller clock
+    double durUs_;
+    uint16_t arg_;
+    uint16_t endArg_;
+} span_t;
+
+typedef struct stage_stats_ {
+    uint32_t spans_ = 0;
+    double sumUs_ = 0;
+    double maxUs_ = 0;
+} stage_stats_t;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Variable definitions
+ *----------------------------------------------------------------------
+ */
+
+static options_t opt_;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Dump
+ *----------------------------------------------------------------------
+ */
+
+// The last dump of the log, a dump starts at its "@SPANS <version>" line.
+static bool
+read_dump(const std::string & path, dump_t * dump)
+{
+    FILE * fp = fopen(path.c_str(), "r");
+    if (fp == nullptr) return false;
+    char line[256];
+    int ringSource = -1, ringCore = -1;
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        const char * p = strstr(line, "@SPANS ");
+        if (p != nullptr) {
+            p += strlen("@SPANS ");
+            int source, core;
+            unsigned events, overwritten;
+            int version, sources;
+            if (sscanf(p, "RING %d %d %u %u", &source, &core, &events, &overwritten) == 4) {
+                ringSource = ringCore = -1;
+                if (source < 0 || source >= SOURCES_MAX || core < 0 || core >= SPAN_CORES) continue;
+                ring_t * ring = &dump->rings_[source][core];
+                ring->dumped_ = true;
+                ring->events_ = events;
+                ring->overwritten_ = overwritten;
+                ringSource = source;
+                ringCore = core;
+            } else if (strncmp(p, "END", 3) == 0) {
+                dump->complete_ = true;
+                ringSource = ringCore = -1;
+            } else if (sscanf(p, "%d %d", &version, &sources) == 2) {
+                *dump = dump_t();
+                dump->sources_ = (version == SPAN_VERSION)? std::min(sources, SOURCES_MAX) : 0;
+                ringSource = ringCore = -1;
+            }
+            continue;
+        }
+        int source;
+        span_event_t event;
+        if (!SpanTrace::parse(line, &source, &event)) continue;
+        if (source != ringSource) continue;
+        dump->rings_[ringSource][ringCore].list_.push_back(event);
+    }
+    fclose(fp);
+
+    // The rings of a source share the clock, unwrapped from the same event.
+    for (int source = 0; source < SOURCES_MAX; source++) {
+        bool based = false;
+        uint32_t baseRaw = 0;
+        for (int core = 0; core < SPAN_CORES; core++) {
+            ring_t * ring = &dump->rings_[source][core];
+            if (ring->list_.empty()) continue;
+            if (!based) {
+                baseRaw = ring->list_[0].timeUs_;
+                based = true;
+            }
+            int64_t us = (int32_t)(ring->list_[0].timeUs_ - baseRaw);
+            uint32_t last = ring->list_[0].timeUs_;
+            for (const span_event_t & e : ring->list_) {
+                us += (int32_t)(e.timeUs_ - last);
+                last = e.timeUs_;
+                ring->us_.push_back(us);
+            }
+        }
+    }
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Clock fit
+ *----------------------------------------------------------------------
+ */
+
+// The SYNC marks of the controller for a bridge, and of the bridge, by the sequence.
+static void
+sync_marks(const dump_t & dump, int source, std::map<int, double> * marks)
+{
+    for (int core = 0; core < SPAN_CORES; core++) {
+        const ring_t & ring = dump.rings_[source][core];
+        for (size_t i = 0; i < ring.list_.size(); i++) {
+            const span_event_t & e = ring.list_[i];
+            if (e.stage_ != SPAN_SYNC) continue;
+            if (source == 0) {
+                (*marks)[e.arg_] = (double)ring.us_[i];
+            } else {
+                (*marks)[(source - 1) << 12 | (e.arg_ & SPAN_SYNC_SEQ_MASK)] = (double)ring.us_[i];
+            }
+        }
+    }
+}
+
+static clock_fit_t
+fit_clock(const dump_t & dump, int source)
+{
+    std::map<int, double> controller, bridge;
+    sync_marks(dump, 0, &controller);
+    sync_marks(dump, source, &bridge);
+    std::vector<double> xs, ys;
+    for (const auto & b : bridge) {
+        auto c = controller.find(b.first);
+        if (c == controller.end()) continue;
+        xs.push_back(b.second);
+        ys.push_back(c->second);
+    }
+
+    clock_fit_t fit;
+    fit.syncs_ = (int)xs.size();
+    if (xs.empty()) return fit;
+    double mx = 0, my = 0;
+    for (size_t i = 0; i < xs.size(); i++) {
+        mx += xs[i];
+        my += ys[i];
+    }
+    mx /= xs.size();
+    my /= xs.size();
+    double sxx = 0, sxy = 0;
+    for (size_t i = 0; i < xs.size(); i++) {
+        sxx += (xs[i] - mx) * (xs[i] - mx);
+        sxy += (xs[i] - mx) * (ys[i] - my);
+    }
+    fit.originUs_ = mx;
+    fit.offsetUs_ = my;
+    fit.scale_ = (sxx > 0)? sxy / sxx : 1.0;
+    for (size_t i = 0; i < xs.size(); i++) {
+        double r = fabs(ys[i] - (fit.offsetUs_ + fit.scale_ * (xs[i] - mx)));
+        fit.residualUs_ = std::max(fit.residualUs_, r);
+    }
+    return fit;
+}
+
+static inline double
+to_controller(const clock_fit_t & fit, double us)
+{
+    return fit.offsetUs_ + fit.scale_ * (us - fit.originUs_);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Spans
+ *----------------------------------------------------------------------
+ */
+
+static void
+collect_spans(const dump_t & dump, int source, const clock_fit_t & fit, std::vector<span_t> * spans)
+{
+    for (int core = 0; core < SPAN_CORES; core++) {
+        const ring_t & ring = dump.rings_[source][core];
+        std::vector<size_t> open;
+        for (size_t i = 0; i < ring.list_.size(); i++) {
+            const span_event_t & e = ring.list_[i];
+            double us = to_controller(fit, (double)ring.us_[i]);
+            if (e.flags_ & SPAN_FLAG_BEGIN) {
+                open.push_back(i);
+            } else if (e.flags_ & SPAN_FLAG_END) {
+                auto it = std::find_if(open.rbegin(), open.rend(),
+                    [&](size_t b) { return ring.list_[b].stage_ == e.stage_; });
+                if (it == open.rend()) continue;
+                // The stages begun after it and not ended, closed here.
+                size_t depth = open.size() - (it - open.rbegin());
+                while (open.size() >= depth) {
+                    size_t b = open.back();
+                    open.pop_back();
+                    double beginUs = to_controller(fit, (double)ring.us_[b]);
+                    bool matched = (open.size() + 1 == depth);
+                    spans->push_back({ source, core, ring.list_[b].stage_, false, beginUs, us - beginUs,
+                        ring.list_[b].arg_, (uint16_t)((matched)? e.arg_ : 0) });
+                }
+            } else {
+                spans->push_back({ source, core, e.stage_, true, us, 0, e.arg_, 0 });
+            }
+        }
+    }
+}
+
+static const char *
+source_name(int source, char * name, size_t size)
+{
+    if (source == 0) snprintf(name, size, "controller");
+    else snprintf(name, size, "bridge %d", source - 1);
+    return name;
+}
+
+static bool
+write_json(const std::string & path, const dump_t & dump, const std::vector<span_t> & spans)
+{
+    FILE * fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) return false;
+    double originUs = 0;
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (i == 0 || spans[i].us_ < originUs) originUs = spans[i].us_;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    char name[32];
+    for (int source = 0; source < dump.sources_; source++) {
+        fprintf(fp, "%s{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_name\",\"args\":{\"name\":\"%s\"}}",
+            (first)? "" : ",\n", source, source_name(source, name, sizeof(name)));
+        first = false;
+        fprintf(fp, ",\n{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_sort_index\",\"args\":{\"sort_index\":%d}}",
+            source, source);
+        for (int core = 0; core < SPAN_CORES; core++) {
+            fprintf(fp, ",\n{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"core %d\"}}",
+                source, core, core);
+        }
+    }
+    for (const span_t & s : spans) {
+        fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,",
+            (first)? "" : ",\n", SpanTrace::stageName(s.stage_), (s.source_ == 0)? "controller" : "bridge",
+            s.source_, s.core_, s.us_ - originUs);
+        first = false;
+        if (s.instant_) {
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"arg\":%u}}", s.arg_);
+        } else {
+            fprintf(fp, "\"ph\":\"X\",\"dur\":%.3f,\"args\":{\"arg\":%u,\"end\":%u}}", s.durUs_, s.arg_, s.endArg_);
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: spantrace [options] serial.log\n"
+        "  -o file       Chrome trace JSON output\n"
+        "  -c            check the syncs and the spans\n"
+        "  -r us         largest sync residual, default %.0f\n", RESIDUAL_US);
+}
+
+int
+main(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if      (a == "-o" && hasValue) opt_.output = argv[++i];
+        else if (a == "-r" && hasValue) opt_.residualUs = atof(argv[++i]);
+        else if (a == "-c") opt_.check = true;
+        else if (a[0] != '-' && opt_.input.empty()) opt_.input = a;
+        else { usage(); return 1; }
+    }
+    if (opt_.input.empty()) {
+        usage();
+        return 1;
+    }
+
+    dump_t dump;
+    if (!read_dump(opt_.input, &dump)) {
+        printf("%s : can not read\n", opt_.input.c_str());
+        return 1;
+    }
+    if (dump.sources_ == 0) {
+        printf("%s : no span dump\n", opt_.input.c_str());
+        printf("check : NG\n");
+        return 1;
+    }
+
+    bool ok = dump.complete_;
+    if (!dump.complete_) printf("dump      : no @SPANS END, truncated\n");
+    std::vector<span_t> spans;
+    char name[32];
+    for (int source = 0; source < dump.sources_; source++) {
+        clock_fit_t fit;
+        const ring_t * rings = dump.rings_[source];
+        printf("%-10s: %zu / %zu events (%u / %u overwritten)",
+            source_name(source, name, sizeof(name)), rings[0].list_.size(), rings[1].list_.size(),
+            rings[0].overwritten_, rings[1].overwritten_);
+        if (source > 0) {
+            fit = fit_clock(dump, source);
+            // The drift of the bridge clock, fast is +.
+            printf(", %d syncs, drift %+.1f ppm, largest residual %.1f us",
+                fit.syncs_, (1.0 / fit.scale_ - 1.0) * 1e6, fit.residualUs_);
+            if (fit.syncs_ < 2 || fit.residualUs_ > opt_.residualUs) ok = false;
+            if (fit.syncs_ == 0) printf(", not aligned");
+        }
+        printf("\n");
+        size_t before = spans.size();
+        collect_spans(dump, source, fit, &spans);
+        bool spanned = false;
+        for (size_t i = before; i < spans.size(); i++) spanned |= !spans[i].instant_;
+        if (!spanned) ok = false;
+    }
+
+    // Per process and stage
+    std::map<std::pair<int, int>, stage_stats_t> stats;
+    for (const span_t & s : spans) {
+        if (s.instant_) continue;
+        stage_stats_t & st = stats[{ s.source_, s.stage_ }];
+        st.spans_++;
+        st.sumUs_ += s.durUs_;
+        st.maxUs_ = std::max(st.maxUs_, s.durUs_);
+    }
+    printf("%-10s  %-22s %8s %10s %10s\n", "process", "stage", "spans", "avg us", "max us");
+    for (const auto & it : stats) {
+        const stage_stats_t & st = it.second;
+        printf("%-10s  %-22s %8u %10.1f %10.1f\n", source_name(it.first.first, name, sizeof(name)),
+            SpanTrace::stageName(it.first.second), st.spans_, st.sumUs_ / st.spans_, st.maxUs_);
+    }
+
+    if (!opt_.output.empty()) {
+        if (!write_json(opt_.output, dump, spans)) {
+            printf("%s : can not write\n", opt_.output.c_str());
+            return 1;
+        }
+        printf("%s : %zu events\n", opt_.output.c_str(), spans.size());
+    }
+    if (opt_.check) printf("check : %s\n", (ok)? "OK" : "NG");
+    return (opt_.check && !ok)? 1 : 0;
+}
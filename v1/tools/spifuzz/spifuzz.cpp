@@ -0,0 +1,527 @@
+/**********************************************************************/
+/**
+ * @brief  Bridge SPI Receiver Fuzz Test and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Feed SpiReceiver (the SPI command parser of the bridge) with
+ *   - random command sequences (frames in one or more SET_DATA blocks,
+ *     payloads, status, padding), split in random chunks, checked command
+ *     by command and frame by frame
+ *   - the same with one corrupted command, then the rest must be received
+ *   - frames without a free slot (slow consumer), dropped with no write to
+ *     the slot in the I2C transfer standby
+ *   - random noise
+ * then measure the parse throughput per chunk size (the rx fifo level is
+ * 4 bytes, one interrupt per chunk).
+ *
+ * Build :
+ *   g++ -O2 -g -std=c++17 -fsanitize=address,undefined -I../../firmware/spi-i2c-bridge \
+ *       spifuzz.cpp ../../firmware/spi-i2c-bridge/spi_receiver.cpp \
+ *       ../../firmware/spi-i2c-bridge/circular_buffer.cpp -o spifuzz
+ *   (benchmark : the same with -O2 and no sanitizer)
+ *
+ *   libFuzzer :
+ *   clang++ -O1 -g -std=c++17 -fsanitize=fuzzer,address,undefined -DSPIFUZZ_LIBFUZZER \
+ *       -I../../firmware/spi-i2c-bridge spifuzz.cpp \
+ *       ../../firmware/spi-i2c-bridge/spi_receiver.cpp \
+ *       ../../firmware/spi-i2c-bridge/circular_buffer.cpp -o spifuzz_lf
+ *
+ * Run :
+ *   ./spifuzz [iterations] [seed]
+ *   ./spifuzz -b [MB]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "spi_receiver.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define FRAME_SIZE          (4096)      // Same to the bridge, 8 panels
+#define SLOTS               (2)
+#define PAYLOAD_MAX         (1024)
+#define PAD_MAX             (40)
+
+// A reported command, or an error.
+typedef struct event_ {
+    bool error_;
+    int code_;                          // cmd, or spirx_error_t
+    size_t size_;
+    bool operator==(const event_ & e) const { return error_ == e.error_ && code_ == e.code_ && size_ == e.size_; }
+} event_t;
+
+// A receiver on a 2 slot circular buffer, like the bridge.
+typedef struct harness_ {
+    CircularBuffer buffer_;
+    SpiReceiver receiver_;
+    uint8_t raw_[FRAME_SIZE * SLOTS];
+    uint8_t shadow_[SLOTS][FRAME_SIZE];         // Committed slots, must not change
+    uint8_t payload_[PAYLOAD_MAX];
+    std::vector<event_t> events_;
+    std::vector<std::vector<uint8_t>> consumed_;
+    bool fastConsumer_;
+    uint32_t frames_;
+    int fails_;
+} harness_t;
+
+static uint32_t seed_ = 1;
+static int fails_ = 0;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
+
+static int
+rnd(int n)
+{
+    return (int)(rnd() % (uint32_t)n);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Harness
+ *----------------------------------------------------------------------
+ */
+
+static void consume(harness_t * h);
+
+static uint8_t *
+payloadHook(void * context, uint8_t cmd, size_t size)
+{
+    harness_t * h = (harness_t *)context;
+    (void)cmd;
+    return (size <= PAYLOAD_MAX)? h->payload_ : nullptr;
+}
+
+static void
+commandHook(void * context, uint8_t cmd, size_t size)
+{
+    harness_t * h = (harness_t *)context;
+    h->events_.push_back({ false, cmd, size });
+    if (cmd == SPI_CMD_START_FRAME) h->receiver_.restartFrame();
+
+    // A slot committed, keep a copy to check it is not written until consumed.
+    if (h->receiver_.stats()->frames_ != h->frames_) {
+        h->frames_ = h->receiver_.stats()->frames_;
+        int slot = (h->buffer_.getWriteIndex() + SLOTS - 1) % SLOTS;
+        memcpy(h->shadow_[slot], &h->raw_[slot * FRAME_SIZE], FRAME_SIZE);
+        if (h->fastConsumer_) consume(h);
+    }
+}
+
+static void
+errorHook(void * context, spirx_error_t error)
+{
+    harness_t * h = (harness_t *)context;
+    h->events_.push_back({ true, error, 0 });
+}
+
+static void
+setup(harness_t * h, bool fastConsumer)
+{
+    memset(h->raw_, 0, sizeof(h->raw_));
+    h->buffer_.setBuffer(h->raw_, sizeof(h->raw_), SLOTS);
+    spirx_hooks_t hooks = { h, payloadHook, commandHook, errorHook };
+    h->receiver_.init(&h->buffer_, FRAME_SIZE, &hooks);
+    h->events_.clear();
+    h->consumed_.clear();
+    h->fastConsumer_ = fastConsumer;
+    h->frames_ = 0;
+    h->fails_ = 0;
+}
+
+// The I2C transfer of the read slot is done.
+static void
+consume(harness_t * h)
+{
+    if (!h->buffer_.getReadReady()) return;
+    int slot = h->buffer_.getReadIndex();
+    const uint8_t * p = h->buffer_.getReadBufferPtr();
+    if (memcmp(p, h->shadow_[slot], FRAME_SIZE) != 0) {
+        printf("slot %d written while waiting the transfer\n", slot);
+        h->fails_++;
+    }
+    h->consumed_.push_back(std::vector<uint8_t>(p, p + FRAME_SIZE));
+    h->buffer_.nextReadBuffer();
+}
+
+static void
+feed(harness_t * h, const std::vector<uint8_t> & stream, int maxChunk)
+{
+    size_t i = 0;
+    while (i < stream.size()) {
+        size_t n = 1 + rnd(maxChunk);
+        if (n > stream.size() - i) n = stream.size() - i;
+        h->receiver_.receive(&stream[i], n);
+        i += n;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Stream
+ *----------------------------------------------------------------------
+ */
+
+// Same to SpiI2cBridge::sendCommand() / sendPayload(), the body is not sent
+// for a size without a body. (OPTs as parameters)
+static void
+makeCommand(std::vector<uint8_t> * out, uint8_t cmd, uint16_t opt, const uint8_t * body, size_t size)
+{
+    uint8_t opt1 = (uint8_t)(opt >> 0);
+    uint8_t opt2 = (uint8_t)(opt >> 8);
+    uint8_t header[7] = { SPI_SYNC1, SPI_SYNC2, cmd, opt1, opt2, (uint8_t)~opt1, (uint8_t)~opt2 };
+    uint16_t crc = SpiReceiver::crc16(header, sizeof(header));
+    crc = SpiReceiver::crc16(body, size, crc);
+    out->insert(out->end(), header, header + sizeof(header));
+    out->insert(out->end(), body, body + size);
+    out->push_back((uint8_t)(crc >> 0));
+    out->push_back((uint8_t)(crc >> 8));
+}
+
+// Zero padding (flush), or noise without a sync.
+static void
+makePad(std::vector<uint8_t> * out)
+{
+    int n = rnd(PAD_MAX + 1);
+    bool noise = (rnd(4) == 0);
+    for (int i = 0; i < n; i++) {
+        uint8_t c = (noise)? (uint8_t)rnd() : 0x00;
+        if (c == SPI_SYNC1) c = 0x00;
+        out->push_back(c);
+    }
+}
+
+// One item : a frame (START_FRAME and 1 ~ 3 SET_DATA blocks), or one command.
+typedef struct item_ {
+    std::vector<uint8_t> stream_;
+    std::vector<event_t> events_;
+    std::vector<size_t> blocks_;        // Offsets of the SET_DATA commands in stream_
+    size_t pad_;                        // Offset of the padding in stream_
+    std::vector<uint8_t> frame_;        // Frame data, empty if not a frame
+} item_t;
+
+static void
+makeItem(item_t * item)
+{
+    static const uint8_t simple[] = {
+        SPI_CMD_NONE, SPI_CMD_GET_STATUS, SPI_CMD_PING, SPI_CMD_OB_LED_ON, SPI_CMD_OB_LED_OFF,
+        SPI_CMD_SET_ID_DIR0, SPI_CMD_SET_ID_DIR1, SPI_CMD_CLEAR_ASSETS, SPI_CMD_PRESENT, SPI_CMD_GET_PRESENT_STATS,
+        SPI_CMD_SET_GRAY, SPI_CMD_SPANS, SPI_CMD_GET_SPANS,
+    };
+    item->stream_.clear();
+    item->events_.clear();
+    item->blocks_.clear();
+    item->frame_.clear();
+
+    int kind = rnd(4);
+    if (kind == 0) {
+        item->frame_.resize(FRAME_SIZE);
+        for (auto & b : item->frame_) b = (uint8_t)rnd();
+        makeCommand(&item->stream_, SPI_CMD_START_FRAME, 0x5555, nullptr, 0);
+        item->events_.push_back({ false, SPI_CMD_START_FRAME, 0 });
+        int blocks = 1 + rnd(3);
+        size_t offset = 0;
+        for (int i = 0; i < blocks; i++) {
+            size_t size = (i == blocks - 1)? FRAME_SIZE - offset : 1 + rnd((int)(FRAME_SIZE - offset - (blocks - 1 - i)));
+            item->blocks_.push_back(item->stream_.size());
+            makeCommand(&item->stream_, SPI_CMD_SET_DATA, (uint16_t)size, &item->frame_[offset], size);
+            item->events_.push_back({ false, SPI_CMD_SET_DATA, size });
+            offset += size;
+        }
+    } else if (kind == 1) {
+        uint8_t cmd = (rnd(2))? SPI_CMD_UPLOAD_ASSET : SPI_CMD_DRAW_SPRITES;
+        std::vector<uint8_t> body(1 + rnd(PAYLOAD_MAX));
+        for (auto & b : body) b = (uint8_t)rnd();
+        makeCommand(&item->stream_, cmd, (uint16_t)body.size(), body.data(), body.size());
+        item->events_.push_back({ false, cmd, body.size() });
+    } else {
+        uint8_t cmd = simple[rnd(sizeof(simple))];
+        makeCommand(&item->stream_, cmd, 0x5555, nullptr, 0);
+        item->events_.push_back({ false, cmd, 0 });
+    }
+    item->pad_ = item->stream_.size();
+    makePad(&item->stream_);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Tests
+ *----------------------------------------------------------------------
+ */
+
+static bool
+check(const char * label, harness_t * h, const std::vector<event_t> & events, const std::vector<std::vector<uint8_t>> & frames)
+{
+    consume(h);
+    consume(h);
+    bool ok = (h->fails_ == 0);
+    if (h->events_ != events) {
+        size_t i = 0;
+        while (i < events.size() && i < h->events_.size() && h->events_[i] == events[i]) i++;
+        printf("%s : event %zu mismatch (%zu / %zu events)\n", label, i, h->events_.size(), events.size());
+        ok = false;
+    }
+    if (h->consumed_ != frames) {
+        printf("%s : %zu / %zu frames, or a frame mismatch\n", label, h->consumed_.size(), frames.size());
+        ok = false;
+    }
+    if (!h->receiver_.idle()) {
+        printf("%s : not idle at the end\n", label);
+        ok = false;
+    }
+    if (!ok) fails_++;
+    return ok;
+}
+
+// Valid commands across any chunk split.
+static void
+testSequence(harness_t * h)
+{
+    static const int chunks[] = { 1, 2, 4, 8, 64, 5000 };
+    std::vector<uint8_t> stream;
+    std::vector<event_t> events;
+    std::vector<std::vector<uint8_t>> frames;
+    int n = 1 + rnd(12);
+    for (int i = 0; i < n; i++) {
+        item_t item;
+        makeItem(&item);
+        stream.insert(stream.end(), item.stream_.begin(), item.stream_.end());
+        events.insert(events.end(), item.events_.begin(), item.events_.end());
+        if (!item.frame_.empty()) frames.push_back(item.frame_);
+    }
+    setup(h, true);
+    feed(h, stream, chunks[rnd(sizeof(chunks) / sizeof(chunks[0]))]);
+    check("sequence", h, events, frames);
+}
+
+// One byte of one command corrupted, the other commands are received. A
+// frame with a corrupted SET_DATA is not committed.
+static void
+testCorrupt(harness_t * h, int stats[SPIRX_ERRORS])
+{
+    std::vector<uint8_t> stream;
+    std::vector<event_t> events;
+    std::vector<std::vector<uint8_t>> frames;
+    int n = 2 + rnd(8);
+    int broken = rnd(n);
+    for (int i = 0; i < n; i++) {
+        item_t item;
+        makeItem(&item);
+        if (i == broken) {
+            // A byte of one of the commands, header, body or CRC.
+            size_t c = rnd((int)item.blocks_.size() + 1);
+            size_t start = (c == 0)? 0 : item.blocks_[c - 1];
+            size_t end = (c < item.blocks_.size())? item.blocks_[c] : item.pad_;
+            size_t pos = start + rnd((int)(end - start));
+            item.stream_[pos] ^= (uint8_t)(1 + rnd(255));
+
+            // The command is lost. A lost START_FRAME does not lose the
+            // frame (the slot is from its start), a lost SET_DATA does.
+            item.events_.erase(item.events_.begin() + c);
+            if (c > 0) item.frame_.clear();
+        }
+        stream.insert(stream.end(), item.stream_.begin(), item.stream_.end());
+        events.insert(events.end(), item.events_.begin(), item.events_.end());
+        if (!item.frame_.empty()) frames.push_back(item.frame_);
+        // Resync padding after the broken command, the next sync is found.
+        if (i == broken) stream.insert(stream.end(), 2, 0x00);
+    }
+    setup(h, true);
+    feed(h, stream, 1 + rnd(64));
+
+    // The errors are not in the expected list, only the order of the commands.
+    std::vector<event_t> received;
+    for (const auto & e : h->events_) {
+        if (e.error_) stats[e.code_]++;
+        else received.push_back(e);
+    }
+    h->events_ = received;
+    check("corrupt", h, events, frames);
+}
+
+// A slow consumer, the frames sent without a free slot are dropped.
+static void
+testOverflow(harness_t * h)
+{
+    setup(h, false);
+    std::vector<event_t> events;
+    std::vector<std::vector<uint8_t>> frames;
+    int n = 4 + rnd(16);
+    for (int i = 0; i < n; i++) {
+        if (rnd(3) == 0) consume(h);
+        item_t item;
+        makeItem(&item);
+        bool ready = h->buffer_.getWriteReady();
+        if (!item.frame_.empty() && !ready) {
+            events.push_back(item.events_[0]);
+            for (size_t b = 0; b < item.blocks_.size(); b++) events.push_back({ true, SPIRX_ERROR_OVERFLOW, 0 });
+        } else {
+            events.insert(events.end(), item.events_.begin(), item.events_.end());
+            if (!item.frame_.empty()) frames.push_back(item.frame_);
+        }
+        feed(h, item.stream_, 1 + rnd(16));
+    }
+    check("overflow", h, events, frames);
+}
+
+// Noise, then a resync and valid commands.
+static void
+testNoise(harness_t * h)
+{
+    std::vector<uint8_t> stream;
+    int n = rnd(4000);
+    for (int i = 0; i < n; i++) {
+        uint8_t c = (uint8_t)rnd();
+        if (rnd(16) == 0) c = SPI_SYNC1;
+        if (rnd(32) == 0) c = SPI_SYNC2;
+        stream.push_back(c);
+    }
+    setup(h, true);
+    feed(h, stream, 1 + rnd(64));
+
+    // A noise header may start a body (up to 64k), the flush is its size.
+    std::vector<uint8_t> flush(65536 + 16, 0x00);
+    h->receiver_.receive(flush.data(), flush.size());
+    h->events_.clear();
+    h->consumed_.clear();
+
+    std::vector<uint8_t> tail;
+    std::vector<event_t> events;
+    std::vector<std::vector<uint8_t>> frames;
+    makeCommand(&tail, SPI_CMD_START_FRAME, 0x5555, nullptr, 0);
+    for (int i = 0; i < 3; i++) {
+        item_t item;
+        makeItem(&item);
+        tail.insert(tail.end(), item.stream_.begin(), item.stream_.end());
+        events.insert(events.end(), item.events_.begin(), item.events_.end());
+        if (!item.frame_.empty()) frames.push_back(item.frame_);
+    }
+    events.insert(events.begin(), { false, SPI_CMD_START_FRAME, 0 });
+    feed(h, tail, 1 + rnd(64));
+    check("noise", h, events, frames);
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Benchmark
+ *----------------------------------------------------------------------
+ */
+
+// Frames as the controller sends them, parsed in chunks of the rx fifo level and more.
+static void
+benchmark(int megabytes)
+{
+    static harness_t h;
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> frame(FRAME_SIZE);
+    for (auto & b : frame) b = (uint8_t)rnd();
+    for (int i = 0; i < 4; i++) {
+        makeCommand(&stream, SPI_CMD_GET_STATUS, 0x5555, nullptr, 0);
+        stream.insert(stream.end(), 8, 0x00);   // Response polls
+        makeCommand(&stream, SPI_CMD_START_FRAME, 0x5555, nullptr, 0);
+        makeCommand(&stream, SPI_CMD_SET_DATA, FRAME_SIZE, frame.data(), FRAME_SIZE);
+        stream.insert(stream.end(), 32, 0x00);  // Padding
+    }
+
+    static const int chunks[] = { 1, 4, 8, 32, 256, 4096 };
+    printf("chunk     MB/s    ns/byte  ns/call  SPI clock at 100 %%\n");
+    for (int chunk : chunks) {
+        setup(&h, true);
+        size_t total = (size_t)megabytes * 1000000;
+        size_t done = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        while (done < total) {
+            for (size_t i = 0; i < stream.size(); i += chunk) {
+                size_t n = ((size_t)chunk < stream.size() - i)? chunk : stream.size() - i;
+                h.receiver_.receive(&stream[i], n);
+            }
+            done += stream.size();
+            h.consumed_.clear();
+            h.events_.clear();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(t1 - t0).count();
+        double bps = done / sec;
+        printf("%5d  %8.1f  %8.2f  %7.1f  %8.1f MHz\n",
+            chunk, bps / 1e6, 1e9 / bps, 1e9 * chunk / bps, bps * 8 / 1e6);
+        if (h.receiver_.stats()->frames_ == 0) {
+            printf("benchmark : no frames\n");
+            fails_++;
+        }
+    }
+}
+
+#if defined(SPIFUZZ_LIBFUZZER)
+
+// The first byte is the chunk size and the consumer, the rest is the stream.
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+    static harness_t h;
+    if (size < 1) return 0;
+    int chunk = 1 + (data[0] & 0x3F);
+    setup(&h, (data[0] & 0x40) != 0);
+    for (size_t i = 1; i < size; i += chunk) {
+        size_t n = ((size_t)chunk < size - i)? chunk : size - i;
+        h.receiver_.receive(&data[i], n);
+        if (data[0] & 0x80) consume(&h);
+        if (h.fails_ > 0) abort();
+    }
+    consume(&h);
+    consume(&h);
+    if (h.fails_ > 0) abort();
+    return 0;
+}
+
+#else
+
+int
+main(int argc, char ** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        benchmark((argc > 2)? atoi(argv[2]) : 200);
+        return (fails_ == 0)? 0 : 1;
+    }
+
+    int iterations = (argc > 1)? atoi(argv[1]) : 2000;
+    seed_ = (argc > 2)? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+    if (seed_ == 0) seed_ = 1;
+
+    static harness_t h;
+    int errors[SPIRX_ERRORS] = { 0 };
+    for (int it = 0; it < iterations; it++) {
+        testSequence(&h);
+        testCorrupt(&h, errors);
+        testOverflow(&h);
+        testNoise(&h);
+        if (fails_ > 10) break;
+    }
+
+    printf("%d iterations, corrupt errors : command %d, header %d, size %d, crc %d\n",
+        iterations, errors[SPIRX_ERROR_COMMAND], errors[SPIRX_ERROR_HEADER],
+        errors[SPIRX_ERROR_SIZE], errors[SPIRX_ERROR_CRC]);
+    printf("check : %s\n", (fails_ == 0)? "OK" : "NG");
+    return (fails_ == 0)? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,407 @@
+/**********************************************************************/
+/**
+ * @brief  USB Frame Stream Sender (Host Tool)
+ * @author naoa
+ *
+ * Render test frames on the host and stream them to the controller over
+ * the USB serial (see frame_stream.hpp), paced to a frame rate. The
+ * controller stats are read back every second, and the achieved frame
+ * rate, throughput and drop rate are reported.
+ *
+ *   panels   : 16 panel buffers (8 KiB), written to the circular buffer as is.
+ *   cylinder : the whole cylinder plane (18 KiB), rotated on the controller.
+ *   delta    : the cylinder plane as the mono_video token stream.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller streamtx.cpp \
+ *       ../../firmware/controller/frame_stream.cpp ../../firmware/controller/cmd_parser.cpp \
+ *       ../../firmware/controller/mono_video.cpp -o streamtx
+ *
+ * Run :
+ *   ./streamtx -d /dev/ttyACM0 -f delta -r 60 -s 30
+ *   ./streamtx -o stream.bin -f panels -n 100      (to a file, no pacing)
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "screen_config.hpp"
+#include "cmd_parser.hpp"
+#include "mono_video.hpp"
+#include "frame_stream.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Same to controller.ino
+#define BIN_CMD_STREAM      (0x20)
+#define BIN_RSP_FLAG        (0x80)
+
+typedef struct options_ {
+    std::string device;
+    std::string output;
+    stream_format_t format = STREAM_FORMAT_DELTA;
+    int fps = 60;
+    int frames = 0;             // 0 : by seconds
+    int seconds = 10;
+    int keyint = 60;
+} options_t;
+
+typedef struct device_stats_ {
+    bool valid = false;
+    uint32_t frames = 0;
+    uint32_t dropped = 0;
+    uint32_t errors = 0;
+    uint32_t bytes = 0;
+    uint16_t seq = 0;
+    uint16_t fps = 0;
+} device_stats_t;
+
+static int fd_ = -1;
+static CmdParser parser_;
+static device_stats_t stats_;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Test Frames
+ *----------------------------------------------------------------------
+ */
+
+static void
+set_plane_dot(std::vector<uint8_t> * plane, int x, int y)
+{
+    x %= STREAM_PLANE_WIDTH;
+    if (x < 0) x += STREAM_PLANE_WIDTH;
+    if (y < 0 || y >= STREAM_PLANE_HEIGHT) return;
+    (*plane)[((x >> 3) * STREAM_PLANE_HEIGHT) + y] |= (uint8_t)(1 << (x & 7));
+}
+
+// Cylinder : a sine wave moving around, and a ring of ticks fixed to the cylinder.
+static void
+make_cylinder(int frame, std::vector<uint8_t> * plane)
+{
+    plane->assign(STREAM_PLANE_SIZE, 0);
+    for (int x = 0; x < STREAM_PLANE_WIDTH; x++) {
+        double phase = (x * 6.283185307 * 4 / STREAM_PLANE_WIDTH) + (frame * 0.1);
+        int y = (STREAM_PLANE_HEIGHT / 2) + (int)(40 * std::sin(phase));
+        for (int t = -2; t <= 2; t++) set_plane_dot(plane, x, y + t);
+        if ((x % CV_DISTANCE) == 0) {
+            for (int y2 = 0; y2 < 8; y2++) set_plane_dot(plane, x, y2);
+        }
+    }
+}
+
+// Panels : a bar per panel, falling at a panel dependent speed.
+static void
+make_panels(int frame, std::vector<uint8_t> * panels)
+{
+    panels->assign(CV_FRAME_BYTES, 0);
+    for (int p = 0; p < CV_DISPLAYS; p++) {
+        uint8_t * buffer = panels->data() + (p * CV_ONE_FRAME_BYTES);
+        int y0 = (frame * (p + 1)) % CV_HEIGHT;
+        for (int y = y0; y < y0 + 8 && y < CV_HEIGHT; y++) {
+            for (int x = 0; x < CV_WIDTH; x++) {
+                buffer[((x >> 3) * CV_HEIGHT) + y] |= (uint8_t)(1 << (x & 7));
+            }
+        }
+    }
+}
+
+// Same to mvenc, the XOR difference to the token stream.
+static void
+encode_tokens(const std::vector<uint8_t> & diff, std::vector<uint8_t> * out)
+{
+    size_t n = diff.size();
+    size_t i = 0;
+
+    auto same_run = [&](size_t pos) {
+        size_t r = 1;
+        while (pos + r < n && diff[pos + r] == diff[pos] && r < MONO_VIDEO_FILL_MAX) r++;
+        return r;
+    };
+
+    while (i < n) {
+        if (diff[i] == 0) {
+            size_t z = 0;
+            while (i + z < n && diff[i + z] == 0) z++;
+            if (i + z >= n) break;  // Remaining bytes are unchanged
+            i += z;
+            while (z > 0) {
+                size_t k = (z > MONO_VIDEO_SKIP_MAX)? MONO_VIDEO_SKIP_MAX : z;
+                out->push_back((uint8_t)(MONO_VIDEO_TOKEN_SKIP | (k - 1)));
+                z -= k;
+            }
+            continue;
+        }
+
+        size_t r = same_run(i);
+        if (r >= 3) {
+            out->push_back((uint8_t)(MONO_VIDEO_TOKEN_FILL | (r - MONO_VIDEO_FILL_MIN)));
+            out->push_back(diff[i]);
+            i += r;
+            continue;
+        }
+
+        size_t l = 0;
+        while (i + l < n && l < MONO_VIDEO_LITERAL_MAX) {
+            if (l > 0 && diff[i + l] == 0 && (i + l + 1 >= n || diff[i + l + 1] == 0)) break;
+            if (l > 0 && same_run(i + l) >= 3) break;
+            l++;
+        }
+        out->push_back((uint8_t)(l - 1));
+        out->insert(out->end(), diff.begin() + i, diff.begin() + i + l);
+        i += l;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Serial
+ *----------------------------------------------------------------------
+ */
+
+static bool
+open_serial(const char * path)
+{
+    fd_ = open(path, O_RDWR | O_NOCTTY);
+    if (fd_ < 0) {
+        perror(path);
+        return false;
+    }
+    struct termios tio;
+    if (tcgetattr(fd_, &tio) == 0) {
+        // USB CDC, the baud rate is not used.
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd_, TCSANOW, &tio);
+    }
+    return true;
+}
+
+static bool
+write_all(const uint8_t * data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd_, data, size);
+        if (n < 0) {
+            perror("write");
+            return false;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static uint32_t
+get_u32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Read the stats replies, other output (text) is ignored.
+static void
+poll_stats(void)
+{
+    if (fd_ < 0 || !isatty(fd_)) return;
+    uint8_t buffer[256];
+    ssize_t n;
+    while ((n = read(fd_, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (parser_.push(buffer[i]) != CMDPARSER_BINARY) continue;
+            if (parser_.binaryCmd() != (BIN_CMD_STREAM | BIN_RSP_FLAG) || parser_.payloadSize() < 20) continue;
+            const uint8_t * p = parser_.payload();
+            stats_.valid = true;
+            stats_.frames  = get_u32(p + 0);
+            stats_.dropped = get_u32(p + 4);
+            stats_.errors  = get_u32(p + 8);
+            stats_.bytes   = get_u32(p + 12);
+            stats_.seq     = (uint16_t)(p[16] | (p[17] << 8));
+            stats_.fps     = (uint16_t)(p[18] | (p[19] << 8));
+            printf("  device : %u frames, %u dropped, %u errors, %u bytes, seq %u, %u fps\n",
+                stats_.frames, stats_.dropped, stats_.errors, stats_.bytes, stats_.seq, stats_.fps);
+        }
+    }
+}
+
+static double
+now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: streamtx (-d tty | -o file) [options]\n"
+        "  -d tty        controller USB serial (e.g. /dev/ttyACM0)\n"
+        "  -o file       write the stream to a file, not paced\n"
+        "  -f format     panels, cylinder or delta, default delta\n"
+        "  -r fps        frame rate, default 60\n"
+        "  -s seconds    duration, default 10\n"
+        "  -n frames     frame count (instead of -s)\n"
+        "  -k frames     keyframe interval for delta, default 60\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    options_t opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if      (a == "-d" && hasValue) opt.device = argv[++i];
+        else if (a == "-o" && hasValue) opt.output = argv[++i];
+        else if (a == "-r" && hasValue) opt.fps = atoi(argv[++i]);
+        else if (a == "-s" && hasValue) opt.seconds = atoi(argv[++i]);
+        else if (a == "-n" && hasValue) opt.frames = atoi(argv[++i]);
+        else if (a == "-k" && hasValue) opt.keyint = atoi(argv[++i]);
+        else if (a == "-f" && hasValue) {
+            std::string f = argv[++i];
+            if      (f == "panels")   opt.format = STREAM_FORMAT_PANELS;
+            else if (f == "cylinder") opt.format = STREAM_FORMAT_CYLINDER;
+            else if (f == "delta")    opt.format = STREAM_FORMAT_DELTA;
+            else { usage(); return 1; }
+        }
+        else { usage(); return 1; }
+    }
+    if (opt.device.empty() == opt.output.empty() || opt.fps <= 0 || opt.keyint <= 0) {
+        usage();
+        return 1;
+    }
+    bool paced = !opt.device.empty();
+    int frames = (opt.frames > 0)? opt.frames : (opt.seconds * opt.fps);
+
+    if (paced) {
+        if (!open_serial(opt.device.c_str())) return 1;
+        // Resync the command parser, then start the stream.
+        uint8_t on = 1;
+        uint8_t frame[CMDPARSER_HEADER_SIZE + 1 + CMDPARSER_CRC_SIZE];
+        size_t n = CmdParser::makeFrame(frame, sizeof(frame), BIN_CMD_STREAM, &on, 1);
+        if (!write_all((const uint8_t *)"\n", 1) || !write_all(frame, n)) return 1;
+        usleep(100 * 1000);
+    } else {
+        fd_ = open(opt.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            perror(opt.output.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> body;
+    std::vector<uint8_t> plane;
+    std::vector<uint8_t> prev;
+    uint64_t bytes = 0;
+    int late = 0;
+    int keyframes = 0;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long periodNs = 1000000000L / opt.fps;
+    double start = now_s();
+    double lastReport = start;
+
+    for (int f = 0; f < frames; f++) {
+        uint8_t flags = 0;
+        if (opt.format == STREAM_FORMAT_PANELS) {
+            make_panels(f, &body);
+        } else if (opt.format == STREAM_FORMAT_CYLINDER) {
+            make_cylinder(f, &body);
+        } else {
+            make_cylinder(f, &plane);
+            body.clear();
+            bool isKey = (f % opt.keyint) == 0;
+            if (isKey) {
+                encode_tokens(plane, &body);
+                flags = STREAM_FLAG_KEYFRAME;
+                keyframes++;
+            } else {
+                std::vector<uint8_t> diff(plane.size());
+                for (size_t i = 0; i < plane.size(); i++) diff[i] = plane[i] ^ prev[i];
+                encode_tokens(diff, &body);
+            }
+            prev = plane;
+        }
+
+        uint8_t header[STREAM_HEADER_SIZE];
+        FrameStream::makeHeader(header, opt.format, flags, (uint16_t)f, (uint32_t)body.size());
+        if (!write_all(header, sizeof(header)) || !write_all(body.data(), body.size())) return 1;
+        bytes += sizeof(header) + body.size();
+
+        if (!paced) continue;
+        poll_stats();
+
+        // Absolute deadlines, a late frame is sent at once and not caught up.
+        next.tv_nsec += periodNs;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+            late++;
+            next = now;
+        } else {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+
+        double t = now_s();
+        if (t - lastReport >= 1.0) {
+            printf("%6.1f s : %d frames, %.1f fps, %.2f MB/s\n", t - start, f + 1,
+                (f + 1) / (t - start), bytes / (t - start) / 1e6);
+            lastReport = t;
+        }
+    }
+
+    double elapsed = now_s() - start;
+    if (paced) {
+        uint8_t header[STREAM_HEADER_SIZE];
+        FrameStream::makeHeader(header, STREAM_FORMAT_END, 0, (uint16_t)frames, 0);
+        write_all(header, sizeof(header));
+        // The last stats, sent at the end.
+        usleep(300 * 1000);
+        poll_stats();
+    }
+    close(fd_);
+
+    printf("sent %d frames (%d keyframes), %llu bytes, %.1f bytes/frame\n",
+        frames, keyframes, (unsigned long long)bytes, (double)bytes / frames);
+    if (paced) {
+        printf("%.2f s, %.1f fps (target %d), %.2f MB/s, %d late\n",
+            elapsed, frames / elapsed, opt.fps, bytes / elapsed / 1e6, late);
+        if (stats_.valid) {
+            uint32_t received = stats_.frames + stats_.dropped;
+            printf("device : %u / %d frames used, %u dropped (%.1f %%), %u errors\n",
+                stats_.frames, frames, stats_.dropped,
+                (received > 0)? (stats_.dropped * 100.0 / received) : 0.0, stats_.errors);
+        } else {
+            printf("device : no stats\n");
+        }
+    }
+    return 0;
+}
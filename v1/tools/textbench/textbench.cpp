@@ -0,0 +1,326 @@
+/**********************************************************************/
+/**
+ * @brief  Text Rendering Check and Benchmark (Host Tool)
+ * @author naoa
+ *
+ * Check text_render_span (text_render.hpp) with and without the glyph
+ * cache, and CyclicMonoDrawer::drawText around the cylinder, against a
+ * naive per pixel text : both fonts (font_small, font_ticker) and a font
+ * too big for the cache entries, both layouts, random positions with the
+ * clipping, and the span edges. Then measure a string of the whole
+ * circumference, drawText (a blit per glyph) against the span from the
+ * cache, scrolled on 8 column steps (render mode 10) and on 1 column
+ * steps, in us a string and glyphs a 70 fps frame, with the cache hit
+ * rate.
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller textbench.cpp \
+ *       ../../firmware/controller/text_render.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o textbench
+ *
+ * Run :
+ *   ./textbench [rounds]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+#include "font.hpp"
+#include "text_render.hpp"
+
+#include "font_small.h"
+#include "font_ticker.h"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+typedef CvScreenGeometry G;
+
+#define BIG_HEIGHT          (40)    // 2 pages or more do not fit to an entry
+#define GUARD_BYTES         (64)
+
+static uint32_t rnd_ = 2463534242UL;
+
+// Random glyphs, the columns past the width 0.
+static font_glyph_t bigGlyphs_[95];
+static std::vector<uint8_t> bigData_;
+static font_t bigFont_ = { "big", 0x20, 95, BIG_HEIGHT, 34, 2, 10, 30, bigGlyphs_, nullptr };
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Reference
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+static int
+rnd_range(int lo, int hi)
+{
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+static void
+make_big_font(void)
+{
+    for (int i = 0; i < 95; i++) {
+        int w = (i == 0)? 0 : rnd_range(1, 30);
+        bigGlyphs_[i] = { (uint32_t)bigData_.size(), (uint8_t)w, (uint8_t)((34 - w) / 2) };
+        for (int page = 0; page < (w + 7) / 8; page++) {
+            int bits = w - (page * 8);
+            uint8_t mask = (bits >= 8)? 0xFF : (uint8_t)((1 << bits) - 1);
+            for (int r = 0; r < BIG_HEIGHT; r++) bigData_.push_back((uint8_t)rnd() & mask);
+        }
+    }
+    bigFont_.data_ = bigData_.data();
+}
+
+static std::string
+rnd_text(int maxLength)
+{
+    std::string s;
+    int n = rnd_range(0, maxLength);
+    for (int i = 0; i < n; i++) {
+        // Some codes out of the font, blanks.
+        s.push_back((char)(((rnd() & 15) == 0)? rnd_range(1, 255) : rnd_range(0x20, 0x7E)));
+    }
+    return s;
+}
+
+// Ink of the glyph at x / row r.
+static bool
+ink(const Font * font, const font_glyph_t * g, int x, int r)
+{
+    int c = g->width_ - 1 - x;
+    return (font->font_->data_[g->offset_ + ((c >> 3) * font->height()) + r] >> (c & 7)) & 1;
+}
+
+// Per pixel, func(x, row) for every ink pixel of the text.
+template <typename F>
+static int
+naive_text(int x, int y, const Font * font, const char * text, text_layout_t layout, F func)
+{
+    for (const char * p = text; *p != '\0'; p++) {
+        const font_glyph_t * g = font->glyph((uint8_t)*p);
+        int gx = x + font->left(g, layout);
+        for (int r = 0; r < font->height(); r++) {
+            for (int i = 0; i < g->width_; i++) {
+                if (ink(font, g, i, r)) func(gx + i, y + r);
+            }
+        }
+        x += font->advance(g, layout);
+    }
+    return x;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Checks
+ *----------------------------------------------------------------------
+ */
+
+static bool
+check_span(int rounds)
+{
+    const font_t * fonts[] = { &font_small, &font_ticker, &bigFont_ };
+    GlyphCache cache;
+    for (int n = 0; n < rounds; n++) {
+        Font font(fonts[rnd() % 3]);
+        int width = rnd_range(1, 300);
+        int height = rnd_range(1, 60);
+        int pages = (width + 7) / 8;
+        size_t size = (size_t)pages * height;
+        std::vector<uint8_t> a(size + GUARD_BYTES), b(size + GUARD_BYTES), c(size + GUARD_BYTES);
+        for (size_t i = 0; i < a.size(); i++) a[i] = b[i] = c[i] = (uint8_t)(((rnd() & 3) == 0)? rnd() : 0);
+        mono_surface_t sa = { width, height, a.data() };
+        mono_surface_t sc = { width, height, c.data() };
+        std::string text = rnd_text(24);
+        text_layout_t layout = (text_layout_t)(rnd() & 1);
+        int x = rnd_range(-100, width + 20), y = rnd_range(-30, height + 5);
+
+        int ea = text_render_span(&sa, x, y, &font, text.c_str(), layout, &cache);
+        int ec = text_render_span(&sc, x, y, &font, text.c_str(), layout, nullptr);
+        int eb = naive_text(x, y, &font, text.c_str(), layout, [&](int px, int row) {
+            int column = width - 1 - px;
+            if (px < 0 || px >= width || row < 0 || row >= height) return;
+            b[((column >> 3) * height) + row] |= (uint8_t)(1 << (column & 7));
+        });
+
+        // The columns past the width in the last page are don't care.
+        uint8_t mask = (uint8_t)((1 << (((width - 1) & 7) + 1)) - 1);
+        bool same = (ea == eb && ec == eb);
+        for (size_t i = 0; i < a.size() && same; i++) {
+            uint8_t m = (i >= size)? 0xFF : ((int)(i / height) == pages - 1)? mask : 0xFF;
+            if ((a[i] & m) != (b[i] & m) || (c[i] & m) != (b[i] & m)) same = false;
+            if (i >= size && (a[i] != b[i] || c[i] != b[i])) same = false;
+        }
+        if (!same) {
+            printf("NG : span %d x %d, text at (%d, %d), font %s, layout %d, \"%s\"\n",
+                width, height, x, y, font.font_->name_, layout, text.c_str());
+            return false;
+        }
+    }
+    const glyph_cache_stats_t * s = cache.stats();
+    printf("span check : %u hits, %u misses, %u bypasses\n", s->hits_, s->misses_, s->bypasses_);
+    return true;
+}
+
+static bool
+check_drawer(int rounds)
+{
+    const font_t * fonts[] = { &font_small, &font_ticker, &bigFont_ };
+    std::vector<uint8_t> a(G::FRAME_BYTES), b(G::FRAME_BYTES);
+    CyclicMonoScreen sa, sb;
+    CyclicMonoDrawer drawer;
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        sa.getMonoScreen(i)->setBuffer(a.data() + (i * G::ONE_FRAME_BYTES));
+        sb.getMonoScreen(i)->setBuffer(b.data() + (i * G::ONE_FRAME_BYTES));
+    }
+    drawer.init(&sa);
+
+    for (int n = 0; n < rounds; n++) {
+        Font font(fonts[rnd() % 3]);
+        for (size_t i = 0; i < a.size(); i++) a[i] = b[i] = (uint8_t)(((rnd() & 3) == 0)? rnd() : 0);
+        std::string text = rnd_text(64);
+        text_layout_t layout = (text_layout_t)(rnd() & 1);
+        int x = rnd_range(-2 * G::V_WIDTH, 2 * G::V_WIDTH), y = rnd_range(-40, 140);
+        bool centered = (rnd() & 1) != 0;
+        int ea = drawer.drawText(x, y, &font, text.c_str(), layout, centered);
+
+        int x0 = (centered)? x - (font.textWidth(text.c_str(), layout) / 2) : x;
+        int y0 = (centered)? y - (font.height() / 2) : y;
+        int eb = naive_text(x0, y0, &font, text.c_str(), layout, [&](int px, int row) {
+            int v = G::COLUMNS.v_[G::wrap(px)];
+            if (v < 0 || row < 0 || row >= G::HEIGHT) return;
+            sb.getMonoScreen(v / G::WIDTH)->setDot(v % G::WIDTH, row, DISP_COLOR_WHITE);
+        });
+        if (a != b || ea != eb) {
+            printf("NG : drawText (%d, %d), font %s, layout %d, centered %d, \"%s\"\n",
+                x, y, font.font_->name_, layout, centered, text.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+template <typename F>
+static double
+us_per_call(F func)
+{
+    using clock = std::chrono::steady_clock;
+    int n = 0;
+    auto t0 = clock::now();
+    double us = 0;
+    do {
+        for (int i = 0; i < 64; i++) func();
+        n += 64;
+        us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+    } while (us < 200000.0);
+    return us / n;
+}
+
+// Time of a string, the glyphs in a 70 fps frame time at that rate.
+static void
+print_result(const char * name, double us, int glyphs, const GlyphCache * cache)
+{
+    printf("%-36s %8.2f us %10.0f glyphs/frame", name, us, (glyphs * (1000000.0 / 70)) / us);
+    if (cache) {
+        const glyph_cache_stats_t * s = cache->stats();
+        uint32_t total = s->hits_ + s->misses_ + s->bypasses_;
+        printf("  hit %5.1f %%", (total > 0)? (s->hits_ * 100.0) / total : 0.0);
+    }
+    printf("\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    int rounds = (argc > 1)? atoi(argv[1]) : 20000;
+    if (rounds <= 0) rounds = 20000;
+
+    make_big_font();
+    bool ok = check_span(rounds);
+    ok = ok && check_drawer(rounds / 20);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+
+    // A string of the whole circumference in the ticker font.
+    Font font(&font_ticker);
+    std::string text;
+    const char * words = "CylinView - persistence of vision cylinder display. ";
+    while (font.textWidth((text + words).c_str(), TEXT_LAYOUT_PROPORTIONAL) <= G::V_WIDTH) text += words;
+    for (const char * p = words; font.textWidth((text + *p).c_str(), TEXT_LAYOUT_PROPORTIONAL) <= G::V_WIDTH; p++) text += *p;
+    printf("%d glyphs, %d of %d columns\n", (int)text.size(),
+        font.textWidth(text.c_str(), TEXT_LAYOUT_PROPORTIONAL), G::V_WIDTH);
+
+    static uint8_t frame[G::FRAME_BYTES];
+    static uint8_t span[((G::V_WIDTH + 7) / 8) * 28];
+    const mono_surface_t surface = { G::V_WIDTH, font.height(), span };
+    CyclicMonoScreen screen;
+    CyclicMonoDrawer drawer;
+    for (int i = 0; i < G::DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frame + (i * G::ONE_FRAME_BYTES));
+    }
+    drawer.init(&screen);
+    const mono_plane_t plane = { G::V_WIDTH, font.height(), span };
+
+    // The string repeats round the span, as render mode 10.
+    int scroll = 0;
+    auto render = [&](int x, GlyphCache * cache) {
+        memset(span, 0, sizeof(span));
+        x %= G::V_WIDTH;
+        for (x -= G::V_WIDTH; x < G::V_WIDTH; x += G::V_WIDTH) {
+            text_render_span(&surface, x, 0, &font, text.c_str(), TEXT_LAYOUT_PROPORTIONAL, cache);
+        }
+    };
+    print_result("drawText, a blit per glyph", us_per_call([&]() {
+        drawer.drawText(-(scroll++), 50, &font, text.c_str());
+    }), (int)text.size(), nullptr);
+    print_result("span, no cache", us_per_call([&]() {
+        render(scroll++, nullptr);
+    }), (int)text.size(), nullptr);
+    GlyphCache cache;
+    print_result("span, cache, 1 column steps", us_per_call([&]() {
+        render(scroll++, &cache);
+    }), (int)text.size(), &cache);
+    cache.clearStats();
+    print_result("span, cache, 8 column steps", us_per_call([&]() {
+        render((scroll++) & ~7, &cache);
+    }), (int)text.size(), &cache);
+    cache.clearStats();
+    print_result("span, 8 column steps + drawPlane", us_per_call([&]() {
+        render(scroll & ~7, &cache);
+        drawer.drawPlane(-(scroll & 7), 50, &plane);
+        scroll++;
+    }), (int)text.size(), &cache);
+    return (ok)? 0 : 1;
+}
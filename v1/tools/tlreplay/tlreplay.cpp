@@ -0,0 +1,315 @@
+/**********************************************************************/
+/**
+ * @brief  Timeline Replay (Host Tool)
+ * @author naoa
+ *
+ * Replay the intro scene (render mode 6, intro_scene.cpp) on the Timeline
+ * with the motor stubbed and a simulated rotor, and check :
+ *   - the same frame times give the same trace, bit exact (frame hashes)
+ *   - every step is entered once and in order, at 30 / 70 / 144 fps and
+ *     at jittered frame times
+ *   - a timed step starts exactly at the end of the previous one, so the
+ *     timed part of the sequence does not depend on the frame rate
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../../firmware/controller tlreplay.cpp \
+ *       ../../firmware/controller/timeline.cpp \
+ *       ../../firmware/controller/intro_scene.cpp \
+ *       ../../firmware/controller/image_data.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o tlreplay
+ *
+ * Run :
+ *   ./tlreplay [-v]
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "screen_config.hpp"
+#include "cyclic_mono_screen.hpp"
+#include "cyclic_mono_drawer.hpp"
+#include "particles.hpp"
+#include "timeline.hpp"
+#include "intro_scene.hpp"
+#include "motor.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+#define REPLAY_REV_US           (61231UL)       // Rotor, one revolution while powered (not a multiple of the frames)
+#define REPLAY_LIMIT_US         (120000000UL)   // Give up
+
+#define SNOW_PARTICLES          (100)
+
+typedef struct replay_step_ {
+    int step_;
+    uint32_t startUs_;
+    int frames_;
+    uint32_t hash_;         // Frame buffers at the last frame of the step
+} replay_step_t;
+
+typedef struct replay_ {
+    std::vector<replay_step_t> steps_;
+    std::vector<std::string> motor_;
+    uint32_t endUs_;
+    uint32_t hash_;         // All frames
+    bool finished_;
+} replay_t;
+
+static uint8_t frameBuffer_[CV_FRAME_BYTES];
+
+static uint16_t snowX_[SNOW_PARTICLES];
+static int16_t  snowY_[SNOW_PARTICLES];
+static int16_t  snowVY_[SNOW_PARTICLES];
+
+// Simulated rotor. The angle runs while powered, and holds on brake.
+static bool rotorSpin_ = false;
+static uint32_t rotorBaseUs_ = 0;
+static uint32_t rotorBaseAngle_ = 0;
+static uint32_t nowUs_ = 0;
+static uint32_t startUs_ = 0;
+static std::vector<std::string> * motorLog_ = nullptr;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Motor stub
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+rotor_angle(uint32_t nowUs)
+{
+    if (!rotorSpin_) return rotorBaseAngle_;
+    uint64_t a = ((uint64_t)(nowUs - rotorBaseUs_) << 16) / REPLAY_REV_US;
+    return (uint32_t)(rotorBaseAngle_ + a) & 0xFFFF;
+}
+
+static void
+motor_log(const char * text)
+{
+    char line[64];
+    snprintf(line, sizeof(line), "%10u us  %s", (unsigned)(nowUs_ - startUs_), text);
+    if (motorLog_) motorLog_->push_back(line);
+}
+
+void
+motor_init(int pin_in_1, int pin_in_2)
+{
+}
+
+void
+motor_set_power(int power)
+{
+    rotorBaseAngle_ = rotor_angle(nowUs_);
+    rotorBaseUs_ = nowUs_;
+    rotorSpin_ = (power != 0);
+    char text[32];
+    snprintf(text, sizeof(text), "motor power %d", power);
+    motor_log(text);
+}
+
+void
+motor_set_brake(bool brake)
+{
+    rotorBaseAngle_ = rotor_angle(nowUs_);
+    rotorBaseUs_ = nowUs_;
+    if (brake) rotorSpin_ = false;
+    motor_log((brake)? "motor brake" : "motor release");
+}
+
+void
+motor_set_decay_mode(bool slow)
+{
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t
+fnv1a(uint32_t h, const uint8_t * p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 16777619UL;
+    }
+    return h;
+}
+
+// Same to App::angle2xpos()
+static int
+angle2xpos(uint32_t angle)
+{
+    return (int)(((angle & 0xFFFF) * CV_V_WIDTH) >> 16);
+}
+
+// Frame interval of the frame i. jitter is in percent of the interval.
+static uint32_t
+frame_us(uint32_t intervalUs, int jitter, uint32_t * seed)
+{
+    if (jitter == 0) return intervalUs;
+    uint32_t s = *seed;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    *seed = s;
+    int span = (int)(intervalUs * jitter / 100);
+    return intervalUs - span + (s % (uint32_t)(span * 2 + 1));
+}
+
+static replay_t
+replay(uint32_t intervalUs, int jitter, uint32_t seed)
+{
+    replay_t r;
+    r.endUs_ = 0;
+    r.hash_ = 2166136261UL;
+    r.finished_ = false;
+
+    CyclicMonoScreen screen;
+    for (int i = 0; i < CV_DISPLAYS; i++) {
+        screen.getMonoScreen(i)->setBuffer(frameBuffer_ + (i * CV_ONE_FRAME_BYTES));
+    }
+    memset(frameBuffer_, 0, sizeof(frameBuffer_));
+    CyclicMonoDrawer drawer;
+    drawer.init(&screen);
+
+    Particles snow;
+    snow.setSeed(1);
+    snow.setBuffers(snowX_, snowY_, snowVY_, SNOW_PARTICLES);
+
+    rotorSpin_ = false;
+    rotorBaseUs_ = 0;
+    rotorBaseAngle_ = 0x8000;
+    motorLog_ = &r.motor_;
+
+    intro_scene_t scene;
+    scene.drawer_ = &drawer;
+    scene.snow_ = &snow;
+    scene.finished_ = false;
+
+    // Start at a non zero time, to see the wrap of the time stamps.
+    nowUs_ = 0xFFFFFFFFUL - 3000000UL;
+    startUs_ = nowUs_;
+    const uint32_t t0 = nowUs_;
+    Timeline timeline;
+    timeline.start(intro_scene_steps, intro_scene_step_count, &scene, nowUs_);
+
+    while ((uint32_t)(nowUs_ - t0) < REPLAY_LIMIT_US) {
+        int before = timeline.step();
+        scene.xpos_ = angle2xpos(rotor_angle(nowUs_));
+        drawer.init(&screen);
+        timeline.update(nowUs_);
+
+        // Step entries, including the steps passed over in this frame.
+        int after = timeline.step();
+        if (r.steps_.empty()) {
+            r.steps_.push_back({ 0, 0, 0, 0 });
+        }
+        r.steps_.back().frames_++;
+        r.steps_.back().hash_ = fnv1a(2166136261UL, frameBuffer_, sizeof(frameBuffer_));
+        r.hash_ = fnv1a(r.hash_, frameBuffer_, sizeof(frameBuffer_));
+        for (int s = before + 1; s <= after; s++) {
+            uint32_t start = (s == after)? timeline.stepStartUs() - t0
+                           : r.steps_.back().startUs_ + intro_scene_steps[s - 1].durationUs_;
+            r.steps_.push_back({ s, start, 0, 0 });
+        }
+
+        if (scene.finished_) {
+            timeline.stop();
+            r.finished_ = true;
+            r.endUs_ = nowUs_ - t0;
+            break;
+        }
+        nowUs_ += frame_us(intervalUs, jitter, &seed);
+    }
+    motorLog_ = nullptr;
+    return r;
+}
+
+// Timed steps start at the end of the previous step.
+static bool
+check_starts(const replay_t * r, const char * label)
+{
+    bool ok = r->finished_ && (int)r->steps_.size() == intro_scene_step_count;
+    for (size_t i = 0; ok && i < r->steps_.size(); i++) {
+        if (r->steps_[i].step_ != (int)i) ok = false;
+    }
+    if (!ok) {
+        printf("%-16s steps not in order, or not finished\n", label);
+        return false;
+    }
+    for (size_t i = 1; i < r->steps_.size(); i++) {
+        const timeline_step_t * prev = &intro_scene_steps[i - 1];
+        if (prev->durationUs_ == 0) continue;
+        uint32_t expect = r->steps_[i - 1].startUs_ + prev->durationUs_;
+        if (r->steps_[i].startUs_ != expect) {
+            printf("%-16s step %zu starts %u us, expected %u us\n",
+                label, i, (unsigned)r->steps_[i].startUs_, (unsigned)expect);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void
+print_replay(const replay_t * r)
+{
+    for (const replay_step_t & s : r->steps_) {
+        printf("  %10u us  %-16s %5d frames  %08x\n",
+            (unsigned)s.startUs_, intro_scene_steps[s.step_].name_, s.frames_, (unsigned)s.hash_);
+    }
+    for (const std::string & m : r->motor_) {
+        printf("  %s\n", m.c_str());
+    }
+}
+
+int
+main(int argc, char ** argv)
+{
+    bool verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+    bool ok = true;
+
+    // Deterministic, same frame times give the same frames.
+    replay_t a = replay(1000000UL / 70, 0, 1);
+    replay_t b = replay(1000000UL / 70, 0, 1);
+    bool same = (a.hash_ == b.hash_) && (a.endUs_ == b.endUs_) && (a.motor_ == b.motor_);
+    printf("70 fps replay twice : %08x / %08x, %s\n", (unsigned)a.hash_, (unsigned)b.hash_, (same)? "same" : "DIFFER");
+    ok = ok && same;
+    if (verbose) print_replay(&a);
+
+    // Any frame rate.
+    struct { const char * label_; uint32_t intervalUs_; int jitter_; } rates[] = {
+        { "30 fps",          1000000UL / 30,  0 },
+        { "70 fps",          1000000UL / 70,  0 },
+        { "144 fps",         1000000UL / 144, 0 },
+        { "70 fps +-50%",    1000000UL / 70,  50 },
+        { "20 fps +-90%",    1000000UL / 20,  90 },
+    };
+    for (auto & rate : rates) {
+        replay_t r = replay(rate.intervalUs_, rate.jitter_, 12345);
+        bool rok = check_starts(&r, rate.label_);
+        int frames = 0;
+        for (const replay_step_t & s : r.steps_) frames += s.frames_;
+        printf("%-16s %6d frames, %8.3f s, %2d steps, %s\n",
+            rate.label_, frames, r.endUs_ / 1e6, (int)r.steps_.size(), (rok)? "OK" : "NG");
+        ok = ok && rok;
+    }
+
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    return (ok)? 0 : 1;
+}
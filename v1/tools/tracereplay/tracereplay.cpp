@@ -0,0 +1,566 @@
+/**********************************************************************/
+/**
+ * @brief  Trace Replay (Host Tool)
+ * @author naoa
+ *
+ * Replay a controller trace (trace_recorder.hpp, dumped by "TRACE DUMP")
+ * on App with a virtual clock : the loops at their recorded times and
+ * encoder angles, the commands, and a render at every frame. Then check
+ * the replay against the trace :
+ *   - the frame hashes (the trace started with a hash, "TRACE START s 1")
+ *     and the render mode after every frame
+ *   - the motor calls (the intro scene, render mode 6) at the same frames
+ * and report per render mode the frames, the render time on the device
+ * (from the trace) and on the host, the rotor speed and the frame interval.
+ *
+ * The trace is exact from its SEED record, the App is reseeded there. A
+ * trace of a ring that was overwritten has no SEED, it is replayed from
+ * the default state without the checks. The render modes keep their state
+ * from before the trace on the device, a mode that was run before the
+ * trace may differ. (e.g. the particles of the snow)
+ *
+ * Build :
+ *   g++ -O2 -std=c++17 -I../cvsim/arduino -I../../firmware/controller tracereplay.cpp \
+ *       ../../firmware/controller/trace_recorder.cpp \
+ *       ../../firmware/controller/app.cpp \
+ *       ../../firmware/controller/life.cpp \
+ *       ../../firmware/controller/timeline.cpp \
+ *       ../../firmware/controller/intro_scene.cpp \
+ *       ../../firmware/controller/image_data.cpp \
+ *       ../../firmware/controller/mono_video.cpp \
+ *       ../../firmware/controller/cyclic_mono_drawer.cpp \
+ *       ../../firmware/controller/cyclic_mono_screen.cpp \
+ *       ../../firmware/controller/mono_screen.cpp \
+ *       ../../firmware/controller/mono_blit.cpp \
+ *       ../../firmware/controller/mono_dither.cpp \
+ *       ../../firmware/controller/text_render.cpp \
+ *       ../../firmware/controller/fixed_math.cpp \
+ *       ../../firmware/controller/scroll_layer.cpp \
+ *       ../../firmware/controller/sprite_registry.cpp -o tracereplay
+ *
+ * Run :
+ *   ./tracereplay [-v] serial.log       replay a dump (other lines are skipped)
+ *   ./tracereplay -g trace.txt [-s sec] record a simulated session (a rotor
+ *                                       model and scripted commands) to replay
+ */
+/**********************************************************************/
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Include files
+ *----------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cstdarg>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "screen_config.hpp"
+#include "encoder.hpp"
+#include "motor.hpp"
+#include "trace_recorder.hpp"
+#include "app.hpp"
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Definitions
+ *----------------------------------------------------------------------
+ */
+
+// Binary commands replayed, same to controller.ino.
+#define BIN_CMD_SET_MODE        (0x02)
+#define BIN_CMD_MOTOR_POWER     (0x03)
+#define BIN_CMD_MOTOR_BRAKE     (0x04)
+
+// Simulated session (-g)
+#define SIM_SEED                (0x7ACE0001UL)
+#define SIM_START_US            (0xFFFFFFFFUL - 3000000UL)  // micros() wraps in the session
+#define SIM_TRANSFER_US         (13500)                     // A frame to the bridges, ~70 fps
+
+typedef struct options_ {
+    std::string input;
+    std::string generate;
+    int seconds = 8;
+    bool verbose = false;
+} options_t;
+
+typedef struct motor_event_ {
+    uint32_t frame_;
+    int type_;
+    int value_;
+    bool operator==(const motor_event_ & o) const {
+        return frame_ == o.frame_ && type_ == o.type_ && value_ == o.value_;
+    }
+} motor_event_t;
+
+typedef struct mode_stats_ {
+    int frames_ = 0;
+    uint64_t deviceUs_ = 0;
+    uint32_t deviceMaxUs_ = 0;
+    double hostUs_ = 0;
+    double hostMaxUs_ = 0;
+    double revs_ = 0;               // Revolutions in the frames of the mode
+    uint64_t spanUs_ = 0;
+} mode_stats_t;
+
+static options_t opt_;
+static uint32_t nowUs_ = 0;
+static bool simulating_ = false;    // -g, the motor calls are recorded
+
+static App app_;
+static uint8_t frameBuffer_[CV_FRAME_BYTES * CV_GRAY_PLANES_MAX];
+static sprite_list_t sprites_;
+
+static uint32_t frames_ = 0;        // Frames replayed
+static std::vector<motor_event_t> motor_;
+
+HardwareSerial Serial;
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Arduino and motor stand-ins
+ *----------------------------------------------------------------------
+ */
+
+uint64_t
+cvsim_now_ns(void)
+{
+    return (uint64_t)nowUs_ * 1000ULL;
+}
+
+void
+cvsim_reset_request(void)
+{
+}
+
+void
+digitalWrite(int pin, int value)
+{
+}
+
+int
+HardwareSerial::printf(const char * format, ...)
+{
+    if (!opt_.verbose) return 0;
+    va_list ap;
+    va_start(ap, format);
+    int n = vprintf(format, ap);
+    va_end(ap);
+    return n;
+}
+
+// Recorded as motor.cpp does on the device (-g), or compared. (replay)
+void motor_init(int pin_in_1, int pin_in_2) {}
+void motor_set_power(int power)
+{
+    if (simulating_) trace_motor(TRACE_MOTOR_POWER, power);
+    else motor_.push_back({ frames_, TRACE_MOTOR_POWER, (int16_t)power });
+}
+void motor_set_brake(bool brake)
+{
+    if (simulating_) trace_motor(TRACE_MOTOR_BRAKE, brake);
+    else motor_.push_back({ frames_, TRACE_MOTOR_BRAKE, brake });
+}
+void motor_set_decay_mode(bool slow) {}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Commands
+ *----------------------------------------------------------------------
+ */
+
+// The commands of controller.ino that change App or the motor, the others
+// (the bridges, the monitors, the encoder offset : already in the angles)
+// have nothing to replay.
+static bool
+apply_command(const std::string & line)
+{
+    std::vector<std::string> args;
+    size_t p = 0;
+    while (p < line.size()) {
+        size_t q = line.find(' ', p);
+        if (q == std::string::npos) q = line.size();
+        if (q > p) args.push_back(line.substr(p, q - p));
+        p = q + 1;
+    }
+    if (args.empty()) return false;
+    auto param = [&](size_t i) { return (i + 1 < args.size())? atoi(args[i + 1].c_str()) : 0; };
+
+    const std::string & cmd = args[0];
+    if (cmd == "MODE") {
+        app_.setMode(param(0));
+    } else if (cmd == "GRAY") {
+        int planes = param(0);
+        app_.setGrayPlanes((planes < 1)? 1 : (planes > CV_GRAY_PLANES_MAX)? CV_GRAY_PLANES_MAX : planes);
+    } else if (cmd == "TEXT") {
+        std::string text;
+        for (size_t i = 1; i < args.size(); i++) text += ((i > 1)? " " : "") + args[i];
+        app_.setTickerText(text.c_str());
+    } else if (cmd == "TICKER") {
+        app_.setTickerSpeed(param(0));
+    } else if (cmd == "M") {
+        motor_set_power(param(0));
+    } else if (cmd == "MB") {
+        motor_set_brake(param(0) != 0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool
+apply_binary(uint8_t cmd, const std::vector<uint8_t> & p)
+{
+    switch (cmd) {
+    case BIN_CMD_SET_MODE:
+        if (p.size() >= 1) app_.setMode(p[0]);
+        return true;
+    case BIN_CMD_MOTOR_POWER:
+        if (p.size() >= 2) motor_set_power((int16_t)(p[0] | (p[1] << 8)));
+        return true;
+    case BIN_CMD_MOTOR_BRAKE:
+        if (p.size() >= 1) motor_set_brake(p[0] != 0);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Simulated session
+ *----------------------------------------------------------------------
+ */
+
+static uint32_t rnd_ = 2463534242UL;
+
+static uint32_t
+rnd(void)
+{
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 17;
+    rnd_ ^= rnd_ << 5;
+    return rnd_;
+}
+
+// The controller loop on a virtual clock : the commands, the encoder and
+// App::loop every loop, a render when the slot is free (the transfer of
+// the last frame is done). The rotor spins up, wobbles and jitters.
+static bool
+simulate(const std::string & path, int seconds)
+{
+    struct { uint32_t atUs_; const char * line_; } script[] = {
+        {       0, "MODE 1" },
+        {  600000, "MODE 5" },
+        { 1200000, "TEXT Replayed on the host" },
+        { 1250000, "TICKER -90" },
+        { 1300000, "MODE 10" },
+        { 2200000, "GRAY 2 0" },
+        { 2250000, "MODE 9" },
+        { 2600000, nullptr },       // Binary SET_MODE 4
+        { 3000000, "GRAY 1 0" },
+        { 3050000, "MODE 6" },      // The intro, the motor calls, then mode 7
+        { 6500000, "M 90" },
+        { 7000000, "MODE 8" },
+    };
+    const int scriptCount = sizeof(script) / sizeof(script[0]);
+
+    simulating_ = true;
+    nowUs_ = SIM_START_US;
+    app_.init();
+    app_.setSeed(SIM_SEED);
+    trace_start(nowUs_, SIM_SEED, app_.rendermode_, app_.grayPlanes(), true, true);
+
+    const uint32_t startUs = nowUs_;
+    const uint64_t endUs = (uint64_t)seconds * 1000000ULL;
+    double angle = 0;
+    double revPerSec = 4.0;
+    uint32_t readyUs = nowUs_;
+    int next = 0;
+    for (uint64_t t = 0; t < endUs; t = (uint32_t)(nowUs_ - startUs)) {
+        // Commands
+        while (next < scriptCount && script[next].atUs_ <= t) {
+            if (script[next].line_ != nullptr) {
+                trace_command(script[next].line_);
+                apply_command(script[next].line_);
+            } else {
+                const uint8_t mode = 4;
+                trace_binary(BIN_CMD_SET_MODE, &mode, 1);
+                apply_binary(BIN_CMD_SET_MODE, std::vector<uint8_t>(1, mode));
+            }
+            next++;
+        }
+
+        // Encoder and App::loop
+        uint16_t count = (uint16_t)((uint32_t)(angle * ENCODER_COUNTS) & (ENCODER_COUNTS - 1));
+        count = (uint16_t)((count + (rnd() % 5) - 2) & (ENCODER_COUNTS - 1));
+        trace_loop(nowUs_, count);
+        app_.loop(nowUs_, count);
+
+        uint32_t stepUs = 30 + (rnd() % 120);
+        if ((int32_t)(nowUs_ - readyUs) >= 0) {
+            memset(&sprites_, 0, sizeof(sprites_));
+            app_.render(frameBuffer_, &sprites_);
+            stepUs += 1500 + (rnd() % 4000) + (((rnd() & 255) == 0)? 20000 : 0);   // A glitch at times
+            uint32_t hash = trace_hash(frameBuffer_, CV_FRAME_BYTES * app_.grayPlanes(), &sprites_);
+            trace_frame(nowUs_ + stepUs, app_.rendermode_, 0, hash);
+            readyUs = nowUs_ + stepUs + SIM_TRANSFER_US + (rnd() % 1500);
+        }
+
+        // Rotor
+        double target = 6.0 + 1.5 * ((t / 1000000) & 1);
+        revPerSec += (target - revPerSec) * (stepUs / 1500000.0);
+        angle += revPerSec * (stepUs / 1000000.0);
+        angle -= (int)angle;
+        nowUs_ += stepUs;
+    }
+    trace_stop();
+    simulating_ = false;
+
+    FILE * fp = fopen(path.c_str(), "w");
+    if (fp == NULL) {
+        printf("%s : can not write\n", path.c_str());
+        return false;
+    }
+    trace_stats_t stats;
+    trace_get_stats(&stats);
+    fprintf(fp, "@TRACE %d %u %u\n", TRACE_VERSION, (unsigned)stats.records_, (unsigned)stats.overwritten_);
+    trace_record_t record;
+    char line[TRACE_LINE_SIZE];
+    for (uint32_t i = 0; trace_get(i, &record); i++) {
+        trace_format(&record, line, sizeof(line));
+        fprintf(fp, "%s\n", line);
+    }
+    fprintf(fp, "@TRACE END\n");
+    fclose(fp);
+    printf("%s : %u records, %u frames, %d s\n", path.c_str(), (unsigned)stats.records_, (unsigned)stats.frames_, seconds);
+    return true;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Replay
+ *----------------------------------------------------------------------
+ */
+
+static bool
+read_trace(const std::string & path, std::vector<trace_record_t> * records)
+{
+    FILE * fp = fopen(path.c_str(), "r");
+    if (fp == NULL) return false;
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        trace_record_t r;
+        if (trace_parse(line, &r)) records->push_back(r);
+    }
+    fclose(fp);
+    return true;
+}
+
+// The bytes of the TEXT records after records[*i], false if cut.
+static bool
+read_text(const std::vector<trace_record_t> & records, size_t * i, size_t size, std::vector<uint8_t> * bytes)
+{
+    while (bytes->size() < size) {
+        if ((*i + 1) >= records.size() || records[*i + 1].type_ != TRACE_TEXT) return false;
+        const trace_record_t & t = records[++(*i)];
+        const uint8_t * p = (const uint8_t *)t.data_;
+        bytes->insert(bytes->end(), p, p + ((t.arg_ < TRACE_TEXT_BYTES)? t.arg_ : TRACE_TEXT_BYTES));
+    }
+    return true;
+}
+
+static bool
+replay(const std::vector<trace_record_t> & records)
+{
+    using clock = std::chrono::steady_clock;
+    bool complete = !records.empty() && records[0].type_ == TRACE_SEED;
+    bool hashed = complete && (records[0].data_[1] & TRACE_FLAG_HASH);
+
+    std::vector<motor_event_t> expected;
+    std::map<int, mode_stats_t> modes;
+    uint32_t firstUs = 0, lastFrameUs = 0, maxIntervalUs = 0, maxIntervalFrame = 0;
+    bool hasFrame = false;
+    uint16_t lastAngle = 0;
+    uint32_t lastLoopUs = 0;
+    bool hasLoop = false;
+    double revs = 0;
+    uint64_t loops = 0;
+    int streamed = 0, commands = 0, skipped = 0;
+    int firstBad = -1;
+    std::string firstBadWhy;
+
+    app_.init();
+    if (!complete) app_.setSeed(0);
+    for (size_t i = 0; i < records.size(); i++) {
+        const trace_record_t & r = records[i];
+        switch (r.type_) {
+        case TRACE_SEED:
+            app_.setSeed(r.data_[0]);
+            app_.setMode(r.value_);
+            app_.setGrayPlanes(r.arg_);
+            firstUs = r.timeUs_;
+            break;
+        case TRACE_LOOP:
+            if (hasLoop) {
+                int d = ((int)r.value_ - (int)lastAngle) & (ENCODER_COUNTS - 1);
+                if (d > (ENCODER_COUNTS / 2)) d -= ENCODER_COUNTS;
+                revs += (double)d / ENCODER_COUNTS;
+            }
+            if (!hasLoop && !complete) firstUs = r.timeUs_;
+            hasLoop = true;
+            lastAngle = r.value_;
+            lastLoopUs = r.timeUs_;
+            loops += r.data_[0];
+            nowUs_ = r.timeUs_;
+            app_.loop(r.timeUs_, r.value_);
+            break;
+        case TRACE_COMMAND:
+        case TRACE_BINARY:
+        {
+            std::vector<uint8_t> bytes;
+            if (!read_text(records, &i, r.arg_, &bytes)) { skipped++; break; }
+            bool applied = (r.type_ == TRACE_COMMAND)?
+                apply_command(std::string(bytes.begin(), bytes.end())) :
+                apply_binary((uint8_t)r.value_, bytes);
+            commands++;
+            if (opt_.verbose) {
+                printf("%10.3f ms  %s %s%s\n", (uint32_t)(r.timeUs_ - firstUs) / 1000.0,
+                    (r.type_ == TRACE_COMMAND)? "command" : "binary",
+                    (r.type_ == TRACE_COMMAND)? std::string(bytes.begin(), bytes.end()).c_str() : std::to_string(r.value_).c_str(),
+                    (applied)? "" : " (not replayed)");
+            }
+        } break;
+        case TRACE_FRAME:
+        {
+            if (hasFrame) {
+                uint32_t interval = r.timeUs_ - lastFrameUs;
+                if (interval > maxIntervalUs) { maxIntervalUs = interval; maxIntervalFrame = frames_; }
+            }
+            hasFrame = true;
+            lastFrameUs = r.timeUs_;
+            mode_stats_t & m = modes[r.value_];
+            m.frames_++;
+            m.deviceUs_ += r.data_[0];
+            if (r.data_[0] > m.deviceMaxUs_) m.deviceMaxUs_ = r.data_[0];
+            m.revs_ += revs;
+            revs = 0;
+            if (r.arg_ & TRACE_FLAG_STREAM) {
+                streamed++;
+                frames_++;
+                break;
+            }
+
+            memset(&sprites_, 0, sizeof(sprites_));
+            auto t0 = clock::now();
+            app_.render(frameBuffer_, &sprites_);
+            double us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+            m.hostUs_ += us;
+            if (us > m.hostMaxUs_) m.hostMaxUs_ = us;
+
+            if (complete && firstBad < 0) {
+                uint32_t hash = trace_hash(frameBuffer_, CV_FRAME_BYTES * app_.grayPlanes(), &sprites_);
+                if (app_.rendermode_ != r.value_) {
+                    firstBad = (int)frames_;
+                    firstBadWhy = "mode " + std::to_string(app_.rendermode_) + " / " + std::to_string(r.value_);
+                } else if (hashed && hash != r.data_[1]) {
+                    char s[64];
+                    snprintf(s, sizeof(s), "hash %08x / %08x", (unsigned)hash, (unsigned)r.data_[1]);
+                    firstBad = (int)frames_;
+                    firstBadWhy = s;
+                }
+            }
+            frames_++;
+        } break;
+        case TRACE_MOTOR:
+            expected.push_back({ r.data_[0], r.arg_, (r.arg_ == TRACE_MOTOR_POWER)? (int16_t)r.value_ : r.value_ });
+            break;
+        default:
+            skipped++;
+            break;
+        }
+    }
+    (void)lastLoopUs;
+
+    // Report
+    uint32_t spanUs = lastFrameUs - firstUs;
+    printf("%zu records, %u frames (%d streamed), %d commands, %.3f s, %.1f loops a frame, %s\n",
+        records.size(), (unsigned)frames_, streamed, commands, spanUs / 1000000.0,
+        (frames_ > 0)? (double)loops / frames_ : 0.0,
+        (complete)? ((hashed)? "from the seed, hashed" : "from the seed") : "partial (no seed), not checked");
+    printf("frame interval max %.3f ms at frame %u\n", maxIntervalUs / 1000.0, (unsigned)maxIntervalFrame);
+    printf("%-6s %7s %12s %12s %12s %12s %8s\n", "mode", "frames", "device us", "device max", "host us", "host max", "rev/s");
+    for (auto & it : modes) {
+        const mode_stats_t & m = it.second;
+        int rendered = m.frames_;
+        double seconds = (m.frames_ * (spanUs / 1000000.0)) / ((frames_ > 0)? frames_ : 1);
+        printf("%-6d %7d %12.1f %12u %12.1f %12.1f %8.2f\n", it.first, m.frames_,
+            (double)m.deviceUs_ / rendered, (unsigned)m.deviceMaxUs_,
+            m.hostUs_ / rendered, m.hostMaxUs_, (seconds > 0)? m.revs_ / seconds : 0.0);
+    }
+
+    if (!complete) return true;
+    bool ok = (firstBad < 0) && (skipped == 0);
+    if (firstBad >= 0) printf("NG : frame %d differs, %s\n", firstBad, firstBadWhy.c_str());
+    if (skipped > 0) printf("NG : %d records skipped\n", skipped);
+    if (!(motor_ == expected)) {
+        size_t k = 0;
+        while (k < motor_.size() && k < expected.size() && motor_[k] == expected[k]) k++;
+        printf("NG : motor call %zu differs (%zu replayed, %zu recorded)\n", k, motor_.size(), expected.size());
+        ok = false;
+    } else {
+        printf("motor : %zu calls, same\n", motor_.size());
+    }
+    return ok;
+}
+
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Function definitions - Main
+ *----------------------------------------------------------------------
+ */
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+        "usage: tracereplay [options] trace.txt\n"
+        "  -g file       record a simulated session to file, instead of a replay\n"
+        "  -s seconds    simulated session length, default 8\n"
+        "  -v            commands and App logs\n");
+}
+
+int
+main(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if      (a == "-g" && hasValue) opt_.generate = argv[++i];
+        else if (a == "-s" && hasValue) opt_.seconds = atoi(argv[++i]);
+        else if (a == "-v") opt_.verbose = true;
+        else if (a[0] != '-' && opt_.input.empty()) opt_.input = a;
+        else { usage(); return 1; }
+    }
+
+    if (!opt_.generate.empty()) {
+        return simulate(opt_.generate, (opt_.seconds > 0)? opt_.seconds : 8)? 0 : 1;
+    }
+    if (opt_.input.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::vector<trace_record_t> records;
+    if (!read_trace(opt_.input, &records)) {
+        printf("%s : can not read\n", opt_.input.c_str());
+        return 1;
+    }
+    if (records.empty()) {
+        printf("%s : no trace records\n", opt_.input.c_str());
+        printf("check : NG\n");
+        return 1;
+    }
+    bool ok = replay(records);
+    printf("check : %s\n", (ok)? "OK" : "NG");
+    return (ok)? 0 : 1;
+}